@@ -19,6 +19,8 @@
 #include <iostream>
 #include <algorithm>
 
+#include <sdf/discretization/grid.hpp>
+
 class VolumeLoader
 {
 public:
@@ -37,7 +39,7 @@ public:
 	bool GetIsProcessing() { return m_processing; }
 	//----------------------------------------------------------------------------------
 	/// \brief Returns a 'ticket'
-	/// \param [in] _filename
+	/// \param [in] _filename A .vol file, or a compressed .cbf field (its own size and bounds are used)
 	/// \param [in] _depth
 	/// \param [in] _width
 	/// \param [in] _height
@@ -117,6 +119,10 @@ protected:
 		//----------------------------------------------------------------------------------
 		float *m_data;
 		//----------------------------------------------------------------------------------
+		/// \brief Samples decoded from a .cbf file, m_data stays NULL for those
+		//----------------------------------------------------------------------------------
+		sdf::grid m_samples;
+		//----------------------------------------------------------------------------------
 		/// \brief Min bound
 		//----------------------------------------------------------------------------------
 		cml::vector3f m_boundMin;
@@ -133,6 +139,11 @@ protected:
 	//----------------------------------------------------------------------------------
 	JobData* GetFinishedJobData( unsigned int _ticket );
 	//----------------------------------------------------------------------------------
+	/// \brief Decodes a compressed .cbf field into the job's samples, sets its size and bounds
+	/// \param [in] _job
+	//----------------------------------------------------------------------------------
+	bool LoadCompressed( JobData *_job );
+	//----------------------------------------------------------------------------------
 	/// \brief Issue new ticket
 	//----------------------------------------------------------------------------------
 	unsigned int IssueNewTicket();
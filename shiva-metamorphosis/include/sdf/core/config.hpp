@@ -3,5 +3,12 @@
 
 #define SDF_NO_BOOST_THREAD
 //#define SDF_USE_PADDING
+//#define SDF_NO_PROFILER
+
+// SSE2 code paths are used when the compiler targets it (x64, or x86 with /arch:SSE2 which is the default)
+// define SDF_NO_SSE to force the scalar paths
+#if !defined(SDF_NO_SSE) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2) || defined(__SSE2__))
+#define SDF_USE_SSE
+#endif
 
 #endif /* SDF_CORE_CONFIG_INCLUDED */
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef SDF_CORE_MAPPED_FILE_INCLUDED
+#define SDF_CORE_MAPPED_FILE_INCLUDED
+
+#include <string>
+#include <cstddef>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class mapped_file "include/sdf/core/mapped_file.hpp"
+	/// @brief A read only view of a whole file mapped in memory (MapViewOfFile on Windows, mmap elsewhere)
+	///			The pages are only read from the disk when they are touched, and the file is never copied
+	//----------------------------------------------------------------------------------------------------------------------
+	class mapped_file
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor - map a file
+		/// @param[in] i_filename The path to the file
+		//----------------------------------------------------------------------------------------------------------------------
+		mapped_file(const std::string& i_filename);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Destructor - unmap the file
+		//----------------------------------------------------------------------------------------------------------------------
+		~mapped_file();
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check if the file is mapped
+		/// @return True if the file could be opened, an empty file is open with no data
+		//----------------------------------------------------------------------------------------------------------------------
+		bool is_open() const { return m_open; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the first byte of the file
+		/// @return A pointer to the data, 0 for an empty file
+		//----------------------------------------------------------------------------------------------------------------------
+		const char* data() const { return m_data; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the size of the file
+		/// @return The number of bytes
+		//----------------------------------------------------------------------------------------------------------------------
+		std::size_t size() const { return m_size; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Unmap the file
+		//----------------------------------------------------------------------------------------------------------------------
+		void close();
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief No copy - the mapping belongs to one object
+		//----------------------------------------------------------------------------------------------------------------------
+		mapped_file(const mapped_file&);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief No copy - the mapping belongs to one object
+		//----------------------------------------------------------------------------------------------------------------------
+		mapped_file& operator=(const mapped_file&);
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The mapped data
+		//----------------------------------------------------------------------------------------------------------------------
+		const char* m_data;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Size of the file
+		//----------------------------------------------------------------------------------------------------------------------
+		std::size_t m_size;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief True if the file could be opened
+		//----------------------------------------------------------------------------------------------------------------------
+		bool m_open;
+#ifdef _WIN32
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The file and mapping handles
+		//----------------------------------------------------------------------------------------------------------------------
+		void* m_file;
+		void* m_mapping;
+#endif
+	};
+}
+
+#endif /* SDF_CORE_MAPPED_FILE_INCLUDED */
@@ -55,6 +55,25 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		bool load_from_obj(const std::string& i_filename, aabb* o_box = 0);
 		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructing the mesh from a binary .stl file, the vertices are welded
+		/// @param[in] i_filename Path to the file
+		/// @param[in] i_weld_tolerance Distance under which vertices are merged, 0 only merges identical positions
+		/// @return True if everything went well, otherwise, mesh is empty and returns false
+		//----------------------------------------------------------------------------------------------------------------------
+		bool load_from_stl(const std::string& i_filename, float i_weld_tolerance = 0.f, aabb* o_box = 0);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructing the mesh from a binary .ply file
+		/// @param[in] i_filename Path to the file
+		/// @return True if everything went well, otherwise, mesh is empty and returns false
+		//----------------------------------------------------------------------------------------------------------------------
+		bool load_from_ply(const std::string& i_filename, aabb* o_box = 0);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructing the mesh from a file, the format is guessed from the extension (.stl, .ply, .obj otherwise)
+		/// @param[in] i_filename Path to the file
+		/// @return True if everything went well, otherwise, mesh is empty and returns false
+		//----------------------------------------------------------------------------------------------------------------------
+		bool load_from_file(const std::string& i_filename, aabb* o_box = 0);
+		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Export the current mesh to an object file
 		/// @param[in] i_filename Path to the file
 		/// @return True if everything went well, otherwise, no file created
@@ -86,6 +105,11 @@ namespace sdf
 		/// @return True if it has a known source, false otherwise
 		//----------------------------------------------------------------------------------------------------------------------
 		bool known_source() const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Forget the source of the mesh: the structures built from it (.bvh, .awn) will neither load nor write the
+		///			files next to the source, whose content may not match the file anymore
+		//----------------------------------------------------------------------------------------------------------------------
+		void forget_source();
 
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get the vertex array
@@ -179,6 +203,14 @@ namespace sdf
 		/// @return The face id added
 		//----------------------------------------------------------------------------------------------------------------------
 		index_type append(index_type i_indexA, index_type i_indexB, index_type i_indexC);
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Keep the source after a load, or empty the mesh if it failed
+		/// @param[in] i_success Whether the file was read
+		/// @param[in] i_filename Path to the file
+		/// @return i_success
+		//----------------------------------------------------------------------------------------------------------------------
+		bool finish_load(bool i_success, const std::string& i_filename);
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Filename the mesh comes from - empty if loaded manually
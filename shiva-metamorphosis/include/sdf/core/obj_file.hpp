@@ -26,9 +26,11 @@ namespace sdf
 		obj_file() : m_enable_comments(true) {}
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Read an obj file from a filename
+		///			The file is mapped in memory and parsed in parallel, see the buffer version
 		/// @param[in] i_filename The path to the obj file
 		/// @param[out] o_vb The vertex buffer
 		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
 		/// @return True if it managed to read the file, false otherwise
 		//----------------------------------------------------------------------------------------------------------------------
 		bool read(const std::string& i_filename, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
@@ -37,10 +39,24 @@ namespace sdf
 		/// @param[in] i_sstream The stream
 		/// @param[out] o_vb The vertex buffer
 		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
 		/// @return True if it managed to read the file, false otherwise
 		//----------------------------------------------------------------------------------------------------------------------
 		bool read(std::stringstream& i_sstream, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
 		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Read an obj file from memory
+		///			The text is split in chunks of whole lines, parsed in parallel by a thread::task_pool with hand written
+		///			number parsers, then the chunks are appended in order (prefix sum of their vertex and index counts).
+		///			Polygons with more than 3 vertices are triangulated as a fan, negative (relative) indices are supported
+		/// @param[in] i_begin The first character
+		/// @param[in] i_end The end marker
+		/// @param[out] o_vb The vertex buffer
+		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
+		/// @return True if it managed to read the file, false otherwise
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(const char* i_begin, const char* i_end, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
+		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Write an obj file 
 		/// @param[in] i_filename The path to the file
 		/// @param[in] i_vb Vertex buffer of the object
@@ -54,20 +70,6 @@ namespace sdf
 		/// @param[in] i_enable Enable or disable comments
 		//----------------------------------------------------------------------------------------------------------------------
 		void enable_comments(bool i_enable);
-	private :
-		//----------------------------------------------------------------------------------------------------------------------
-		/// @brief Read a vertex from a stream
-		/// @param io_stream The stream to read from
-		/// @param[out] o_vertex The vertex to fill, it needs at least 3 consecutive floats
-		//----------------------------------------------------------------------------------------------------------------------
-		void read_vertex(std::stringstream& io_stream, float* o_vertex) const;
-		//----------------------------------------------------------------------------------------------------------------------
-		/// @brief Read a face from a stream
-		/// @param io_stream The stream to read from
-		/// @param[out] o_indices An array with at least 4 elements
-		/// @param[out] o_nAttrib The number of attributes read in - normally 3
-		//----------------------------------------------------------------------------------------------------------------------
-		void read_face  (std::stringstream& io_stream, index_type o_indices[], unsigned char& o_nAttrib) const;
 	private :
 		bool m_enable_comments;
 	};
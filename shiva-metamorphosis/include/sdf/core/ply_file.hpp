@@ -0,0 +1,41 @@
+#ifndef SDF_CORE_PLY_FILE_INCLUDED
+#define SDF_CORE_PLY_FILE_INCLUDED
+
+#include <sdf/core/types.hpp>
+#include <sdf/core/aabb.hpp>
+#include <string>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class ply_file "include/sdf/core/ply_file.hpp"
+	/// @brief A class to read binary .ply files (little or big endian). From the file it will only read the x, y, z
+	///			properties of the vertices and the vertex_indices list of the faces, the other properties and elements
+	///			are skipped. Polygons are triangulated as a fan
+	//----------------------------------------------------------------------------------------------------------------------
+	class ply_file
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Read a binary ply file from a filename
+		/// @param[in] i_filename The path to the ply file
+		/// @param[out] o_vb The vertex buffer
+		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
+		/// @return True if it managed to read the file, false otherwise (ascii ply is not read)
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(const std::string& i_filename, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Read a binary ply file from memory
+		/// @param[in] i_begin The first byte
+		/// @param[in] i_end The end marker
+		/// @param[out] o_vb The vertex buffer
+		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
+		/// @return True if it managed to read the file, false otherwise
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(const char* i_begin, const char* i_end, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
+	};
+}
+
+#endif // SDF_CORE_PLY_FILE_INCLUDED
@@ -0,0 +1,61 @@
+#ifndef SDF_CORE_STL_FILE_INCLUDED
+#define SDF_CORE_STL_FILE_INCLUDED
+
+#include <sdf/core/types.hpp>
+#include <sdf/core/aabb.hpp>
+#include <string>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class stl_file "include/sdf/core/stl_file.hpp"
+	/// @brief A class to read and write binary .stl files. The facet normals and attributes are ignored.
+	///			STL stores 3 positions per triangle, the vertices are welded while reading (see vertex_welder) so the
+	///			mesh is indexed and its edges and vertices are shared
+	//----------------------------------------------------------------------------------------------------------------------
+	class stl_file
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor
+		//----------------------------------------------------------------------------------------------------------------------
+		stl_file() : m_weld_tolerance(0.f) {}
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Read a binary stl file from a filename
+		/// @param[in] i_filename The path to the stl file
+		/// @param[out] o_vb The vertex buffer
+		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
+		/// @return True if it managed to read the file, false otherwise (ascii stl is not read)
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(const std::string& i_filename, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Read a binary stl file from memory
+		/// @param[in] i_begin The first byte
+		/// @param[in] i_end The end marker
+		/// @param[out] o_vb The vertex buffer
+		/// @param[out] o_ib The index buffer
+		/// @param[out] o_box The bounding box of the vertices (optional)
+		/// @return True if it managed to read the file, false otherwise
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(const char* i_begin, const char* i_end, vertex_array* o_vb, index_array* o_ib, aabb* o_box = 0) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Write a binary stl file
+		/// @param[in] i_filename The path to the file
+		/// @param[in] i_vb Vertex buffer of the object
+		/// @param[in] i_ib Index buffer of the object
+		/// @return True if it managed to write the file, false otherwise
+		//----------------------------------------------------------------------------------------------------------------------
+		bool write(const std::string& i_filename, const vertex_array& i_vb, const index_array& i_ib) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Set the distance under which the vertices are merged
+		/// @param[in] i_tolerance The distance, 0 (default) only merges identical positions
+		//----------------------------------------------------------------------------------------------------------------------
+		void set_weld_tolerance(float i_tolerance) { m_weld_tolerance = i_tolerance; }
+	private :
+		float m_weld_tolerance;
+	};
+}
+
+#endif // SDF_CORE_STL_FILE_INCLUDED
@@ -0,0 +1,113 @@
+#ifndef SDF_CORE_TASK_POOL_INCLUDED
+#define SDF_CORE_TASK_POOL_INCLUDED
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace sdf
+{
+	namespace thread
+	{
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class task_pool "include/sdf/core/task_pool.hpp"
+		/// @brief Runs a number of independent tasks on all the cores, using std::thread only (no boost needed)
+		///			The task ids are split in one contiguous range per thread. A thread eats its own range from the front,
+		///			and when it runs dry it steals the back half of the fullest range it can find.
+		///			Ranges are packed in a single atomic word, so grabbing a task is one compare and swap, never a mutex lock.
+		///			The calling thread works too, the pool only spawns num_threads()-1 extra threads for each run.
+		//----------------------------------------------------------------------------------------------------------------------
+		class task_pool
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor
+			/// @param[in] i_num_threads The number of threads to use - 0 uses the hardware concurrency number
+			//----------------------------------------------------------------------------------------------------------------------
+			task_pool(unsigned int i_num_threads = 0);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the number of threads working (including the calling thread)
+			/// @return Number of threads
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int num_threads() const { return m_num_threads; }
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Process all the tasks and return once they are all done
+			///			The task is called as i_task(task_id, thread_id), thread_id being in [0,num_threads()[
+			///			so the task can keep per-thread data (distance records, ...) without any locking
+			/// @param[in] i_num_tasks Number of tasks to process
+			/// @param[in] i_task The task functor, shared by all the threads
+			//----------------------------------------------------------------------------------------------------------------------
+			template<typename TaskFn>
+			void run(unsigned int i_num_tasks, TaskFn& i_task);
+
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief No copy - the ranges are atomics
+			//----------------------------------------------------------------------------------------------------------------------
+			task_pool(const task_pool&);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief No copy - the ranges are atomics
+			//----------------------------------------------------------------------------------------------------------------------
+			task_pool& operator=(const task_pool&);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Split the tasks in one contiguous range per thread
+			/// @param[in] i_num_tasks Number of tasks to process
+			/// @return The number of threads taking part (never more than the number of tasks)
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int split(unsigned int i_num_tasks);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the next task for a thread, stealing from the others when its own range is empty
+			/// @param[in] i_thread The thread asking
+			/// @param[out] o_id The task id
+			/// @return True if there is a new task, False when all the tasks have been handed out
+			//----------------------------------------------------------------------------------------------------------------------
+			bool next_task(unsigned int i_thread, unsigned int* o_id);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Steal the back half of another thread's range
+			/// @param[in] i_thread The thread stealing
+			/// @param[out] o_first First stolen task id
+			/// @param[out] o_end End marker of the stolen tasks
+			/// @return True if something was stolen
+			//----------------------------------------------------------------------------------------------------------------------
+			bool steal(unsigned int i_thread, unsigned int* o_first, unsigned int* o_end);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The main loop of a thread
+			/// @param[in] i_task The task functor
+			/// @param[in] i_thread The thread id
+			//----------------------------------------------------------------------------------------------------------------------
+			template<typename TaskFn>
+			void work(TaskFn* i_task, unsigned int i_thread);
+
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief A range of task ids [first,end[ packed as (end<<32)|first, padded to its own cache line
+			//----------------------------------------------------------------------------------------------------------------------
+			struct range
+			{
+				std::atomic<unsigned long long> m_packed;
+				char m_padding[64-sizeof(std::atomic<unsigned long long>)];
+			};
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Number of threads working (including the calling thread)
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int m_num_threads;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Number of threads taking part in the current run
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int m_num_active;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief One range per thread
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<range> m_ranges;
+		};
+	}
+}
+
+#include <sdf/core/task_pool.inl>
+
+#endif /* SDF_CORE_TASK_POOL_INCLUDED */
@@ -0,0 +1,31 @@
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TaskFn>
+inline void sdf::thread::task_pool::run(unsigned int i_num_tasks, TaskFn& i_task)
+{
+	if (i_num_tasks==0)
+		return;
+
+	const unsigned int num_helpers = split(i_num_tasks)-1;
+	std::vector<std::thread> helpers;
+	helpers.reserve(num_helpers);
+	for (unsigned int i=0;i<num_helpers;i++)
+		helpers.push_back(std::thread(&task_pool::work<TaskFn>,this,&i_task,i+1));
+
+	work(&i_task,0);
+
+	for (unsigned int i=0;i<helpers.size();i++)
+		helpers[i].join();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TaskFn>
+inline void sdf::thread::task_pool::work(TaskFn* i_task, unsigned int i_thread)
+{
+	unsigned int id(0);
+	// Grabing a new task until none are left
+	while (next_task(i_thread,&id))
+	{
+		(*i_task)(id,i_thread);
+	}
+}
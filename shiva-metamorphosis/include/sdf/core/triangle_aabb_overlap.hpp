@@ -15,6 +15,17 @@ namespace sdf
 	/// @return True if they collide false otherwise
 	//----------------------------------------------------------------------------------------------------------------------
 	bool triangle_box_overlap(const point3d& i_centre, const vector3d& i_halfextent, const point3d& i_first, const point3d& i_second, const point3d& i_third);
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Triangle-AABB overlap of one triangle against 4 boxes of the same size (the cells of a grid for example)
+	///			The boxes are tested at once with SSE, the results are the same as 4 calls of the single box test
+	/// @param[in] i_centres Centres of the boxes, [axis][box]
+	/// @param[in] i_halfextent The half extent of the boxes (vector from centre to corner)
+	/// @param[in] i_first The first triangle vertex
+	/// @param[in] i_second The second triangle vertex
+	/// @param[in] i_third The third triangle vertex
+	/// @return A mask with bit i set if the triangle collides with box i
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned int triangle_box_overlap(const float i_centres[3][4], const vector3d& i_halfextent, const point3d& i_first, const point3d& i_second, const point3d& i_third);
 }
 
 #endif /* SDF_CORE_TRIANGLE_AABB_OVERLAP_INCLUDED */
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef SDF_CORE_VERTEX_WELDER_INCLUDED
+#define SDF_CORE_VERTEX_WELDER_INCLUDED
+
+#include <sdf/core/types.hpp>
+#include <vector>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class vertex_welder "include/sdf/core/vertex_welder.hpp"
+	/// @brief Merge the vertices at the same position to turn a triangle soup into an indexed mesh
+	///			The vertices are hashed by cell, a cell is a tolerance wide (or one exact position with no tolerance).
+	///			A vertex is merged with the first vertex found within the tolerance in the 27 cells around it.
+	///			Vertices can be added one by one, so a file can be welded while it is being read
+	//----------------------------------------------------------------------------------------------------------------------
+	class vertex_welder
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor
+		/// @param[out] io_vertices The vertex buffer the welded vertices are appended to - the vertices already in it are used
+		/// @param[in] i_tolerance The distance under which two vertices are merged, 0 only merges identical positions
+		//----------------------------------------------------------------------------------------------------------------------
+		vertex_welder(vertex_array* io_vertices, float i_tolerance = 0.f);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Add a vertex
+		/// @param[in] i_vertex The position
+		/// @return The index of the vertex it is merged with, or of the new vertex
+		//----------------------------------------------------------------------------------------------------------------------
+		index_type add(const vertex_type& i_vertex);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Weld an indexed mesh in place, the unused vertices are removed
+		/// @param[out] io_vertices The vertices
+		/// @param[out] io_indices The indices, rewritten to the welded vertices
+		/// @param[in] i_tolerance The distance under which two vertices are merged
+		//----------------------------------------------------------------------------------------------------------------------
+		static void weld(vertex_array* io_vertices, index_array* io_indices, float i_tolerance = 0.f);
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The cell coordinates of a position (float bits with no tolerance)
+		//----------------------------------------------------------------------------------------------------------------------
+		void cell_of(const vertex_type& i_vertex, int o_cell[]) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Find the slot of a cell in the table, or the empty slot it goes to
+		//----------------------------------------------------------------------------------------------------------------------
+		std::size_t find(const int i_cell[]) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Find a vertex close enough in a cell
+		/// @return Its index or no_vertex
+		//----------------------------------------------------------------------------------------------------------------------
+		index_type search(const int i_cell[], const vertex_type& i_vertex) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Insert a new vertex in the table
+		//----------------------------------------------------------------------------------------------------------------------
+		void insert(const int i_cell[], index_type i_vertex);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Double the table
+		//----------------------------------------------------------------------------------------------------------------------
+		void grow();
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Marks the end of a list and the empty slots
+		//----------------------------------------------------------------------------------------------------------------------
+		static const index_type no_vertex = 0xffffffff;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief A cell of the table and its first vertex
+		//----------------------------------------------------------------------------------------------------------------------
+		struct slot
+		{
+			int m_cell[3];
+			index_type m_first;
+		};
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The output vertices
+		//----------------------------------------------------------------------------------------------------------------------
+		vertex_array& m_vertices;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Merge distance and its square
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_tolerance;
+		float m_tolerance_squared;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Open addressing table of the cells, the size is a power of 2
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<slot> m_slots;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief 64 minus log2 of the table size, for the hash
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_shift;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of used slots
+		//----------------------------------------------------------------------------------------------------------------------
+		std::size_t m_num_used;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Per vertex, the next vertex in the same cell
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<index_type> m_next;
+	};
+}
+
+#endif /* SDF_CORE_VERTEX_WELDER_INCLUDED */
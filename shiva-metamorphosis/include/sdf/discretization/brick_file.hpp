@@ -0,0 +1,189 @@
+#ifndef SDF_DISCRETIZATION_BRICK_FILE_INCLUDED
+#define SDF_DISCRETIZATION_BRICK_FILE_INCLUDED
+
+#include <string>
+#include <sdf/core/point3d.hpp>
+#include <sdf/core/mapped_file.hpp>
+#include <sdf/discretization/grid.hpp>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class brick_file "include/sdf/discretization/brick_file.hpp"
+	/// @brief A compressed field file (.cbf). The grid is cut in bricks of 8^3 or 16^3 samples (smaller at the far ends)
+	///			- the distances are clamped to a band around the surface, a brick entirely outside the band is one constant
+	///			- the other bricks are quantised to 8 or 16 bits over their own range, with zero as one of the levels so
+	///			  every sample keeps its sign and the surface does not move
+	///			- the quantised samples are predicted from their neighbours (Lorenzo predictor) and the residuals are
+	///			  bit packed in groups of 64, so the smooth distance compresses to a few bits per sample
+	///			An index after the header gives the offset of every brick, so a brick can be decoded alone and all the bricks
+	///			can be decoded in parallel. The file is mapped, only the bricks decoded are read from the disk
+	//----------------------------------------------------------------------------------------------------------------------
+	class brick_file
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief How a brick is stored
+		//----------------------------------------------------------------------------------------------------------------------
+		enum brick_type
+		{
+			constant_brick = 0,
+			quantized_brick = 1
+		};
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief An entry of the brick index, the samples are m_minimum+q*m_scale (a constant brick is m_minimum)
+		//----------------------------------------------------------------------------------------------------------------------
+		struct brick_entry
+		{
+			unsigned long long m_offset;
+			unsigned int m_size;
+			unsigned int m_type;
+			float m_minimum;
+			float m_scale;
+		};
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor - map a file and check its header and index
+		/// @param[in] i_filename The path to the file
+		//----------------------------------------------------------------------------------------------------------------------
+		brick_file(const std::string& i_filename);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check if the file is a valid brick file
+		/// @return True if the file could be mapped and its index is consistent
+		//----------------------------------------------------------------------------------------------------------------------
+		bool is_open() const { return m_index!=0; }
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of samples in a direction
+		/// @param[in] i_axis The direction
+		/// @return Number of samples
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int size(unsigned int i_axis) const { return m_size[i_axis]; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of samples along a (full) brick
+		/// @return The brick size
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int brick_size() const { return m_brick_size; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of bricks in a direction
+		/// @param[in] i_axis The direction
+		/// @return Number of bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int num_bricks(unsigned int i_axis) const { return m_num_bricks[i_axis]; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the total number of bricks, the id of brick (i,j,k) is i+j*nx+k*nx*ny
+		/// @return Number of bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int num_bricks() const { return m_num_bricks[0]*m_num_bricks[1]*m_num_bricks[2]; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the minimum of the field
+		/// @return Constant reference to the minimum
+		//----------------------------------------------------------------------------------------------------------------------
+		const point3d& minimum() const { return m_min; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the maximum of the field
+		/// @return Constant reference to the maximum
+		//----------------------------------------------------------------------------------------------------------------------
+		const point3d& maximum() const { return m_max; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the index entry of a brick
+		/// @param[in] i_brick The brick id
+		/// @return Constant reference to the entry
+		//----------------------------------------------------------------------------------------------------------------------
+		const brick_entry& entry(unsigned int i_brick) const { return m_index[i_brick]; }
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the samples covered by a brick
+		/// @param[in] i_brick The brick id
+		/// @param[out] o_first The first sample in each direction
+		/// @param[out] o_size The number of samples in each direction
+		//----------------------------------------------------------------------------------------------------------------------
+		void brick_range(unsigned int i_brick, unsigned int o_first[3], unsigned int o_size[3]) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Decode a single brick
+		/// @param[in] i_brick The brick id
+		/// @param[out] o_samples The samples of the brick, X first, o_size[0]*o_size[1]*o_size[2] of them (see brick_range)
+		/// @return False if the brick data is corrupted
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read_brick(unsigned int i_brick, float* o_samples) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Decode the whole field
+		/// @param[out] o_grid The grid, resized to the field size
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
+		/// @return False if a brick is corrupted
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(sdf::grid* o_grid, unsigned int i_num_threads = 0) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Compress a sampled field to a file
+		/// @param[in] i_filename The path to the file
+		/// @param[in] i_grid The samples
+		/// @param[in] i_min The minimum of the field
+		/// @param[in] i_max The maximum of the field
+		/// @param[in] i_brick_size Number of samples along a brick, 8 or 16
+		/// @param[in] i_bits Number of bits of the quantised samples, 8 or 16
+		/// @param[in] i_band Half width of the band kept around the surface, in samples (the largest spacing).
+		///			The distances are clamped to it, 0 keeps the whole range
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
+		/// @return True if the file was written
+		//----------------------------------------------------------------------------------------------------------------------
+		static bool write(
+			const std::string& i_filename,
+			const sdf::grid& i_grid,
+			const point3d& i_min,
+			const point3d& i_max,
+			unsigned int i_brick_size = 8,
+			unsigned int i_bits = 16,
+			float i_band = 8.f,
+			unsigned int i_num_threads = 0);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check if a file starts like a brick file
+		/// @param[in] i_data The first bytes of the file
+		/// @param[in] i_size The number of bytes available
+		/// @return True if the magic number matches
+		//----------------------------------------------------------------------------------------------------------------------
+		static bool is_brick_file(const char* i_data, std::size_t i_size);
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief No copy - the file is mapped
+		//----------------------------------------------------------------------------------------------------------------------
+		brick_file(const brick_file&);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief No copy - the file is mapped
+		//----------------------------------------------------------------------------------------------------------------------
+		brick_file& operator=(const brick_file&);
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The mapped file
+		//----------------------------------------------------------------------------------------------------------------------
+		mapped_file m_file;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The brick index, in the mapped file, 0 if the file is not valid
+		//----------------------------------------------------------------------------------------------------------------------
+		const brick_entry* m_index;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of samples in each direction
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_size[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of bricks in each direction
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_num_bricks[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of samples along a brick
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_brick_size;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The minimum of the field
+		//----------------------------------------------------------------------------------------------------------------------
+		point3d m_min;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The maximum of the field
+		//----------------------------------------------------------------------------------------------------------------------
+		point3d m_max;
+	};
+}
+
+#endif // SDF_DISCRETIZATION_BRICK_FILE_INCLUDED
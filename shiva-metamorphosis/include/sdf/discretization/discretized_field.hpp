@@ -1,11 +1,16 @@
 #ifndef SDF_DISCRETIZED_FIELD_INCLUDED
 #define SDF_DISCRETIZED_FIELD_INCLUDED
 
+#include <limits>
 #include <sdf/discretization/grid.hpp>
+#include <sdf/discretization/sparse_bricks.hpp>
 #include <sdf/core/types.hpp>
-#include <sdf/core/thread_work.hpp>
+#include <sdf/core/mesh.hpp>
+#include <sdf/core/tools.hpp>
+#include <sdf/core/task_pool.hpp>
 #include <sdf/core/binary_file.hpp>
 #include <sdf/distance/distance_record.hpp>
+#include <sdf/profiler/scope.hpp>
 
 namespace sdf
 {
@@ -98,16 +103,104 @@ namespace sdf
 		template<typename TriVariateFn>
 		void fill_slice(const TriVariateFn& i_function, unsigned int i_slice);
 
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill a slice of the field using a tri-variate function ( F(x,y,z)=... ) reusing the caller's records
+		/// @param[in] i_function The function to evaluate
+		/// @param[in] i_slice The slice id
+		/// @param[out] o_face_id Scratch face id for the function
+		/// @param[out] o_hit Scratch distance record for the function
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		void fill_slice(const TriVariateFn& i_function, unsigned int i_slice, unsigned int* o_face_id, distance_record* o_hit);
+
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Fill the field using a tri-variate function ( F(x,y,z)=... ) Multithreaded version
+		///			The slices are dealt by a work stealing thread::task_pool, each thread has its own distance record
+		///			The function is shared by all the threads, so its operator() has to be safe to call concurrently
 		/// @param[in] i_function The function to evaluate
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
 		//----------------------------------------------------------------------------------------------------------------------
 		template<typename TriVariateFn>
-		void fill_mt(const TriVariateFn& i_function);
+		void fill_mt(const TriVariateFn& i_function, unsigned int i_num_threads = 0);
 
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill the field using a function evaluating packets of 8 points ( bool F(const point3d[8], float[8]) )
+		///			The points of a packet are a 2x2x2 block of samples, so the resolution has to be even in every direction
+		/// @param[in] i_function The function to evaluate
+		//----------------------------------------------------------------------------------------------------------------------
 		template<typename TriVariateFn>
 		void fill_packets(const TriVariateFn& i_function);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill the field with packets of 8 points, Multithreaded version
+		///			The slabs of 2 slices are dealt by a work stealing thread::task_pool
+		///			The function is shared by all the threads, so its operator() has to be safe to call concurrently
+		/// @param[in] i_function The function to evaluate
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		void fill_packets_mt(const TriVariateFn& i_function, unsigned int i_num_threads = 0);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill the slices k and k+1 with packets of 8 points
+		/// @param[in] i_function The function to evaluate
+		/// @param[in] k The first slice id (even)
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		void fill_packet_slab(const TriVariateFn& i_function, unsigned int k);
 
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill the field with exact distances near the surface only, Multithreaded version
+		///			The samples around the cells the triangles go through (triangle_box_overlap), grown by i_band samples,
+		///			are evaluated with the function. The distance to the band is then propagated to the rest of the grid by
+		///			fast sweeping (first order Eikonal solver), each thread sweeping its own slab of slices until nothing changes.
+		///			The far samples get their sign from a flood fill: every connected region outside the band takes the sign
+		///			most of the band samples around it have.
+		///			Far from the surface the values are upper bounds of the exact distance, within a few percent
+		/// @param[in] i_function The signed distance function to evaluate in the band
+		/// @param[in] i_mesh The mesh the function is the distance to
+		/// @param[in] i_band Number of samples added around the cells crossed by the surface
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		void fill_narrow_band(const TriVariateFn& i_function, const mesh& i_mesh, unsigned int i_band = 1, unsigned int i_num_threads = 0);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill the samples of a slice which are in the band, the others are set to the largest float
+		/// @param[in] i_function The function to evaluate
+		/// @param[in] i_band One flag per sample, non zero in the band
+		/// @param[in] i_slice The slice id
+		/// @param[out] o_face_id Scratch face id for the function
+		/// @param[out] o_hit Scratch distance record for the function
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		void fill_band_slice(const TriVariateFn& i_function, const std::vector<unsigned char>& i_band, unsigned int i_slice, unsigned int* o_face_id, distance_record* o_hit);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Fill the field evaluating the function only where the surface can be, Multithreaded version
+		///			The function is evaluated at the corners of bricks of i_brick_size^3 cells. A cell is split in 8 while the
+		///			smallest |value| at its corners is not more than half its diagonal: every point of the cell is within half
+		///			the diagonal of a corner, so a 1-Lipschitz distance cannot reach 0 in the cell otherwise. The samples of the
+		///			cells which are not split are interpolated from the cell corners, they have the exact sign and are within
+		///			the cell diagonal of the exact distance. The bricks are dealt by a work stealing thread::task_pool, in 8
+		///			passes so that the samples a brick evaluates on its faces are reused by its neighbours.
+		///			The function is evaluated around the surface and at the brick corners only, so the evaluations grow with the
+		///			area of the surface instead of the volume of the grid: a sphere or a torus takes 15 to 30% of the evaluations
+		///			of fill at 64^3, half of that at 128^3 and half again at 256^3. This beats fill from 64^3 up, and whenever
+		///			the surface leaves most bricks empty. A coarse grid (32^3 or less) or a surface going through most bricks
+		///			(a noisy scan) still takes half the evaluations of fill or more, and checking the centres adds 50 to 100%.
+		/// @param[in] i_function The function to evaluate
+		/// @param[in] i_brick_size Number of cells along a brick, a power of 2 splits evenly
+		/// @param[in] i_tolerance Largest error allowed at the centre of an interpolated cell, in samples spacing. The centre
+		///			is evaluated and a cell is also split while its interpolation misses it by more (the distance has creases
+		///			along the medial axis). 0 skips the check, the far samples are then less accurate but the surface is the same
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
+		/// @param[out] o_bricks If not null, gets the same samples as sparse bricks, only the bricks which were split are stored
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		void fill_adaptive(
+			const TriVariateFn& i_function,
+			unsigned int i_brick_size = 8,
+			float i_tolerance = 0.f,
+			unsigned int i_num_threads = 0,
+			sparse_bricks* o_bricks = 0);
 
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get the value at the sample i,j,k
@@ -137,6 +230,23 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		float operator()(const point3d& i_position) const;
 
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Trilinear filtering as the GPU does it - the grid is sampled like a 3D texture over the box, with
+		///			GL_LINEAR and GL_CLAMP_TO_EDGE, so the value matches the rendered field
+		/// @param[in] i_position Position to sample
+		/// @param[out] o_gradient If not null, the gradient of the interpolation (0 along a clamped direction)
+		/// @return The interpolated value at that position
+		//----------------------------------------------------------------------------------------------------------------------
+		float sample(const point3d& i_position, vector3d* o_gradient = 0) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Sample many positions at once (for ray marching, meshing or picking), see grid::sample
+		/// @param[in] i_count The number of positions
+		/// @param[in] i_positions The positions to sample
+		/// @param[out] o_values The interpolated values
+		/// @param[out] o_gradients If not null, the gradients
+		//----------------------------------------------------------------------------------------------------------------------
+		void sample(unsigned int i_count, const point3d* i_positions, float* o_values, vector3d* o_gradients = 0) const;
+
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Minimum of the box
 		/// @return Constant reference to the minimum of the field
@@ -169,7 +279,23 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		void unserialize(binary_file_in& o_file);
 		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Save the field to a .bdf file (version 2)
+		///			A 64 bytes header (magic, version, size, bounding box) then the samples, 64 bytes aligned
+		/// @param[in] i_filename The path to the file
+		/// @return True if the file was written
+		//----------------------------------------------------------------------------------------------------------------------
+		bool save(const std::string& i_filename) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Load a .bdf file, version 2 or the version 1 written by serialize
+		///			The file is mapped in memory and the grid is a view of it, nothing is copied until the grid is modified.
+		///			A compressed .cbf file (see brick_file) is decoded instead
+		/// @param[in] i_filename The path to the file
+		/// @return True if the file was read, the field is unchanged otherwise
+		//----------------------------------------------------------------------------------------------------------------------
+		bool load(const std::string& i_filename);
+		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get the grid as raw data
+		/// @warning Empty if the grid is a view of a file, use grid().raw_data()
 		/// @return A constant reference to the raw data 
 		//----------------------------------------------------------------------------------------------------------------------
 		const grid::scalar_field& raw_data() const { return m_grid.data(); }
@@ -180,15 +306,308 @@ namespace sdf
 		grid::scalar_field& raw_data() { return m_grid.data(); }
 	private :
 
-#ifndef SDF_NO_BOOST_THREAD
 		//----------------------------------------------------------------------------------------------------------------------
-		/// @brief The main thread loop to fill the field
-		/// @param[in] i_function The function to evaluate
-		/// @param[in] i_wq The work queue that deals the tasks
+		/// @class slice_filler "include/sdf/discretization/discretized_field.hpp"
+		/// @brief The task given to the thread::task_pool by fill_mt - one task per slice
+		///			The records are per thread, padded so two threads never write to the same cache line
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		class slice_filler
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor
+			/// @param[in] i_field The field to fill
+			/// @param[in] i_function The function to evaluate
+			/// @param[in] i_num_threads The number of threads of the pool
+			//----------------------------------------------------------------------------------------------------------------------
+			slice_filler(discretized_field* i_field, const TriVariateFn& i_function, unsigned int i_num_threads);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Fill one slice
+			/// @param[in] i_slice The slice id
+			/// @param[in] i_thread The thread id
+			//----------------------------------------------------------------------------------------------------------------------
+			void operator()(unsigned int i_slice, unsigned int i_thread);
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Scratch data of one thread
+			//----------------------------------------------------------------------------------------------------------------------
+			struct thread_record
+			{
+				distance_record m_hit;
+				unsigned int m_face_id;
+				char m_padding[64];
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The field to fill
+			//----------------------------------------------------------------------------------------------------------------------
+			discretized_field* m_field;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The function to evaluate
+			//----------------------------------------------------------------------------------------------------------------------
+			const TriVariateFn& m_function;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief One record per thread
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<thread_record> m_records;
+		};
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class packet_filler "include/sdf/discretization/discretized_field.hpp"
+		/// @brief The task given to the thread::task_pool by fill_packets_mt - one task per slab of 2 slices
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		class packet_filler
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor
+			/// @param[in] i_field The field to fill
+			/// @param[in] i_function The function to evaluate
+			//----------------------------------------------------------------------------------------------------------------------
+			packet_filler(discretized_field* i_field, const TriVariateFn& i_function);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Fill one slab
+			/// @param[in] i_slab The slab id (slices 2*i_slab and 2*i_slab+1)
+			/// @param[in] i_thread The thread id
+			//----------------------------------------------------------------------------------------------------------------------
+			void operator()(unsigned int i_slab, unsigned int i_thread);
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The field to fill
+			//----------------------------------------------------------------------------------------------------------------------
+			discretized_field* m_field;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The function to evaluate
+			//----------------------------------------------------------------------------------------------------------------------
+			const TriVariateFn& m_function;
+		};
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class band_filler "include/sdf/discretization/discretized_field.hpp"
+		/// @brief The task given to the thread::task_pool by fill_narrow_band - one task per slice
 		//----------------------------------------------------------------------------------------------------------------------
 		template<typename TriVariateFn>
-		void fill_mt_single(const TriVariateFn& i_function, thread::work_queue* i_wq);
-#endif
+		class band_filler
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor
+			/// @param[in] i_field The field to fill
+			/// @param[in] i_function The function to evaluate
+			/// @param[in] i_band One flag per sample, non zero in the band
+			/// @param[in] i_num_threads The number of threads of the pool
+			//----------------------------------------------------------------------------------------------------------------------
+			band_filler(discretized_field* i_field, const TriVariateFn& i_function, const std::vector<unsigned char>& i_band, unsigned int i_num_threads);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Fill the band samples of one slice
+			/// @param[in] i_slice The slice id
+			/// @param[in] i_thread The thread id
+			//----------------------------------------------------------------------------------------------------------------------
+			void operator()(unsigned int i_slice, unsigned int i_thread);
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Scratch data of one thread
+			//----------------------------------------------------------------------------------------------------------------------
+			struct thread_record
+			{
+				distance_record m_hit;
+				unsigned int m_face_id;
+				char m_padding[64];
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The field to fill
+			//----------------------------------------------------------------------------------------------------------------------
+			discretized_field* m_field;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The function to evaluate
+			//----------------------------------------------------------------------------------------------------------------------
+			const TriVariateFn& m_function;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The band flags
+			//----------------------------------------------------------------------------------------------------------------------
+			const std::vector<unsigned char>& m_band;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief One record per thread
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<thread_record> m_records;
+		};
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class adaptive_filler "include/sdf/discretization/discretized_field.hpp"
+		/// @brief The task given to the thread::task_pool by fill_adaptive
+		///			First one task per slice of brick corners, then one task per brick refining it in a scratch brick
+		///			A brick writes the samples from its first one to the one before its last (the last one is the first of the
+		///			next brick) so no two threads write the same sample.
+		///			The bricks are refined in 8 passes, one per parity of their index along the 3 axes: two bricks of a pass do
+		///			not share any sample, so a brick can give the samples it evaluated on its faces to the neighbours of the
+		///			next passes through the field, and take the ones the neighbours of the previous passes evaluated
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename TriVariateFn>
+		class adaptive_filler
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor
+			/// @param[in] i_field The field to fill
+			/// @param[in] i_function The function to evaluate
+			/// @param[out] io_bricks The bricks, initialized for the field
+			/// @param[in] i_tolerance Largest error allowed at the centre of an interpolated cell, in samples spacing - 0 skips the check
+			/// @param[in] i_keep_bricks True to keep the samples of the bricks which get split
+			/// @param[in] i_num_threads The number of threads of the pool
+			//----------------------------------------------------------------------------------------------------------------------
+			adaptive_filler(
+				discretized_field* i_field,
+				const TriVariateFn& i_function,
+				sparse_bricks* io_bricks,
+				float i_tolerance,
+				bool i_keep_bricks,
+				unsigned int i_num_threads);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Evaluate the corners of a slice of bricks, or refine a brick once the corners are done
+			/// @param[in] i_task The corner slice id, or the brick id
+			/// @param[in] i_thread The thread id
+			//----------------------------------------------------------------------------------------------------------------------
+			void operator()(unsigned int i_task, unsigned int i_thread);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Switch from the corners to the bricks of one pass
+			/// @param[in] i_parity The pass, the parity of the brick index in X, Y and Z in its bits 0, 1 and 2
+			/// @return The number of bricks of the pass
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int refine_bricks(unsigned int i_parity);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Give the kept bricks to the sparse bricks, in order
+			//----------------------------------------------------------------------------------------------------------------------
+			void store_bricks();
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Scratch data of one thread
+			//----------------------------------------------------------------------------------------------------------------------
+			struct thread_record
+			{
+				distance_record m_hit;
+				unsigned int m_face_id;
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief The samples of the current brick
+				//----------------------------------------------------------------------------------------------------------------------
+				std::vector<float> m_samples;
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief Per sample of the current brick, 0 unknown, 1 interpolated, 2 evaluated
+				//----------------------------------------------------------------------------------------------------------------------
+				std::vector<unsigned char> m_state;
+				char m_padding[64];
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Refine a box of samples of the current brick
+			/// @param[out] io_record The thread scratch data
+			/// @param[in] i_first The brick first sample
+			/// @param[in] i_min The box minimum sample, relative to the brick
+			/// @param[in] i_max The box maximum sample, relative to the brick
+			/// @return True if the box was split
+			//----------------------------------------------------------------------------------------------------------------------
+			bool refine(thread_record& io_record, const unsigned int i_first[3], const unsigned int i_min[3], const unsigned int i_max[3]);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Evaluate the function at a sample
+			/// @param[out] io_record The thread scratch data
+			/// @param[in] i Index in X
+			/// @param[in] j Index in Y
+			/// @param[in] k Index in Z
+			/// @return The function value
+			//----------------------------------------------------------------------------------------------------------------------
+			float evaluate(thread_record& io_record, unsigned int i, unsigned int j, unsigned int k) const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Interpolate the samples of a box of the current brick which have not been evaluated
+			/// @param[out] io_record The thread scratch data
+			/// @param[in] i_corners The 8 corner values, X first
+			/// @param[in] i_min The box minimum sample, relative to the brick
+			/// @param[in] i_max The box maximum sample, relative to the brick
+			//----------------------------------------------------------------------------------------------------------------------
+			void interpolate_box(thread_record& io_record, const float i_corners[8], const unsigned int i_min[3], const unsigned int i_max[3]);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the index of a sample in m_exact
+			/// @param[in] i Index in X
+			/// @param[in] j Index in Y
+			/// @param[in] k Index in Z
+			/// @return The index
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int exact_index(unsigned int i, unsigned int j, unsigned int k) const
+			{
+				return i+(j+k*m_bricks.num_samples(1))*m_bricks.num_samples(0);
+			}
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Trilinear interpolation of the corners of a box at one of its samples
+			/// @param[in] i_corners The 8 corner values, X first
+			/// @param[in] i_min The box minimum sample
+			/// @param[in] i_size The box size in samples
+			/// @param[in] i_sample The sample
+			/// @return The interpolated value
+			//----------------------------------------------------------------------------------------------------------------------
+			static float interpolate(const float i_corners[8], const unsigned int i_min[3], const unsigned int i_size[3], const unsigned int i_sample[3]);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The field to fill
+			//----------------------------------------------------------------------------------------------------------------------
+			discretized_field* m_field;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The function to evaluate
+			//----------------------------------------------------------------------------------------------------------------------
+			const TriVariateFn& m_function;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The bricks, the corners are set by the first pass
+			//----------------------------------------------------------------------------------------------------------------------
+			sparse_bricks& m_bricks;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Distance between two samples along each axis
+			//----------------------------------------------------------------------------------------------------------------------
+			float m_spacing[3];
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Largest error allowed at the centre of an interpolated cell, 0 when the centres are not checked
+			//----------------------------------------------------------------------------------------------------------------------
+			float m_tolerance;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief True once the corners are evaluated
+			//----------------------------------------------------------------------------------------------------------------------
+			bool m_corners_done;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The current pass, the parity of the brick index in X, Y and Z in its bits 0, 1 and 2
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int m_parity;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Number of bricks of the current pass in each direction
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int m_pass_bricks[3];
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Per sample of the field, 1 if the value in the field is the function value
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<unsigned char> m_exact;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief True to keep the split bricks
+			//----------------------------------------------------------------------------------------------------------------------
+			bool m_keep_bricks;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The samples of each split brick (empty for the others) when they are kept
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<std::vector<float> > m_kept;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief One record per thread
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<thread_record> m_records;
+		};
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Flag the samples around the cells crossed by the triangles of a mesh
+		/// @param[in] i_mesh The mesh
+		/// @param[in] i_band Number of samples added around the crossed cells
+		/// @param[out] o_band One flag per sample, non zero in the band
+		/// @return The number of samples in the band
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int mark_band(const mesh& i_mesh, unsigned int i_band, std::vector<unsigned char>* o_band) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Compute the samples outside the band from the band values (fast sweeping, then sign flood fill)
+		/// @param[in] i_band One flag per sample, non zero in the band
+		/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
+		//----------------------------------------------------------------------------------------------------------------------
+		void extend_band(const std::vector<unsigned char>& i_band, unsigned int i_num_threads);
 
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
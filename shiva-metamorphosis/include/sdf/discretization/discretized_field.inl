@@ -4,6 +4,7 @@
 template<typename TriVariateFn>
 inline void sdf::discretized_field::fill(const TriVariateFn& i_function)
 {
+	SDF_PROFILE(fill)
 	// Use at least boost::thread!
 	const float xscale = 1.f/((float)m_grid.width()-1);
 	const float yscale = 1.f/((float)m_grid.height()-1);
@@ -33,13 +34,19 @@ inline void sdf::discretized_field::fill(const TriVariateFn& i_function)
 template<typename TriVariateFn>
 inline void sdf::discretized_field::fill_slice(const TriVariateFn& i_function, unsigned int i_slice)
 {
-	// Use at least boost::thread!
+	unsigned int faceid(0);
+	distance_record ft;
+	fill_slice(i_function,i_slice,&faceid,&ft);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::fill_slice(const TriVariateFn& i_function, unsigned int i_slice, unsigned int* o_face_id, distance_record* o_hit)
+{
 	const float xscale = 1.f/((float)m_grid.width()-1);
 	const float yscale = 1.f/((float)m_grid.height()-1);
 	const float zscale = 1.f/((float)m_grid.depth()-1);
 	const vector3d extent = m_max-m_min;
-	unsigned int faceid(0);
-	distance_record ft;
 	for (unsigned int j=0;j<m_grid.height();j++)
 	{
 		for (unsigned int i=0;i<m_grid.width();i++)
@@ -49,7 +56,7 @@ inline void sdf::discretized_field::fill_slice(const TriVariateFn& i_function, u
 				(float)j*yscale*extent[1],
 				(float)i_slice*zscale*extent[2]
 			);
-			m_grid(i,j,i_slice)=i_function(m_min+point,&faceid,&ft);
+			m_grid(i,j,i_slice)=i_function(m_min+point,o_face_id,o_hit);
 		}
 	}
 }
@@ -58,87 +65,524 @@ inline void sdf::discretized_field::fill_slice(const TriVariateFn& i_function, u
 //----------------------------------------------------------------------------------------------------------------------
 template<typename TriVariateFn>
 inline void sdf::discretized_field::fill_packets(const TriVariateFn& i_function)
+{
+	SDF_PROFILE(fill_packets)
+	assert(m_grid.depth()%2==0);
+	for (unsigned int k=0;k<m_grid.depth();k+=2)
+		fill_packet_slab(i_function,k);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::fill_packet_slab(const TriVariateFn& i_function, unsigned int k)
 {
 	const float xscale = 1.f/((float)m_grid.width()-1);
 	const float yscale = 1.f/((float)m_grid.height()-1);
 	const float zscale = 1.f/((float)m_grid.depth()-1);
 	const vector3d extent = m_max-m_min;
-	unsigned int faceid(0);
-	distance_record ft;
 
-	assert(m_grid.depth()%2==0);
+	assert(k%2==0 && k+1<m_grid.depth());
 	assert(m_grid.height()%2==0);
 	assert(m_grid.width()%2==0);
-	int incoherents = 0;
-	int coherents = 0;
 
-	for (unsigned int k=0;k<m_grid.depth();k+=2)
+	for (unsigned int j=0;j<m_grid.height();j+=2)
 	{
-		for (unsigned int j=0;j<m_grid.height();j+=2)
+		for (unsigned int i=0;i<m_grid.width();i+=2)
 		{
-			for (unsigned int i=0;i<m_grid.width();i+=2)
+			const point3d points[8] = { 
+				m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
+				m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+1)*zscale*extent[2]),
+				m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
+				m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+1)*zscale*extent[2]),
+				m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
+				m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+1)*zscale*extent[2]),
+				m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
+				m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+1)*zscale*extent[2])					
+			};
+			float dists[8] = { 0,0,0,0,0,0,0,0 };
+			i_function(points,dists);
+
+			m_grid(i+0,j+0,k+0)=dists[0];
+			m_grid(i+0,j+0,k+1)=dists[1];
+			m_grid(i+0,j+1,k+0)=dists[2];
+			m_grid(i+0,j+1,k+1)=dists[3];
+			m_grid(i+1,j+0,k+0)=dists[4];
+			m_grid(i+1,j+0,k+1)=dists[5];
+			m_grid(i+1,j+1,k+0)=dists[6];
+			m_grid(i+1,j+1,k+1)=dists[7];
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::fill_packets_mt(const TriVariateFn& i_function, unsigned int i_num_threads)
+{
+	SDF_PROFILE(fill_packets_mt)
+	assert(m_grid.depth()%2==0);
+	thread::task_pool pool(i_num_threads);
+	packet_filler<TriVariateFn> filler(this,i_function);
+	pool.run(m_grid.depth()/2,filler);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline sdf::discretized_field::packet_filler<TriVariateFn>::packet_filler(
+	discretized_field* i_field,
+	const TriVariateFn& i_function) : m_field(i_field), m_function(i_function)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::packet_filler<TriVariateFn>::operator()(unsigned int i_slab, unsigned int /*i_thread*/)
+{
+	m_field->fill_packet_slab(m_function,i_slab*2);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::fill_mt(const TriVariateFn& i_function, unsigned int i_num_threads)
+{
+	SDF_PROFILE(fill_mt)
+	thread::task_pool pool(i_num_threads);
+	slice_filler<TriVariateFn> filler(this,i_function,pool.num_threads());
+	pool.run(m_grid.depth(),filler);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline sdf::discretized_field::slice_filler<TriVariateFn>::slice_filler(
+	discretized_field* i_field,
+	const TriVariateFn& i_function,
+	unsigned int i_num_threads) : m_field(i_field), m_function(i_function), m_records(i_num_threads)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::slice_filler<TriVariateFn>::operator()(unsigned int i_slice, unsigned int i_thread)
+{
+	thread_record& record = m_records[i_thread];
+	m_field->fill_slice(m_function,i_slice,&record.m_face_id,&record.m_hit);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::fill_narrow_band(const TriVariateFn& i_function, const mesh& i_mesh, unsigned int i_band, unsigned int i_num_threads)
+{
+	SDF_PROFILE(fill_narrow_band)
+	std::vector<unsigned char> band;
+	if (mark_band(i_mesh,i_band,&band)==0)
+	{
+		// Nothing to propagate from, the surface is out of the field
+		fill_mt(i_function,i_num_threads);
+		return;
+	}
+
+	{
+		SDF_PROFILE(band)
+		thread::task_pool pool(i_num_threads);
+		band_filler<TriVariateFn> filler(this,i_function,band,pool.num_threads());
+		pool.run(m_grid.depth(),filler);
+	}
+	SDF_PROFILE(extend_band)
+	extend_band(band,i_num_threads);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::fill_band_slice(
+	const TriVariateFn& i_function,
+	const std::vector<unsigned char>& i_band,
+	unsigned int i_slice,
+	unsigned int* o_face_id,
+	distance_record* o_hit)
+{
+	const float xscale = 1.f/((float)m_grid.width()-1);
+	const float yscale = 1.f/((float)m_grid.height()-1);
+	const float zscale = 1.f/((float)m_grid.depth()-1);
+	const vector3d extent = m_max-m_min;
+	unsigned int index = i_slice*m_grid.height()*m_grid.width();
+	for (unsigned int j=0;j<m_grid.height();j++)
+	{
+		for (unsigned int i=0;i<m_grid.width();i++,index++)
+		{
+			if (!i_band[index])
 			{
-				const point3d points[8] = { 
-					m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
-					m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+1)*zscale*extent[2]),
-					m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
-					m_min+point3d((float)(i+0)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+1)*zscale*extent[2]),
-					m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
-					m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+0)*yscale*extent[1],(float)(k+1)*zscale*extent[2]),
-					m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+0)*zscale*extent[2]),
-					m_min+point3d((float)(i+1)*xscale*extent[0],(float)(j+1)*yscale*extent[1],(float)(k+1)*zscale*extent[2])					
-				};
-				float dists[8] = { 0,0,0,0,0,0,0,0 };
-				if (i_function(points,dists))
-					coherents++;
-				else
-					incoherents--;
-
-				m_grid(i+0,j+0,k+0)=dists[0];
-				m_grid(i+0,j+0,k+1)=dists[1];
-				m_grid(i+0,j+1,k+0)=dists[2];
-				m_grid(i+0,j+1,k+1)=dists[3];
-				m_grid(i+1,j+0,k+0)=dists[4];
-				m_grid(i+1,j+0,k+1)=dists[5];
-				m_grid(i+1,j+1,k+0)=dists[6];
-				m_grid(i+1,j+1,k+1)=dists[7];
+				m_grid(i,j,i_slice)=std::numeric_limits<float>::max();
+				continue;
 			}
+			const point3d point(
+				(float)i*xscale*extent[0],
+				(float)j*yscale*extent[1],
+				(float)i_slice*zscale*extent[2]
+			);
+			m_grid(i,j,i_slice)=i_function(m_min+point,o_face_id,o_hit);
 		}
 	}
+}
 
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline sdf::discretized_field::band_filler<TriVariateFn>::band_filler(
+	discretized_field* i_field,
+	const TriVariateFn& i_function,
+	const std::vector<unsigned char>& i_band,
+	unsigned int i_num_threads) : m_field(i_field), m_function(i_function), m_band(i_band), m_records(i_num_threads)
+{
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::band_filler<TriVariateFn>::operator()(unsigned int i_slice, unsigned int i_thread)
+{
+	thread_record& record = m_records[i_thread];
+	m_field->fill_band_slice(m_function,m_band,i_slice,&record.m_face_id,&record.m_hit);
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 template<typename TriVariateFn>
-inline void sdf::discretized_field::fill_mt(const TriVariateFn& i_function)
+inline void sdf::discretized_field::fill_adaptive(
+	const TriVariateFn& i_function,
+	unsigned int i_brick_size,
+	float i_tolerance,
+	unsigned int i_num_threads,
+	sparse_bricks* o_bricks)
 {
-#ifndef SDF_NO_BOOST_THREAD
-	boost::thread_group group;
-	thread::work_queue wq(m_grid.depth());
-	for (unsigned int i=0;i<boost::thread::hardware_concurrency();i++)
+	SDF_PROFILE(fill_adaptive)
+	sparse_bricks local;
+	sparse_bricks& bricks = o_bricks ? *o_bricks : local;
+	bricks.initialize(m_grid.width(),m_grid.height(),m_grid.depth(),i_brick_size);
+
+	thread::task_pool pool(i_num_threads);
+	adaptive_filler<TriVariateFn> filler(this,i_function,&bricks,i_tolerance,o_bricks!=0,pool.num_threads());
 	{
-		group.create_thread(boost::bind(
-			&discretized_field::fill_mt_single<TriVariateFn>,this,i_function,&wq
-			));
+		SDF_PROFILE(coarse)
+		pool.run(bricks.num_bricks(2)+1,filler);
 	}
-	group.join_all();
-#else
-	fill(i_function);
-#endif
+	SDF_PROFILE(refine)
+	for (unsigned int parity=0;parity<8;parity++)
+		pool.run(filler.refine_bricks(parity),filler);
+	if (o_bricks)
+		filler.store_bricks();
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline sdf::discretized_field::adaptive_filler<TriVariateFn>::adaptive_filler(
+	discretized_field* i_field,
+	const TriVariateFn& i_function,
+	sparse_bricks* io_bricks,
+	float i_tolerance,
+	bool i_keep_bricks,
+	unsigned int i_num_threads) :
+	m_field(i_field), m_function(i_function), m_bricks(*io_bricks), m_corners_done(false), m_parity(0),
+	m_exact(i_field->m_grid.num_elements(),0), m_keep_bricks(i_keep_bricks), m_records(i_num_threads)
+{
+	const vector3d extent = m_field->m_max-m_field->m_min;
+	for (unsigned int axis=0;axis<3;axis++)
+		m_spacing[axis] = extent[axis]/((float)m_bricks.num_samples(axis)-1);
+	m_tolerance = std::max(0.f,i_tolerance)*std::min(m_spacing[0],std::min(m_spacing[1],m_spacing[2]));
+	for (unsigned int axis=0;axis<3;axis++)
+		m_pass_bricks[axis] = 0;
+	if (m_keep_bricks)
+		m_kept.resize(m_bricks.num_bricks(0)*m_bricks.num_bricks(1)*m_bricks.num_bricks(2));
+	const unsigned int side = m_bricks.brick_size()+1;
+	for (std::size_t i=0;i<m_records.size();i++)
+	{
+		m_records[i].m_face_id = 0;
+		m_records[i].m_samples.resize(side*side*side);
+		m_records[i].m_state.resize(side*side*side);
+	}
+}
 
-#ifndef SDF_NO_BOOST_THREAD
 //----------------------------------------------------------------------------------------------------------------------
 template<typename TriVariateFn>
-inline void sdf::discretized_field::fill_mt_single(const TriVariateFn& i_function, thread::work_queue* i_wq)
+inline unsigned int sdf::discretized_field::adaptive_filler<TriVariateFn>::refine_bricks(unsigned int i_parity)
 {
-	unsigned int slice(0);
-	// Grabing a new slice until none are left
-	while (i_wq->next_work_id(&slice))
+	m_corners_done = true;
+	m_parity = i_parity;
+	for (unsigned int axis=0;axis<3;axis++)
 	{
-		fill_slice(i_function,slice);
-	};
+		const unsigned int odd = (i_parity>>axis)&1;
+		m_pass_bricks[axis] = (m_bricks.num_bricks(axis)+1-odd)/2;
+	}
+	return m_pass_bricks[0]*m_pass_bricks[1]*m_pass_bricks[2];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline float sdf::discretized_field::adaptive_filler<TriVariateFn>::evaluate(thread_record& io_record, unsigned int i, unsigned int j, unsigned int k) const
+{
+	// Same positions as fill
+	const float xscale = 1.f/((float)m_field->m_grid.width()-1);
+	const float yscale = 1.f/((float)m_field->m_grid.height()-1);
+	const float zscale = 1.f/((float)m_field->m_grid.depth()-1);
+	const vector3d extent = m_field->m_max-m_field->m_min;
+	const point3d point(
+		(float)i*xscale*extent[0],
+		(float)j*yscale*extent[1],
+		(float)k*zscale*extent[2]
+	);
+	return m_function(m_field->m_min+point,&io_record.m_face_id,&io_record.m_hit);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::adaptive_filler<TriVariateFn>::operator()(unsigned int i_task, unsigned int i_thread)
+{
+	thread_record& record = m_records[i_thread];
+	const unsigned int nx = m_bricks.num_bricks(0);
+	const unsigned int ny = m_bricks.num_bricks(1);
+	if (!m_corners_done)
+	{
+		const unsigned int z = m_bricks.corner_sample(2,i_task);
+		for (unsigned int cj=0;cj<=ny;cj++)
+		{
+			const unsigned int y = m_bricks.corner_sample(1,cj);
+			for (unsigned int ci=0;ci<=nx;ci++)
+				m_bricks.corner(ci,cj,i_task) = evaluate(record,m_bricks.corner_sample(0,ci),y,z);
+		}
+		return;
+	}
+
+	const unsigned int task[3] = { i_task%m_pass_bricks[0],(i_task/m_pass_bricks[0])%m_pass_bricks[1],i_task/(m_pass_bricks[0]*m_pass_bricks[1]) };
+	unsigned int brick[3], first[3], last[3], size[3];
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		brick[axis] = 2*task[axis]+((m_parity>>axis)&1);
+		m_bricks.brick_range(axis,brick[axis],first+axis,last+axis);
+		size[axis] = last[axis]-first[axis];
+	}
+	const unsigned int brick_id = brick[0]+(brick[1]+brick[2]*ny)*nx;
+
+	// The brick corners are known, the rest is found by refining the whole brick
+	const unsigned int side = m_bricks.brick_size()+1;
+	std::fill(record.m_samples.begin(),record.m_samples.end(),0.f);
+	std::fill(record.m_state.begin(),record.m_state.end(),0);
+	for (unsigned int corner=0;corner<8;corner++)
+	{
+		const unsigned int dx = corner&1, dy = (corner>>1)&1, dz = (corner>>2)&1;
+		const unsigned int local = dx*size[0]+(dy*size[1]+dz*size[2]*side)*side;
+		record.m_samples[local] = m_bricks.corner(brick[0]+dx,brick[1]+dy,brick[2]+dz);
+		record.m_state[local] = 2;
+	}
+	// The neighbours of the previous passes left the samples they evaluated on the faces
+	for (unsigned int k=0;k<=size[2];k++)
+	{
+		for (unsigned int j=0;j<=size[1];j++)
+		{
+			for (unsigned int i=0;i<=size[0];i++)
+			{
+				if (m_exact[exact_index(first[0]+i,first[1]+j,first[2]+k)])
+				{
+					const unsigned int local = i+(j+k*side)*side;
+					record.m_samples[local] = m_field->m_grid(first[0]+i,first[1]+j,first[2]+k);
+					record.m_state[local] = 2;
+				}
+			}
+		}
+	}
+	const unsigned int zero[3] = { 0,0,0 };
+	const bool split = refine(record,first,zero,size);
+
+	// Give the samples evaluated on the faces owned by the neighbours of the next passes
+	const bool last_brick[3] = {
+		last[0]+1==m_bricks.num_samples(0),
+		last[1]+1==m_bricks.num_samples(1),
+		last[2]+1==m_bricks.num_samples(2) };
+	for (unsigned int k=0;k<=size[2];k++)
+	{
+		const unsigned int dz = (k==size[2] && !last_brick[2]) ? 1 : 0;
+		for (unsigned int j=0;j<=size[1];j++)
+		{
+			const unsigned int dy = (j==size[1] && !last_brick[1]) ? 1 : 0;
+			for (unsigned int i=0;i<=size[0];i++)
+			{
+				const unsigned int dx = (i==size[0] && !last_brick[0]) ? 1 : 0;
+				const unsigned int owner = ((brick[0]+dx)&1)|(((brick[1]+dy)&1)<<1)|(((brick[2]+dz)&1)<<2);
+				const unsigned int local = i+(j+k*side)*side;
+				if (owner>m_parity && record.m_state[local]==2)
+				{
+					m_field->m_grid(first[0]+i,first[1]+j,first[2]+k) = record.m_samples[local];
+					m_exact[exact_index(first[0]+i,first[1]+j,first[2]+k)] = 1;
+				}
+			}
+		}
+	}
+
+	if (!split)
+	{
+		// Only the corners of a brick which is not split are kept by the sparse bricks, so the samples evaluated to
+		// check the interpolation are dropped to give the same field
+		float corners[8];
+		for (unsigned int corner=0;corner<8;corner++)
+			corners[corner] = m_bricks.corner(brick[0]+(corner&1),brick[1]+((corner>>1)&1),brick[2]+((corner>>2)&1));
+		std::fill(record.m_state.begin(),record.m_state.end(),0);
+		interpolate_box(record,corners,zero,size);
+	}
+
+	// Write the samples this brick owns
+	const unsigned int end[3] = {
+		last_brick[0] ? size[0]+1 : size[0],
+		last_brick[1] ? size[1]+1 : size[1],
+		last_brick[2] ? size[2]+1 : size[2] };
+	for (unsigned int k=0;k<end[2];k++)
+	{
+		for (unsigned int j=0;j<end[1];j++)
+		{
+			for (unsigned int i=0;i<end[0];i++)
+			{
+				const unsigned int local = i+(j+k*side)*side;
+				m_field->m_grid(first[0]+i,first[1]+j,first[2]+k) = record.m_samples[local];
+				m_exact[exact_index(first[0]+i,first[1]+j,first[2]+k)] = record.m_state[local]==2 ? 1 : 0;
+			}
+		}
+	}
+	if (split && m_keep_bricks)
+		m_kept[brick_id] = record.m_samples;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline bool sdf::discretized_field::adaptive_filler<TriVariateFn>::refine(
+	thread_record& io_record,
+	const unsigned int i_first[3],
+	const unsigned int i_min[3],
+	const unsigned int i_max[3])
+{
+	const unsigned int side = m_bricks.brick_size()+1;
+	float corners[8];
+	float closest(std::numeric_limits<float>::max());
+	for (unsigned int corner=0;corner<8;corner++)
+	{
+		const unsigned int x = (corner&1) ? i_max[0] : i_min[0];
+		const unsigned int y = ((corner>>1)&1) ? i_max[1] : i_min[1];
+		const unsigned int z = ((corner>>2)&1) ? i_max[2] : i_min[2];
+		const unsigned int local = x+(y+z*side)*side;
+		if (io_record.m_state[local]!=2)
+		{
+			io_record.m_samples[local] = evaluate(io_record,i_first[0]+x,i_first[1]+y,i_first[2]+z);
+			io_record.m_state[local] = 2;
+		}
+		corners[corner] = io_record.m_samples[local];
+		closest = std::min(closest,fabsf(corners[corner]));
+	}
+
+	const unsigned int size[3] = { i_max[0]-i_min[0],i_max[1]-i_min[1],i_max[2]-i_min[2] };
+	if (size[0]<=1 && size[1]<=1 && size[2]<=1)
+		return false;
+
+	const vector3d diagonal((float)size[0]*m_spacing[0],(float)size[1]*m_spacing[1],(float)size[2]*m_spacing[2]);
+	if (closest>0.5f*sqrtf(diagonal.length_squared()))
+	{
+		// The surface is not in the cell, when asked the interpolation still has to match the function at the centre
+		bool interpolated(true);
+		if (m_tolerance>0.f)
+		{
+			const unsigned int centre[3] = { i_min[0]+size[0]/2,i_min[1]+size[1]/2,i_min[2]+size[2]/2 };
+			const unsigned int local = centre[0]+(centre[1]+centre[2]*side)*side;
+			if (io_record.m_state[local]!=2)
+			{
+				io_record.m_samples[local] = evaluate(io_record,i_first[0]+centre[0],i_first[1]+centre[1],i_first[2]+centre[2]);
+				io_record.m_state[local] = 2;
+			}
+			interpolated = fabsf(io_record.m_samples[local]-interpolate(corners,i_min,size,centre))<=m_tolerance;
+		}
+		if (interpolated)
+		{
+			interpolate_box(io_record,corners,i_min,i_max);
+			return false;
+		}
+	}
+
+	// Split in 2 along every axis longer than a cell
+	unsigned int halves[3][3], num_halves[3];
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		halves[axis][0] = i_min[axis];
+		if (size[axis]>1)
+		{
+			halves[axis][1] = i_min[axis]+size[axis]/2;
+			halves[axis][2] = i_max[axis];
+			num_halves[axis] = 2;
+		}
+		else
+		{
+			halves[axis][1] = i_max[axis];
+			num_halves[axis] = 1;
+		}
+	}
+	for (unsigned int hz=0;hz<num_halves[2];hz++)
+	{
+		for (unsigned int hy=0;hy<num_halves[1];hy++)
+		{
+			for (unsigned int hx=0;hx<num_halves[0];hx++)
+			{
+				const unsigned int child_min[3] = { halves[0][hx],halves[1][hy],halves[2][hz] };
+				const unsigned int child_max[3] = { halves[0][hx+1],halves[1][hy+1],halves[2][hz+1] };
+				refine(io_record,i_first,child_min,child_max);
+			}
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline float sdf::discretized_field::adaptive_filler<TriVariateFn>::interpolate(
+	const float i_corners[8],
+	const unsigned int i_min[3],
+	const unsigned int i_size[3],
+	const unsigned int i_sample[3])
+{
+	const float a = (float)(i_sample[0]-i_min[0])/(float)std::max(i_size[0],1u);
+	const float b = (float)(i_sample[1]-i_min[1])/(float)std::max(i_size[1],1u);
+	const float c = (float)(i_sample[2]-i_min[2])/(float)std::max(i_size[2],1u);
+	return lerp(
+		lerp(lerp(i_corners[0],i_corners[1],a),lerp(i_corners[2],i_corners[3],a),b),
+		lerp(lerp(i_corners[4],i_corners[5],a),lerp(i_corners[6],i_corners[7],a),b),
+		c);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::adaptive_filler<TriVariateFn>::interpolate_box(
+	thread_record& io_record,
+	const float i_corners[8],
+	const unsigned int i_min[3],
+	const unsigned int i_max[3])
+{
+	const unsigned int side = m_bricks.brick_size()+1;
+	const unsigned int size[3] = { i_max[0]-i_min[0],i_max[1]-i_min[1],i_max[2]-i_min[2] };
+	for (unsigned int z=i_min[2];z<=i_max[2];z++)
+	{
+		for (unsigned int y=i_min[1];y<=i_max[1];y++)
+		{
+			for (unsigned int x=i_min[0];x<=i_max[0];x++)
+			{
+				const unsigned int sample[3] = { x,y,z };
+				const unsigned int local = x+(y+z*side)*side;
+				if (io_record.m_state[local]==2)
+					continue;
+				io_record.m_samples[local] = interpolate(i_corners,i_min,size,sample);
+				io_record.m_state[local] = 1;
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename TriVariateFn>
+inline void sdf::discretized_field::adaptive_filler<TriVariateFn>::store_bricks()
+{
+	const unsigned int nx = m_bricks.num_bricks(0);
+	const unsigned int ny = m_bricks.num_bricks(1);
+	for (unsigned int b=0;b<m_kept.size();b++)
+	{
+		if (!m_kept[b].empty())
+			m_bricks.set_brick(b%nx,(b/nx)%ny,b/(nx*ny),m_kept[b]);
+	}
 }
-#endif
@@ -10,25 +10,27 @@ namespace sdf
 	///			It will open the file at i_filename, read the mesh from there (.obj)
 	///			Prepare the signed distance function (using the template provided)
 	///			Discretize it to a uniform grid using the accuracy provided
-	///			And save the field to the file changing the extension .obj to .bdf (binary discretized field)
-	/// @param[in] i_filename THe path to the object file, will be used to create the bdf
+	///			And save the field to the file changing the extension .obj to .cbf (compressed bricks, see brick_file)
+	/// @param[in] i_filename THe path to the object file, will be used to create the cbf
 	/// @param[in] i_accuracy Field accuracy
+	/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
 	//----------------------------------------------------------------------------------------------------------------------
 	template<typename DistanceFunction>
-	void discretize_field_to(const std::string& i_filename, unsigned int i_accuracy);
+	void discretize_field_to(const std::string& i_filename, unsigned int i_accuracy, unsigned int i_num_threads = 0);
 
 	//----------------------------------------------------------------------------------------------------------------------
 	/// @brief Discreatize a field to a file. It is a useful function
 	///			It will open the file at i_filename, read the mesh from there (.obj)
 	///			Prepare the signed distance function (using the template provided)
 	///			Discretize it to a uniform grid using the accuracy provided and using the box provided
-	///			And save the field to the file changing the extension .obj to .bdf (binary discretized field)
-	/// @param[in] i_filename THe path to the object file, will be used to create the bdf
+	///			And save the field to the file changing the extension .obj to .cbf (compressed bricks, see brick_file)
+	/// @param[in] i_filename THe path to the object file, will be used to create the cbf
 	/// @param[in] i_accuracy Field accuracy
 	/// @param[in] i_box THe bounding box to discretize over
+	/// @param[in] i_num_threads The number of threads to use - 0 uses all the cores
 	//----------------------------------------------------------------------------------------------------------------------
 	template<typename DistanceFunction>
-	void discretize_field_to(const std::string& i_filename, unsigned int i_accuracy, const aabb& i_box);
+	void discretize_field_to(const std::string& i_filename, unsigned int i_accuracy, const aabb& i_box, unsigned int i_num_threads = 0);
 }
 
 #include <sdf/discretization/generate_volume.inl>
@@ -2,12 +2,13 @@
 #include <sdf/core/obj_file.hpp>
 #include <sdf/signed_distance_field_from_mesh.hpp>
 #include <sdf/discretization/discretized_field.hpp>
+#include <sdf/discretization/brick_file.hpp>
 
 //----------------------------------------------------------------------------------------------------------------------
 template<typename DistanceFunction>
-void sdf::discretize_field_to<DistanceFunction>(const std::string& i_filename, unsigned int i_accuracy)
+void sdf::discretize_field_to<DistanceFunction>(const std::string& i_filename, unsigned int i_accuracy, unsigned int i_num_threads)
 {
-	const std::string out = i_filename.substr(0,i_filename.size()-4)+".bdf";
+	const std::string out = i_filename.substr(0,i_filename.size()-4)+".cbf";
 
 	sdf::aabb box;
 	sdf::mesh mesh;
@@ -18,17 +19,19 @@ void sdf::discretize_field_to<DistanceFunction>(const std::string& i_filename, u
 	sdf::vector3d extent;
 	box.extent(&extent);
 	sdf::discretized_field df(box.minimum()-extent*0.1f,box.maximum()+extent*0.1f,i_accuracy,i_accuracy,i_accuracy);
-	df.fill_mt(eval);
-	sdf::binary_file_out fileout(out);
-	df.serialize(fileout);
+	if (i_accuracy%2==0)
+		df.fill_packets_mt(eval,i_num_threads);
+	else
+		df.fill_mt(eval,i_num_threads);
+	sdf::brick_file::write(out,df.grid(),df.minimum(),df.maximum(),8,16,8.f,i_num_threads);
 }
 
 
 //----------------------------------------------------------------------------------------------------------------------
 template<typename DistanceFunction>
-void sdf::discretize_field_to<DistanceFunction>(const std::string& i_filename, unsigned int i_accuracy, const aabb& i_box)
+void sdf::discretize_field_to<DistanceFunction>(const std::string& i_filename, unsigned int i_accuracy, const aabb& i_box, unsigned int i_num_threads)
 {
-	const std::string out = i_filename.substr(0,i_filename.size()-4)+".bdf";
+	const std::string out = i_filename.substr(0,i_filename.size()-4)+".cbf";
 	sdf::mesh mesh;
 	sdf::obj_file mr;
 	DistanceFunction eval(mesh,0.002f);
@@ -36,8 +39,10 @@ void sdf::discretize_field_to<DistanceFunction>(const std::string& i_filename, u
 	eval.initialize();
 
 	sdf::discretized_field df(i_box.minimum(),i_box.maximum(),i_accuracy,i_accuracy,i_accuracy);
-	df.fill_mt(eval);
-	sdf::binary_file_out fileout(out);
-	df.serialize(fileout);
+	if (i_accuracy%2==0)
+		df.fill_packets_mt(eval,i_num_threads);
+	else
+		df.fill_mt(eval,i_num_threads);
+	sdf::brick_file::write(out,df.grid(),df.minimum(),df.maximum(),8,16,8.f,i_num_threads);
 }
 
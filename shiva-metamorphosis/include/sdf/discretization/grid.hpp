@@ -2,6 +2,7 @@
 #define SDF_DISCRETIZATION_GRID_INCLUDED
 
 #include <vector>
+#include <memory>
 #include <sdf/core/binary_file.hpp>
 
 namespace sdf
@@ -9,6 +10,11 @@ namespace sdf
 	//----------------------------------------------------------------------------------------------------------------------
 	/// @class grid "include/sdf/discretization/grid.hpp"
 	/// @brief A grid (3D array) for the function samples
+	///			The samples are either owned or a view of memory owned by someone else (a mapped file for example).
+	///			A view is never written to, the first non constant access copies the samples.
+	///			Owned samples are stored X first (linear layout) or in tiles of 8^3 samples (tiled layout). In a tile the
+	///			samples follow the Z-order curve, so the 8 corners of a cell and the neighbours in Y and Z are a few
+	///			floats apart instead of a row or a slice. Views are always linear
 	/// @author Mathieu Sanchez
 	/// @version 1.0
 	/// @date Last Revision 28/06/11 Initial revision
@@ -20,6 +26,83 @@ namespace sdf
 		/// @brief A scalar field type
 		//----------------------------------------------------------------------------------------------------------------------
 		typedef std::vector<float> scalar_field;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief How the samples are ordered in memory
+		//----------------------------------------------------------------------------------------------------------------------
+		enum layout_type
+		{
+			linear_layout,
+			tiled_layout
+		};
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of samples along a tile of the tiled layout
+		//----------------------------------------------------------------------------------------------------------------------
+		static const unsigned int tile_size = 8;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class sample_iterator "include/sdf/discretization/grid.hpp"
+		/// @brief Goes through the samples in memory order, whatever the layout, and gives their position in the grid
+		///			It is the fastest way to visit all the samples of a tiled grid. The padding of the tiles is skipped
+		//----------------------------------------------------------------------------------------------------------------------
+		template<typename Value>
+		class sample_iterator
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor
+			/// @param[in] i_samples The samples, in memory order
+			/// @param[in] i_grid The grid
+			/// @param[in] i_index The index in memory, the number of samples stored for the end marker
+			//----------------------------------------------------------------------------------------------------------------------
+			sample_iterator(Value* i_samples, const grid& i_grid, unsigned int i_index);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the sample
+			//----------------------------------------------------------------------------------------------------------------------
+			Value& operator*() const { return m_samples[m_index]; }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Go to the next sample
+			//----------------------------------------------------------------------------------------------------------------------
+			sample_iterator& operator++();
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Comparison
+			//----------------------------------------------------------------------------------------------------------------------
+			bool operator==(const sample_iterator& i_other) const { return m_index==i_other.m_index; }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Comparison
+			//----------------------------------------------------------------------------------------------------------------------
+			bool operator!=(const sample_iterator& i_other) const { return m_index!=i_other.m_index; }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the index of the sample in X
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int x() const { return m_position[0]; }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the index of the sample in Y
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int y() const { return m_position[1]; }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the index of the sample in Z
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int z() const { return m_position[2]; }
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Find the position of the current index, moving past the padding of the tiles
+			//----------------------------------------------------------------------------------------------------------------------
+			void locate();
+		private :
+			Value* m_samples;
+			const grid* m_grid;
+			unsigned int m_index;
+			unsigned int m_end;
+			unsigned int m_position[3];
+		};
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Iterator over the samples
+		//----------------------------------------------------------------------------------------------------------------------
+		typedef sample_iterator<float> iterator;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Iterator over the constant samples
+		//----------------------------------------------------------------------------------------------------------------------
+		typedef sample_iterator<const float> const_iterator;
 	public :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Default constructor - unserialize has to be called to fill the data
@@ -31,12 +114,14 @@ namespace sdf
 		/// @param[in] i_dimy Dimension in y
 		/// @param[in] i_dimz Dimension in z
 		/// @param[in] i_default Default value to fill the scalar field with
+		/// @param[in] i_layout How the samples are ordered in memory
 		//----------------------------------------------------------------------------------------------------------------------
 		grid(
 			unsigned int i_dimx,
 			unsigned int i_dimy,
 			unsigned int i_dimz,
-			float i_default = 0.f);
+			float i_default = 0.f,
+			layout_type i_layout = linear_layout);
 
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get a value
@@ -61,13 +146,124 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		float& operator()(unsigned int i_x, unsigned int i_y, unsigned int i_z);
 
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the 8 samples at the corners of a cell - the cell (i,j,k) goes from sample (i,j,k) to (i+1,j+1,k+1)
+		/// @param[in] i_x Index of the cell in X, less than width()-1
+		/// @param[in] i_y Index of the cell in Y, less than height()-1
+		/// @param[in] i_z Index of the cell in Z, less than depth()-1
+		/// @param[out] o_corners The corners, X first: (i,j,k), (i+1,j,k), (i,j+1,k), (i+1,j+1,k), (i,j,k+1), ...
+		//----------------------------------------------------------------------------------------------------------------------
+		void cell(unsigned int i_x, unsigned int i_y, unsigned int i_z, float o_corners[8]) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Trilinear interpolation of the samples
+		/// @param[in] i_x Position in X, in samples (clamped to the grid)
+		/// @param[in] i_y Position in Y, in samples (clamped to the grid)
+		/// @param[in] i_z Position in Z, in samples (clamped to the grid)
+		/// @return The interpolated value
+		//----------------------------------------------------------------------------------------------------------------------
+		float trilinear(float i_x, float i_y, float i_z) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Trilinear interpolation of the samples and its gradient, both from the same 8 corners
+		/// @param[in] i_x Position in X, in samples (clamped to the grid)
+		/// @param[in] i_y Position in Y, in samples (clamped to the grid)
+		/// @param[in] i_z Position in Z, in samples (clamped to the grid)
+		/// @param[out] o_gradient The derivatives of the interpolation along X, Y and Z, per sample
+		/// @return The interpolated value
+		//----------------------------------------------------------------------------------------------------------------------
+		float trilinear(float i_x, float i_y, float i_z, float o_gradient[3]) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Sample like an OpenGL 3D texture with GL_LINEAR and GL_CLAMP_TO_EDGE - the sample i is at (i+0.5)/size
+		/// @param[in] i_u Texture coordinate in X, in [0,1]
+		/// @param[in] i_v Texture coordinate in Y, in [0,1]
+		/// @param[in] i_w Texture coordinate in Z, in [0,1]
+		/// @param[out] o_gradient If not null, the derivatives along the texture coordinates (0 where the coordinate is clamped)
+		/// @return The interpolated value
+		//----------------------------------------------------------------------------------------------------------------------
+		float sample(float i_u, float i_v, float i_w, float o_gradient[3] = 0) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Sample many texture coordinates at once, 4 at a time with SSE - same results as the single sample
+		/// @param[in] i_count The number of coordinates
+		/// @param[in] i_coordinates The texture coordinates, one array per axis (structure of arrays)
+		/// @param[out] o_values The interpolated values
+		/// @param[out] o_gradient If not null, the derivatives, one array per axis
+		//----------------------------------------------------------------------------------------------------------------------
+		void sample(
+			unsigned int i_count,
+			const float* const i_coordinates[3],
+			float* o_values,
+			float* const o_gradient[3] = 0) const;
+
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get raw data
-		/// @warning No assumption should be made about the layout
-		/// @return A pointer to the data (constant)
+		/// @warning No assumption should be made about the layout, use copy_linear to get the samples X first
+		/// @return A pointer to the data (constant), directly in the viewed memory for a view
 		//----------------------------------------------------------------------------------------------------------------------
 		const float* raw_data() const;
 		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the samples X first, whatever the layout (to upload to OpenGL or write a file)
+		/// @param[out] o_samples The samples, width()*height()*depth() of them
+		//----------------------------------------------------------------------------------------------------------------------
+		void copy_linear(scalar_field* o_samples) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the samples X first without copying them when it is already the layout
+		/// @param[out] o_buffer Receives the samples if they need reordering
+		/// @return The samples X first, raw_data() or the content of o_buffer
+		//----------------------------------------------------------------------------------------------------------------------
+		const float* linear_data(scalar_field* o_buffer) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the layout
+		/// @return How the samples are ordered in memory
+		//----------------------------------------------------------------------------------------------------------------------
+		layout_type layout() const { return m_layout; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Reorder the samples, a view is copied first when changing to the tiled layout
+		/// @param[in] i_layout The new layout
+		//----------------------------------------------------------------------------------------------------------------------
+		void set_layout(layout_type i_layout);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get an iterator to the first sample in memory
+		//----------------------------------------------------------------------------------------------------------------------
+		const_iterator begin() const { return const_iterator(values(),*this,0); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the end marker
+		//----------------------------------------------------------------------------------------------------------------------
+		const_iterator end() const { return const_iterator(values(),*this,storage_size()); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get an iterator to the first sample in memory, a view is detached first
+		//----------------------------------------------------------------------------------------------------------------------
+		iterator begin() { detach(); return iterator(m_data.empty() ? 0 : &m_data[0],*this,0); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the end marker, a view is detached first
+		//----------------------------------------------------------------------------------------------------------------------
+		iterator end() { detach(); return iterator(m_data.empty() ? 0 : &m_data[0],*this,storage_size()); }
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Use samples owned by someone else, nothing is copied
+		/// @param[in] i_dimx Dimension in x
+		/// @param[in] i_dimy Dimension in y
+		/// @param[in] i_dimz Dimension in z
+		/// @param[in] i_data The samples, X first
+		/// @param[in] i_owner Keeps i_data alive as long as a grid views it (copies of the grid share it)
+		//----------------------------------------------------------------------------------------------------------------------
+		void view(
+			unsigned int i_dimx,
+			unsigned int i_dimy,
+			unsigned int i_dimz,
+			const float* i_data,
+			const std::shared_ptr<const void>& i_owner);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check if the samples are a view
+		/// @return True if the grid does not own its samples
+		//----------------------------------------------------------------------------------------------------------------------
+		bool is_view() const { return m_view!=0; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Copy the viewed samples so the grid owns them (nothing happens if it already does)
+		//----------------------------------------------------------------------------------------------------------------------
+		void detach();
+		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get the number of elements (total)
 		/// @return Number of elements
 		//----------------------------------------------------------------------------------------------------------------------
@@ -109,23 +305,24 @@ namespace sdf
 		bool operator==(const grid& i_other) const;
 
 		//----------------------------------------------------------------------------------------------------------------------
-		/// @brief Get the scalar field as a 1D array
+		/// @brief Get the scalar field as a 1D array, in the order of the layout (padded to whole tiles when tiled)
+		/// @warning Empty for a view, use raw_data
 		/// @return Constant reference to the scalar field
 		//----------------------------------------------------------------------------------------------------------------------
 		const scalar_field& data() const { return m_data; }
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get the scalar field as a 1D array
-		/// @return Reference to the scalar field
+		/// @return Reference to the scalar field, a view is detached first
 		//----------------------------------------------------------------------------------------------------------------------
-		scalar_field& data() { return m_data; }
+		scalar_field& data() { detach(); return m_data; }
 
 		//----------------------------------------------------------------------------------------------------------------------
-		/// @brief Serialize the grid to a binary file
+		/// @brief Serialize the grid to a binary file, the samples are always written X first
 		/// @param[out] o_file The file stream to send the data to
 		//----------------------------------------------------------------------------------------------------------------------
 		void serialize(binary_file_out& o_file) const;
 		//----------------------------------------------------------------------------------------------------------------------
-		/// @brief Unserialize the grid from a binary file
+		/// @brief Unserialize the grid from a binary file, the grid keeps its layout
 		/// @param[out] o_file The file stream to retrieve the data from
 		//----------------------------------------------------------------------------------------------------------------------
 		void unserialize(binary_file_in& o_file);
@@ -138,6 +335,23 @@ namespace sdf
 		/// @return The absolute index 
 		//----------------------------------------------------------------------------------------------------------------------
 		unsigned int raw_index(unsigned int i_x, unsigned int i_y, unsigned int i_z) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the samples, owned or viewed
+		//----------------------------------------------------------------------------------------------------------------------
+		const float* values() const { return m_view ? m_view : (m_data.empty() ? 0 : &m_data[0]); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of floats stored, more than num_elements() when the tiles are padded
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int storage_size() const { return m_view ? num_elements() : static_cast<unsigned int>(m_data.size()); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the number of tiles from the dimensions
+		//----------------------------------------------------------------------------------------------------------------------
+		void update_tiles();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Spread the 3 bits of a coordinate in a tile so they can be interleaved (Z-order)
+		/// @param[in] i_local The coordinate in the tile, less than tile_size
+		//----------------------------------------------------------------------------------------------------------------------
+		static unsigned int spread(unsigned int i_local) { return (i_local&1)|((i_local&2)<<2)|((i_local&4)<<4); }
 
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
@@ -153,10 +367,28 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		unsigned int m_dimension_z;
 		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief How the owned samples are ordered
+		//----------------------------------------------------------------------------------------------------------------------
+		layout_type m_layout;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of tiles in each direction (tiled layout)
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_tiles[3];
+		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief The data as a 1D array
 		//----------------------------------------------------------------------------------------------------------------------
 		scalar_field m_data;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The viewed samples, 0 when the grid owns them
+		//----------------------------------------------------------------------------------------------------------------------
+		const float* m_view;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Keeps the viewed samples alive
+		//----------------------------------------------------------------------------------------------------------------------
+		std::shared_ptr<const void> m_owner;
 	};
 }
 
+#include <sdf/discretization/grid.inl>
+
 #endif // SDF_DISCRETIZATION_GRID_INCLUDED
@@ -0,0 +1,70 @@
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename Value>
+sdf::grid::sample_iterator<Value>::sample_iterator(Value* i_samples, const grid& i_grid, unsigned int i_index) :
+	m_samples(i_samples),
+	m_grid(&i_grid),
+	m_index(i_index),
+	m_end(i_grid.storage_size())
+{
+	locate();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename Value>
+sdf::grid::sample_iterator<Value>& sdf::grid::sample_iterator<Value>::operator++()
+{
+	m_index++;
+	if (m_grid->m_view || m_grid->m_layout==linear_layout)
+	{
+		// X first, no padding
+		if (++m_position[0]==m_grid->m_dimension_x)
+		{
+			m_position[0] = 0;
+			if (++m_position[1]==m_grid->m_dimension_y)
+			{
+				m_position[1] = 0;
+				m_position[2]++;
+			}
+		}
+	}
+	else
+	{
+		locate();
+	}
+	return *this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename Value>
+void sdf::grid::sample_iterator<Value>::locate()
+{
+	const grid& samples = *m_grid;
+	if (samples.m_view || samples.m_layout==linear_layout)
+	{
+		const unsigned int slice = samples.m_dimension_x*samples.m_dimension_y;
+		m_position[0] = slice ? m_index%samples.m_dimension_x : 0;
+		m_position[1] = slice ? (m_index/samples.m_dimension_x)%samples.m_dimension_y : 0;
+		m_position[2] = slice ? m_index/slice : 0;
+		return;
+	}
+
+	const unsigned int tile_samples = tile_size*tile_size*tile_size;
+	for (;m_index<m_end;m_index++)
+	{
+		const unsigned int tile = m_index/tile_samples;
+		const unsigned int local = m_index%tile_samples;
+		const unsigned int tile_position[3] = {
+			tile%samples.m_tiles[0],
+			(tile/samples.m_tiles[0])%samples.m_tiles[1],
+			tile/(samples.m_tiles[0]*samples.m_tiles[1]) };
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			// Gather every third bit back
+			const unsigned int bits = local>>axis;
+			m_position[axis] = tile_position[axis]*tile_size+((bits&1)|((bits>>2)&2)|((bits>>4)&4));
+		}
+		if (m_position[0]<samples.m_dimension_x && m_position[1]<samples.m_dimension_y && m_position[2]<samples.m_dimension_z)
+			return;
+	}
+}
@@ -0,0 +1,171 @@
+#ifndef SDF_DISCRETIZATION_SPARSE_BRICKS_INCLUDED
+#define SDF_DISCRETIZATION_SPARSE_BRICKS_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <sdf/discretization/grid.hpp>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class sparse_bricks "include/sdf/discretization/sparse_bricks.hpp"
+	/// @brief A sampled field stored as bricks of brick_size^3 cells, only the bricks near the surface keep their samples
+	///			The samples of the other bricks are the trilinear interpolation of the brick corners, which are always kept.
+	///			A stored brick has (brick_size+1)^3 samples, its faces are shared with the neighbours so it can be used alone.
+	///			The last brick in each direction can be smaller when the number of cells is not a multiple of the brick size
+	//----------------------------------------------------------------------------------------------------------------------
+	class sparse_bricks
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Id of a brick which is not stored
+		//----------------------------------------------------------------------------------------------------------------------
+		static const unsigned int no_brick = 0xffffffff;
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Default constructor - empty
+		//----------------------------------------------------------------------------------------------------------------------
+		sparse_bricks();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Set up an empty structure, no brick stored and all the corners at 0
+		/// @param[in] i_nx Number of samples in X direction
+		/// @param[in] i_ny Number of samples in Y direction
+		/// @param[in] i_nz Number of samples in Z direction
+		/// @param[in] i_brick_size Number of cells along a brick
+		//----------------------------------------------------------------------------------------------------------------------
+		void initialize(unsigned int i_nx, unsigned int i_ny, unsigned int i_nz, unsigned int i_brick_size);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of bricks in a direction
+		/// @param[in] i_axis The direction
+		/// @return Number of bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int num_bricks(unsigned int i_axis) const { return m_num_bricks[i_axis]; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the samples covered by a brick in a direction
+		/// @param[in] i_axis The direction
+		/// @param[in] i_brick The brick coordinate in that direction
+		/// @param[out] o_first The first sample
+		/// @param[out] o_last The last sample (shared with the next brick)
+		//----------------------------------------------------------------------------------------------------------------------
+		void brick_range(unsigned int i_axis, unsigned int i_brick, unsigned int* o_first, unsigned int* o_last) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the sample at a brick corner in a direction
+		/// @param[in] i_axis The direction
+		/// @param[in] i_corner The brick corner coordinate in that direction
+		/// @return The sample index
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int corner_sample(unsigned int i_axis, unsigned int i_corner) const { return std::min(i_corner*m_brick_size,m_size[i_axis]-1); }
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get a brick corner value
+		/// @param[in] i Brick corner index in X
+		/// @param[in] j Brick corner index in Y
+		/// @param[in] k Brick corner index in Z
+		/// @return The value of the sample at the corner
+		//----------------------------------------------------------------------------------------------------------------------
+		float corner(unsigned int i, unsigned int j, unsigned int k) const { return m_corners(i,j,k); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Set a brick corner value
+		/// @param[in] i Brick corner index in X
+		/// @param[in] j Brick corner index in Y
+		/// @param[in] k Brick corner index in Z
+		/// @return A reference to the value of the sample at the corner
+		//----------------------------------------------------------------------------------------------------------------------
+		float& corner(unsigned int i, unsigned int j, unsigned int k) { return m_corners(i,j,k); }
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Store the samples of a brick
+		/// @param[in] i Brick index in X
+		/// @param[in] j Brick index in Y
+		/// @param[in] k Brick index in Z
+		/// @param[in] i_samples The samples of the brick, X first, (brick_size+1)^3 of them (unused past the last sample)
+		//----------------------------------------------------------------------------------------------------------------------
+		void set_brick(unsigned int i, unsigned int j, unsigned int k, const std::vector<float>& i_samples);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check if the samples of a brick are stored
+		/// @param[in] i Brick index in X
+		/// @param[in] j Brick index in Y
+		/// @param[in] k Brick index in Z
+		/// @return True if they are, false if the brick is interpolated from its corners
+		//----------------------------------------------------------------------------------------------------------------------
+		bool has_brick(unsigned int i, unsigned int j, unsigned int k) const { return m_bricks[brick_index(i,j,k)]!=no_brick; }
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the value of a sample
+		/// @param[in] i Index in X
+		/// @param[in] j Index in Y
+		/// @param[in] k Index in Z
+		/// @return The stored value, or the interpolation of the brick corners
+		//----------------------------------------------------------------------------------------------------------------------
+		float value(unsigned int i, unsigned int j, unsigned int k) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Expand to a dense grid
+		/// @param[out] o_grid The grid, resized to the number of samples
+		//----------------------------------------------------------------------------------------------------------------------
+		void to_grid(sdf::grid* o_grid) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of stored bricks
+		/// @return Number of stored bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int num_stored_bricks() const { return m_num_stored; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of cells along a brick
+		/// @return Brick size
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int brick_size() const { return m_brick_size; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the number of samples in a direction
+		/// @param[in] i_axis The direction
+		/// @return Number of samples
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int num_samples(unsigned int i_axis) const { return m_size[i_axis]; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the memory used by the structure
+		/// @return The number of bytes allocated
+		//----------------------------------------------------------------------------------------------------------------------
+		std::size_t memory_usage() const;
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the index of a brick in m_bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int brick_index(unsigned int i, unsigned int j, unsigned int k) const { return i+(j+k*num_bricks(1))*num_bricks(0); }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of samples per stored brick
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int brick_samples() const { return (m_brick_size+1)*(m_brick_size+1)*(m_brick_size+1); }
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of samples in each direction
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_size[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of bricks in each direction
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_num_bricks[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of cells along a brick
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_brick_size;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The samples at the corners of the bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		sdf::grid m_corners;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Per brick, the id of its samples in m_samples or no_brick
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<unsigned int> m_bricks;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The samples of the stored bricks, one after the other
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<float> m_samples;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of stored bricks
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_num_stored;
+	};
+}
+
+#endif /* SDF_DISCRETIZATION_SPARSE_BRICKS_INCLUDED */
@@ -0,0 +1,52 @@
+#ifndef SDF_DISTANCE_DISTANCE_TO_AABB_PACKET_INCLUDED
+#define SDF_DISTANCE_DISTANCE_TO_AABB_PACKET_INCLUDED
+
+#include <sdf/core/aabb.hpp>
+#include <sdf/core/config.hpp>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class distance_to_aabb_packet "include/sdf/distance/distance_to_aabb_packet.hpp"
+	/// @brief Distance to an AABB for a packet of 8 points at once (SSE, two halves of 4 lanes)
+	///			Same result as distance_to_aabb for each point
+	//----------------------------------------------------------------------------------------------------------------------
+	class distance_to_aabb_packet
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of points in a packet
+		//----------------------------------------------------------------------------------------------------------------------
+		static const unsigned int packet_size = 8;
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor with positions
+		/// @param[in] i_positions The 8 positions to compute distances from
+		//----------------------------------------------------------------------------------------------------------------------
+		distance_to_aabb_packet(const point3d i_positions[]);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the shortest squared distances to the box from the points
+		/// @param[in] i_box The box to test against
+		/// @param[in] i_best The current closest squared distance of each point
+		/// @param[out] o_sqdist The squared distance of each point
+		/// @return The mask of the points closer to the box than their best (bit i for point i)
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int operator()(const aabb& i_box, const float i_best[], float o_sqdist[]) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Compare squared distances to the current best ones
+		/// @param[in] i_sqdist The squared distances
+		/// @param[in] i_best The current closest squared distances
+		/// @return The mask of the points where i_sqdist<i_best
+		//----------------------------------------------------------------------------------------------------------------------
+		static unsigned int closer(const float i_sqdist[], const float i_best[]);
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The positions as lanes, one array per axis
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_position[3][packet_size];
+	};
+}
+
+#endif // SDF_DISTANCE_DISTANCE_TO_AABB_PACKET_INCLUDED
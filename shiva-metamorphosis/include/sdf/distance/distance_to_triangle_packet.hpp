@@ -0,0 +1,56 @@
+#ifndef SDF_DISTANCE_TO_TRIANGLE_PACKET_INCLUDED
+#define SDF_DISTANCE_TO_TRIANGLE_PACKET_INCLUDED
+
+#include <sdf/core/types.hpp>
+#include <sdf/core/config.hpp>
+#include <sdf/distance/distance_record.hpp>
+#include <sdf/distance/triangle_store.hpp>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class distance_to_triangle_packet "include/sdf/distance/distance_to_triangle_packet.hpp"
+	/// @brief Distance from 8 points to one triangle of a triangle_store at once
+	///			Every Voronoi region is computed for all the lanes and the right one is selected per lane (SSE, two halves
+	///			of 4 lanes). The records are the same as the ones triangle_store gives for a single point
+	//----------------------------------------------------------------------------------------------------------------------
+	class distance_to_triangle_packet
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of points in a packet
+		//----------------------------------------------------------------------------------------------------------------------
+		static const unsigned int packet_size = 8;
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor
+		/// @param[in] i_positions The 8 reference positions to measure distances to
+		//----------------------------------------------------------------------------------------------------------------------
+		distance_to_triangle_packet(const point3d i_positions[]);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the closest records of the active points with a triangle
+		/// @param[in] i_triangles The precomputed triangles
+		/// @param[in] i_index The triangle (index in the face list of the store)
+		/// @param[in] i_active The mask of points to update (bit i for point i)
+		/// @param[out] io_best The closest squared distance of each point
+		/// @param[out] io_closest_record The closest record of each point, replaced where the triangle is closer
+		/// @param[out] io_face_id The face id of each closest record
+		/// @return The mask of the points which got closer
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int operator()(
+			const triangle_store& i_triangles,
+			index_type i_index,
+			unsigned int i_active,
+			float io_best[],
+			distance_record io_closest_record[],
+			unsigned int io_face_id[]) const;
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The reference positions as lanes, one array per axis
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_position[3][packet_size];
+	};
+}
+
+#endif /* SDF_DISTANCE_TO_TRIANGLE_PACKET_INCLUDED */
@@ -0,0 +1,261 @@
+#ifndef SDF_DISTANCE_TRIANGLE_KERNEL_INCLUDED
+#define SDF_DISTANCE_TRIANGLE_KERNEL_INCLUDED
+
+#include <sdf/core/config.hpp>
+#include <sdf/core/feature_type.hpp>
+#include <sdf/distance/triangle_store.hpp>
+
+#ifdef SDF_USE_SSE
+#include <emmintrin.h>
+#endif
+
+// The closest point on a precomputed triangle, shared by triangle_store (1 point, 4 triangles) and
+// distance_to_triangle_packet (8 points, 1 triangle) so both give the same records.
+// Same Voronoi regions as distance_to_triangle::barycentric_method (Real-Time Collision Detection, Christer Ericson)
+// Only meant to be included by the .cpp files.
+
+namespace sdf
+{
+	namespace detail
+	{
+#ifdef SDF_USE_SSE
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief 4 triangles in SSE registers, [axis] each
+		//----------------------------------------------------------------------------------------------------------------------
+		struct triangle_lanes
+		{
+			__m128 m_a[3];
+			__m128 m_b[3];
+			__m128 m_c[3];
+			__m128 m_ab[3];
+			__m128 m_ac[3];
+			__m128 m_bc[3];
+			__m128 m_normal[3];
+			__m128 m_inv_length[3];
+		};
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The 4 triangles of a block
+		//----------------------------------------------------------------------------------------------------------------------
+		inline void load_lanes(const triangle_store::block& i_block, triangle_lanes* o_lanes)
+		{
+			for (unsigned int axis=0;axis<3;axis++)
+			{
+				o_lanes->m_a[axis] = _mm_loadu_ps(i_block.m_a[axis]);
+				o_lanes->m_b[axis] = _mm_loadu_ps(i_block.m_b[axis]);
+				o_lanes->m_c[axis] = _mm_loadu_ps(i_block.m_c[axis]);
+				o_lanes->m_ab[axis] = _mm_loadu_ps(i_block.m_ab[axis]);
+				o_lanes->m_ac[axis] = _mm_loadu_ps(i_block.m_ac[axis]);
+				o_lanes->m_bc[axis] = _mm_loadu_ps(i_block.m_bc[axis]);
+				o_lanes->m_normal[axis] = _mm_loadu_ps(i_block.m_normal[axis]);
+				o_lanes->m_inv_length[axis] = _mm_loadu_ps(i_block.m_inv_length[axis]);
+			}
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief One triangle of a block in all the lanes
+		//----------------------------------------------------------------------------------------------------------------------
+		inline void broadcast_lane(const triangle_store::block& i_block, unsigned int i_lane, triangle_lanes* o_lanes)
+		{
+			for (unsigned int axis=0;axis<3;axis++)
+			{
+				o_lanes->m_a[axis] = _mm_set1_ps(i_block.m_a[axis][i_lane]);
+				o_lanes->m_b[axis] = _mm_set1_ps(i_block.m_b[axis][i_lane]);
+				o_lanes->m_c[axis] = _mm_set1_ps(i_block.m_c[axis][i_lane]);
+				o_lanes->m_ab[axis] = _mm_set1_ps(i_block.m_ab[axis][i_lane]);
+				o_lanes->m_ac[axis] = _mm_set1_ps(i_block.m_ac[axis][i_lane]);
+				o_lanes->m_bc[axis] = _mm_set1_ps(i_block.m_bc[axis][i_lane]);
+				o_lanes->m_normal[axis] = _mm_set1_ps(i_block.m_normal[axis][i_lane]);
+				o_lanes->m_inv_length[axis] = _mm_set1_ps(i_block.m_inv_length[axis][i_lane]);
+			}
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Dot product of 4 vectors with 4 vectors, summed in the same order as point3d::dot
+		//----------------------------------------------------------------------------------------------------------------------
+		inline __m128 dot_lanes(const __m128 i_u[3], const __m128 i_v[3])
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(i_u[0],i_v[0]),_mm_mul_ps(i_u[1],i_v[1])),_mm_mul_ps(i_u[2],i_v[2]));
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Per lane i_mask ? i_true : i_false
+		//----------------------------------------------------------------------------------------------------------------------
+		inline __m128 select_lanes(__m128 i_mask, __m128 i_true, __m128 i_false)
+		{
+			return _mm_or_ps(_mm_and_ps(i_mask,i_true),_mm_andnot_ps(i_mask,i_false));
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Per lane i_mask ? i_true : i_false, integer lanes
+		//----------------------------------------------------------------------------------------------------------------------
+		inline __m128i select_lanes(__m128 i_mask, __m128i i_true, __m128i i_false)
+		{
+			const __m128i mask = _mm_castps_si128(i_mask);
+			return _mm_or_si128(_mm_and_si128(mask,i_true),_mm_andnot_si128(mask,i_false));
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Closest points from 4 points to 4 triangles (lane i against lane i)
+		/// @param[in] i_position The points
+		/// @param[in] i_triangles The triangles
+		/// @param[out] o_closest The closest points
+		/// @param[out] o_feature The feature_type of the closest points
+		/// @return The squared distances
+		//----------------------------------------------------------------------------------------------------------------------
+		inline __m128 closest_on_triangle(const __m128 i_position[3], const triangle_lanes& i_triangles, __m128 o_closest[3], __m128i* o_feature)
+		{
+			const triangle_lanes& t = i_triangles;
+			const __m128 zero = _mm_setzero_ps();
+			__m128 ap[3], bp[3], cp[3];
+			for (unsigned int axis=0;axis<3;axis++)
+			{
+				ap[axis] = _mm_sub_ps(i_position[axis],t.m_a[axis]);
+				bp[axis] = _mm_sub_ps(i_position[axis],t.m_b[axis]);
+				cp[axis] = _mm_sub_ps(i_position[axis],t.m_c[axis]);
+			}
+			const __m128 d1 = dot_lanes(t.m_ab,ap);
+			const __m128 d2 = dot_lanes(t.m_ac,ap);
+			const __m128 d3 = dot_lanes(t.m_ab,bp);
+			const __m128 d4 = dot_lanes(t.m_ac,bp);
+			const __m128 d5 = dot_lanes(t.m_ab,cp);
+			const __m128 d6 = dot_lanes(t.m_ac,cp);
+			const __m128 vc = _mm_sub_ps(_mm_mul_ps(d1,d4),_mm_mul_ps(d3,d2));
+			const __m128 vb = _mm_sub_ps(_mm_mul_ps(d5,d2),_mm_mul_ps(d1,d6));
+			const __m128 va = _mm_sub_ps(_mm_mul_ps(d3,d6),_mm_mul_ps(d5,d4));
+
+			// Face region first (projection on the plane), then each region overrides the previous ones,
+			// in the reverse order of the scalar tests
+			const __m128 height = dot_lanes(t.m_normal,ap);
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = _mm_sub_ps(i_position[axis],_mm_mul_ps(t.m_normal[axis],height));
+			__m128i feature = _mm_set1_epi32(face);
+
+			// Edge bc - d4-d3 is bc.bp
+			const __m128 d43 = _mm_sub_ps(d4,d3);
+			const __m128 inbc = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(va,zero),_mm_cmpge_ps(d43,zero)),_mm_cmpge_ps(_mm_sub_ps(d5,d6),zero));
+			const __m128 bcw = _mm_mul_ps(d43,t.m_inv_length[2]);
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = select_lanes(inbc,_mm_add_ps(t.m_b[axis],_mm_mul_ps(t.m_bc[axis],bcw)),o_closest[axis]);
+			feature = select_lanes(inbc,_mm_set1_epi32(edge_bc),feature);
+
+			// Edge ca
+			const __m128 inca = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(vb,zero),_mm_cmpge_ps(d2,zero)),_mm_cmple_ps(d6,zero));
+			const __m128 caw = _mm_mul_ps(d2,t.m_inv_length[1]);
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = select_lanes(inca,_mm_add_ps(t.m_a[axis],_mm_mul_ps(t.m_ac[axis],caw)),o_closest[axis]);
+			feature = select_lanes(inca,_mm_set1_epi32(edge_ca),feature);
+
+			// Vertex c
+			const __m128 inc = _mm_and_ps(_mm_cmpge_ps(d6,zero),_mm_cmple_ps(d5,d6));
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = select_lanes(inc,t.m_c[axis],o_closest[axis]);
+			feature = select_lanes(inc,_mm_set1_epi32(vertex_c),feature);
+
+			// Edge ab
+			const __m128 inab = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(vc,zero),_mm_cmpge_ps(d1,zero)),_mm_cmple_ps(d3,zero));
+			const __m128 abv = _mm_mul_ps(d1,t.m_inv_length[0]);
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = select_lanes(inab,_mm_add_ps(t.m_a[axis],_mm_mul_ps(t.m_ab[axis],abv)),o_closest[axis]);
+			feature = select_lanes(inab,_mm_set1_epi32(edge_ab),feature);
+
+			// Vertex b
+			const __m128 inb = _mm_and_ps(_mm_cmpge_ps(d3,zero),_mm_cmple_ps(d4,d3));
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = select_lanes(inb,t.m_b[axis],o_closest[axis]);
+			feature = select_lanes(inb,_mm_set1_epi32(vertex_b),feature);
+
+			// Vertex a
+			const __m128 ina = _mm_and_ps(_mm_cmple_ps(d1,zero),_mm_cmple_ps(d2,zero));
+			for (unsigned int axis=0;axis<3;axis++)
+				o_closest[axis] = select_lanes(ina,t.m_a[axis],o_closest[axis]);
+			feature = select_lanes(ina,_mm_set1_epi32(vertex_a),feature);
+
+			*o_feature = feature;
+			__m128 difference[3];
+			for (unsigned int axis=0;axis<3;axis++)
+				difference[axis] = _mm_sub_ps(i_position[axis],o_closest[axis]);
+			return dot_lanes(difference,difference);
+		}
+#else
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Dot product of a point with a lane of a block
+		//----------------------------------------------------------------------------------------------------------------------
+		inline float dot_lane(const float i_u[3][triangle_store::width], unsigned int i_lane, const point3d& i_v)
+		{
+			return i_u[0][i_lane]*i_v[0]+i_u[1][i_lane]*i_v[1]+i_u[2][i_lane]*i_v[2];
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Point of a lane of a block
+		//----------------------------------------------------------------------------------------------------------------------
+		inline point3d lane_point(const float i_u[3][triangle_store::width], unsigned int i_lane)
+		{
+			return point3d(i_u[0][i_lane],i_u[1][i_lane],i_u[2][i_lane]);
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Closest point from a point to one triangle of a block, scalar version of the SSE kernel
+		/// @param[in] i_position The point
+		/// @param[in] i_block The block
+		/// @param[in] i_lane The triangle in the block
+		/// @param[out] o_closest The closest point
+		/// @param[out] o_feature The feature_type of the closest point
+		/// @return The squared distance
+		//----------------------------------------------------------------------------------------------------------------------
+		inline float closest_on_triangle(const point3d& i_position, const triangle_store::block& i_block, unsigned int i_lane, point3d* o_closest, feature_type* o_feature)
+		{
+			const triangle_store::block& t = i_block;
+			const unsigned int l = i_lane;
+			const vector3d ap = i_position-lane_point(t.m_a,l);
+			const vector3d bp = i_position-lane_point(t.m_b,l);
+			const vector3d cp = i_position-lane_point(t.m_c,l);
+			const float d1 = dot_lane(t.m_ab,l,ap);
+			const float d2 = dot_lane(t.m_ac,l,ap);
+			const float d3 = dot_lane(t.m_ab,l,bp);
+			const float d4 = dot_lane(t.m_ac,l,bp);
+			const float d5 = dot_lane(t.m_ab,l,cp);
+			const float d6 = dot_lane(t.m_ac,l,cp);
+
+			if (d1<=0.f && d2<=0.f)
+			{
+				*o_feature = vertex_a;
+				*o_closest = lane_point(t.m_a,l);
+			}
+			else if (d3>=0.f && d4<=d3)
+			{
+				*o_feature = vertex_b;
+				*o_closest = lane_point(t.m_b,l);
+			}
+			else if (d1*d4-d3*d2<=0.f && d1>=0.f && d3<=0.f)
+			{
+				*o_feature = edge_ab;
+				*o_closest = lane_point(t.m_a,l)+lane_point(t.m_ab,l)*(d1*t.m_inv_length[0][l]);
+			}
+			else if (d6>=0.f && d5<=d6)
+			{
+				*o_feature = vertex_c;
+				*o_closest = lane_point(t.m_c,l);
+			}
+			else if (d5*d2-d1*d6<=0.f && d2>=0.f && d6<=0.f)
+			{
+				*o_feature = edge_ca;
+				*o_closest = lane_point(t.m_a,l)+lane_point(t.m_ac,l)*(d2*t.m_inv_length[1][l]);
+			}
+			else if (d3*d6-d5*d4<=0.f && (d4-d3)>=0.f && (d5-d6)>=0.f)
+			{
+				*o_feature = edge_bc;
+				*o_closest = lane_point(t.m_b,l)+lane_point(t.m_bc,l)*((d4-d3)*t.m_inv_length[2][l]);
+			}
+			else
+			{
+				*o_feature = face;
+				*o_closest = i_position-lane_point(t.m_normal,l)*dot_lane(t.m_normal,l,ap);
+			}
+			return o_closest->distance_squared_to(i_position);
+		}
+#endif
+	}
+}
+
+#endif /* SDF_DISTANCE_TRIANGLE_KERNEL_INCLUDED */
@@ -0,0 +1,130 @@
+#ifndef SDF_DISTANCE_TRIANGLE_STORE_INCLUDED
+#define SDF_DISTANCE_TRIANGLE_STORE_INCLUDED
+
+#include <vector>
+#include <sdf/core/types.hpp>
+#include <sdf/core/mesh.hpp>
+#include <sdf/core/config.hpp>
+#include <sdf/distance/distance_record.hpp>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class triangle_store "include/sdf/distance/triangle_store.hpp"
+	/// @brief The triangles of a mesh with everything the distance test needs already computed (vertices, edges, unit
+	///			normal, inverse squared edge lengths), stored as blocks of 4 triangles in lanes (structure of arrays)
+	///			One point is tested against the 4 triangles of a block at once with SSE. The triangles are stored in the order
+	///			of the face list given to build, so a range of that list is a range of the store. Ranges can be made to start
+	///			on a new block, the lanes left at the end of the previous block are padding.
+	///			Compared to distance_to_triangle the face and edge regions do not divide anymore: the face distance is the
+	///			distance to the plane, and the edge parameters use the inverse squared lengths
+	//----------------------------------------------------------------------------------------------------------------------
+	class triangle_store
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of triangles per block
+		//----------------------------------------------------------------------------------------------------------------------
+		static const unsigned int width = 4;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief 4 triangles as lanes, each array is [axis][triangle]
+		///			Lanes past the end of the store have NaN vertices so they never get closer
+		//----------------------------------------------------------------------------------------------------------------------
+		struct block
+		{
+			float m_a[3][width];
+			float m_b[3][width];
+			float m_c[3][width];
+			float m_ab[3][width];
+			float m_ac[3][width];
+			float m_bc[3][width];
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Unit normal, NaN for degenerated triangles so their face region never wins
+			//----------------------------------------------------------------------------------------------------------------------
+			float m_normal[3][width];
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief 1/|ab|^2, 1/|ac|^2 and 1/|bc|^2
+			//----------------------------------------------------------------------------------------------------------------------
+			float m_inv_length[3][width];
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The face id of each triangle
+			//----------------------------------------------------------------------------------------------------------------------
+			index_type m_face[width];
+		};
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The blocks in one array
+		//----------------------------------------------------------------------------------------------------------------------
+		typedef std::vector<block> block_array;
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Default constructor - empty store
+		//----------------------------------------------------------------------------------------------------------------------
+		triangle_store();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Store all the faces of a mesh, in order
+		/// @param[in] i_mesh The mesh
+		//----------------------------------------------------------------------------------------------------------------------
+		void build(const mesh& i_mesh);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Store a list of faces of a mesh, in the order of the list
+		/// @param[in] i_mesh The mesh
+		/// @param[in] i_faces The face ids
+		//----------------------------------------------------------------------------------------------------------------------
+		void build(const mesh& i_mesh, const std::vector<index_type>& i_faces);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Store a list of faces of a mesh, each range of the list starting on a new block (the leaves of a tree)
+		///			so a range of up to 4 triangles is tested in one go
+		/// @param[in] i_mesh The mesh
+		/// @param[in] i_faces The face ids
+		/// @param[in] i_ranges The first index in the list of each range
+		//----------------------------------------------------------------------------------------------------------------------
+		void build(const mesh& i_mesh, const std::vector<index_type>& i_faces, const std::vector<index_type>& i_ranges);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the triangles after the vertices of the mesh moved, the faces keep their slots (in parallel)
+		/// @param[in] i_mesh The mesh
+		/// @param[in] i_faces The face ids, the same list as given to build
+		//----------------------------------------------------------------------------------------------------------------------
+		void refit(const mesh& i_mesh, const std::vector<index_type>& i_faces);
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the closest record of a point with a range of triangles
+		/// @param[in] i_position The position to look from
+		/// @param[in] i_begin The first triangle of the range (index in the face list given to build)
+		/// @param[in] i_end The end of the range
+		/// @param[out] io_closest_record The current closest record, replaced by a closer one
+		/// @param[out] io_face_id The face id of the closest record
+		//----------------------------------------------------------------------------------------------------------------------
+		void operator()(
+			const point3d& i_position,
+			index_type i_begin,
+			index_type i_end,
+			distance_record* io_closest_record,
+			unsigned int* io_face_id) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Where a triangle of the face list is stored (block slot/width, lane slot%width)
+		/// @param[in] i_index Index in the face list given to build
+		/// @return The slot
+		//----------------------------------------------------------------------------------------------------------------------
+		index_type slot(index_type i_index) const { return m_slots.empty() ? i_index : m_slots[i_index]; }
+
+		const block& block_at(index_type i) const { return m_blocks[i]; }
+		index_type size() const { return m_size; }
+		std::size_t memory_usage() const;
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The blocks
+		//----------------------------------------------------------------------------------------------------------------------
+		block_array m_blocks;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Slot of each triangle of the face list, empty when the list is not padded
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<index_type> m_slots;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of triangles
+		//----------------------------------------------------------------------------------------------------------------------
+		index_type m_size;
+	};
+}
+
+#endif /* SDF_DISTANCE_TRIANGLE_STORE_INCLUDED */
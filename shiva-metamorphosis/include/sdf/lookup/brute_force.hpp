@@ -4,6 +4,7 @@
 #include <sdf/core/types.hpp>
 #include <sdf/core/mesh.hpp>
 #include <sdf/distance/distance_to_triangle.hpp>
+#include <sdf/distance/triangle_store.hpp>
 
 namespace sdf
 {
@@ -35,11 +36,17 @@ namespace sdf
 		/// @param[out] o_face_id The face id will be filled in there
 		//----------------------------------------------------------------------------------------------------------------------
 		void operator()(const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
+
+		std::size_t memory_usage() const { return m_triangles.memory_usage(); }
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief A pointer to the mesh - pointer is only valid after initialize has been called with appropriate mesh
 		//----------------------------------------------------------------------------------------------------------------------
 		const mesh* m_mesh;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief All the faces of the mesh, precomputed
+		//----------------------------------------------------------------------------------------------------------------------
+		triangle_store m_triangles;
 	};
 }
 
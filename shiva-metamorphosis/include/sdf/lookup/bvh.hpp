@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <sdf/lookup/bvh_branch.hpp>
+#include <sdf/distance/triangle_store.hpp>
 
 namespace sdf
 {
@@ -66,6 +67,18 @@ namespace sdf
 				const mesh& i_mesh,
 				const settings& i_settings);
 			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Update the boxes after the vertices of the mesh moved, the faces and the topology of the tree are kept.
+			///			The leaves are refitted in parallel, then the nodes bottom-up (children are always after their parent)
+			/// @param[in] i_mesh The mesh with the new vertices (same faces as the one the tree was built on)
+			//----------------------------------------------------------------------------------------------------------------------
+			void refit(const mesh& i_mesh);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Surface area heuristic cost of the tree, relative to the area of the root.
+			///			A refitted tree gets more expensive as the mesh deforms, compare it to the cost after the build
+			/// @return The expected cost of a lookup, in node visits and blocks of triangle tests
+			//----------------------------------------------------------------------------------------------------------------------
+			float sah_cost() const;
+			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Shortest distance to mesh lookup
 			/// @param[in] i_mesh The original mesh
 			/// @param[in] i_position THe position to look up from
@@ -120,10 +133,32 @@ namespace sdf
 				unsigned int i_depth,
 				bvh_branch::child_index* o_childindex);
 
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The triangles in the order of the polygon list, so a leaf is a range of it
+			/// @return The precomputed triangles
+			//----------------------------------------------------------------------------------------------------------------------
+			const triangle_store& triangles() const { return m_triangles; }
+
 			const m_tree_pool& nodes() const { return m_branches; }
 			const polygon_array polygons() const { return m_polylist; }
 			unsigned int num_polygons() const { return static_cast<unsigned int>(m_polylist.size()); }
 			std::size_t memory_usage() const;
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Build the tree with the binned surface area heuristic
+			///			The polygon list is partitioned in place, the top levels are split first and the subtrees below are
+			///			built in parallel, each in its own branch array, then moved to the tree
+			/// @param[in] i_mesh The original mesh
+			/// @param[in] i_settings The tree settings
+			//----------------------------------------------------------------------------------------------------------------------
+			void sah_build(
+				const mesh& i_mesh,
+				const settings& i_settings);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Precompute the triangles of the polygon list, each leaf starting on a new block
+			/// @param[in] i_mesh The original mesh
+			//----------------------------------------------------------------------------------------------------------------------
+			void build_triangles(const mesh& i_mesh);
 		private :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief The raw data - a pool of indices used by the offset grid
@@ -133,6 +168,10 @@ namespace sdf
 			/// @brief The tree pool - all the bvh branches in one array
 			//----------------------------------------------------------------------------------------------------------------------
 			m_tree_pool m_branches;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The triangles of the polygon list, precomputed for the leaf tests
+			//----------------------------------------------------------------------------------------------------------------------
+			triangle_store m_triangles;
 		};
 	}
 }
@@ -34,9 +34,23 @@ namespace sdf
 		/// @param[out] o_face_id The face id will be filled in there
 		//----------------------------------------------------------------------------------------------------------------------
 		void operator()(const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
-
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the shortest distance to the mesh for a packet of 8 points, traversed together when they are coherent
+		/// @param[in] i_positions The 8 points
+		/// @param[out] o_closest_record The 8 records
+		/// @param[out] o_face_id The 8 face ids
+		//----------------------------------------------------------------------------------------------------------------------
 		void operator()(const point3d i_positions[], distance_record o_closest_record[], unsigned int o_face_id[]) const;
 
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the tree after the vertices of the mesh moved (the faces must not change).
+		///			The boxes are refitted, a deformed mesh can make them overlap a lot: the tree is built again from scratch
+		///			when its surface area heuristic cost grew past a ratio of its cost after the build
+		/// @param[in] i_rebuild_ratio Rebuild when cost > ratio * build cost, 0 never rebuilds (1.5 is a reasonable value)
+		/// @return True if the tree was built again
+		//----------------------------------------------------------------------------------------------------------------------
+		bool refit(float i_rebuild_ratio = 0.f);
+
 		const detail::bvh& bvh() const { return m_tree; }
 		std::size_t memory_usage() const { return m_tree.memory_usage(); }
 	private :
@@ -48,6 +62,14 @@ namespace sdf
 		/// @brief A BVH tree to accelerate lookups
 		//----------------------------------------------------------------------------------------------------------------------
 		detail::bvh m_tree;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The settings the tree was built with, to build it again
+		//----------------------------------------------------------------------------------------------------------------------
+		detail::settings m_settings;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Surface area heuristic cost of the tree after its last build
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_build_cost;
 	};
 }
 
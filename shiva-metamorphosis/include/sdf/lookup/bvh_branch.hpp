@@ -69,6 +69,11 @@ namespace sdf
 			//----------------------------------------------------------------------------------------------------------------------
 			index_type num_polygons() const;
 			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the offset of the first polygon in the tree's polygon list
+			/// @return Offset of the polygons of this branch
+			//----------------------------------------------------------------------------------------------------------------------
+			index_type offset() const { return m_offset; }
+			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Decide whether this branch should be a leaf or a node
 			/// @param[in] i_depth Current depth of the tree
 			/// @param[in] i_polygons Polygon list of the node
@@ -92,6 +97,19 @@ namespace sdf
 			/// @param[in] i_depth Current tree depth (default to 0, root build)
 			//----------------------------------------------------------------------------------------------------------------------
 			void build(bvh& io_tree, const mesh& i_mesh, const settings& i_settings, const polygon_array& i_polygons, unsigned int i_depth = 0);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Make this branch a leaf (used by the builders working on the tree's polygon list directly)
+			/// @param[in] i_box The branch's box
+			/// @param[in] i_offset Offset of the first polygon in the tree's polygon list
+			/// @param[in] i_size Number of polygons
+			//----------------------------------------------------------------------------------------------------------------------
+			void set_leaf(const aabb& i_box, index_type i_offset, index_type i_size);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Make this branch a node (used by the builders working on the tree's polygon list directly)
+			/// @param[in] i_box The branch's box
+			/// @param[in] i_children Index of the first child, the second one is i_children+1
+			//----------------------------------------------------------------------------------------------------------------------
+			void set_node(const aabb& i_box, child_index i_children);
 
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Shortest distance to the mesh lookup
@@ -102,6 +120,18 @@ namespace sdf
 			/// @param[out] o_face_id The face id of the closest distance record
 			//----------------------------------------------------------------------------------------------------------------------
 			inline void operator()(const bvh& i_tree, const mesh& i_mesh, const point3d& i_position, distance_record* io_closest_record, unsigned int* o_face_id) const { recursive_traversal(i_tree,i_mesh,i_position,io_closest_record,o_face_id); };
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Shortest distance to the mesh lookup for a packet of 8 coherent points (a 2x2x2 block of a grid for example)
+			///			The first point is looked up alone. When the points are far apart compared to its distance, the packet is
+			///			incoherent and the other points are looked up alone too. Otherwise they share one node stack, start bounded
+			///			by the distance of the first point and only keep the lanes which can still get closer, and fall back to
+			///			recursive_traversal per lane when only a few lanes are left
+			/// @param[in] i_tree BVH tree
+			/// @param[in] i_mesh Mesh to lookup, this will be used for vertices - it is important that the mesh is exactly the same as the one use in build
+			/// @param[in] i_position The 8 positions to look from
+			/// @param[out] o_closest_record The current distance records, updated if closer records are found
+			/// @param[out] o_face_id The face ids of the closest distance records
+			//----------------------------------------------------------------------------------------------------------------------
 			void operator()(const bvh& i_tree, const mesh& i_mesh,	const point3d i_position[], distance_record o_closest_record[],	unsigned int o_face_id[]) const;
 
 			bool operator()(const bvh& i_tree, const mesh& i_mesh, const point3d i_triangle[3], const aabb& i_box, const index_type i_ignore[],	index_type* o_face) const;
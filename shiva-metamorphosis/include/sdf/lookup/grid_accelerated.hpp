@@ -41,6 +41,7 @@ namespace sdf
 		void operator()(const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
 
                 const detail::regular_grid& grid() const { return m_grid; }
+		std::size_t memory_usage() const { return m_grid.memory_usage(); }
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief A pointer to the mesh - pointer is only valid after initialize has been called with appropriate mesh
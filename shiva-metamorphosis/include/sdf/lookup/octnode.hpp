@@ -86,15 +86,13 @@ namespace sdf
 			child_index child(unsigned int i) const;
 
 			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Build this node (recursively)
-			/// @param io_octree The tree it belongs to. It is io because the tree may allocate new nodes (and invalidate this instance by deleting this memory)
-			/// @param[in] i_mesh The original mesh
+			/// @brief Set the box and the polygons of this node (used by the octree build)
+			///			A leaf owns all the polygons of its box, a node only the ones overlapping several children
 			/// @param[in] i_box The bounding box of this node
-			/// @param[in] i_polygons The polygon list this node has to handle
-			/// @param[in] i_depth Current depth of recursion, starts at 0, finishes at max_depth (from heuristic settings)
-			/// @param[in] i_settings The heuristic settings containing the max depth, the optimum number of polygons per leaf etc...
+			/// @param[in] i_offset Offset of the polygons in the tree's polygon list
+			/// @param[in] i_size Number of polygons
 			//----------------------------------------------------------------------------------------------------------------------
-			void build(octree* io_octree, const mesh& i_mesh, const aabb& i_box, const polygon_array& i_polygons, unsigned int i_depth, const settings& i_settings);
+			void set_polygons(const aabb& i_box, index_type i_offset, index_type i_size);
 
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Shortest distance to the mesh lookup
@@ -134,37 +132,6 @@ namespace sdf
 			/// @return End polygon index (end marker, not included)
 			//----------------------------------------------------------------------------------------------------------------------
 			index_type polygon_end() const;
-		private :
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Decide if this node should become a leaf - Called by the build function
-			/// @param[in] i_depth Current build depth
-			/// @param[in] i_polygon The polygon list of this node
-			/// @param[in] i_settings The heuristics of this tree
-			/// @return True if it should stop the recursion, false otherwise
-			//----------------------------------------------------------------------------------------------------------------------
-			bool has_reached_leaf(unsigned int i_depth, const polygon_array& i_polygon, const settings& i_settings) const;
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Build the box from a polygon list - Called by the build function
-			/// @param[in] i_mesh The original mesh
-			/// @param[in] i_polygon The polygon list
-			/// @param[out] o_box The box containing all the polygons
-			//----------------------------------------------------------------------------------------------------------------------
-			void build_box(const mesh& i_mesh, const polygon_array& i_polygon, aabb* o_box) const;
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Set this node as a leaf - Called by the build function
-			/// @param io_octree The tree it belongs to. 
-			/// @param[in] i_polygon The polygon list of this node
-			//----------------------------------------------------------------------------------------------------------------------
-			void set_leaf(octree* io_tree, const polygon_array& i_polygon);
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Set this node as a node (with children) - Called by the build function
-			/// @param io_octree The tree it belongs to. It is io because the tree may allocate new nodes (and invalidate this instance by deleting this memory)
-			/// @param[in] i_mesh The original mesh
-			/// @param[in] i_polygon The polygon list of this node
-			/// @param[in] i_depth Current build depth
-			/// @param[in] i_settings The heuristics of this tree
-			//----------------------------------------------------------------------------------------------------------------------
-			void set_node(octree* io_tree, const mesh& i_mesh, const polygon_array& i_polygons,	unsigned int i_depth, const settings& i_settings);
 		private :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief The bounding box of this node
@@ -31,23 +31,11 @@ namespace sdf
 			/// @brief A polygon array contains the list of face indices (so to get the vertex indices you need to use index*3+0 for the first index)
 			//----------------------------------------------------------------------------------------------------------------------
 			typedef std::vector<index_type> polygon_array;
-		public :
 			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Build the two children
-			/// @param[in] i_mesh The original mesh
-			/// @param[in] i_settings The tree settings
-			/// @param[in] i_buckets An array of 8 arrays of polygons
-			/// @param[in] i_depth Depth of those children
-			/// @param[out] o_childindex First child index , the second is first+1
-			//----------------------------------------------------------------------------------------------------------------------
-			void build_children(
-				const mesh& i_mesh,
-				const settings& i_settings,
-				const polygon_array i_buckets[],
-				const aabb i_boxes[],
-				unsigned int i_depth,
-				child_index* o_childindex);
-
+			/// @brief The typedef of the node array
+			//----------------------------------------------------------------------------------------------------------------------
+			typedef std::vector<octnode> node_pool;
+		public :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Get a node
 			/// @param[in] i The node index
@@ -75,9 +63,16 @@ namespace sdf
 			/// @return A constant reference to the polygon list
 			//----------------------------------------------------------------------------------------------------------------------
 			const polygon_array& array() const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the memory used by the nodes and the polygon list
+			/// @return The number of bytes allocated
+			//----------------------------------------------------------------------------------------------------------------------
+			std::size_t memory_usage() const;
 
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Build the tree from a mesh
+			///			The polygon list is partitioned in place (a node's own polygons first, then its 8 children), the top
+			///			levels are split first and the subtrees below are built in parallel, each in its own node array
 			/// @param[in] i_mesh The mesh
 			/// @param[in] i_settings The heurisitic settings 
 			//----------------------------------------------------------------------------------------------------------------------
@@ -91,16 +86,6 @@ namespace sdf
 			/// @param[out] o_face_id The face id of the closest face
 			//----------------------------------------------------------------------------------------------------------------------
 			void operator()(const mesh& i_mesh, const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Append a list of polygons to the "super" list
-			/// @param[in] i_polygons The polygons to add
-			/// @param[out] o_offset The offset of the polygons added in the super array
-			/// @param[out] o_num_elements the number of elements added (i_polygons.size())
-			//----------------------------------------------------------------------------------------------------------------------
-			void append_polygons(
-				const polygon_array& i_polygons,
-				index_type* o_offset,
-				index_type* o_num_elements);
 		private :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Check if the tree is ready to be queried
@@ -114,10 +99,6 @@ namespace sdf
 			//----------------------------------------------------------------------------------------------------------------------
 			bool tree_contains(const octnode::polygon_array& i_polygons) const;
 		private :
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief The typedef of the node array
-			//----------------------------------------------------------------------------------------------------------------------
-			typedef std::vector<octnode> node_pool;
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief The node pool (array)
 			//----------------------------------------------------------------------------------------------------------------------
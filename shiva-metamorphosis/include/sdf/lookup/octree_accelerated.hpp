@@ -34,6 +34,9 @@ namespace sdf
 		/// @param[out] o_face_id The face id will be filled in there
 		//----------------------------------------------------------------------------------------------------------------------
 		void operator()(const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
+
+		const detail::octree& tree() const { return m_tree; }
+		std::size_t memory_usage() const { return m_tree.memory_usage(); }
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief A pointer to the mesh - pointer is only valid after initialize has been called with appropriate mesh
@@ -34,10 +34,19 @@ namespace sdf
 			typedef std::vector<index_type> polygon_array;
 		public :
 			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief Build the grid
+			/// @brief Build the grid. The faces are binned in parallel, in two passes: the cells of each face are found and
+			///			counted, then the faces are scattered into a single polygon list, in the order of the cells
 			/// @param[in] i_mesh The mesh the grid builds upon
+			/// @param[in] i_weights The cell weighting for the cell size
 			//----------------------------------------------------------------------------------------------------------------------
 			void build(const mesh& i_mesh, const cell_weights& i_weights);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Find the cells a face overlaps (exact triangle/box test, 4 cells at a time)
+			/// @param[in] i_mesh The mesh the grid was built upon
+			/// @param[in] i_face The face id
+			/// @param[out] o_cells The absolute index of the cells are appended to it
+			//----------------------------------------------------------------------------------------------------------------------
+			void face_cells(const mesh& i_mesh, unsigned int i_face, std::vector<unsigned int>* o_cells) const;
 
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Shortest distance to the mesh lookup
@@ -89,6 +98,7 @@ namespace sdf
 			unsigned int num_polygons() const { return static_cast<unsigned int>(m_polylist.size()); }
 			const float* grid_data() const { return (const float*)&m_box; }
 			const int* dimensions() const { return m_dim; }
+			std::size_t memory_usage() const;
 		private :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Access a cell directly 
@@ -146,10 +156,6 @@ namespace sdf
 			void propagation_lookup(const mesh& i_mesh, const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
 
 		private :
-			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief typedef grid of cells - the each own a vector, which is used for building the grid, but discarded after
-			//----------------------------------------------------------------------------------------------------------------------
-			typedef std::vector<grid_cell> cell_grid;
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief typedef grid of offset cells - A grid containing offsets to a pool
 			//----------------------------------------------------------------------------------------------------------------------
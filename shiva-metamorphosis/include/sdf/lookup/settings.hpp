@@ -14,6 +14,17 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		class settings
 		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief How the tree is split - only the bvh looks at it so far
+			//----------------------------------------------------------------------------------------------------------------------
+			enum builder_type
+			{
+				/// Split on the longest axis at the mean triangle centre
+				mean_split,
+				/// Binned surface area heuristic, partitioned in place with the top levels built in parallel
+				binned_sah
+			};
 		public :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Constructor
@@ -21,8 +32,9 @@ namespace sdf
 			/// @param[in] i_min Minimum number of polygons per leaf
 			/// @param[in] i_max Maximum number of polygons per leaf
 			/// @param[in] i_opt Best number of polygons per leaf
+			/// @param[in] i_builder How to split the tree
 			//----------------------------------------------------------------------------------------------------------------------
-			settings(unsigned int i_maxdepth, unsigned int i_min, unsigned int i_max, unsigned int i_opt) : m_maxdepth(i_maxdepth), m_min(i_min),m_max(i_max), m_opt(i_opt) {}
+			settings(unsigned int i_maxdepth, unsigned int i_min, unsigned int i_max, unsigned int i_opt, builder_type i_builder = mean_split) : m_maxdepth(i_maxdepth), m_min(i_min),m_max(i_max), m_opt(i_opt), m_builder(i_builder) {}
 			
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Get the maximum depth
@@ -44,6 +56,11 @@ namespace sdf
 			/// @return Maximum count
 			//----------------------------------------------------------------------------------------------------------------------
 			unsigned int maximum_count() const { return m_max; }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the way the tree is split
+			/// @return Builder type
+			//----------------------------------------------------------------------------------------------------------------------
+			builder_type builder() const { return m_builder; }
 		private :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief Maximum depth
@@ -61,6 +78,10 @@ namespace sdf
 			/// @brief Optimum count
 			//----------------------------------------------------------------------------------------------------------------------
 			unsigned int m_opt;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Builder type
+			//----------------------------------------------------------------------------------------------------------------------
+			builder_type m_builder;
 		};
 	}
 }
@@ -0,0 +1,134 @@
+#ifndef SDF_LOOKUP_WIDE_BVH_INCLUDED
+#define SDF_LOOKUP_WIDE_BVH_INCLUDED
+
+#include <vector>
+#include <sdf/core/config.hpp>
+#include <sdf/lookup/bvh.hpp>
+
+namespace sdf
+{
+	namespace detail
+	{
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class wide_bvh "include/sdf/lookup/wide_bvh.hpp"
+		/// @brief A BVH with 4 children per node, made by collapsing a binary bvh
+		///			The boxes of the 4 children are stored as float lanes (structure of arrays), so one node is 2 cache lines
+		///			and the 4 point to box distances are computed at once with SSE. Children are then sorted with a small
+		///			sorting network and visited nearest first.
+		//----------------------------------------------------------------------------------------------------------------------
+		class wide_bvh
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Number of children per node
+			//----------------------------------------------------------------------------------------------------------------------
+			static const unsigned int width = 4;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Marks a child that is a node (the other children are leaves, and 0 polygons is an empty slot)
+			//----------------------------------------------------------------------------------------------------------------------
+			static const index_type inner_child = static_cast<index_type>(-1);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief A node - 4 child boxes as lanes, then what each child is
+			//----------------------------------------------------------------------------------------------------------------------
+			struct node
+			{
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief Minimum of the child boxes, [axis][child]
+				//----------------------------------------------------------------------------------------------------------------------
+				float m_min[3][width];
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief Maximum of the child boxes, [axis][child]
+				//----------------------------------------------------------------------------------------------------------------------
+				float m_max[3][width];
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief Node index for an inner child, offset in the polygon list for a leaf
+				//----------------------------------------------------------------------------------------------------------------------
+				index_type m_child[width];
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief inner_child for an inner child, number of polygons for a leaf
+				//----------------------------------------------------------------------------------------------------------------------
+				index_type m_count[width];
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The nodes in one array, root first
+			//----------------------------------------------------------------------------------------------------------------------
+			typedef std::vector<node> node_array;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief A polygon array contains the list of face indices
+			//----------------------------------------------------------------------------------------------------------------------
+			typedef bvh::polygon_array polygon_array;
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Build a binary bvh (or pick up the .bvh file) and collapse it
+			/// @param[in] i_mesh The original mesh
+			/// @param[in] i_settings The binary tree settings
+			//----------------------------------------------------------------------------------------------------------------------
+			void build(
+				const mesh& i_mesh,
+				const settings& i_settings);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Collapse a binary bvh
+			/// @param[in] i_tree The binary tree
+			//----------------------------------------------------------------------------------------------------------------------
+			void build(const bvh& i_tree);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Update the boxes after the vertices of the mesh moved, the faces and the topology of the tree are kept.
+			///			The leaf lanes are refitted in parallel, then the inner lanes bottom-up
+			/// @param[in] i_mesh The mesh with the new vertices (same faces as the one the tree was built on)
+			//----------------------------------------------------------------------------------------------------------------------
+			void refit(const mesh& i_mesh);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Surface area heuristic cost of the tree, relative to the area of the root (see bvh::sah_cost)
+			/// @return The expected cost of a lookup, in node visits and blocks of triangle tests
+			//----------------------------------------------------------------------------------------------------------------------
+			float sah_cost() const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Shortest distance to mesh lookup
+			/// @param[in] i_mesh The original mesh
+			/// @param[in] i_position The position to look up from
+			/// @param[out] o_closest_record The closest record
+			/// @param[out] o_face_id The face that registered the closest record
+			//----------------------------------------------------------------------------------------------------------------------
+			void operator()(
+				const mesh& i_mesh,
+				const point3d& i_position,
+				distance_record* o_closest_record,
+				unsigned int* o_face_id) const;
+
+			const node_array& nodes() const { return m_nodes; }
+			const polygon_array& polygons() const { return m_polylist; }
+			std::size_t memory_usage() const;
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Collapse a binary branch and the levels below it into a wide node (recursive)
+			/// @param[in] i_tree The binary tree
+			/// @param[in] i_branch The binary branch
+			/// @return The index of the new node
+			//----------------------------------------------------------------------------------------------------------------------
+			index_type collapse(const bvh& i_tree, bvh_branch::child_index i_branch);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Squared distances from a point to the 4 child boxes of a node, and the order to visit them in
+			/// @param[in] i_node The node
+			/// @param[in] i_position The position to look up from
+			/// @param[out] o_distances Squared distance per child (infinite for empty slots)
+			/// @param[out] o_order Children sorted nearest first
+			//----------------------------------------------------------------------------------------------------------------------
+			static void child_distances(const node& i_node, const point3d& i_position, float o_distances[width], unsigned int o_order[width]);
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The polygon list, the leaves point into it
+			//----------------------------------------------------------------------------------------------------------------------
+			polygon_array m_polylist;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The nodes
+			//----------------------------------------------------------------------------------------------------------------------
+			node_array m_nodes;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The triangles of the polygon list, precomputed for the leaf tests
+			//----------------------------------------------------------------------------------------------------------------------
+			triangle_store m_triangles;
+		};
+	}
+}
+
+#endif /* SDF_LOOKUP_WIDE_BVH_INCLUDED */
@@ -0,0 +1,79 @@
+#ifndef SDF_LOOKUP_WIDE_BVH_ACCELERATED_INCLUDED
+#define SDF_LOOKUP_WIDE_BVH_ACCELERATED_INCLUDED
+
+#include <sdf/lookup/wide_bvh.hpp>
+
+namespace sdf
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class wide_bvh_accelerated "include/sdf/lookup/wide_bvh_accelerated.hpp"
+	/// @brief Using a 4 wide bvh it will look for the shortest distance to the mesh
+	///			Same interface as bvh_accelerated, so it can be given to signed_distance_field_from_mesh instead
+	//----------------------------------------------------------------------------------------------------------------------
+	class wide_bvh_accelerated
+	{
+	public :
+		typedef detail::settings parameters;
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Default constructor - sets invalid attributes
+		//----------------------------------------------------------------------------------------------------------------------
+		wide_bvh_accelerated();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Initialize the tree (save the mesh)
+		/// @param[in] i_mesh The polygonal mesh
+		//----------------------------------------------------------------------------------------------------------------------
+		void initialize(const mesh& i_mesh);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Initialize the tree (save the mesh)
+		/// @param[in] i_mesh The polygonal mesh
+		/// @param[in] i_settings Settings of the binary tree which gets collapsed
+		//----------------------------------------------------------------------------------------------------------------------
+		void initialize(const mesh& i_mesh, const detail::settings& i_settings);
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the shortest distance to the mesh
+		/// @param[in] i_position Tne point in space to compute the distance from
+		/// @param[out] o_closest_record A record of the closest hit (feature type, distance)
+		/// @param[out] o_face_id The face id will be filled in there
+		//----------------------------------------------------------------------------------------------------------------------
+		void operator()(const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the shortest distance to the mesh for 8 points
+		/// @param[in] i_positions The 8 points
+		/// @param[out] o_closest_record The 8 records
+		/// @param[out] o_face_id The 8 face ids
+		//----------------------------------------------------------------------------------------------------------------------
+		void operator()(const point3d i_positions[], distance_record o_closest_record[], unsigned int o_face_id[]) const;
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the tree after the vertices of the mesh moved (the faces must not change).
+		///			The boxes are refitted, a deformed mesh can make them overlap a lot: the tree is built again from scratch
+		///			when its surface area heuristic cost grew past a ratio of its cost after the build
+		/// @param[in] i_rebuild_ratio Rebuild when cost > ratio * build cost, 0 never rebuilds (1.5 is a reasonable value)
+		/// @return True if the tree was built again
+		//----------------------------------------------------------------------------------------------------------------------
+		bool refit(float i_rebuild_ratio = 0.f);
+
+		const detail::wide_bvh& bvh() const { return m_tree; }
+		std::size_t memory_usage() const { return m_tree.memory_usage(); }
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief A pointer to the mesh - pointer is only valid after initialize has been called with appropriate mesh
+		//----------------------------------------------------------------------------------------------------------------------
+		const mesh* m_mesh;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief A wide BVH tree to accelerate lookups
+		//----------------------------------------------------------------------------------------------------------------------
+		detail::wide_bvh m_tree;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The settings the tree was built with, to build it again
+		//----------------------------------------------------------------------------------------------------------------------
+		detail::settings m_settings;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Surface area heuristic cost of the tree after its last build
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_build_cost;
+	};
+}
+
+#endif /* SDF_LOOKUP_WIDE_BVH_ACCELERATED_INCLUDED */
@@ -0,0 +1,256 @@
+#ifndef SDF_PROFILER_RECORDER_INCLUDED
+#define SDF_PROFILER_RECORDER_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sdf
+{
+	namespace profiler
+	{
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @class recorder "include/sdf/profiler/recorder.hpp"
+		/// @brief Collects the timings of the profiled scopes of all the threads.
+		///			Every thread writes its events to its own buffer, a list of fixed size chunks: a chunk is never moved, an
+		///			event is published by incrementing the count of its chunk, so recording an event takes no lock.
+		///			The scopes nest, an event is identified by its path (the names of the enclosing scopes joined with '/').
+		///			The paths are interned, an event only stores the id of its path so recording it does not allocate.
+		///			The table of the paths is only locked the first time a thread enters a path, and when reading the events.
+		///			The times are in microseconds from a monotonic clock, since the recorder was created.
+		///			The events can be aggregated per path (count, total, min, max) or written as a Chrome trace
+		///			(chrome://tracing or https://ui.perfetto.dev)
+		//----------------------------------------------------------------------------------------------------------------------
+		class recorder
+		{
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief A profiled scope, once it ended
+			//----------------------------------------------------------------------------------------------------------------------
+			struct event
+			{
+				std::string m_path;
+				unsigned int m_name;
+				unsigned int m_depth;
+				double m_begin;
+				double m_duration;
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The aggregated timings of a path, in microseconds
+			//----------------------------------------------------------------------------------------------------------------------
+			struct statistics
+			{
+				std::string m_path;
+				unsigned int m_depth;
+				unsigned long long m_count;
+				double m_total;
+				double m_min;
+				double m_max;
+			};
+		public :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The recorder of the process
+			/// @return Reference to the recorder
+			//----------------------------------------------------------------------------------------------------------------------
+			static recorder& instance();
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Time since the recorder was created
+			/// @return The time in microseconds
+			//----------------------------------------------------------------------------------------------------------------------
+			double now() const;
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Turn the recording on or off (on by default). The scopes still time themselves when it is off
+			/// @param[in] i_enabled True to record the events
+			//----------------------------------------------------------------------------------------------------------------------
+			void set_enabled(bool i_enabled) { m_enabled.store(i_enabled,std::memory_order_relaxed); }
+			bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Print the start and the end of every scope to the standard output, like the profiler used to
+			/// @param[in] i_echo True to print
+			//----------------------------------------------------------------------------------------------------------------------
+			void set_echo(bool i_echo) { m_echo.store(i_echo,std::memory_order_relaxed); }
+			bool echo() const { return m_echo.load(std::memory_order_relaxed); }
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Name the calling thread in the trace
+			/// @param[in] i_name The name
+			//----------------------------------------------------------------------------------------------------------------------
+			void set_thread_name(const std::string& i_name);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Enter a scope on the calling thread
+			/// @param[in] i_name The name of the scope
+			//----------------------------------------------------------------------------------------------------------------------
+			void push(const std::string& i_name);
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Leave the innermost scope of the calling thread and record it
+			/// @param[in] i_begin The time the scope started (see now)
+			/// @param[in] i_end The time the scope ended
+			//----------------------------------------------------------------------------------------------------------------------
+			void pop(double i_begin, double i_end);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get a copy of the events recorded so far - it can be called while other threads record
+			/// @param[out] o_events The events, thread by thread, in the order they ended
+			/// @param[out] o_threads The thread id of every event
+			//----------------------------------------------------------------------------------------------------------------------
+			void events(std::vector<event>* o_events, std::vector<unsigned int>* o_threads) const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Aggregate the events per path, over all the threads
+			/// @param[out] o_statistics The statistics sorted by path, a scope comes before the scopes it contains
+			//----------------------------------------------------------------------------------------------------------------------
+			void aggregate(std::vector<statistics>* o_statistics) const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Print the aggregated timings as an indented table
+			/// @param[out] o_stream The stream to print to
+			//----------------------------------------------------------------------------------------------------------------------
+			void print_summary(std::ostream& o_stream = std::cout) const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Write the events in the Chrome trace event format (complete events, one track per thread)
+			/// @param[in] i_filename The path to the JSON file
+			/// @return True if the file was written
+			//----------------------------------------------------------------------------------------------------------------------
+			bool write_chrome_trace(const std::string& i_filename) const;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Forget the events recorded so far. No other thread may be recording while it runs
+			//----------------------------------------------------------------------------------------------------------------------
+			void clear();
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Number of events in a chunk
+			//----------------------------------------------------------------------------------------------------------------------
+			static const unsigned int chunk_size = 256;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief An interned path, m_name and m_depth are those of the events
+			//----------------------------------------------------------------------------------------------------------------------
+			struct path_entry
+			{
+				std::string m_path;
+				unsigned int m_name;
+				unsigned int m_depth;
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief An event as it is recorded, m_path is the id of its path
+			//----------------------------------------------------------------------------------------------------------------------
+			struct record
+			{
+				unsigned int m_path;
+				double m_begin;
+				double m_duration;
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief A block of events, only its thread writes in it, the events below m_count can be read by any thread
+			//----------------------------------------------------------------------------------------------------------------------
+			struct chunk
+			{
+				chunk() : m_count(0), m_next(0) {}
+
+				record m_events[chunk_size];
+				std::atomic<unsigned int> m_count;
+				std::atomic<chunk*> m_next;
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The events of a thread. A buffer is released when its thread ends and taken again by the next new
+			///			thread, so the short lived threads of the task pools do not make a buffer each
+			//----------------------------------------------------------------------------------------------------------------------
+			struct thread_buffer
+			{
+				thread_buffer(unsigned int i_id) : m_id(i_id), m_head(new chunk), m_tail(m_head), m_owned(true), m_next(0) {}
+				~thread_buffer();
+
+				unsigned int m_id;
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief The path ids of the open scopes, innermost last
+				//----------------------------------------------------------------------------------------------------------------------
+				std::vector<unsigned int> m_open;
+				//----------------------------------------------------------------------------------------------------------------------
+				/// @brief The path ids met by the thread, per parent path id and name, so m_paths is only locked for new paths
+				//----------------------------------------------------------------------------------------------------------------------
+				std::map<unsigned int,std::map<std::string,unsigned int> > m_children;
+				std::string m_name;
+				chunk* m_head;
+				chunk* m_tail;
+				std::atomic<bool> m_owned;
+				thread_buffer* m_next;
+			};
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Releases the buffer of a thread when the thread ends
+			//----------------------------------------------------------------------------------------------------------------------
+			struct buffer_owner
+			{
+				buffer_owner() : m_buffer(0) {}
+				~buffer_owner();
+
+				thread_buffer* m_buffer;
+			};
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Constructor - the clock starts
+			//----------------------------------------------------------------------------------------------------------------------
+			recorder();
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Destructor - free the buffers
+			//----------------------------------------------------------------------------------------------------------------------
+			~recorder();
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief No copy
+			//----------------------------------------------------------------------------------------------------------------------
+			recorder(const recorder&);
+			recorder& operator=(const recorder&);
+
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The buffer of the calling thread, a released buffer is taken first, a new one is made otherwise
+			/// @return Reference to the buffer
+			//----------------------------------------------------------------------------------------------------------------------
+			thread_buffer& local_buffer();
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Get the id of a path, it is added if it is new
+			/// @param[in] i_parent The id of the path of the enclosing scope, 0 for none
+			/// @param[in] i_name The name of the scope
+			/// @return The id of the path
+			//----------------------------------------------------------------------------------------------------------------------
+			unsigned int intern(unsigned int i_parent, const std::string& i_name);
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Time 0
+			//----------------------------------------------------------------------------------------------------------------------
+			std::chrono::steady_clock::time_point m_start;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The buffers, newest first - a buffer is only ever added to the front
+			//----------------------------------------------------------------------------------------------------------------------
+			std::atomic<thread_buffer*> m_buffers;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Number of buffers made, the id of the next one
+			//----------------------------------------------------------------------------------------------------------------------
+			std::atomic<unsigned int> m_num_buffers;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The interned paths, the id of a path is its index, the first one is the empty root
+			//----------------------------------------------------------------------------------------------------------------------
+			std::vector<path_entry> m_paths;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief The id of every interned path, per parent path id and name
+			//----------------------------------------------------------------------------------------------------------------------
+			std::map<std::pair<unsigned int,std::string>,unsigned int> m_path_ids;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Guards m_paths and m_path_ids
+			//----------------------------------------------------------------------------------------------------------------------
+			mutable std::mutex m_paths_mutex;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Record the events
+			//----------------------------------------------------------------------------------------------------------------------
+			std::atomic<bool> m_enabled;
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Print the scopes as they start and end
+			//----------------------------------------------------------------------------------------------------------------------
+			std::atomic<bool> m_echo;
+		};
+	}
+}
+
+#endif /* SDF_PROFILER_RECORDER_INCLUDED */
@@ -6,7 +6,8 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <boost/timer.hpp>
+#include <sdf/core/config.hpp>
+#include <sdf/profiler/recorder.hpp>
 
 namespace sdf
 {
@@ -14,7 +15,8 @@ namespace sdf
 	{
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @class scope "include/sdf/profiler/scope.hpp"
-		/// @brief Profiles a scope (based on boost::timer)
+		/// @brief Profiles a scope with a monotonic high resolution clock, the wall time is measured so it works across
+		///			threads. When it ends the scope is recorded by the recorder, nested in the scopes still open on its thread
 		/// @author Mathieu Sanchez
 		/// @version 1.0
 		/// @date Last Revision 28/06/11 Initial revision
@@ -28,22 +30,46 @@ namespace sdf
 			~scope();
 
 			void restart();
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Time since the scope started (or was restarted)
+			/// @return The time in seconds
+			//----------------------------------------------------------------------------------------------------------------------
 			float query() const;
 			void print_time() const;
+		private :
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief Enter the scope, in the recorder
+			//----------------------------------------------------------------------------------------------------------------------
+			void start();
+			//----------------------------------------------------------------------------------------------------------------------
+			/// @brief No copy
+			//----------------------------------------------------------------------------------------------------------------------
+			scope(const scope&);
+			scope& operator=(const scope&);
 		private :
 			//----------------------------------------------------------------------------------------------------------------------
 			/// @brief  A name to identify and allow nested profilers
 			//----------------------------------------------------------------------------------------------------------------------
 			std::string m_name;
 			//----------------------------------------------------------------------------------------------------------------------
-			/// @brief  Start time for profiling
+			/// @brief  Start time for profiling, in microseconds (recorder time)
 			//----------------------------------------------------------------------------------------------------------------------
-			boost::timer m_start;
+			double m_start;
 		};
 	}
 }
 
+// Define SDF_NO_PROFILER to compile the profiled scopes out
+#ifndef SDF_NO_PROFILER
 // DO NOT USE SPACES IN name !
 #define SDF_PROFILE(name) sdf::profiler::scope sdf_profiler_macro_generated_name_##name(#name);
+#define SDF_PROFILE_CONCAT_IMPL(a,b) a##b
+#define SDF_PROFILE_CONCAT(a,b) SDF_PROFILE_CONCAT_IMPL(a,b)
+// Profile the rest of the enclosing block, the arguments are a name or a printf format and its values
+#define SDF_PROFILE_SCOPE(...) sdf::profiler::scope SDF_PROFILE_CONCAT(sdf_profiler_scope_,__LINE__)(__VA_ARGS__);
+#else
+#define SDF_PROFILE(name)
+#define SDF_PROFILE_SCOPE(...)
+#endif
 
 #endif /* SDF_PROFILER_SCOPE_INCLUDED */
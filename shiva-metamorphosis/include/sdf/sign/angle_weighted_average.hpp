@@ -21,6 +21,11 @@ namespace sdf
 	//----------------------------------------------------------------------------------------------------------------------
 	class angle_weighted_average
 	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The opposite of a border edge
+		//----------------------------------------------------------------------------------------------------------------------
+		static const index_type no_edge = 0xffffffff;
 	public :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Default constructor
@@ -40,6 +45,12 @@ namespace sdf
 		/// @return -1 or 1. It is the value the distance should be multiplied by.
 		//----------------------------------------------------------------------------------------------------------------------
 		float operator()(const point3d& i_position, const distance_record& i_closest_record, unsigned int i_face_id) const;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Update the normals after some vertices of the mesh moved - the faces must not have changed
+		///			Only the faces around the moved vertices, and the vertices and edges of those faces are computed again
+		/// @param[in] i_moved The indices of the vertices which moved
+		//----------------------------------------------------------------------------------------------------------------------
+		void refit(const std::vector<index_type>& i_moved);
 
 		const normal_array& face_normals() const { return m_face_normals; }
 		const normal_array& edge_normals() const { return m_edge_normals; }
@@ -63,6 +74,14 @@ namespace sdf
 		/// @brief Build the vertex normals for later lookups
 		//----------------------------------------------------------------------------------------------------------------------
 		void build_vertex_normals();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Build the list of corners of each vertex
+		//----------------------------------------------------------------------------------------------------------------------
+		void build_corners();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Pair the half edges
+		//----------------------------------------------------------------------------------------------------------------------
+		void build_opposite();
 	private :
 		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief A pointer to the mesh - pointer is only valid after initialize has been called with appropriate mesh
@@ -80,6 +99,18 @@ namespace sdf
 		/// @brief Precomputed edge normals - an edge normal is the average of each face on each side.
 		//----------------------------------------------------------------------------------------------------------------------
 		normal_array m_edge_normals;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The corners of vertex v are m_vertex_corners[m_first_corner[v]] to m_vertex_corners[m_first_corner[v+1]-1]
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<index_type> m_first_corner;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The corners (offsets in the index array) sorted by vertex
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<index_type> m_vertex_corners;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The opposite half edge of each half edge, no_edge on a border
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<index_type> m_opposite;
 	};
 }
 
@@ -8,6 +8,8 @@
 #include <sdf/core/mesh.hpp>
 #include <sdf/sign/angle_weighted_average.hpp>
 #include <sdf/lookup/bvh_accelerated.hpp>
+#include <sdf/lookup/wide_bvh_accelerated.hpp>
+#include <sdf/profiler/scope.hpp>
 
 namespace sdf
 {
@@ -15,17 +17,18 @@ namespace sdf
 	/// @class signed_distance_field_from_mesh "include/sdf/signed_distance_field_from_mesh.hpp"
 	/// @brief This should be the main class users should use. 
 	///			It takes in a mesh and allows users to query the signed distance to the mesh from any point in space
+	///			The lookup structure can be swapped, wide_bvh_accelerated gives the same distances faster than the default
 	/// @author Mathieu Sanchez
 	/// @version 1.0
 	/// @date Last Revision 28/06/11 Initial revision
 	//----------------------------------------------------------------------------------------------------------------------
-	template<typename T>
+	template<typename T, typename Lookup = bvh_accelerated>
 	class signed_distance_field_from_mesh// : boost::noncopyable
 	{
 	public :
 		typedef angle_weighted_average sign_computation;
-		typedef bvh_accelerated distance_lookup;
-		typedef signed_distance_field_from_mesh<T> this_type;
+		typedef Lookup distance_lookup;
+		typedef signed_distance_field_from_mesh<T,Lookup> this_type;
 
 		typedef std::vector<point3d> point_array;
 		typedef std::vector<float> scalar_array;
@@ -47,6 +50,19 @@ namespace sdf
 		//----------------------------------------------------------------------------------------------------------------------
 		void initialize(const parameters& i_params);		
 		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Initialize the distance field from the mesh alone: the sign and lookup files next to the mesh (.awn, .bvh)
+		///			are neither read nor written, for a mesh that may have changed since they were saved
+		//----------------------------------------------------------------------------------------------------------------------
+		void initialize_without_files();
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Move the vertices of the mesh and update the field, instead of initializing it again. The faces must not change.
+		///			Only the normals around the moved vertices are computed again and the lookup boxes are refitted
+		/// @param[in] i_vertices The new vertices, as many as the mesh has
+		/// @param[in] i_rebuild_ratio The lookup is built again when its quality dropped below this ratio of the build (0 never)
+		/// @return True if the lookup was built again
+		//----------------------------------------------------------------------------------------------------------------------
+		bool refit(const vertex_array& i_vertices, float i_rebuild_ratio = 0.f);
+		//----------------------------------------------------------------------------------------------------------------------
 		/// @brief Get the signed distance from i_position to the mesh
 		/// @param[in] i_position A point in space to get the signed distance to the mesh
 		/// @return Signed distance to the mesh
@@ -124,6 +140,7 @@ namespace sdf
 
 	typedef signed_distance_field_from_mesh<float> sdffmf;
 	typedef signed_distance_field_from_mesh<float> sdffmd;
+	typedef signed_distance_field_from_mesh<float,wide_bvh_accelerated> wide_sdffmf;
 }
 
 #include <sdf/signed_distance_field_from_mesh.inl>
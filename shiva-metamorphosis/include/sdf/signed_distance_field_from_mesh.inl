@@ -1,7 +1,7 @@
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-sdf::signed_distance_field_from_mesh<T>::signed_distance_field_from_mesh(const std::string& i_filename) : m_mesh(i_filename) 
+template<typename T, typename Lookup>
+sdf::signed_distance_field_from_mesh<T,Lookup>::signed_distance_field_from_mesh(const std::string& i_filename) : m_mesh(i_filename) 
 {
 	m_mesh.bounding_box(&m_box);
 #ifdef _DEBUG
@@ -10,11 +10,18 @@ sdf::signed_distance_field_from_mesh<T>::signed_distance_field_from_mesh(const s
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-void sdf::signed_distance_field_from_mesh<T>::initialize()
+template<typename T, typename Lookup>
+void sdf::signed_distance_field_from_mesh<T,Lookup>::initialize()
 {
-	sign.initialize(m_mesh);
-	lookup.initialize(m_mesh);
+	SDF_PROFILE_SCOPE("sdf build (%u faces)",m_mesh.num_faces())
+	{
+		SDF_PROFILE(sign)
+		sign.initialize(m_mesh);
+	}
+	{
+		SDF_PROFILE(lookup)
+		lookup.initialize(m_mesh);
+	}
 #ifdef _DEBUG
 	m_initialized=true;
 #endif 
@@ -22,19 +29,60 @@ void sdf::signed_distance_field_from_mesh<T>::initialize()
 
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-void sdf::signed_distance_field_from_mesh<T>::initialize(const parameters& i_params)
+template<typename T, typename Lookup>
+void sdf::signed_distance_field_from_mesh<T,Lookup>::initialize(const parameters& i_params)
 {
-	sign.initialize(m_mesh);
-	lookup.initialize(m_mesh,i_params);
+	SDF_PROFILE_SCOPE("sdf build (%u faces)",m_mesh.num_faces())
+	{
+		SDF_PROFILE(sign)
+		sign.initialize(m_mesh);
+	}
+	{
+		SDF_PROFILE(lookup)
+		lookup.initialize(m_mesh,i_params);
+	}
 #ifdef _DEBUG
 	m_initialized=true;
 #endif 
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-float sdf::signed_distance_field_from_mesh<T>::operator()(const point3d& i_position) const
+template<typename T, typename Lookup>
+void sdf::signed_distance_field_from_mesh<T,Lookup>::initialize_without_files()
+{
+	m_mesh.forget_source();
+	initialize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename T, typename Lookup>
+bool sdf::signed_distance_field_from_mesh<T,Lookup>::refit(const vertex_array& i_vertices, float i_rebuild_ratio)
+{
+#ifdef _DEBUG
+	assert(m_initialized);
+#endif 
+	vertex_array& vertices = m_mesh.vertices();
+	assert(i_vertices.size()==vertices.size());
+
+	std::vector<index_type> moved;
+	for (index_type i=0;i<static_cast<index_type>(vertices.size());i++)
+	{
+		if (!(vertices[i]==i_vertices[i]))
+		{
+			vertices[i] = i_vertices[i];
+			moved.push_back(i);
+		}
+	}
+	m_mesh.bounding_box(&m_box);
+
+	SDF_PROFILE_SCOPE("sdf refit (%u vertices)",static_cast<unsigned int>(moved.size()))
+	sign.refit(moved);
+	return lookup.refit(i_rebuild_ratio);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<typename T, typename Lookup>
+float sdf::signed_distance_field_from_mesh<T,Lookup>::operator()(const point3d& i_position) const
 {
 	unsigned int dummyint(0);
 	distance_record dummyrecord;
@@ -42,8 +90,8 @@ float sdf::signed_distance_field_from_mesh<T>::operator()(const point3d& i_posit
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-bool sdf::signed_distance_field_from_mesh<T>::operator()(const point3d i_positions[], float o_distances[]) const
+template<typename T, typename Lookup>
+bool sdf::signed_distance_field_from_mesh<T,Lookup>::operator()(const point3d i_positions[], float o_distances[]) const
 {
 #ifdef _DEBUG
 	assert(m_initialized);
@@ -66,8 +114,8 @@ bool sdf::signed_distance_field_from_mesh<T>::operator()(const point3d i_positio
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-float sdf::signed_distance_field_from_mesh<T>::operator()(float x, float y, float z) const
+template<typename T, typename Lookup>
+float sdf::signed_distance_field_from_mesh<T,Lookup>::operator()(float x, float y, float z) const
 {
 	unsigned int dummyint(0);
 	distance_record dummyrecord;
@@ -75,8 +123,8 @@ float sdf::signed_distance_field_from_mesh<T>::operator()(float x, float y, floa
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-float sdf::signed_distance_field_from_mesh<T>::operator()(const point3d& i_position, unsigned int* o_face_id, distance_record* o_hit) const
+template<typename T, typename Lookup>
+float sdf::signed_distance_field_from_mesh<T,Lookup>::operator()(const point3d& i_position, unsigned int* o_face_id, distance_record* o_hit) const
 {
 #ifdef _DEBUG
 	assert(m_initialized);
@@ -98,8 +146,8 @@ float sdf::signed_distance_field_from_mesh<T>::operator()(const point3d& i_posit
 
 
 //----------------------------------------------------------------------------------------------------------------------
-template<typename T>
-std::size_t sdf::signed_distance_field_from_mesh<T>::memory_usage() const 
+template<typename T, typename Lookup>
+std::size_t sdf::signed_distance_field_from_mesh<T,Lookup>::memory_usage() const 
 { 
 	return m_mesh.memory_usage()+sign.memory_usage()+lookup.memory_usage();
 }
\ No newline at end of file
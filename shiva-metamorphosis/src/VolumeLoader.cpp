@@ -1,6 +1,8 @@
 
 #include "VolumeLoader.h"
 #include "vol_metamorph.h"
+#include <sdf/discretization/brick_file.hpp>
+#include <sdf/profiler/scope.hpp>
 
 #define DEFAULT_RESOLUTION 128
 
@@ -62,7 +64,15 @@ void VolumeLoader::GetJobToGL( unsigned int _ticket, unsigned int _glTexID )
 		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
 		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
-		glTexImage3D( GL_TEXTURE_3D, 0, GL_RGBA32F, currentJob->m_depth, currentJob->m_height, currentJob->m_width, 0, GL_ALPHA, GL_FLOAT, ( GLvoid * )currentJob->m_data );
+		SDF_PROFILE_SCOPE( "texture upload %ux%ux%u", currentJob->m_width, currentJob->m_height, currentJob->m_depth )
+
+		// OpenGL needs the samples X first, whatever the layout of the grid
+		const float *data = currentJob->m_data;
+		sdf::grid::scalar_field linearSamples;
+		if( currentJob->m_samples.num_elements() > 0 )
+			data = currentJob->m_samples.linear_data( &linearSamples );
+
+		glTexImage3D( GL_TEXTURE_3D, 0, GL_RGBA32F, currentJob->m_depth, currentJob->m_height, currentJob->m_width, 0, GL_ALPHA, GL_FLOAT, ( const GLvoid * )data );
 	}
 }
 
@@ -71,7 +81,13 @@ void VolumeLoader::GetJobToGL( unsigned int _ticket, unsigned int _glTexID )
 void VolumeLoader::GetJobBounds( unsigned int _ticket, cml::vector3f &_boundMin, cml::vector3f &_boundMax )
 {
 	JobData *currentJob = GetFinishedJobData( _ticket );
-	if( currentJob != NULL )
+	if( currentJob != NULL && currentJob->m_samples.num_elements() > 0 )
+	{
+		// A .cbf file knows its bounds
+		_boundMin = currentJob->m_boundMin;
+		_boundMax = currentJob->m_boundMax;
+	}
+	else if( currentJob != NULL )
 	{
 		_boundMin[ 0 ] = -1.2f;
 		_boundMin[ 1 ] = -1.2f;
@@ -138,31 +154,40 @@ void VolumeLoader::ThreadProcess()
 
 		std::cout << "INFO: Attempting to load vol file: " << m_activeJob->m_filename << ": " << m_activeJob->m_width << "x" << m_activeJob->m_height << "x" << m_activeJob->m_depth << std::endl;
 
-		float* bbox = NULL;
-		open_params tmp;
-		tmp.m_fit_to_box = true;
-		tmp.m_calculate_bbox = true;
-		tmp.m_fill_array = true;
-		tmp.m_exact_bbox = true;
-
-		if ( !openVol( m_activeJob->m_filename.c_str(), m_activeJob->m_depth, m_activeJob->m_width, m_activeJob->m_height, tmp, &bbox, &( m_activeJob->m_data ) ) )
+		const std::string &filename = m_activeJob->m_filename;
+		if( filename.size() > 4 && filename.compare( filename.size() - 4, 4, ".cbf" ) == 0 )
 		{
-			std::cout << "WARNING: Failed to load .vol file: " << m_activeJob->m_filename << std::endl;
+			if( !LoadCompressed( m_activeJob ) )
+				std::cout << "WARNING: Failed to load .cbf file: " << filename << std::endl;
 		}
 		else
 		{
-			std::cout << "INFO: Unpacked texture " << m_activeJob->m_filename << ": " << m_activeJob->m_width << "x" << m_activeJob->m_height << "x" << m_activeJob->m_depth << " in bounds (";
-			std::cout << bbox[ 0 ] << "," << bbox[ 1 ] << "," << bbox[ 2 ] << ")<(" << bbox[ 3 ] << "," << bbox[ 4 ] << "," << bbox[ 5 ] << ")" << std::endl;
-
-			m_activeJob->m_boundMin[ 0 ] = bbox[ 0 ];
-			m_activeJob->m_boundMin[ 1 ] = bbox[ 1 ];
-			m_activeJob->m_boundMin[ 2 ] = bbox[ 2 ];
-			m_activeJob->m_boundMax[ 0 ] = bbox[ 3 ];
-			m_activeJob->m_boundMax[ 1 ] = bbox[ 4 ];
-			m_activeJob->m_boundMax[ 2 ] = bbox[ 5 ];
-		}
+			float* bbox = NULL;
+			open_params tmp;
+			tmp.m_fit_to_box = true;
+			tmp.m_calculate_bbox = true;
+			tmp.m_fill_array = true;
+			tmp.m_exact_bbox = true;
+
+			if ( !openVol( m_activeJob->m_filename.c_str(), m_activeJob->m_depth, m_activeJob->m_width, m_activeJob->m_height, tmp, &bbox, &( m_activeJob->m_data ) ) )
+			{
+				std::cout << "WARNING: Failed to load .vol file: " << m_activeJob->m_filename << std::endl;
+			}
+			else
+			{
+				std::cout << "INFO: Unpacked texture " << m_activeJob->m_filename << ": " << m_activeJob->m_width << "x" << m_activeJob->m_height << "x" << m_activeJob->m_depth << " in bounds (";
+				std::cout << bbox[ 0 ] << "," << bbox[ 1 ] << "," << bbox[ 2 ] << ")<(" << bbox[ 3 ] << "," << bbox[ 4 ] << "," << bbox[ 5 ] << ")" << std::endl;
+
+				m_activeJob->m_boundMin[ 0 ] = bbox[ 0 ];
+				m_activeJob->m_boundMin[ 1 ] = bbox[ 1 ];
+				m_activeJob->m_boundMin[ 2 ] = bbox[ 2 ];
+				m_activeJob->m_boundMax[ 0 ] = bbox[ 3 ];
+				m_activeJob->m_boundMax[ 1 ] = bbox[ 4 ];
+				m_activeJob->m_boundMax[ 2 ] = bbox[ 5 ];
+			}
 
-		freePt( &bbox );
+			freePt( &bbox );
+		}
 
 		m_finishedQueueMtx.lock();
 			m_finishedQueue.push_back( m_activeJob );
@@ -182,6 +207,32 @@ void VolumeLoader::ThreadProcess()
 
 //----------------------------------------------------------------------------------
 
+bool VolumeLoader::LoadCompressed( JobData *_job )
+{
+	// The bricks are decoded in parallel, at the resolution they were saved at
+	sdf::brick_file file( _job->m_filename );
+	if( !file.is_open() || !file.read( &( _job->m_samples ) ) )
+	{
+		_job->m_samples = sdf::grid();
+		return false;
+	}
+
+	// X varies fastest, it is the texture width which is given as m_depth
+	_job->m_depth = file.size( 0 );
+	_job->m_height = file.size( 1 );
+	_job->m_width = file.size( 2 );
+	for( unsigned int axis = 0; axis < 3; axis++ )
+	{
+		_job->m_boundMin[ axis ] = file.minimum()[ axis ];
+		_job->m_boundMax[ axis ] = file.maximum()[ axis ];
+	}
+
+	std::cout << "INFO: Unpacked texture " << _job->m_filename << ": " << file.size( 0 ) << "x" << file.size( 1 ) << "x" << file.size( 2 ) << " from " << file.num_bricks() << " bricks" << std::endl;
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
 unsigned int VolumeLoader::IssueNewTicket()
 {
 	return m_topTicket++;
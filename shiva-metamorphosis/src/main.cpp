@@ -14,6 +14,8 @@
 #include "RotationChooser.h"
 #include "ShivaMetamorphosis.h"
 
+#include <sdf/profiler/recorder.hpp>
+
 #include <boost/program_options.hpp>
 
 //----------------------------------------------------------------------------------
@@ -23,6 +25,7 @@ struct ProgramOptions
 {
 	std::string profileDirectory;
 	std::string profileName;
+	std::string traceFile;
 };
 
 //----------------------------------------------------------------------------------
@@ -50,8 +53,19 @@ int main( int argc, char **argv )
 	mainGUIManager->RegisterActivityCreator( "RotationChooser", RotationChooser::Factory );
 	mainGUIManager->RegisterViewCreator( "SDFView", SDFView::Factory );
 
+	// Only record the profiled scopes for a trace, an interactive session would keep adding them
+	sdf::profiler::recorder::instance().set_enabled( !options.traceFile.empty() );
+	sdf::profiler::recorder::instance().set_thread_name( "main" );
+
 	mainGUIManager->StartWithProfileChooser( "ModelChooser", options.profileDirectory, options.profileName );
 
+	if( !options.traceFile.empty() )
+	{
+		sdf::profiler::recorder::instance().print_summary();
+		if( !sdf::profiler::recorder::instance().write_chrome_trace( options.traceFile ) )
+			std::cerr << "WARNING: could not write the trace to " << options.traceFile << std::endl;
+	}
+
 	return 0;
 }
 
@@ -74,9 +88,15 @@ bool GetOptions( ProgramOptions *_options, int _argc, char **_argv )
 		 boost::program_options::value< std::string >( &( _options->profileName ) )->default_value( "" ),
 		 "profile name" );
 
+	boost::program_options::options_description debugging( "Debugging options" );
+	debugging.add_options()
+		( "trace,t",
+		 boost::program_options::value< std::string >( &( _options->traceFile ) )->default_value( "" ),
+		 "write the profiled scopes to this file on exit, as a Chrome trace (chrome://tracing), and print their timings" );
+
 
 	boost::program_options::options_description allOptions( "Allowed options" );
-	allOptions.add( generic ).add( profile );
+	allOptions.add( generic ).add( profile ).add( debugging );
 
 	boost::program_options::variables_map variableMap;
 	boost::program_options::store( boost::program_options::parse_command_line( _argc, _argv, allOptions ), variableMap );
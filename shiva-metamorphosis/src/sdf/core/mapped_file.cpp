@@ -0,0 +1,107 @@
+#include <sdf/core/mapped_file.hpp>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::mapped_file::mapped_file(const std::string& i_filename) : m_data(0), m_size(0), m_open(false), m_file(INVALID_HANDLE_VALUE), m_mapping(0)
+{
+	m_file = CreateFileA(i_filename.c_str(),GENERIC_READ,FILE_SHARE_READ,0,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,0);
+	if (m_file==INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file,&size))
+	{
+		close();
+		return;
+	}
+	m_open = true;
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	if (m_size==0)
+		return;
+
+	m_mapping = CreateFileMappingA(m_file,0,PAGE_READONLY,0,0,0);
+	if (m_mapping!=0)
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping,FILE_MAP_READ,0,0,0));
+	if (m_data==0)
+		close();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::mapped_file::close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file!=INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_data = 0;
+	m_mapping = 0;
+	m_file = INVALID_HANDLE_VALUE;
+	m_size = 0;
+	m_open = false;
+}
+
+#else
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::mapped_file::mapped_file(const std::string& i_filename) : m_data(0), m_size(0), m_open(false)
+{
+	const int descriptor = open(i_filename.c_str(),O_RDONLY);
+	if (descriptor<0)
+		return;
+	struct stat status;
+	if (fstat(descriptor,&status)==0)
+	{
+		m_open = true;
+		m_size = static_cast<std::size_t>(status.st_size);
+		if (m_size>0)
+		{
+			void* data = mmap(0,m_size,PROT_READ,MAP_PRIVATE,descriptor,0);
+			if (data==MAP_FAILED)
+			{
+				m_open = false;
+				m_size = 0;
+			}
+			else
+			{
+				m_data = static_cast<const char*>(data);
+			}
+		}
+	}
+	// The mapping stays valid once the descriptor is closed
+	::close(descriptor);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::mapped_file::close()
+{
+	if (m_data)
+		munmap(const_cast<char*>(m_data),m_size);
+	m_data = 0;
+	m_size = 0;
+	m_open = false;
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::mapped_file::~mapped_file()
+{
+	close();
+}
@@ -1,9 +1,12 @@
 #include <sdf/core/mesh.hpp>
 #include <sdf/core/obj_file.hpp>
+#include <sdf/core/stl_file.hpp>
+#include <sdf/core/ply_file.hpp>
 #include <sdf/core/tools.hpp>
 #include <assert.h>
 #include <iostream>
 #include <string>
+#include <ctype.h>
 
 //----------------------------------------------------------------------------------------------------------------------
 sdf::mesh::mesh() : m_source() {}
@@ -11,9 +14,7 @@ sdf::mesh::mesh() : m_source() {}
 //----------------------------------------------------------------------------------------------------------------------
 sdf::mesh::mesh(const std::string& i_filename) : m_source(i_filename) 
 {
-	obj_file file;
-	file.enable_comments(false);
-	file.read(i_filename,&m_vertices,&m_indices);
+	load_from_file(i_filename);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -38,20 +39,63 @@ bool sdf::mesh::load_from_obj(const std::string& i_filename, aabb* o_box)
 
 	obj_file file;
 	file.enable_comments(false);
-	if (file.read(i_filename,&m_vertices,&m_indices,o_box))
+	return finish_load(file.read(i_filename,&m_vertices,&m_indices,o_box),i_filename);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::mesh::load_from_stl(const std::string& i_filename, float i_weld_tolerance, aabb* o_box)
+{
+	m_indices.resize(0);
+	m_vertices.resize(0);
+
+	stl_file file;
+	file.set_weld_tolerance(i_weld_tolerance);
+	return finish_load(file.read(i_filename,&m_vertices,&m_indices,o_box),i_filename);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::mesh::load_from_ply(const std::string& i_filename, aabb* o_box)
+{
+	m_indices.resize(0);
+	m_vertices.resize(0);
+
+	ply_file file;
+	return finish_load(file.read(i_filename,&m_vertices,&m_indices,o_box),i_filename);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::mesh::load_from_file(const std::string& i_filename, aabb* o_box)
+{
+	std::string extension;
+	const std::string::size_type dot = i_filename.find_last_of('.');
+	if (dot!=std::string::npos)
 	{
-		m_source = i_filename;
-		return true;
+		extension = i_filename.substr(dot+1);
+		for (std::string::size_type i=0;i<extension.size();i++)
+			extension[i] = static_cast<char>(tolower(extension[i]));
 	}
-	else
+
+	if (extension=="stl")
+		return load_from_stl(i_filename,0.f,o_box);
+	if (extension=="ply")
+		return load_from_ply(i_filename,o_box);
+	return load_from_obj(i_filename,o_box);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::mesh::finish_load(bool i_success, const std::string& i_filename)
+{
+	if (i_success)
 	{
-		// CLeanup
-		m_indices.resize(0);
-		m_vertices.resize(0);
-		m_source="";
-		return false;
+		m_source = i_filename;
+		return true;
 	}
-	return false; // How ?
+
+	// Cleanup
+	m_indices.resize(0);
+	m_vertices.resize(0);
+	m_source="";
+	return false;
 }
 
 bool sdf::mesh::export_to_file(const std::string& i_filename) const
@@ -91,6 +135,12 @@ bool sdf::mesh::known_source() const
 	return !m_source.empty();
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::mesh::forget_source()
+{
+	m_source.clear();
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 const sdf::vertex_array& sdf::mesh::vertices() const
 {
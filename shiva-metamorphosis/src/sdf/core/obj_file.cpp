@@ -1,105 +1,368 @@
 #include <sdf/core/obj_file.hpp>
+#include <sdf/core/mapped_file.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <algorithm>
 #include <fstream>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
 #include <assert.h>
 
-//----------------------------------------------------------------------------------------------------------------------
-void sdf::obj_file::enable_comments(bool i_enable)
+namespace
 {
-	m_enable_comments=i_enable;
-}
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Size of the text given to one task
+	//----------------------------------------------------------------------------------------------------------------------
+	const std::size_t chunk_size = 1<<20;
 
-//----------------------------------------------------------------------------------------------------------------------
-void sdf::obj_file::read_vertex(std::stringstream& io_stream, float* o_vertex) const
-{
-	io_stream>>(o_vertex[0])>>(o_vertex[1])>>(o_vertex[2]);
-}
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief What a chunk of lines holds, in file order
+	//----------------------------------------------------------------------------------------------------------------------
+	struct obj_chunk
+	{
+		const char* m_begin;
+		const char* m_end;
+		sdf::vertex_array m_vertices;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Triangle indices, 0 based - relative indices are counted from the first vertex of the chunk
+		//----------------------------------------------------------------------------------------------------------------------
+		sdf::index_array m_indices;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Position in m_indices of the relative indices, they need the number of vertices before the chunk
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<unsigned int> m_relative;
+		sdf::aabb m_box;
+		std::string m_comments;
+		std::size_t m_first_vertex;
+		std::size_t m_first_index;
+	};
 
-//----------------------------------------------------------------------------------------------------------------------
-void sdf::obj_file::read_face(std::stringstream& io_stream, index_type o_indices[], unsigned char& i_nAttrib) const
-{
-	io_stream>>o_indices[i_nAttrib++];
-	while(o_indices[i_nAttrib-1]!=(unsigned int)-1)
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Get the start of the line after the one p is on
+	//----------------------------------------------------------------------------------------------------------------------
+	const char* next_line(const char* p, const char* i_end)
+	{
+		const char* eol = static_cast<const char*>(memchr(p,'\n',i_end-p));
+		return eol ? eol+1 : i_end;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Skip spaces and tabulations
+	//----------------------------------------------------------------------------------------------------------------------
+	const char* skip_blanks(const char* p, const char* i_end)
+	{
+		while (p<i_end && (*p==' ' || *p=='\t'))
+			++p;
+		return p;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Check for the end of a token
+	//----------------------------------------------------------------------------------------------------------------------
+	bool is_separator(char c)
+	{
+		return c==' ' || c=='\t' || c=='\r' || c=='\n';
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read a float, the decimal digits are gathered in an integer and scaled once by a power of 10
+	///			Anything else (inf, nan, hexadecimal) goes through strtod
+	/// @param[out] io_p The position to read at, moved past the number
+	/// @param[in] i_end The end of the text
+	/// @param[out] o_value The value
+	/// @return True if there was a number
+	//----------------------------------------------------------------------------------------------------------------------
+	bool parse_float(const char*& io_p, const char* i_end, float* o_value)
+	{
+		static const double powers[] = {
+			1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+			1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22 };
+
+		const char* p = skip_blanks(io_p,i_end);
+		const char* start = p;
+		bool negative(false);
+		if (p<i_end && (*p=='-' || *p=='+'))
+			negative = *p++=='-';
+
+		unsigned long long mantissa(0);
+		int exponent(0);
+		bool digits(false);
+		// Past 18 digits the others cannot change a float
+		for (;p<i_end && *p>='0' && *p<='9';++p,digits=true)
+		{
+			if (mantissa<100000000000000000ull)
+				mantissa = mantissa*10+(*p-'0');
+			else
+				exponent++;
+		}
+		if (p<i_end && *p=='.')
+		{
+			for (++p;p<i_end && *p>='0' && *p<='9';++p,digits=true)
+			{
+				if (mantissa<100000000000000000ull)
+				{
+					mantissa = mantissa*10+(*p-'0');
+					exponent--;
+				}
+			}
+		}
+		if (digits && p<i_end && (*p=='e' || *p=='E'))
+		{
+			const char* q = p+1;
+			bool negative_exponent(false);
+			if (q<i_end && (*q=='-' || *q=='+'))
+				negative_exponent = *q++=='-';
+			if (q<i_end && *q>='0' && *q<='9')
+			{
+				int value(0);
+				for (;q<i_end && *q>='0' && *q<='9';++q)
+					value = std::min(value*10+(*q-'0'),100000);
+				exponent += negative_exponent ? -value : value;
+				p = q;
+			}
+		}
+
+		if (!digits || (p<i_end && !is_separator(*p)))
+		{
+			// Not a plain decimal number
+			char buffer[64];
+			const char* token_end = start;
+			while (token_end<i_end && !is_separator(*token_end) && token_end-start<63)
+				++token_end;
+			memcpy(buffer,start,token_end-start);
+			buffer[token_end-start] = 0;
+			char* parsed;
+			const double value = strtod(buffer,&parsed);
+			if (parsed==buffer)
+				return false;
+			*o_value = static_cast<float>(value);
+			io_p = start+(parsed-buffer);
+			return true;
+		}
+
+		double value = static_cast<double>(mantissa);
+		if (exponent>=0 && exponent<=22)
+			value *= powers[exponent];
+		else if (exponent<0 && exponent>=-22)
+			value /= powers[-exponent];
+		else
+			value *= pow(10.0,exponent);
+		*o_value = static_cast<float>(negative ? -value : value);
+		io_p = p;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read a signed integer
+	/// @param[out] io_p The position to read at, moved past the number
+	/// @param[in] i_end The end of the text
+	/// @param[out] o_value The value
+	/// @return True if there was a number
+	//----------------------------------------------------------------------------------------------------------------------
+	bool parse_int(const char*& io_p, const char* i_end, long long* o_value)
+	{
+		const char* p = skip_blanks(io_p,i_end);
+		bool negative(false);
+		if (p<i_end && (*p=='-' || *p=='+'))
+			negative = *p++=='-';
+		if (p==i_end || *p<'0' || *p>'9')
+			return false;
+		long long value(0);
+		for (;p<i_end && *p>='0' && *p<='9';++p)
+			value = value*10+(*p-'0');
+		*o_value = negative ? -value : value;
+		io_p = p;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class chunk_parser
+	/// @brief The task parsing one chunk of lines - only v, f and the comments are read
+	//----------------------------------------------------------------------------------------------------------------------
+	class chunk_parser
 	{
-		char sep(0);
-		unsigned int dummy;
-		io_stream.read(&sep,1);
+	public :
+		chunk_parser(std::vector<obj_chunk>* io_chunks, bool i_comments) : m_chunks(*io_chunks), m_comments(i_comments) {}
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			obj_chunk& chunk = m_chunks[i_chunk];
+			const char* const end = chunk.m_end;
+			// The polygon being read, reused from face to face
+			std::vector<long long> polygon;
+			for (const char* line=chunk.m_begin;line<end;line=next_line(line,end))
+			{
+				const char* p = skip_blanks(line,end);
+				if (p+1>=end)
+					break;
+				if (*p=='#')
+				{
+					if (m_comments)
+					{
+						const char* eol = next_line(p,end);
+						while (eol>line && (eol[-1]=='\n' || eol[-1]=='\r'))
+							--eol;
+						chunk.m_comments.append(line,eol);
+						chunk.m_comments+='\n';
+					}
+					continue;
+				}
+				// Exclude vt, vn, vp...
+				if (!is_separator(p[1]))
+					continue;
+
+				if (*p=='v')
+				{
+					++p;
+					sdf::point3d vertex;
+					for (unsigned int axis=0;axis<3;axis++)
+					{
+						if (!parse_float(p,end,&vertex[axis]))
+							break;
+					}
+					chunk.m_box.include(vertex);
+					chunk.m_vertices.push_back(vertex);
+				}
+				else if (*p=='f')
+				{
+					++p;
+					polygon.clear();
+					long long index;
+					while (parse_int(p,end,&index))
+					{
+						// Negative indices count back from the last vertex read
+						if (index<0)
+							index = static_cast<long long>(chunk.m_vertices.size())+index-relative_flag;
+						else
+							index = index-1;
+						polygon.push_back(index);
+						// Skip the texture coordinate and normal indices
+						while (p<end && !is_separator(*p))
+							++p;
+					}
+					// Triangle fan for quads and polygons
+					for (std::size_t i=1;i+1<polygon.size();i++)
+					{
+						add_index(chunk,polygon[0]);
+						add_index(chunk,polygon[i]);
+						add_index(chunk,polygon[i+1]);
+					}
+				}
+			}
+		}
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Added to the relative indices to tell them apart
+		//----------------------------------------------------------------------------------------------------------------------
+		static const long long relative_flag = 1ll<<40;
+	private :
+		static void add_index(obj_chunk& io_chunk, long long i_index)
+		{
+			if (i_index<-relative_flag/2)
+			{
+				io_chunk.m_relative.push_back(static_cast<unsigned int>(io_chunk.m_indices.size()));
+				i_index += relative_flag;
+			}
+			io_chunk.m_indices.push_back(static_cast<sdf::index_type>(i_index));
+		}
+		std::vector<obj_chunk>& m_chunks;
+		bool m_comments;
+	};
 
-		int counter(0);
-		while(sep=='/' && counter++<3)
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class chunk_merger
+	/// @brief The task copying one chunk to its place in the buffers
+	//----------------------------------------------------------------------------------------------------------------------
+	class chunk_merger
+	{
+	public :
+		chunk_merger(const std::vector<obj_chunk>& i_chunks, std::size_t i_first_vertex, sdf::vertex_array* o_vb, sdf::index_array* o_ib)
+			: m_chunks(i_chunks), m_first_vertex(i_first_vertex), m_vb(*o_vb), m_ib(*o_ib) {}
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
 		{
-			io_stream>>dummy;
-			io_stream.read(&sep,1);
-		};
-		io_stream>>o_indices[i_nAttrib++];
+			const obj_chunk& chunk = m_chunks[i_chunk];
+			std::copy(chunk.m_vertices.begin(),chunk.m_vertices.end(),m_vb.begin()+chunk.m_first_vertex);
+			std::copy(chunk.m_indices.begin(),chunk.m_indices.end(),m_ib.begin()+chunk.m_first_index);
+			// The indices in the file do not count the vertices which were in the buffer before
+			const sdf::index_type offset = static_cast<sdf::index_type>(chunk.m_first_vertex-m_first_vertex);
+			for (std::size_t i=0;i<chunk.m_relative.size();i++)
+				m_ib[chunk.m_first_index+chunk.m_relative[i]] += offset;
+		}
+	private :
+		const std::vector<obj_chunk>& m_chunks;
+		std::size_t m_first_vertex;
+		sdf::vertex_array& m_vb;
+		sdf::index_array& m_ib;
 	};
-	i_nAttrib--;
-	assert(i_nAttrib==3); // We only want triangles
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::obj_file::enable_comments(bool i_enable)
+{
+	m_enable_comments=i_enable;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 bool sdf::obj_file::read(const std::string& i_filename, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
 {
-	std::ifstream file_handler(i_filename.c_str(),std::ios::in);
-	if (!file_handler.is_open())
+	mapped_file file(i_filename);
+	if (!file.is_open())
 		return false;
-
-	std::stringstream stream;
-	stream << file_handler.rdbuf();
-	const bool result = read(stream,o_vb,o_ib, o_box);
-
-        file_handler.close();
-
-	return result;
+	return read(file.data(),file.data()+file.size(),o_vb,o_ib,o_box);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 bool sdf::obj_file::read(std::stringstream& i_sstream, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
 {
+	const std::string text = i_sstream.str().substr(static_cast<std::size_t>(std::max<std::streamoff>(i_sstream.tellg(),0)));
+	i_sstream.seekg(0,std::ios::end);
+	return read(text.data(),text.data()+text.size(),o_vb,o_ib,o_box);
+}
 
-	static const std::string vertex("v");
-	static const std::string face("f");
-	static const std::string comment ("#");
-
-	vertex_array& vertices  = *o_vb;
-	index_array& indices   = *o_ib;
-	aabb box;
-
-	while (!i_sstream.eof())
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::obj_file::read(const char* i_begin, const char* i_end, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
+{
+	// Chunks of whole lines
+	const std::size_t size = static_cast<std::size_t>(i_end-i_begin);
+	const unsigned int num_chunks = static_cast<unsigned int>(std::max<std::size_t>(size/chunk_size,1));
+	std::vector<obj_chunk> chunks(num_chunks);
+	for (unsigned int i=0;i<num_chunks;i++)
 	{
-		std::stringstream line;
-		std::string sline;
-		std::getline(i_sstream,sline);
-		line<<sline;
+		chunks[i].m_begin = i==0 ? i_begin : next_line(i_begin+i*(size/num_chunks)-1,i_end);
+		if (i>0)
+			chunks[i-1].m_end = chunks[i].m_begin;
+	}
+	chunks[num_chunks-1].m_end = i_end;
 
-		std::string identifier;
-		line>>identifier;
+	thread::task_pool pool;
+	chunk_parser parser(&chunks,m_enable_comments);
+	pool.run(num_chunks,parser);
 
-		// Exclude vt and vn
-		if (identifier.size()==1)
-		{
-			if (identifier==vertex)
-			{
-				point3d vertex;
-				read_vertex(line,&vertex[0]);
-				box.include(vertex);
-				vertices.push_back(vertex);
-			}
-			else if (identifier==face)
-			{
-				index_type invalid = static_cast<index_type>(-1);
-				index_type face[4] = { invalid,invalid,invalid,invalid};
-				unsigned char nAttrib = 0;
-				read_face(line,face,nAttrib);
-				assert(nAttrib==3);
-				for (unsigned char i=0;i<3;i++)
-					indices.push_back(face[i]-1);
-			}
-		}
-		else if (identifier[0]==comment[0] && m_enable_comments)
+	// Where each chunk goes in the buffers
+	vertex_array& vertices = *o_vb;
+	index_array& indices = *o_ib;
+	const std::size_t first_vertex = vertices.size();
+	std::size_t num_vertices = vertices.size();
+	std::size_t num_indices = indices.size();
+	aabb box;
+	for (unsigned int i=0;i<num_chunks;i++)
+	{
+		obj_chunk& chunk = chunks[i];
+		chunk.m_first_vertex = num_vertices;
+		chunk.m_first_index = num_indices;
+		num_vertices += chunk.m_vertices.size();
+		num_indices += chunk.m_indices.size();
+		if (!chunk.m_vertices.empty())
 		{
-			std::cout<<sline<<std::endl;
+			box.include(chunk.m_box.minimum());
+			box.include(chunk.m_box.maximum());
 		}
+		if (!chunk.m_comments.empty())
+			std::cout<<chunk.m_comments;
 	}
+	vertices.resize(num_vertices);
+	indices.resize(num_indices);
+
+	chunk_merger merger(chunks,first_vertex,o_vb,o_ib);
+	pool.run(num_chunks,merger);
 
 	if (o_box)
 	{
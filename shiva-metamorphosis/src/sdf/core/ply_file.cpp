@@ -0,0 +1,322 @@
+#include <sdf/core/ply_file.hpp>
+#include <sdf/core/mapped_file.hpp>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The scalar types of the properties
+	//----------------------------------------------------------------------------------------------------------------------
+	enum ply_type { ply_int8, ply_uint8, ply_int16, ply_uint16, ply_int32, ply_uint32, ply_float32, ply_float64, ply_invalid };
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Size in bytes of each type
+	//----------------------------------------------------------------------------------------------------------------------
+	const std::size_t type_size[] = { 1,1,2,2,4,4,4,8 };
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A property of an element, a scalar or a list
+	//----------------------------------------------------------------------------------------------------------------------
+	struct ply_property
+	{
+		std::string m_name;
+		ply_type m_type;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Type of the number of items for a list, ply_invalid for a scalar
+		//----------------------------------------------------------------------------------------------------------------------
+		ply_type m_count_type;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief An element declared in the header
+	//----------------------------------------------------------------------------------------------------------------------
+	struct ply_element
+	{
+		std::string m_name;
+		std::size_t m_count;
+		std::vector<ply_property> m_properties;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Get a type from its name (both the old and the sized names)
+	//----------------------------------------------------------------------------------------------------------------------
+	ply_type type_from_name(const std::string& i_name)
+	{
+		static const char* const names[][2] = {
+			{ "char","int8" },{ "uchar","uint8" },{ "short","int16" },{ "ushort","uint16" },
+			{ "int","int32" },{ "uint","uint32" },{ "float","float32" },{ "double","float64" } };
+		for (unsigned int i=0;i<ply_invalid;i++)
+		{
+			if (i_name==names[i][0] || i_name==names[i][1])
+				return static_cast<ply_type>(i);
+		}
+		return ply_invalid;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Reads the binary body, checking the end of the data
+	//----------------------------------------------------------------------------------------------------------------------
+	class ply_reader
+	{
+	public :
+		ply_reader(const char* i_begin, const char* i_end, bool i_swap) : m_position(i_begin), m_end(i_end), m_swap(i_swap) {}
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Read a value of any type
+		/// @return False past the end of the data
+		//----------------------------------------------------------------------------------------------------------------------
+		bool read(ply_type i_type, double* o_value)
+		{
+			const std::size_t size = type_size[i_type];
+			if (static_cast<std::size_t>(m_end-m_position)<size)
+				return false;
+			unsigned char bytes[8];
+			memcpy(bytes,m_position,size);
+			m_position += size;
+			if (m_swap)
+			{
+				for (std::size_t i=0;i<size/2;i++)
+					std::swap(bytes[i],bytes[size-1-i]);
+			}
+			switch (i_type)
+			{
+			case ply_int8 : { signed char v; memcpy(&v,bytes,1); *o_value = v; break; }
+			case ply_uint8 : { *o_value = bytes[0]; break; }
+			case ply_int16 : { short v; memcpy(&v,bytes,2); *o_value = v; break; }
+			case ply_uint16 : { unsigned short v; memcpy(&v,bytes,2); *o_value = v; break; }
+			case ply_int32 : { int v; memcpy(&v,bytes,4); *o_value = v; break; }
+			case ply_uint32 : { unsigned int v; memcpy(&v,bytes,4); *o_value = v; break; }
+			case ply_float32 : { float v; memcpy(&v,bytes,4); *o_value = v; break; }
+			default : { double v; memcpy(&v,bytes,8); *o_value = v; break; }
+			}
+			return true;
+		}
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Skip a property
+		/// @return False past the end of the data
+		//----------------------------------------------------------------------------------------------------------------------
+		bool skip(const ply_property& i_property)
+		{
+			std::size_t count(1);
+			if (i_property.m_count_type!=ply_invalid)
+			{
+				double value;
+				if (!read(i_property.m_count_type,&value))
+					return false;
+				count = static_cast<std::size_t>(value);
+			}
+			const std::size_t size = count*type_size[i_property.m_type];
+			if (static_cast<std::size_t>(m_end-m_position)<size)
+				return false;
+			m_position += size;
+			return true;
+		}
+	private :
+		const char* m_position;
+		const char* m_end;
+		bool m_swap;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Check if the machine is little endian
+	//----------------------------------------------------------------------------------------------------------------------
+	bool little_endian_machine()
+	{
+		const unsigned int one(1);
+		unsigned char first;
+		memcpy(&first,&one,1);
+		return first==1;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::ply_file::read(const std::string& i_filename, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
+{
+	mapped_file file(i_filename);
+	if (!file.is_open())
+		return false;
+	return read(file.data(),file.data()+file.size(),o_vb,o_ib,o_box);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::ply_file::read(const char* i_begin, const char* i_end, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
+{
+	static const char end_header[] = "end_header";
+	const std::size_t size = static_cast<std::size_t>(i_end-i_begin);
+	if (size<4 || strncmp(i_begin,"ply",3)!=0)
+		return false;
+
+	// The header is text, up to the end of the end_header line
+	const char* body(0);
+	for (const char* line=i_begin;line<i_end;)
+	{
+		const char* eol = static_cast<const char*>(memchr(line,'\n',i_end-line));
+		if (!eol)
+			return false;
+		if (static_cast<std::size_t>(eol-line)>=sizeof(end_header)-1 && strncmp(line,end_header,sizeof(end_header)-1)==0)
+		{
+			body = eol+1;
+			break;
+		}
+		line = eol+1;
+	}
+	if (!body)
+		return false;
+
+	bool binary(false), swap(false);
+	std::vector<ply_element> elements;
+	std::istringstream header(std::string(i_begin,body));
+	std::string line;
+	while (std::getline(header,line))
+	{
+		std::istringstream words(line);
+		std::string keyword;
+		words>>keyword;
+		if (keyword=="format")
+		{
+			std::string format;
+			words>>format;
+			binary = format=="binary_little_endian" || format=="binary_big_endian";
+			swap = (format=="binary_big_endian")==little_endian_machine();
+		}
+		else if (keyword=="element")
+		{
+			ply_element element;
+			words>>element.m_name>>element.m_count;
+			if (words.fail())
+				return false;
+			elements.push_back(element);
+		}
+		else if (keyword=="property")
+		{
+			if (elements.empty())
+				return false;
+			ply_property property;
+			std::string type;
+			words>>type;
+			if (type=="list")
+			{
+				std::string count_type;
+				words>>count_type>>type;
+				property.m_count_type = type_from_name(count_type);
+				if (property.m_count_type==ply_invalid)
+					return false;
+			}
+			else
+			{
+				property.m_count_type = ply_invalid;
+			}
+			property.m_type = type_from_name(type);
+			words>>property.m_name;
+			if (property.m_type==ply_invalid || words.fail())
+				return false;
+			elements.back().m_properties.push_back(property);
+		}
+	}
+	if (!binary)
+		return false;
+
+	vertex_array& vertices = *o_vb;
+	index_array& indices = *o_ib;
+	const index_type first_vertex = static_cast<index_type>(vertices.size());
+	aabb box;
+	ply_reader reader(body,i_end,swap);
+	std::vector<index_type> polygon;
+	for (std::size_t e=0;e<elements.size();e++)
+	{
+		const ply_element& element = elements[e];
+		const std::vector<ply_property>& properties = element.m_properties;
+		if (element.m_name=="vertex")
+		{
+			// Which property goes to which coordinate
+			std::vector<int> axis_of(properties.size(),-1);
+			for (std::size_t p=0;p<properties.size();p++)
+			{
+				if (properties[p].m_count_type!=ply_invalid)
+					continue;
+				if (properties[p].m_name=="x")
+					axis_of[p] = 0;
+				else if (properties[p].m_name=="y")
+					axis_of[p] = 1;
+				else if (properties[p].m_name=="z")
+					axis_of[p] = 2;
+			}
+
+			vertices.reserve(vertices.size()+element.m_count);
+			for (std::size_t i=0;i<element.m_count;i++)
+			{
+				point3d vertex;
+				for (std::size_t p=0;p<properties.size();p++)
+				{
+					if (axis_of[p]<0)
+					{
+						if (!reader.skip(properties[p]))
+							return false;
+						continue;
+					}
+					double value;
+					if (!reader.read(properties[p].m_type,&value))
+						return false;
+					vertex[axis_of[p]] = static_cast<float>(value);
+				}
+				box.include(vertex);
+				vertices.push_back(vertex);
+			}
+		}
+		else if (element.m_name=="face")
+		{
+			indices.reserve(indices.size()+3*element.m_count);
+			for (std::size_t i=0;i<element.m_count;i++)
+			{
+				for (std::size_t p=0;p<properties.size();p++)
+				{
+					const ply_property& property = properties[p];
+					if (property.m_count_type==ply_invalid || (property.m_name!="vertex_indices" && property.m_name!="vertex_index"))
+					{
+						if (!reader.skip(property))
+							return false;
+						continue;
+					}
+					double count;
+					if (!reader.read(property.m_count_type,&count))
+						return false;
+					polygon.resize(static_cast<std::size_t>(count));
+					for (std::size_t v=0;v<polygon.size();v++)
+					{
+						double index;
+						if (!reader.read(property.m_type,&index))
+							return false;
+						polygon[v] = first_vertex+static_cast<index_type>(index);
+					}
+					// Triangle fan for quads and polygons
+					for (std::size_t v=1;v+1<polygon.size();v++)
+					{
+						indices.push_back(polygon[0]);
+						indices.push_back(polygon[v]);
+						indices.push_back(polygon[v+1]);
+					}
+				}
+			}
+		}
+		else
+		{
+			for (std::size_t i=0;i<element.m_count;i++)
+			{
+				for (std::size_t p=0;p<properties.size();p++)
+				{
+					if (!reader.skip(properties[p]))
+						return false;
+				}
+			}
+		}
+	}
+
+	if (o_box)
+	{
+		*o_box = box;
+	}
+
+	return true;
+}
@@ -0,0 +1,150 @@
+#include <sdf/core/stl_file.hpp>
+#include <sdf/core/mapped_file.hpp>
+#include <sdf/core/vertex_welder.hpp>
+#include <fstream>
+#include <string.h>
+#include <math.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Size of the header, before the number of triangles
+	//----------------------------------------------------------------------------------------------------------------------
+	const std::size_t header_size = 80;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Size of a triangle record : normal, 3 positions and the attribute count
+	//----------------------------------------------------------------------------------------------------------------------
+	const std::size_t triangle_size = 50;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read a little endian 32 bits integer
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned int read_uint(const char* i_data)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(i_data);
+		return bytes[0] | (bytes[1]<<8) | (bytes[2]<<16) | (static_cast<unsigned int>(bytes[3])<<24);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read a little endian float
+	//----------------------------------------------------------------------------------------------------------------------
+	float read_float(const char* i_data)
+	{
+		const unsigned int bits = read_uint(i_data);
+		float value;
+		memcpy(&value,&bits,sizeof(float));
+		return value;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Write a little endian 32 bits integer
+	//----------------------------------------------------------------------------------------------------------------------
+	void write_uint(unsigned int i_value, char* o_data)
+	{
+		o_data[0] = static_cast<char>(i_value&0xff);
+		o_data[1] = static_cast<char>((i_value>>8)&0xff);
+		o_data[2] = static_cast<char>((i_value>>16)&0xff);
+		o_data[3] = static_cast<char>((i_value>>24)&0xff);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Write a little endian float
+	//----------------------------------------------------------------------------------------------------------------------
+	void write_float(float i_value, char* o_data)
+	{
+		unsigned int bits;
+		memcpy(&bits,&i_value,sizeof(float));
+		write_uint(bits,o_data);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::stl_file::read(const std::string& i_filename, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
+{
+	mapped_file file(i_filename);
+	if (!file.is_open())
+		return false;
+	return read(file.data(),file.data()+file.size(),o_vb,o_ib,o_box);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::stl_file::read(const char* i_begin, const char* i_end, vertex_array* o_vb, index_array* o_ib, aabb* o_box) const
+{
+	const std::size_t size = static_cast<std::size_t>(i_end-i_begin);
+	if (size<header_size+4)
+		return false;
+	// An ascii file starting with "solid" would not have the right size
+	const std::size_t num_triangles = read_uint(i_begin+header_size);
+	if ((size-header_size-4)/triangle_size<num_triangles)
+		return false;
+
+	vertex_array& vertices = *o_vb;
+	index_array& indices = *o_ib;
+	// About half as many vertices as triangles in a closed mesh
+	vertices.reserve(vertices.size()+num_triangles/2+3);
+	indices.reserve(indices.size()+3*num_triangles);
+
+	vertex_welder welder(o_vb,m_weld_tolerance);
+	aabb box;
+	const char* record = i_begin+header_size+4;
+	for (std::size_t i=0;i<num_triangles;i++,record+=triangle_size)
+	{
+		// Skip the normal
+		const char* position = record+12;
+		for (unsigned int corner=0;corner<3;corner++,position+=12)
+		{
+			const point3d vertex(read_float(position),read_float(position+4),read_float(position+8));
+			box.include(vertex);
+			indices.push_back(welder.add(vertex));
+		}
+	}
+
+	if (o_box)
+	{
+		*o_box = box;
+	}
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::stl_file::write(const std::string& i_filename, const vertex_array& i_vb, const index_array& i_ib) const
+{
+	std::ofstream file_handler(i_filename.c_str(),std::ios::out|std::ios::binary);
+	if (!file_handler.is_open())
+		return false;
+
+	char header[header_size+4];
+	memset(header,0,header_size);
+	strncpy(header,"binary stl - shiva-metamorphosis",header_size);
+	const unsigned int num_triangles = static_cast<unsigned int>(i_ib.size()/3);
+	write_uint(num_triangles,header+header_size);
+	file_handler.write(header,sizeof(header));
+
+	char record[triangle_size];
+	memset(record,0,triangle_size);
+	for (unsigned int i=0;i<num_triangles;i++)
+	{
+		const point3d& a = i_vb[i_ib[3*i+0]];
+		const point3d& b = i_vb[i_ib[3*i+1]];
+		const point3d& c = i_vb[i_ib[3*i+2]];
+		point3d normal;
+		normal.cross(b-a,c-a);
+		const float length = sqrtf(normal.length_squared());
+		if (length>0.f)
+			normal /= length;
+
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			write_float(normal[axis],record+4*axis);
+			write_float(a[axis],record+12+4*axis);
+			write_float(b[axis],record+24+4*axis);
+			write_float(c[axis],record+36+4*axis);
+		}
+		file_handler.write(record,triangle_size);
+	}
+
+	file_handler.close();
+
+	return true;
+}
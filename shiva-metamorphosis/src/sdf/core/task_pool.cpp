@@ -0,0 +1,115 @@
+#include <sdf/core/task_pool.hpp>
+#include <assert.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Pack a range of task ids in one word
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned long long pack_range(unsigned int i_first, unsigned int i_end)
+	{
+		return ((unsigned long long)i_end<<32)|(unsigned long long)i_first;
+	}
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief First task id of a packed range
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned int range_first(unsigned long long i_packed)
+	{
+		return (unsigned int)(i_packed&0xffffffffull);
+	}
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief End marker of a packed range
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned int range_end(unsigned long long i_packed)
+	{
+		return (unsigned int)(i_packed>>32);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::thread::task_pool::task_pool(unsigned int i_num_threads)
+	: m_num_threads(i_num_threads), m_num_active(0), m_ranges(i_num_threads ? i_num_threads : std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1)
+{
+	m_num_threads = (unsigned int)m_ranges.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::thread::task_pool::split(unsigned int i_num_tasks)
+{
+	m_num_active = i_num_tasks<m_num_threads ? i_num_tasks : m_num_threads;
+	assert(m_num_active>0);
+
+	const unsigned int num_tasks_per_thread = i_num_tasks/m_num_active;
+	const unsigned int num_extra_tasks = i_num_tasks%m_num_active;
+	unsigned int first(0);
+	for (unsigned int i=0;i<m_num_active;i++)
+	{
+		const unsigned int end = first+num_tasks_per_thread+(i<num_extra_tasks ? 1 : 0);
+		m_ranges[i].m_packed.store(pack_range(first,end),std::memory_order_relaxed);
+		first = end;
+	}
+	// Thread creation publishes the ranges, no fence needed
+	return m_num_active;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::thread::task_pool::next_task(unsigned int i_thread, unsigned int* o_id)
+{
+	std::atomic<unsigned long long>& own = m_ranges[i_thread].m_packed;
+	unsigned long long packed = own.load(std::memory_order_relaxed);
+	// Front of our own range - only thieves compete with us here, and they take from the back
+	while (range_first(packed)<range_end(packed))
+	{
+		if (own.compare_exchange_weak(packed,pack_range(range_first(packed)+1,range_end(packed)),std::memory_order_relaxed))
+		{
+			*o_id = range_first(packed);
+			return true;
+		}
+	}
+
+	unsigned int first(0), end(0);
+	if (!steal(i_thread,&first,&end))
+		return false;
+
+	// Keep the first stolen task, the rest becomes our range (and can be stolen again)
+	own.store(pack_range(first+1,end),std::memory_order_relaxed);
+	*o_id = first;
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::thread::task_pool::steal(unsigned int i_thread, unsigned int* o_first, unsigned int* o_end)
+{
+	// Keep trying while any range is not empty
+	for (;;)
+	{
+		unsigned int victim = i_thread;
+		unsigned long long victim_packed(0);
+		unsigned int victim_size(0);
+		for (unsigned int i=1;i<m_num_active;i++)
+		{
+			const unsigned int candidate = (i_thread+i)%m_num_active;
+			const unsigned long long packed = m_ranges[candidate].m_packed.load(std::memory_order_relaxed);
+			const unsigned int first = range_first(packed);
+			const unsigned int end = range_end(packed);
+			if (first<end && end-first>victim_size)
+			{
+				victim = candidate;
+				victim_packed = packed;
+				victim_size = end-first;
+			}
+		}
+		if (victim_size==0)
+			return false;
+
+		const unsigned int first = range_first(victim_packed);
+		const unsigned int end = range_end(victim_packed);
+		const unsigned int split_id = end-(victim_size+1)/2;
+		if (m_ranges[victim].m_packed.compare_exchange_strong(victim_packed,pack_range(first,split_id),std::memory_order_relaxed))
+		{
+			*o_first = split_id;
+			*o_end = end;
+			return true;
+		}
+	}
+}
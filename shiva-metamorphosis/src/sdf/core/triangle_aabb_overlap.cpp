@@ -1,6 +1,11 @@
 #include <math.h>
 #include <sdf/core/tools.hpp>
 #include <sdf/core/triangle_aabb_overlap.hpp>
+#include <sdf/core/config.hpp>
+
+#ifdef SDF_USE_SSE
+#include <emmintrin.h>
+#endif
 
 namespace sdf
 {
@@ -11,6 +16,79 @@ namespace sdf
 	}
 }
 
+#ifdef SDF_USE_SSE
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief 3 coordinates of 4 lanes
+	//----------------------------------------------------------------------------------------------------------------------
+	struct vector4x3
+	{
+		__m128 m_v[3];
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Absolute value of 4 lanes
+	//----------------------------------------------------------------------------------------------------------------------
+	inline __m128 abs4(__m128 i_value)
+	{
+		return _mm_and_ps(i_value,_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Separating axis test of two projections against a radius, the lanes set are separated
+	//----------------------------------------------------------------------------------------------------------------------
+	inline __m128 separated(__m128 i_first, __m128 i_second, __m128 i_radius)
+	{
+		const __m128 minimum = _mm_min_ps(i_first,i_second);
+		const __m128 maximum = _mm_max_ps(i_first,i_second);
+		const __m128 negative = _mm_sub_ps(_mm_setzero_ps(),i_radius);
+		return _mm_or_ps(_mm_cmpgt_ps(minimum,i_radius),_mm_cmplt_ps(maximum,negative));
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The 3 axis tests of an edge (edge cross x, y and z), see triangle_box_overlap for the single box version
+	/// @param[in] i_edge The edge
+	/// @param[in] i_a,i_b The two vertices to project for the x axis
+	/// @param[in] i_c,i_d The two vertices to project for the y axis
+	/// @param[in] i_e,i_f The two vertices to project for the z axis
+	/// @param[in] i_half The half extent
+	/// @return The lanes set are separated
+	//----------------------------------------------------------------------------------------------------------------------
+	inline __m128 edge_separated(
+		const vector4x3& i_edge,
+		const vector4x3& i_a, const vector4x3& i_b,
+		const vector4x3& i_c, const vector4x3& i_d,
+		const vector4x3& i_e, const vector4x3& i_f,
+		const __m128 i_half[3])
+	{
+		const __m128 fex = abs4(i_edge.m_v[0]);
+		const __m128 fey = abs4(i_edge.m_v[1]);
+		const __m128 fez = abs4(i_edge.m_v[2]);
+		const __m128 ex = i_edge.m_v[0];
+		const __m128 ey = i_edge.m_v[1];
+		const __m128 ez = i_edge.m_v[2];
+		const __m128 minus_ez = _mm_sub_ps(_mm_setzero_ps(),ez);
+		// X: ez*vy - ey*vz
+		__m128 result = separated(
+			_mm_sub_ps(_mm_mul_ps(ez,i_a.m_v[1]),_mm_mul_ps(ey,i_a.m_v[2])),
+			_mm_sub_ps(_mm_mul_ps(ez,i_b.m_v[1]),_mm_mul_ps(ey,i_b.m_v[2])),
+			_mm_add_ps(_mm_mul_ps(fez,i_half[1]),_mm_mul_ps(fey,i_half[2])));
+		// Y: -ez*vx + ex*vz
+		result = _mm_or_ps(result,separated(
+			_mm_add_ps(_mm_mul_ps(minus_ez,i_c.m_v[0]),_mm_mul_ps(ex,i_c.m_v[2])),
+			_mm_add_ps(_mm_mul_ps(minus_ez,i_d.m_v[0]),_mm_mul_ps(ex,i_d.m_v[2])),
+			_mm_add_ps(_mm_mul_ps(fez,i_half[0]),_mm_mul_ps(fex,i_half[2]))));
+		// Z: ey*vx - ex*vy
+		result = _mm_or_ps(result,separated(
+			_mm_sub_ps(_mm_mul_ps(ey,i_e.m_v[0]),_mm_mul_ps(ex,i_e.m_v[1])),
+			_mm_sub_ps(_mm_mul_ps(ey,i_f.m_v[0]),_mm_mul_ps(ex,i_f.m_v[1])),
+			_mm_add_ps(_mm_mul_ps(fey,i_half[0]),_mm_mul_ps(fex,i_half[1]))));
+		return result;
+	}
+}
+#endif
+
 //----------------------------------------------------------------------------------------------------------------------
 bool sdf::triangle_box_overlap(const point3d& i_centre, const vector3d& i_halfextent, const point3d& i_first, const point3d& i_second, const point3d& i_third)
 {
@@ -194,6 +272,72 @@ bool sdf::triangle_box_overlap(const point3d& i_centre, const vector3d& i_halfex
 
 
 
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::triangle_box_overlap(const float i_centres[3][4], const vector3d& i_halfextent, const point3d& i_first, const point3d& i_second, const point3d& i_third)
+{
+#ifdef SDF_USE_SSE
+	// Same tests as the single box version, each lane being a box
+	vector4x3 v0,v1,v2;
+	__m128 half[3];
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		const __m128 centre = _mm_loadu_ps(i_centres[axis]);
+		v0.m_v[axis] = _mm_sub_ps(_mm_set1_ps(i_first[axis]),centre);
+		v1.m_v[axis] = _mm_sub_ps(_mm_set1_ps(i_second[axis]),centre);
+		v2.m_v[axis] = _mm_sub_ps(_mm_set1_ps(i_third[axis]),centre);
+		half[axis] = _mm_set1_ps(i_halfextent[axis]);
+	}
+	vector4x3 e0,e1,e2;
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		e0.m_v[axis] = _mm_sub_ps(v1.m_v[axis],v0.m_v[axis]);
+		e1.m_v[axis] = _mm_sub_ps(v2.m_v[axis],v1.m_v[axis]);
+		e2.m_v[axis] = _mm_sub_ps(v0.m_v[axis],v2.m_v[axis]);
+	}
+
+	// Bullet 3: the 9 edge axes
+	__m128 rejected = edge_separated(e0,v0,v2,v0,v2,v1,v2,half);
+	rejected = _mm_or_ps(rejected,edge_separated(e1,v0,v2,v0,v2,v0,v1,half));
+	rejected = _mm_or_ps(rejected,edge_separated(e2,v0,v1,v0,v1,v1,v2,half));
+
+	// Bullet 1: the box axes
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		const __m128 minimum = _mm_min_ps(_mm_min_ps(v0.m_v[axis],v1.m_v[axis]),v2.m_v[axis]);
+		const __m128 maximum = _mm_max_ps(_mm_max_ps(v0.m_v[axis],v1.m_v[axis]),v2.m_v[axis]);
+		rejected = _mm_or_ps(rejected,_mm_cmpgt_ps(minimum,half[axis]));
+		rejected = _mm_or_ps(rejected,_mm_cmplt_ps(maximum,_mm_sub_ps(_mm_setzero_ps(),half[axis])));
+	}
+
+	// Bullet 2: the plane of the triangle. n.vmax is the sum of |n|*half, and n.vmin is its opposite
+	vector4x3 normal;
+	normal.m_v[0] = _mm_sub_ps(_mm_mul_ps(e0.m_v[1],e1.m_v[2]),_mm_mul_ps(e0.m_v[2],e1.m_v[1]));
+	normal.m_v[1] = _mm_sub_ps(_mm_mul_ps(e0.m_v[2],e1.m_v[0]),_mm_mul_ps(e0.m_v[0],e1.m_v[2]));
+	normal.m_v[2] = _mm_sub_ps(_mm_mul_ps(e0.m_v[0],e1.m_v[1]),_mm_mul_ps(e0.m_v[1],e1.m_v[0]));
+	const __m128 d = _mm_sub_ps(_mm_setzero_ps(),_mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(normal.m_v[0],v0.m_v[0]),
+		_mm_mul_ps(normal.m_v[1],v0.m_v[1])),
+		_mm_mul_ps(normal.m_v[2],v0.m_v[2])));
+	const __m128 reach = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(abs4(normal.m_v[0]),half[0]),
+		_mm_mul_ps(abs4(normal.m_v[1]),half[1])),
+		_mm_mul_ps(abs4(normal.m_v[2]),half[2]));
+	rejected = _mm_or_ps(rejected,_mm_cmpgt_ps(_mm_add_ps(_mm_sub_ps(_mm_setzero_ps(),reach),d),_mm_setzero_ps()));
+	rejected = _mm_or_ps(rejected,_mm_cmpnge_ps(_mm_add_ps(reach,d),_mm_setzero_ps()));
+
+	return static_cast<unsigned int>(~_mm_movemask_ps(rejected))&0xf;
+#else
+	unsigned int result(0);
+	for (unsigned int i=0;i<4;i++)
+	{
+		const point3d centre(i_centres[0][i],i_centres[1][i],i_centres[2][i]);
+		if (triangle_box_overlap(centre,i_halfextent,i_first,i_second,i_third))
+			result |= 1<<i;
+	}
+	return result;
+#endif
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 bool sdf::detail::plane_box(const vector3d& i_normal, float i_dist, const vector3d& i_max)
 {
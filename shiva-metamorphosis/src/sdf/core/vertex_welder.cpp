@@ -0,0 +1,188 @@
+#include <sdf/core/vertex_welder.hpp>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Initial number of slots
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int initial_log_size = 10;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Compare two cells
+	//----------------------------------------------------------------------------------------------------------------------
+	bool same_cell(const int a[], const int b[])
+	{
+		return a[0]==b[0] && a[1]==b[1] && a[2]==b[2];
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+const sdf::index_type sdf::vertex_welder::no_vertex;
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::vertex_welder::vertex_welder(vertex_array* io_vertices, float i_tolerance) :
+	m_vertices(*io_vertices),
+	m_tolerance(i_tolerance),
+	m_tolerance_squared(i_tolerance*i_tolerance),
+	m_shift(64-initial_log_size),
+	m_num_used(0)
+{
+	assert(i_tolerance>=0.f);
+	slot empty = { {0,0,0}, no_vertex };
+	m_slots.assign(std::size_t(1)<<initial_log_size,empty);
+
+	// The vertices already there can be merged with but are not merged together
+	m_next.assign(m_vertices.size(),no_vertex);
+	for (index_type i=0;i<static_cast<index_type>(m_vertices.size());i++)
+	{
+		int cell[3];
+		cell_of(m_vertices[i],cell);
+		insert(cell,i);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::index_type sdf::vertex_welder::add(const vertex_type& i_vertex)
+{
+	int cell[3];
+	cell_of(i_vertex,cell);
+
+	if (m_tolerance>0.f)
+	{
+		// The closest vertex can be in any neighbour cell
+		for (int dz=-1;dz<=1;dz++)
+		{
+			for (int dy=-1;dy<=1;dy++)
+			{
+				for (int dx=-1;dx<=1;dx++)
+				{
+					const int neighbour[3] = { cell[0]+dx,cell[1]+dy,cell[2]+dz };
+					const index_type found = search(neighbour,i_vertex);
+					if (found!=no_vertex)
+						return found;
+				}
+			}
+		}
+	}
+	else
+	{
+		const index_type found = search(cell,i_vertex);
+		if (found!=no_vertex)
+			return found;
+	}
+
+	const index_type index = static_cast<index_type>(m_vertices.size());
+	m_vertices.push_back(i_vertex);
+	m_next.push_back(no_vertex);
+	insert(cell,index);
+	return index;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::vertex_welder::weld(vertex_array* io_vertices, index_array* io_indices, float i_tolerance)
+{
+	const vertex_array input(*io_vertices);
+	io_vertices->clear();
+	vertex_welder welder(io_vertices,i_tolerance);
+
+	// Only the vertices used by a face are added
+	std::vector<index_type> remap(input.size(),no_vertex);
+	index_array& indices = *io_indices;
+	for (std::size_t i=0;i<indices.size();i++)
+	{
+		assert(indices[i]<input.size());
+		index_type& target = remap[indices[i]];
+		if (target==no_vertex)
+			target = welder.add(input[indices[i]]);
+		indices[i] = target;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::vertex_welder::cell_of(const vertex_type& i_vertex, int o_cell[]) const
+{
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		if (m_tolerance>0.f)
+		{
+			// Clamped so the neighbours do not overflow
+			const float cell = floorf(i_vertex[axis]/m_tolerance);
+			o_cell[axis] = cell<-1e9f ? -1000000000 : (cell>1e9f ? 1000000000 : static_cast<int>(cell));
+		}
+		else
+		{
+			// -0 and +0 are the same position
+			const float value = i_vertex[axis]+0.f;
+			memcpy(o_cell+axis,&value,sizeof(int));
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::size_t sdf::vertex_welder::find(const int i_cell[]) const
+{
+	const unsigned long long key =
+		static_cast<unsigned long long>(static_cast<unsigned int>(i_cell[0]))*0x9E3779B97F4A7C15ull ^
+		static_cast<unsigned long long>(static_cast<unsigned int>(i_cell[1]))*0xC2B2AE3D27D4EB4Full ^
+		static_cast<unsigned long long>(static_cast<unsigned int>(i_cell[2]))*0x165667B19E3779F9ull;
+	const std::size_t mask = m_slots.size()-1;
+	std::size_t position = static_cast<std::size_t>((key*0x9E3779B97F4A7C15ull)>>m_shift);
+	while (m_slots[position].m_first!=no_vertex && !same_cell(m_slots[position].m_cell,i_cell))
+		position = (position+1)&mask;
+	return position;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::index_type sdf::vertex_welder::search(const int i_cell[], const vertex_type& i_vertex) const
+{
+	for (index_type i=m_slots[find(i_cell)].m_first;i!=no_vertex;i=m_next[i])
+	{
+		const vertex_type& other = m_vertices[i];
+		if (m_tolerance>0.f)
+		{
+			if ((other-i_vertex).length_squared()<=m_tolerance_squared)
+				return i;
+		}
+		else if (other[0]==i_vertex[0] && other[1]==i_vertex[1] && other[2]==i_vertex[2])
+		{
+			return i;
+		}
+	}
+	return no_vertex;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::vertex_welder::insert(const int i_cell[], index_type i_vertex)
+{
+	if (2*(m_num_used+1)>m_slots.size())
+		grow();
+
+	slot& target = m_slots[find(i_cell)];
+	if (target.m_first==no_vertex)
+	{
+		target.m_cell[0] = i_cell[0];
+		target.m_cell[1] = i_cell[1];
+		target.m_cell[2] = i_cell[2];
+		m_num_used++;
+	}
+	m_next[i_vertex] = target.m_first;
+	target.m_first = i_vertex;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::vertex_welder::grow()
+{
+	std::vector<slot> old;
+	old.swap(m_slots);
+	slot empty = { {0,0,0}, no_vertex };
+	m_slots.assign(old.size()*2,empty);
+	m_shift--;
+	for (std::size_t i=0;i<old.size();i++)
+	{
+		if (old[i].m_first!=no_vertex)
+			m_slots[find(old[i].m_cell)] = old[i];
+	}
+}
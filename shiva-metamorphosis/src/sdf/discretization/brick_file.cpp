@@ -0,0 +1,542 @@
+#include <sdf/discretization/brick_file.hpp>
+#include <sdf/core/binary_file.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <sdf/profiler/scope.hpp>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Header of a .cbf file, the brick index follows then the bricks data
+	//----------------------------------------------------------------------------------------------------------------------
+	struct cbf_header
+	{
+		char m_magic[4];
+		unsigned int m_version;
+		unsigned int m_brick_size;
+		unsigned int m_bits;
+		unsigned int m_size[3];
+		float m_min[3];
+		float m_max[3];
+		float m_band;
+		unsigned int m_reserved[2];
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief First bytes of a file
+	//----------------------------------------------------------------------------------------------------------------------
+	const char cbf_magic[4] = { 'S','C','B','F' };
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Current version
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int cbf_version = 1;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of residuals sharing the same bit width
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int group_size = 64;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Lorenzo prediction of a sample from the 7 previous corners of its cell, 0 outside the brick
+	/// @param[in] i_q The quantised samples of the brick, X first
+	/// @param[in] i_size The brick size
+	/// @param[in] i_x Index in X
+	/// @param[in] i_y Index in Y
+	/// @param[in] i_z Index in Z
+	//----------------------------------------------------------------------------------------------------------------------
+	int predict(const int* i_q, const unsigned int i_size[3], unsigned int i_x, unsigned int i_y, unsigned int i_z)
+	{
+		const unsigned int sy = i_size[0];
+		const unsigned int sz = i_size[0]*i_size[1];
+		const int* q = i_q+i_x+i_y*sy+i_z*sz;
+		int prediction(0);
+		if (i_x)
+			prediction += q[-1];
+		if (i_y)
+			prediction += q[-int(sy)];
+		if (i_z)
+			prediction += q[-int(sz)];
+		if (i_x && i_y)
+			prediction -= q[-1-int(sy)];
+		if (i_x && i_z)
+			prediction -= q[-1-int(sz)];
+		if (i_y && i_z)
+			prediction -= q[-int(sy)-int(sz)];
+		if (i_x && i_y && i_z)
+			prediction += q[-1-int(sy)-int(sz)];
+		return prediction;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Bit pack the residuals, each group starts with its bit width on a byte and is padded to a byte
+	/// @param[in] i_values The zigzag encoded residuals
+	/// @param[out] o_bytes The packed data
+	//----------------------------------------------------------------------------------------------------------------------
+	void pack(const std::vector<unsigned int>& i_values, std::vector<unsigned char>* o_bytes)
+	{
+		for (std::size_t first=0;first<i_values.size();first+=group_size)
+		{
+			const std::size_t end = std::min(first+group_size,i_values.size());
+			unsigned int all(0);
+			for (std::size_t i=first;i<end;i++)
+				all |= i_values[i];
+			unsigned int width(0);
+			while (width<32 && (all>>width)!=0)
+				width++;
+			o_bytes->push_back(static_cast<unsigned char>(width));
+
+			unsigned long long bits(0);
+			unsigned int num_bits(0);
+			for (std::size_t i=first;i<end;i++)
+			{
+				bits |= static_cast<unsigned long long>(i_values[i])<<num_bits;
+				num_bits += width;
+				while (num_bits>=8)
+				{
+					o_bytes->push_back(static_cast<unsigned char>(bits&0xff));
+					bits >>= 8;
+					num_bits -= 8;
+				}
+			}
+			if (num_bits>0)
+				o_bytes->push_back(static_cast<unsigned char>(bits&0xff));
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Unpack the residuals written by pack
+	/// @param[in] i_begin The packed data
+	/// @param[in] i_end End marker of the packed data
+	/// @param[in] i_count The number of residuals
+	/// @param[out] o_values The zigzag encoded residuals
+	/// @return False if the data is too short
+	//----------------------------------------------------------------------------------------------------------------------
+	bool unpack(const unsigned char* i_begin, const unsigned char* i_end, std::size_t i_count, unsigned int* o_values)
+	{
+		const unsigned char* position = i_begin;
+		for (std::size_t first=0;first<i_count;first+=group_size)
+		{
+			const std::size_t count = std::min<std::size_t>(group_size,i_count-first);
+			if (position>=i_end)
+				return false;
+			const unsigned int width = *position++;
+			if (width>32 || static_cast<std::size_t>(i_end-position)<(count*width+7)/8)
+				return false;
+			const unsigned long long mask = (1ull<<width)-1;
+
+			unsigned long long bits(0);
+			unsigned int num_bits(0);
+			for (std::size_t i=0;i<count;i++)
+			{
+				while (num_bits<width)
+				{
+					bits |= static_cast<unsigned long long>(*position++)<<num_bits;
+					num_bits += 8;
+				}
+				o_values[first+i] = static_cast<unsigned int>(bits&mask);
+				bits >>= width;
+				num_bits -= width;
+			}
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Samples covered by a brick along one direction
+	//----------------------------------------------------------------------------------------------------------------------
+	void axis_range(unsigned int i_brick, unsigned int i_brick_size, unsigned int i_size, unsigned int* o_first, unsigned int* o_size)
+	{
+		*o_first = i_brick*i_brick_size;
+		*o_size = std::min(i_brick_size,i_size-*o_first);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class brick_encoder
+	/// @brief The task given to the thread::task_pool by brick_file::write - clamp, quantise and pack one brick
+	//----------------------------------------------------------------------------------------------------------------------
+	class brick_encoder
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor
+		/// @param[in] i_grid The samples
+		/// @param[in] i_header The file header (sizes, bits and band)
+		/// @param[in] i_num_bricks Number of bricks in each direction
+		/// @param[in] i_num_threads Number of threads running the task
+		//----------------------------------------------------------------------------------------------------------------------
+		brick_encoder(const sdf::grid& i_grid, const cbf_header& i_header, const unsigned int i_num_bricks[3], unsigned int i_num_threads) :
+			m_grid(i_grid), m_header(i_header),
+			m_entries(i_num_bricks[0]*i_num_bricks[1]*i_num_bricks[2]),
+			m_payloads(m_entries.size()),
+			m_samples(i_num_threads), m_quantized(i_num_threads), m_residuals(i_num_threads)
+		{
+			for (unsigned int axis=0;axis<3;axis++)
+				m_num_bricks[axis] = i_num_bricks[axis];
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Encode one brick
+		/// @param[in] i_brick The brick id
+		/// @param[in] i_thread The thread id
+		//----------------------------------------------------------------------------------------------------------------------
+		void operator()(unsigned int i_brick, unsigned int i_thread)
+		{
+			const unsigned int id[3] = { i_brick%m_num_bricks[0],(i_brick/m_num_bricks[0])%m_num_bricks[1],i_brick/(m_num_bricks[0]*m_num_bricks[1]) };
+			unsigned int first[3], size[3];
+			for (unsigned int axis=0;axis<3;axis++)
+				axis_range(id[axis],m_header.m_brick_size,m_header.m_size[axis],first+axis,size+axis);
+			const unsigned int count = size[0]*size[1]*size[2];
+
+			std::vector<float>& samples = m_samples[i_thread];
+			samples.resize(count);
+			float low(0.f), high(0.f);
+			unsigned int index(0);
+			for (unsigned int k=0;k<size[2];k++)
+			{
+				for (unsigned int j=0;j<size[1];j++)
+				{
+					for (unsigned int i=0;i<size[0];i++,index++)
+					{
+						float value = m_grid(first[0]+i,first[1]+j,first[2]+k);
+						if (m_header.m_band>0.f)
+							value = std::max(-m_header.m_band,std::min(m_header.m_band,value));
+						samples[index] = value;
+						low = index ? std::min(low,value) : value;
+						high = index ? std::max(high,value) : value;
+					}
+				}
+			}
+
+			sdf::brick_file::brick_entry& entry = m_entries[i_brick];
+			entry.m_offset = 0;
+			if (!(high>low))
+			{
+				// Far from the surface every sample is clamped to the band
+				entry.m_type = sdf::brick_file::constant_brick;
+				entry.m_minimum = low;
+				entry.m_scale = 0.f;
+				entry.m_size = 0;
+				return;
+			}
+
+			// Zero is always one of the levels, the surface is where the renderers look for it. A brick crossing the surface
+			// spreads its levels on both sides of zero, in proportion to its range on each side
+			const int levels = static_cast<int>((1u<<m_header.m_bits)-1);
+			int zero_level(0);
+			if (high<=0.f)
+			{
+				zero_level = levels;
+				entry.m_scale = -low/static_cast<float>(levels);
+			}
+			else if (low<0.f)
+			{
+				zero_level = static_cast<int>(floorf(-low/(high-low)*static_cast<float>(levels)+0.5f));
+				zero_level = std::min(levels-1,std::max(1,zero_level));
+				entry.m_scale = std::max(-low/static_cast<float>(zero_level),high/static_cast<float>(levels-zero_level));
+			}
+			else
+				entry.m_scale = high/static_cast<float>(levels);
+			// minimum+zero_level*scale is then exactly 0 when decoded
+			entry.m_minimum = -static_cast<float>(zero_level)*entry.m_scale;
+
+			std::vector<int>& quantized = m_quantized[i_thread];
+			quantized.resize(count);
+			const float inverse_scale = 1.f/entry.m_scale;
+			for (unsigned int i=0;i<count;i++)
+			{
+				int level = zero_level+static_cast<int>(floorf(samples[i]*inverse_scale+0.5f));
+				// A sample close to the surface keeps its side, one level away from zero
+				if (samples[i]>0.f)
+					level = std::max(level,zero_level+1);
+				else if (samples[i]<0.f)
+					level = std::min(level,zero_level-1);
+				quantized[i] = std::min(levels,std::max(0,level));
+			}
+
+			std::vector<unsigned int>& residuals = m_residuals[i_thread];
+			residuals.resize(count);
+			index = 0;
+			for (unsigned int k=0;k<size[2];k++)
+			{
+				for (unsigned int j=0;j<size[1];j++)
+				{
+					for (unsigned int i=0;i<size[0];i++,index++)
+					{
+						// Zigzag so the small negative residuals need few bits too
+						const int residual = quantized[index]-predict(&quantized[0],size,i,j,k);
+						residuals[index] = (static_cast<unsigned int>(residual)<<1)^static_cast<unsigned int>(residual>>31);
+					}
+				}
+			}
+
+			std::vector<unsigned char>& payload = m_payloads[i_brick];
+			pack(residuals,&payload);
+			entry.m_type = sdf::brick_file::quantized_brick;
+			entry.m_size = static_cast<unsigned int>(payload.size());
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the index entries, the offsets are not set
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<sdf::brick_file::brick_entry>& entries() { return m_entries; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the packed data of each brick
+		//----------------------------------------------------------------------------------------------------------------------
+		const std::vector< std::vector<unsigned char> >& payloads() const { return m_payloads; }
+	private :
+		const sdf::grid& m_grid;
+		const cbf_header& m_header;
+		unsigned int m_num_bricks[3];
+		std::vector<sdf::brick_file::brick_entry> m_entries;
+		std::vector< std::vector<unsigned char> > m_payloads;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Per-thread buffers
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector< std::vector<float> > m_samples;
+		std::vector< std::vector<int> > m_quantized;
+		std::vector< std::vector<unsigned int> > m_residuals;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class brick_decoder
+	/// @brief The task given to the thread::task_pool by brick_file::read - decode one brick into the grid
+	//----------------------------------------------------------------------------------------------------------------------
+	class brick_decoder
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor
+		/// @param[in] i_file The brick file
+		/// @param[out] o_grid The grid to fill, already at the right size
+		/// @param[in] i_num_threads Number of threads running the task
+		//----------------------------------------------------------------------------------------------------------------------
+		brick_decoder(const sdf::brick_file& i_file, sdf::grid* o_grid, unsigned int i_num_threads) :
+			m_file(i_file), m_grid(*o_grid), m_samples(i_num_threads), m_failed(false)
+		{
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Decode one brick
+		/// @param[in] i_brick The brick id
+		/// @param[in] i_thread The thread id
+		//----------------------------------------------------------------------------------------------------------------------
+		void operator()(unsigned int i_brick, unsigned int i_thread)
+		{
+			unsigned int first[3], size[3];
+			m_file.brick_range(i_brick,first,size);
+			std::vector<float>& samples = m_samples[i_thread];
+			samples.resize(size[0]*size[1]*size[2]);
+			if (!m_file.read_brick(i_brick,&samples[0]))
+			{
+				m_failed = true;
+				return;
+			}
+			unsigned int index(0);
+			for (unsigned int k=0;k<size[2];k++)
+			{
+				for (unsigned int j=0;j<size[1];j++)
+				{
+					for (unsigned int i=0;i<size[0];i++,index++)
+						m_grid(first[0]+i,first[1]+j,first[2]+k) = samples[index];
+				}
+			}
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check if a brick could not be decoded
+		//----------------------------------------------------------------------------------------------------------------------
+		bool failed() const { return m_failed; }
+	private :
+		const sdf::brick_file& m_file;
+		sdf::grid& m_grid;
+		std::vector< std::vector<float> > m_samples;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Set when a brick could not be decoded
+		//----------------------------------------------------------------------------------------------------------------------
+		std::atomic<bool> m_failed;
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::brick_file::brick_file(const std::string& i_filename) :
+	m_file(i_filename),
+	m_index(0),
+	m_brick_size(0)
+{
+	assert(sizeof(cbf_header)==64 && sizeof(brick_entry)==24);
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		m_size[axis] = 0;
+		m_num_bricks[axis] = 0;
+	}
+	if (!m_file.is_open() || !is_brick_file(m_file.data(),m_file.size()) || m_file.size()<sizeof(cbf_header))
+		return;
+
+	cbf_header header;
+	memcpy(&header,m_file.data(),sizeof(header));
+	if (header.m_version>cbf_version || (header.m_brick_size!=8 && header.m_brick_size!=16))
+		return;
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		m_size[axis] = header.m_size[axis];
+		m_num_bricks[axis] = (header.m_size[axis]+header.m_brick_size-1)/header.m_brick_size;
+	}
+	m_brick_size = header.m_brick_size;
+	m_min = point3d(header.m_min[0],header.m_min[1],header.m_min[2]);
+	m_max = point3d(header.m_max[0],header.m_max[1],header.m_max[2]);
+
+	// Every brick has to be inside the file, then no read needs to check it again
+	const std::size_t count = std::size_t(m_num_bricks[0])*m_num_bricks[1]*m_num_bricks[2];
+	if ((m_file.size()-sizeof(cbf_header))/sizeof(brick_entry)<count)
+		return;
+	const brick_entry* index = reinterpret_cast<const brick_entry*>(m_file.data()+sizeof(cbf_header));
+	for (std::size_t i=0;i<count;i++)
+	{
+		if (index[i].m_offset>m_file.size() || m_file.size()-index[i].m_offset<index[i].m_size)
+			return;
+		if (index[i].m_type!=constant_brick && index[i].m_type!=quantized_brick)
+			return;
+	}
+	m_index = index;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::brick_file::brick_range(unsigned int i_brick, unsigned int o_first[3], unsigned int o_size[3]) const
+{
+	assert(i_brick<num_bricks());
+	const unsigned int id[3] = { i_brick%m_num_bricks[0],(i_brick/m_num_bricks[0])%m_num_bricks[1],i_brick/(m_num_bricks[0]*m_num_bricks[1]) };
+	for (unsigned int axis=0;axis<3;axis++)
+		axis_range(id[axis],m_brick_size,m_size[axis],o_first+axis,o_size+axis);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::brick_file::read_brick(unsigned int i_brick, float* o_samples) const
+{
+	assert(is_open());
+	unsigned int first[3], size[3];
+	brick_range(i_brick,first,size);
+	const unsigned int count = size[0]*size[1]*size[2];
+	const brick_entry& brick = m_index[i_brick];
+	if (brick.m_type==constant_brick)
+	{
+		std::fill(o_samples,o_samples+count,brick.m_minimum);
+		return true;
+	}
+
+	// The residuals and the quantised samples share the same buffer
+	std::vector<int> quantized(count);
+	unsigned int* residuals = reinterpret_cast<unsigned int*>(&quantized[0]);
+	const unsigned char* begin = reinterpret_cast<const unsigned char*>(m_file.data()+brick.m_offset);
+	if (!unpack(begin,begin+brick.m_size,count,residuals))
+		return false;
+	unsigned int index(0);
+	for (unsigned int k=0;k<size[2];k++)
+	{
+		for (unsigned int j=0;j<size[1];j++)
+		{
+			for (unsigned int i=0;i<size[0];i++,index++)
+			{
+				const unsigned int zigzag = residuals[index];
+				const int residual = static_cast<int>(zigzag>>1)^-static_cast<int>(zigzag&1);
+				quantized[index] = residual+predict(&quantized[0],size,i,j,k);
+				o_samples[index] = brick.m_minimum+static_cast<float>(quantized[index])*brick.m_scale;
+			}
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::brick_file::read(sdf::grid* o_grid, unsigned int i_num_threads) const
+{
+	SDF_PROFILE(brick_file_read)
+	assert(is_open());
+	*o_grid = sdf::grid(m_size[0],m_size[1],m_size[2]);
+	if (num_bricks()==0)
+		return true;
+	thread::task_pool pool(i_num_threads);
+	brick_decoder decoder(*this,o_grid,pool.num_threads());
+	pool.run(num_bricks(),decoder);
+	return !decoder.failed();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::brick_file::write(
+	const std::string& i_filename,
+	const sdf::grid& i_grid,
+	const point3d& i_min,
+	const point3d& i_max,
+	unsigned int i_brick_size,
+	unsigned int i_bits,
+	float i_band,
+	unsigned int i_num_threads)
+{
+	SDF_PROFILE(brick_file_write)
+	assert(i_brick_size==8 || i_brick_size==16);
+	assert(i_bits==8 || i_bits==16);
+
+	cbf_header header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.m_magic,cbf_magic,sizeof(cbf_magic));
+	header.m_version = cbf_version;
+	header.m_brick_size = i_brick_size;
+	header.m_bits = i_bits;
+	header.m_size[0] = i_grid.width();
+	header.m_size[1] = i_grid.height();
+	header.m_size[2] = i_grid.depth();
+	float spacing(0.f);
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		header.m_min[axis] = i_min[axis];
+		header.m_max[axis] = i_max[axis];
+		if (header.m_size[axis]>1)
+			spacing = std::max(spacing,(i_max[axis]-i_min[axis])/(header.m_size[axis]-1));
+	}
+	header.m_band = i_band*spacing;
+
+	unsigned int num_bricks[3];
+	for (unsigned int axis=0;axis<3;axis++)
+		num_bricks[axis] = (header.m_size[axis]+i_brick_size-1)/i_brick_size;
+	const unsigned int count = num_bricks[0]*num_bricks[1]*num_bricks[2];
+
+	thread::task_pool pool(i_num_threads);
+	brick_encoder encoder(i_grid,header,num_bricks,pool.num_threads());
+	if (count>0)
+		pool.run(count,encoder);
+
+	// The bricks are written in order after the index
+	std::vector<brick_entry>& entries = encoder.entries();
+	unsigned long long offset = sizeof(cbf_header)+count*sizeof(brick_entry);
+	for (unsigned int i=0;i<count;i++)
+	{
+		entries[i].m_offset = offset;
+		offset += entries[i].m_size;
+	}
+
+	binary_file_out file(i_filename);
+	if (!file.is_open())
+		return false;
+	file(header);
+	if (count>0)
+		file(&entries[0],count);
+	const std::vector< std::vector<unsigned char> >& payloads = encoder.payloads();
+	for (unsigned int i=0;i<count;i++)
+	{
+		if (!payloads[i].empty())
+			file(&payloads[i][0],payloads[i].size());
+	}
+	file.close();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::brick_file::is_brick_file(const char* i_data, std::size_t i_size)
+{
+	return i_size>=sizeof(cbf_magic) && memcmp(i_data,cbf_magic,sizeof(cbf_magic))==0;
+}
@@ -1,7 +1,261 @@
 #include <sdf/discretization/discretized_field.hpp>
 #include <sdf/core/tools.hpp>
+#include <sdf/core/triangle_aabb_overlap.hpp>
+#include <sdf/core/mapped_file.hpp>
+#include <sdf/discretization/brick_file.hpp>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
 #include <assert.h>
 
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Header of a version 2 .bdf file, the samples follow at m_data_offset
+	///			Version 1 files (serialize) have no header, they start with the grid size
+	//----------------------------------------------------------------------------------------------------------------------
+	struct bdf_header
+	{
+		char m_magic[4];
+		unsigned int m_version;
+		unsigned int m_data_offset;
+		unsigned int m_size[3];
+		float m_min[3];
+		float m_max[3];
+		unsigned int m_reserved[4];
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief First bytes of a version 2 file
+	//----------------------------------------------------------------------------------------------------------------------
+	const char bdf_magic[4] = { 'S','B','D','F' };
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Current version
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int bdf_version = 2;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Grow the flagged samples by i_radius samples along one axis
+	/// @param[out] io_flags One flag per sample
+	/// @param[in] i_size Number of samples in each direction
+	/// @param[in] i_axis The axis to grow along
+	/// @param[in] i_radius Number of samples to add on each side
+	//----------------------------------------------------------------------------------------------------------------------
+	void dilate(std::vector<unsigned char>* io_flags, const unsigned int i_size[3], unsigned int i_axis, unsigned int i_radius)
+	{
+		const std::vector<unsigned char> source(*io_flags);
+		const unsigned int stride = i_axis==0 ? 1 : (i_axis==1 ? i_size[0] : i_size[0]*i_size[1]);
+		for (unsigned int index=0;index<source.size();index++)
+		{
+			if (!source[index])
+				continue;
+			const unsigned int coordinate = (index/stride)%i_size[i_axis];
+			for (unsigned int d=1;d<=i_radius;d++)
+			{
+				if (coordinate>=d)
+					(*io_flags)[index-d*stride] = 1;
+				if (coordinate+d<i_size[i_axis])
+					(*io_flags)[index+d*stride] = 1;
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Upwind (Godunov) solution of |grad u| = 1 at a sample
+	/// @param[in] i_neighbour The smallest neighbour value along each axis (the largest float if there is none)
+	/// @param[in] i_spacing The distance between samples along each axis
+	/// @return The new value of the sample, the largest float if no neighbour is known yet
+	//----------------------------------------------------------------------------------------------------------------------
+	float eikonal_update(const float i_neighbour[3], const float i_spacing[3])
+	{
+		float a[3] = { i_neighbour[0],i_neighbour[1],i_neighbour[2] };
+		float h[3] = { i_spacing[0],i_spacing[1],i_spacing[2] };
+		// Sort by value, the wavefront comes from the smallest neighbours first
+		for (unsigned int i=1;i<3;i++)
+		{
+			for (unsigned int j=i;j>0 && a[j]<a[j-1];j--)
+			{
+				std::swap(a[j],a[j-1]);
+				std::swap(h[j],h[j-1]);
+			}
+		}
+		if (a[0]==std::numeric_limits<float>::max())
+			return a[0];
+
+		float u = a[0]+h[0];
+		// Sum over the axes used of ((u-a)/h)^2 = 1, adding axes while the solution is past their neighbour
+		float sum_w(0.f), sum_wa(0.f), sum_waa(0.f);
+		for (unsigned int axis=0;axis<3 && u>a[axis];axis++)
+		{
+			const float w = 1.f/(h[axis]*h[axis]);
+			sum_w += w;
+			sum_wa += w*a[axis];
+			sum_waa += w*a[axis]*a[axis];
+			const float discriminant = sum_wa*sum_wa-sum_w*(sum_waa-1.f);
+			u = (sum_wa+sqrtf(std::max(discriminant,0.f)))/sum_w;
+		}
+		return u;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class slab_sweeper
+	/// @brief The task given to the thread::task_pool by extend_band - one Gauss-Seidel sweep of one slab of slices
+	///			Each slab is updated in place by one thread, the slices next to it in the other slabs are read from a copy
+	///			taken before the sweep so threads never read what another one writes. Information crosses a slab border
+	///			once per sweep, so the sweeps are repeated until no sample changes
+	//----------------------------------------------------------------------------------------------------------------------
+	class slab_sweeper
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor
+		/// @param[in] i_size Number of samples in each direction
+		/// @param[in] i_spacing The distance between samples along each axis
+		/// @param[in] i_band The band flags, band samples are never updated
+		/// @param[out] io_distance The unsigned distances to update
+		/// @param[in] i_num_slabs The number of slabs (tasks)
+		//----------------------------------------------------------------------------------------------------------------------
+		slab_sweeper(
+			const unsigned int i_size[3],
+			const float i_spacing[3],
+			const std::vector<unsigned char>& i_band,
+			std::vector<float>* io_distance,
+			unsigned int i_num_slabs) :
+			m_band(i_band), m_distance(*io_distance), m_num_slabs(i_num_slabs),
+			m_ghosts(i_num_slabs*2*i_size[0]*i_size[1]), m_changed(i_num_slabs,0)
+		{
+			for (unsigned int i=0;i<3;i++)
+			{
+				m_size[i] = i_size[i];
+				m_spacing[i] = i_spacing[i];
+				m_direction[i] = 1;
+			}
+			m_tolerance = 1e-4f*std::min(i_spacing[0],std::min(i_spacing[1],i_spacing[2]));
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Prepare the next sweep
+		/// @param[in] i_direction The sweep direction along each axis (1 or -1)
+		//----------------------------------------------------------------------------------------------------------------------
+		void start(const int i_direction[3])
+		{
+			m_direction[0] = i_direction[0];
+			m_direction[1] = i_direction[1];
+			m_direction[2] = i_direction[2];
+			const unsigned int slice = m_size[0]*m_size[1];
+			for (unsigned int slab=0;slab<m_num_slabs;slab++)
+			{
+				if (first_slice(slab)>0)
+					std::copy(&m_distance[(first_slice(slab)-1)*slice],&m_distance[first_slice(slab)*slice],&m_ghosts[(2*slab+0)*slice]);
+				if (end_slice(slab)<m_size[2])
+					std::copy(&m_distance[end_slice(slab)*slice],&m_distance[end_slice(slab)*slice]+slice,&m_ghosts[(2*slab+1)*slice]);
+			}
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Check and clear if any sample changed since the last call
+		/// @return True if a sample changed
+		//----------------------------------------------------------------------------------------------------------------------
+		bool changed()
+		{
+			const bool result = std::find(m_changed.begin(),m_changed.end(),1)!=m_changed.end();
+			std::fill(m_changed.begin(),m_changed.end(),0);
+			return result;
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Sweep one slab
+		/// @param[in] i_slab The slab id
+		/// @param[in] i_thread The thread id
+		//----------------------------------------------------------------------------------------------------------------------
+		void operator()(unsigned int i_slab, unsigned int /*i_thread*/)
+		{
+			const float none = std::numeric_limits<float>::max();
+			const unsigned int nx = m_size[0];
+			const unsigned int ny = m_size[1];
+			const unsigned int slice = nx*ny;
+			const unsigned int k0 = first_slice(i_slab);
+			const unsigned int k1 = end_slice(i_slab);
+			const float* lower_ghost = k0>0 ? &m_ghosts[(2*i_slab+0)*slice] : 0;
+			const float* upper_ghost = k1<m_size[2] ? &m_ghosts[(2*i_slab+1)*slice] : 0;
+			bool changed(false);
+			for (unsigned int kk=k0;kk<k1;kk++)
+			{
+				const unsigned int k = m_direction[2]>0 ? kk : k0+k1-1-kk;
+				const float* below = k>k0 ? &m_distance[(k-1)*slice] : lower_ghost;
+				const float* above = k+1<k1 ? &m_distance[(k+1)*slice] : upper_ghost;
+				for (unsigned int jj=0;jj<ny;jj++)
+				{
+					const unsigned int j = m_direction[1]>0 ? jj : ny-1-jj;
+					for (unsigned int ii=0;ii<nx;ii++)
+					{
+						const unsigned int i = m_direction[0]>0 ? ii : nx-1-ii;
+						const unsigned int local = i+j*nx;
+						const unsigned int index = local+k*slice;
+						if (m_band[index])
+							continue;
+						const float neighbour[3] = {
+							std::min(i>0 ? m_distance[index-1] : none,i+1<nx ? m_distance[index+1] : none),
+							std::min(j>0 ? m_distance[index-nx] : none,j+1<ny ? m_distance[index+nx] : none),
+							std::min(below ? below[local] : none,above ? above[local] : none)
+						};
+						const float value = eikonal_update(neighbour,m_spacing);
+						if (value<m_distance[index])
+						{
+							// Rounding keeps lowering the values by a few ulps, that is not worth another round of sweeps
+							changed = changed || m_distance[index]-value>m_tolerance;
+							m_distance[index] = value;
+						}
+					}
+				}
+			}
+			if (changed)
+				m_changed[i_slab] = 1;
+		}
+	private :
+		unsigned int first_slice(unsigned int i_slab) const { return i_slab*m_size[2]/m_num_slabs; }
+		unsigned int end_slice(unsigned int i_slab) const { return (i_slab+1)*m_size[2]/m_num_slabs; }
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of samples in each direction
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_size[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The distance between samples along each axis
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_spacing[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Smallest change which needs another round of sweeps
+		//----------------------------------------------------------------------------------------------------------------------
+		float m_tolerance;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The current sweep direction along each axis
+		//----------------------------------------------------------------------------------------------------------------------
+		int m_direction[3];
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The band flags
+		//----------------------------------------------------------------------------------------------------------------------
+		const std::vector<unsigned char>& m_band;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The unsigned distances
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<float>& m_distance;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of slabs
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_num_slabs;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The slices below and above each slab, copied before each sweep
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<float> m_ghosts;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief One flag per slab, set when a sample of the slab changed
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<unsigned char> m_changed;
+	};
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 sdf::discretized_field::discretized_field() {}
 //----------------------------------------------------------------------------------------------------------------------
@@ -103,28 +357,20 @@ float sdf::discretized_field::linear(const point3d& i_position) const
         const int minCornerY = int(positionV);
         const int minCornerZ = int(positionW);
 
-        const int maxCornerX = minCornerX+1;
-        const int maxCornerY = minCornerY+1;
-        const int maxCornerZ = minCornerZ+1;
-
         const float a = positionU - (float)minCornerX;
         const float b = positionV - (float)minCornerY;
         const float c = positionW - (float)minCornerZ;
 
+        // The corners come from the same tile when the grid is tiled
+        float corners[8];
+        m_grid.cell(minCornerX,minCornerY,minCornerZ,corners);
+
         const float level1[] =
         {
-                lerp( // Bottom front lerp
-                m_grid(minCornerX,minCornerY,minCornerZ),
-                m_grid(maxCornerX,minCornerY,minCornerZ),a)  ,
-                lerp( // Top front lerp
-                m_grid(minCornerX,maxCornerY,minCornerZ),
-                m_grid(maxCornerX,maxCornerY,minCornerZ),a)  ,
-                lerp( // Bottom back lerp
-                m_grid(minCornerX,minCornerY,maxCornerZ),
-                m_grid(maxCornerX,minCornerY,maxCornerZ),a)  ,
-                lerp( // Top back lerp
-                m_grid(minCornerX,maxCornerY,maxCornerZ),
-                m_grid(maxCornerX,maxCornerY,maxCornerZ),a)
+                lerp(corners[0],corners[1],a), // Bottom front lerp
+                lerp(corners[2],corners[3],a), // Top front lerp
+                lerp(corners[4],corners[5],a), // Bottom back lerp
+                lerp(corners[6],corners[7],a)  // Top back lerp
         };
 
         const float level2[] =
@@ -136,6 +382,46 @@ float sdf::discretized_field::linear(const point3d& i_position) const
         return lerp(level2[0],level2[1],c);
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::discretized_field::sample(const point3d& i_position, vector3d* o_gradient) const
+{
+	const vector3d extent = m_max-m_min;
+	const point3d texture = (i_position-m_min)/extent;
+	float gradient[3];
+	const float value = m_grid.sample(texture[0],texture[1],texture[2],o_gradient ? gradient : 0);
+	if (o_gradient)
+		*o_gradient = vector3d(gradient[0]/extent[0],gradient[1]/extent[1],gradient[2]/extent[2]);
+	return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::discretized_field::sample(unsigned int i_count, const point3d* i_positions, float* o_values, vector3d* o_gradients) const
+{
+	// Blocks of texture coordinates as structure of arrays for grid::sample
+	const unsigned int block_size = 64;
+	float texture[3][block_size], gradient[3][block_size];
+	const float* const coordinates[3] = { texture[0],texture[1],texture[2] };
+	float* const derivatives[3] = { gradient[0],gradient[1],gradient[2] };
+	const vector3d extent = m_max-m_min;
+	for (unsigned int first=0;first<i_count;first+=block_size)
+	{
+		const unsigned int count = std::min(block_size,i_count-first);
+		for (unsigned int i=0;i<count;i++)
+		{
+			const point3d position = (i_positions[first+i]-m_min)/extent;
+			texture[0][i] = position[0];
+			texture[1][i] = position[1];
+			texture[2][i] = position[2];
+		}
+		m_grid.sample(count,coordinates,o_values+first,o_gradients ? derivatives : 0);
+		if (o_gradients)
+		{
+			for (unsigned int i=0;i<count;i++)
+				o_gradients[first+i] = vector3d(gradient[0][i]/extent[0],gradient[1][i]/extent[1],gradient[2][i]/extent[2]);
+		}
+	}
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::discretized_field::gradient(const point3d& i_pos, sdf::point3d* o_gradient) const
 {
@@ -173,6 +459,105 @@ void sdf::discretized_field::unserialize(binary_file_in& o_file)
     o_file(&m_max);
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::discretized_field::save(const std::string& i_filename) const
+{
+	assert(sizeof(bdf_header)==64);
+	binary_file_out file(i_filename);
+	if (!file.is_open())
+		return false;
+
+	bdf_header header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.m_magic,bdf_magic,sizeof(bdf_magic));
+	header.m_version = bdf_version;
+	header.m_data_offset = sizeof(bdf_header);
+	header.m_size[0] = m_grid.width();
+	header.m_size[1] = m_grid.height();
+	header.m_size[2] = m_grid.depth();
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		header.m_min[axis] = m_min[axis];
+		header.m_max[axis] = m_max[axis];
+	}
+	file(header);
+	grid::scalar_field buffer;
+	if (m_grid.num_elements()>0)
+		file(m_grid.linear_data(&buffer),m_grid.num_elements());
+	file.close();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::discretized_field::load(const std::string& i_filename)
+{
+	std::shared_ptr<mapped_file> file(new mapped_file(i_filename));
+	if (!file->is_open())
+		return false;
+	const char* data = file->data();
+	const std::size_t size = file->size();
+	if (brick_file::is_brick_file(data,size))
+	{
+		// Compressed, the samples have to be decoded
+		const brick_file bricks(i_filename);
+		sdf::grid samples;
+		if (!bricks.is_open() || !bricks.read(&samples))
+			return false;
+		m_grid = samples;
+		m_min = bricks.minimum();
+		m_max = bricks.maximum();
+		return true;
+	}
+
+	unsigned int dimension[3];
+	std::size_t data_offset;
+	float box[2][3];
+	if (size>=sizeof(bdf_header) && memcmp(data,bdf_magic,sizeof(bdf_magic))==0)
+	{
+		bdf_header header;
+		memcpy(&header,data,sizeof(header));
+		if (header.m_version>bdf_version || header.m_data_offset<sizeof(header) || header.m_data_offset>size || header.m_data_offset%sizeof(float)!=0)
+			return false;
+		memcpy(dimension,header.m_size,sizeof(dimension));
+		memcpy(box[0],header.m_min,sizeof(box[0]));
+		memcpy(box[1],header.m_max,sizeof(box[1]));
+		data_offset = header.m_data_offset;
+		const std::size_t num_elements = std::size_t(dimension[0])*dimension[1]*dimension[2];
+		if ((size-data_offset)/sizeof(float)<num_elements)
+			return false;
+	}
+	else
+	{
+		// Version 1 : size x, y, z, number of samples, samples, minimum, maximum (both point3d)
+		unsigned int count;
+		if (size<4*sizeof(unsigned int))
+			return false;
+		memcpy(dimension,data,sizeof(dimension));
+		memcpy(&count,data+sizeof(dimension),sizeof(count));
+		data_offset = 4*sizeof(unsigned int);
+		if (std::size_t(dimension[0])*dimension[1]*dimension[2]!=count || (size-data_offset)/sizeof(float)<count+6)
+			return false;
+		// The points were written with their padding, the tail is shared by both
+		const std::size_t box_offset = data_offset+count*sizeof(float);
+		const std::size_t point_size = (size-box_offset)/2;
+		memcpy(box[0],data+box_offset,sizeof(box[0]));
+		memcpy(box[1],data+box_offset+point_size,sizeof(box[1]));
+	}
+
+	if (dimension[0]*dimension[1]*dimension[2]==0)
+	{
+		m_grid = sdf::grid();
+	}
+	else
+	{
+		const float* samples = reinterpret_cast<const float*>(data+data_offset);
+		m_grid.view(dimension[0],dimension[1],dimension[2],samples,file);
+	}
+	m_min = point3d(box[0][0],box[0][1],box[0][2]);
+	m_max = point3d(box[1][0],box[1][1],box[1][2]);
+	return true;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::discretized_field::get_positions(std::vector<point3d>* o_positions) const
 {
@@ -200,4 +585,156 @@ void sdf::discretized_field::get_positions(std::vector<point3d>* o_positions) co
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::discretized_field::mark_band(const mesh& i_mesh, unsigned int i_band, std::vector<unsigned char>* o_band) const
+{
+	const unsigned int size[3] = { m_grid.width(),m_grid.height(),m_grid.depth() };
+	assert(size[0]>1 && size[1]>1 && size[2]>1);
+	o_band->assign(m_grid.num_elements(),0);
+
+	const vector3d extent = m_max-m_min;
+	const vector3d spacing(extent[0]/((float)size[0]-1),extent[1]/((float)size[1]-1),extent[2]/((float)size[2]-1));
+	const vector3d half_spacing = spacing*0.5f;
+	for (unsigned int f=0;f<i_mesh.num_faces();f++)
+	{
+		const point3d& a = i_mesh.vertex(f*3+0);
+		const point3d& b = i_mesh.vertex(f*3+1);
+		const point3d& c = i_mesh.vertex(f*3+2);
 
+		// The cells the triangle box covers
+		unsigned int first[3], last[3];
+		bool outside(false);
+		for (unsigned int axis=0;axis<3 && !outside;axis++)
+		{
+			const float lower = (std::min(a[axis],std::min(b[axis],c[axis]))-m_min[axis])/spacing[axis];
+			const float upper = (std::max(a[axis],std::max(b[axis],c[axis]))-m_min[axis])/spacing[axis];
+			const float last_cell = (float)(size[axis]-2);
+			outside = upper<0.f || lower>last_cell+1.f;
+			first[axis] = (unsigned int)clamp(floorf(lower),0.f,last_cell);
+			last[axis] = (unsigned int)clamp(floorf(upper),0.f,last_cell);
+		}
+		if (outside)
+			continue;
+
+		for (unsigned int k=first[2];k<=last[2];k++)
+		{
+			for (unsigned int j=first[1];j<=last[1];j++)
+			{
+				for (unsigned int i=first[0];i<=last[0];i++)
+				{
+					const point3d centre = m_min+point3d(
+						((float)i+0.5f)*spacing[0],
+						((float)j+0.5f)*spacing[1],
+						((float)k+0.5f)*spacing[2]);
+					if (!triangle_box_overlap(centre,half_spacing,a,b,c))
+						continue;
+					// The 8 samples at the corners of the cell
+					for (unsigned int corner=0;corner<8;corner++)
+					{
+						const unsigned int x = i+(corner&1);
+						const unsigned int y = j+((corner>>1)&1);
+						const unsigned int z = k+((corner>>2)&1);
+						(*o_band)[x+(y+z*size[1])*size[0]] = 1;
+					}
+				}
+			}
+		}
+	}
+
+	for (unsigned int axis=0;axis<3 && i_band>0;axis++)
+		dilate(o_band,size,axis,i_band);
+	return (unsigned int)std::count(o_band->begin(),o_band->end(),1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::discretized_field::extend_band(const std::vector<unsigned char>& i_band, unsigned int i_num_threads)
+{
+	const unsigned int size[3] = { m_grid.width(),m_grid.height(),m_grid.depth() };
+	const vector3d extent = m_max-m_min;
+	const float spacing[3] = { extent[0]/((float)size[0]-1),extent[1]/((float)size[1]-1),extent[2]/((float)size[2]-1) };
+
+	// Unsigned distances, the band is fixed and the rest starts infinitely far
+	std::vector<float> distance(m_grid.num_elements(),std::numeric_limits<float>::max());
+	unsigned int index(0);
+	for (unsigned int k=0;k<size[2];k++)
+	{
+		for (unsigned int j=0;j<size[1];j++)
+		{
+			for (unsigned int i=0;i<size[0];i++,index++)
+			{
+				if (i_band[index])
+					distance[index] = fabsf(m_grid(i,j,k));
+			}
+		}
+	}
+
+	// The 8 sweep orderings, repeated until the slabs agree
+	static const int directions[8][3] = {
+		{ 1, 1, 1},{-1, 1, 1},{ 1,-1, 1},{-1,-1, 1},
+		{ 1, 1,-1},{-1, 1,-1},{ 1,-1,-1},{-1,-1,-1} };
+	thread::task_pool pool(i_num_threads);
+	const unsigned int num_slabs = std::min(pool.num_threads(),size[2]);
+	slab_sweeper sweeper(size,spacing,i_band,&distance,num_slabs);
+	bool changed(true);
+	while (changed)
+	{
+		changed = false;
+		for (unsigned int d=0;d<8;d++)
+		{
+			sweeper.start(directions[d]);
+			pool.run(num_slabs,sweeper);
+			changed = sweeper.changed() || changed;
+		}
+	}
+
+	// Sign of each region outside the band: the vote of the band samples it touches
+	const unsigned int slice = size[0]*size[1];
+	std::vector<unsigned char> visited(i_band);
+	std::vector<unsigned int> region;
+	std::vector<unsigned int> stack;
+	for (unsigned int seed=0;seed<visited.size();seed++)
+	{
+		if (visited[seed])
+			continue;
+		visited[seed] = 1;
+		stack.push_back(seed);
+		region.clear();
+		int votes(0);
+		while (!stack.empty())
+		{
+			const unsigned int current = stack.back();
+			stack.pop_back();
+			region.push_back(current);
+			const unsigned int i = current%size[0];
+			const unsigned int j = (current/size[0])%size[1];
+			const unsigned int k = current/slice;
+			const unsigned int neighbours[6][3] = {
+				{i-1,j,k},{i+1,j,k},{i,j-1,k},{i,j+1,k},{i,j,k-1},{i,j,k+1} };
+			for (unsigned int n=0;n<6;n++)
+			{
+				// Unsigned, so going below 0 wraps past the size
+				const unsigned int x = neighbours[n][0], y = neighbours[n][1], z = neighbours[n][2];
+				if (x>=size[0] || y>=size[1] || z>=size[2])
+					continue;
+				const unsigned int other = x+y*size[0]+z*slice;
+				if (i_band[other])
+				{
+					const float value = m_grid(x,y,z);
+					votes += value>0.f ? 1 : (value<0.f ? -1 : 0);
+				}
+				else if (!visited[other])
+				{
+					visited[other] = 1;
+					stack.push_back(other);
+				}
+			}
+		}
+
+		const float sign = votes<0 ? -1.f : 1.f;
+		for (std::size_t r=0;r<region.size();r++)
+		{
+			const unsigned int current = region[r];
+			m_grid(current%size[0],(current/size[0])%size[1],current/slice) = sign*distance[current];
+		}
+	}
+}
@@ -1,13 +1,73 @@
 #include <sdf/discretization/grid.hpp>
+#include <sdf/core/config.hpp>
+#include <algorithm>
 #include <assert.h>
 #include <math.h>
 
+#ifdef SDF_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Interpolate the 8 corners of a cell, X first
+	/// @param[in] i_corners The samples at the corners
+	/// @param[in] i_a Position in the cell in X, in [0,1]
+	/// @param[in] i_b Position in the cell in Y, in [0,1]
+	/// @param[in] i_c Position in the cell in Z, in [0,1]
+	/// @param[out] o_gradient The derivatives along X, Y and Z (optional)
+	//----------------------------------------------------------------------------------------------------------------------
+	float interpolate(const float i_corners[8], float i_a, float i_b, float i_c, float* o_gradient)
+	{
+		const float* c = i_corners;
+		const float x00 = c[0]+(c[1]-c[0])*i_a;
+		const float x10 = c[2]+(c[3]-c[2])*i_a;
+		const float x01 = c[4]+(c[5]-c[4])*i_a;
+		const float x11 = c[6]+(c[7]-c[6])*i_a;
+		const float y0 = x00+(x10-x00)*i_b;
+		const float y1 = x01+(x11-x01)*i_b;
+		if (o_gradient)
+		{
+			const float dx0 = (c[1]-c[0])+((c[3]-c[2])-(c[1]-c[0]))*i_b;
+			const float dx1 = (c[5]-c[4])+((c[7]-c[6])-(c[5]-c[4]))*i_b;
+			o_gradient[0] = dx0+(dx1-dx0)*i_c;
+			o_gradient[1] = (x10-x00)+((x11-x01)-(x10-x00))*i_c;
+			o_gradient[2] = y1-y0;
+		}
+		return y0+(y1-y0)*i_c;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Find the cell containing a position along one direction
+	/// @param[in] i_position The position in samples
+	/// @param[in] i_size The number of samples
+	/// @param[out] o_cell The first sample of the cell
+	/// @return The position in the cell, in [0,1]
+	//----------------------------------------------------------------------------------------------------------------------
+	float locate_cell(float i_position, unsigned int i_size, unsigned int* o_cell)
+	{
+		if (i_size<2 || !(i_position>0.f))
+		{
+			*o_cell = 0;
+			return 0.f;
+		}
+		const float last = static_cast<float>(i_size-1);
+		const float position = std::min(i_position,last);
+		*o_cell = std::min(static_cast<unsigned int>(position),i_size-2);
+		return position-static_cast<float>(*o_cell);
+	}
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 sdf::grid::grid()
 :   m_dimension_x(0),
 	m_dimension_y(0),
-	m_dimension_z(0)
+	m_dimension_z(0),
+	m_layout(linear_layout),
+	m_view(0)
 {
+	update_tiles();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -15,36 +75,326 @@ sdf::grid::grid(
 				unsigned int i_dimx,
 				unsigned int i_dimy,
 				unsigned int i_dimz, 
-				float i_default)
+				float i_default,
+				layout_type i_layout)
 	:   m_dimension_x(i_dimx),
 		m_dimension_y(i_dimy),
 		m_dimension_z(i_dimz), 
-		m_data(i_dimx*i_dimy*i_dimz,i_default)
+		m_layout(i_layout),
+		m_view(0)
 {
+	update_tiles();
+	if (m_layout==tiled_layout)
+		m_data.assign(m_tiles[0]*m_tiles[1]*m_tiles[2]*tile_size*tile_size*tile_size,i_default);
+	else
+		m_data.assign(i_dimx*i_dimy*i_dimz,i_default);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 const float& sdf::grid::operator[](unsigned int i_index) const
 {
-	return m_data[i_index];
+	assert(i_index<num_elements());
+	return values()[i_index];
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 const float& sdf::grid::operator()(unsigned int i_x, unsigned int i_y, unsigned int i_z) const
 {
-	return m_data[raw_index(i_x,i_y,i_z)];
+	return values()[raw_index(i_x,i_y,i_z)];
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 float& sdf::grid::operator()(unsigned int i_x, unsigned int i_y, unsigned int i_z)
 {
+	if (m_view)
+		detach();
 	return m_data[raw_index(i_x,i_y,i_z)];
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 const float* sdf::grid::raw_data() const
 {
-	return &m_data[0];
+	return values();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::view(
+				unsigned int i_dimx,
+				unsigned int i_dimy,
+				unsigned int i_dimz,
+				const float* i_data,
+				const std::shared_ptr<const void>& i_owner)
+{
+	assert(i_data);
+	m_dimension_x = i_dimx;
+	m_dimension_y = i_dimy;
+	m_dimension_z = i_dimz;
+	m_layout = linear_layout;
+	update_tiles();
+	scalar_field().swap(m_data);
+	m_view = i_data;
+	m_owner = i_owner;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::cell(unsigned int i_x, unsigned int i_y, unsigned int i_z, float o_corners[8]) const
+{
+	assert(i_x+1<m_dimension_x && i_y+1<m_dimension_y && i_z+1<m_dimension_z);
+	const float* samples = values();
+	if (m_view || m_layout==linear_layout)
+	{
+		const unsigned int y_stride = m_dimension_x;
+		const unsigned int z_stride = m_dimension_x*m_dimension_y;
+		const float* corner = samples+raw_index(i_x,i_y,i_z);
+		o_corners[0] = corner[0];
+		o_corners[1] = corner[1];
+		o_corners[2] = corner[y_stride];
+		o_corners[3] = corner[y_stride+1];
+		o_corners[4] = corner[z_stride];
+		o_corners[5] = corner[z_stride+1];
+		o_corners[6] = corner[z_stride+y_stride];
+		o_corners[7] = corner[z_stride+y_stride+1];
+		return;
+	}
+
+	const unsigned int last = tile_size-1;
+	if ((i_x&last)!=last && (i_y&last)!=last && (i_z&last)!=last)
+	{
+		// The whole cell is in one tile, the corners are within the 64 bytes of the same Z-order block
+		const float* tile = samples+(raw_index(i_x,i_y,i_z)&~(tile_size*tile_size*tile_size-1));
+		const unsigned int x[2] = { spread(i_x&last),spread((i_x&last)+1) };
+		const unsigned int y[2] = { spread(i_y&last)<<1,spread((i_y&last)+1)<<1 };
+		const unsigned int z[2] = { spread(i_z&last)<<2,spread((i_z&last)+1)<<2 };
+		for (unsigned int corner=0;corner<8;corner++)
+			o_corners[corner] = tile[x[corner&1]|y[(corner>>1)&1]|z[corner>>2]];
+		return;
+	}
+
+	for (unsigned int corner=0;corner<8;corner++)
+		o_corners[corner] = samples[raw_index(i_x+(corner&1),i_y+((corner>>1)&1),i_z+(corner>>2))];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::grid::trilinear(float i_x, float i_y, float i_z) const
+{
+	return trilinear(i_x,i_y,i_z,0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::grid::trilinear(float i_x, float i_y, float i_z, float o_gradient[3]) const
+{
+	assert(num_elements()>0);
+	unsigned int cell_position[3];
+	const float a = locate_cell(i_x,m_dimension_x,cell_position+0);
+	const float b = locate_cell(i_y,m_dimension_y,cell_position+1);
+	const float c = locate_cell(i_z,m_dimension_z,cell_position+2);
+
+	float corners[8];
+	if (m_dimension_x>1 && m_dimension_y>1 && m_dimension_z>1)
+	{
+		cell(cell_position[0],cell_position[1],cell_position[2],corners);
+	}
+	else
+	{
+		// A flat grid, the missing neighbours are the samples themselves
+		const unsigned int next[3] = {
+			std::min(cell_position[0]+1,m_dimension_x-1),
+			std::min(cell_position[1]+1,m_dimension_y-1),
+			std::min(cell_position[2]+1,m_dimension_z-1) };
+		for (unsigned int corner=0;corner<8;corner++)
+		{
+			corners[corner] = (*this)(
+				corner&1 ? next[0] : cell_position[0],
+				corner&2 ? next[1] : cell_position[1],
+				corner&4 ? next[2] : cell_position[2]);
+		}
+	}
+	return interpolate(corners,a,b,c,o_gradient);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::grid::sample(float i_u, float i_v, float i_w, float o_gradient[3]) const
+{
+	const float size[3] = {
+		static_cast<float>(m_dimension_x),
+		static_cast<float>(m_dimension_y),
+		static_cast<float>(m_dimension_z) };
+	// Texel centres, GL_CLAMP_TO_EDGE is the clamping of trilinear
+	const float texel[3] = { i_u*size[0]-0.5f,i_v*size[1]-0.5f,i_w*size[2]-0.5f };
+	const float value = trilinear(texel[0],texel[1],texel[2],o_gradient);
+	if (o_gradient)
+	{
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			const bool inside = texel[axis]>=0.f && texel[axis]<=size[axis]-1.f;
+			o_gradient[axis] = inside ? o_gradient[axis]*size[axis] : 0.f;
+		}
+	}
+	return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::sample(
+	unsigned int i_count,
+	const float* const i_coordinates[3],
+	float* o_values,
+	float* const o_gradient[3]) const
+{
+	unsigned int first(0);
+#ifdef SDF_USE_SSE
+	if (m_dimension_x>1 && m_dimension_y>1 && m_dimension_z>1)
+	{
+		const unsigned int dimension[3] = { m_dimension_x,m_dimension_y,m_dimension_z };
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 half = _mm_set1_ps(0.5f);
+		__m128 size[3], last[3], last_cell[3];
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			size[axis] = _mm_set1_ps(static_cast<float>(dimension[axis]));
+			last[axis] = _mm_set1_ps(static_cast<float>(dimension[axis])-1.f);
+			last_cell[axis] = _mm_set1_ps(static_cast<float>(dimension[axis]-2));
+		}
+
+		for (;first+4<=i_count;first+=4)
+		{
+			// Same steps as locate_cell, 4 lanes at a time
+			__m128 fraction[3], inside[3];
+			int cell_position[3][4];
+			for (unsigned int axis=0;axis<3;axis++)
+			{
+				const __m128 texel = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(i_coordinates[axis]+first),size[axis]),half);
+				inside[axis] = _mm_and_ps(_mm_cmpge_ps(texel,zero),_mm_cmple_ps(texel,last[axis]));
+				// max_ps returns zero for a NaN
+				const __m128 position = _mm_min_ps(_mm_max_ps(texel,zero),last[axis]);
+				const __m128 cell = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(position)),last_cell[axis]);
+				fraction[axis] = _mm_sub_ps(position,cell);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(cell_position[axis]),_mm_cvttps_epi32(cell));
+			}
+
+			// No gather in SSE2, the corners are read lane by lane and transposed
+			float corners[8][4];
+			for (unsigned int lane=0;lane<4;lane++)
+			{
+				float lane_corners[8];
+				cell(cell_position[0][lane],cell_position[1][lane],cell_position[2][lane],lane_corners);
+				for (unsigned int corner=0;corner<8;corner++)
+					corners[corner][lane] = lane_corners[corner];
+			}
+
+			__m128 c[8];
+			for (unsigned int corner=0;corner<8;corner++)
+				c[corner] = _mm_loadu_ps(corners[corner]);
+			const __m128 a = fraction[0];
+			const __m128 b = fraction[1];
+			const __m128 d10 = _mm_sub_ps(c[1],c[0]);
+			const __m128 d32 = _mm_sub_ps(c[3],c[2]);
+			const __m128 d54 = _mm_sub_ps(c[5],c[4]);
+			const __m128 d76 = _mm_sub_ps(c[7],c[6]);
+			const __m128 x00 = _mm_add_ps(c[0],_mm_mul_ps(d10,a));
+			const __m128 x10 = _mm_add_ps(c[2],_mm_mul_ps(d32,a));
+			const __m128 x01 = _mm_add_ps(c[4],_mm_mul_ps(d54,a));
+			const __m128 x11 = _mm_add_ps(c[6],_mm_mul_ps(d76,a));
+			const __m128 y0 = _mm_add_ps(x00,_mm_mul_ps(_mm_sub_ps(x10,x00),b));
+			const __m128 y1 = _mm_add_ps(x01,_mm_mul_ps(_mm_sub_ps(x11,x01),b));
+			_mm_storeu_ps(o_values+first,_mm_add_ps(y0,_mm_mul_ps(_mm_sub_ps(y1,y0),fraction[2])));
+			if (o_gradient)
+			{
+				const __m128 dx0 = _mm_add_ps(d10,_mm_mul_ps(_mm_sub_ps(d32,d10),b));
+				const __m128 dx1 = _mm_add_ps(d54,_mm_mul_ps(_mm_sub_ps(d76,d54),b));
+				const __m128 dy0 = _mm_sub_ps(x10,x00);
+				const __m128 dy1 = _mm_sub_ps(x11,x01);
+				const __m128 derivative[3] = {
+					_mm_add_ps(dx0,_mm_mul_ps(_mm_sub_ps(dx1,dx0),fraction[2])),
+					_mm_add_ps(dy0,_mm_mul_ps(_mm_sub_ps(dy1,dy0),fraction[2])),
+					_mm_sub_ps(y1,y0) };
+				for (unsigned int axis=0;axis<3;axis++)
+					_mm_storeu_ps(o_gradient[axis]+first,_mm_and_ps(inside[axis],_mm_mul_ps(derivative[axis],size[axis])));
+			}
+		}
+	}
+#endif
+	// The remainder, flat grids and the scalar build
+	for (unsigned int i=first;i<i_count;i++)
+	{
+		float gradient[3];
+		o_values[i] = sample(i_coordinates[0][i],i_coordinates[1][i],i_coordinates[2][i],o_gradient ? gradient : 0);
+		if (o_gradient)
+		{
+			o_gradient[0][i] = gradient[0];
+			o_gradient[1][i] = gradient[1];
+			o_gradient[2][i] = gradient[2];
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::copy_linear(scalar_field* o_samples) const
+{
+	o_samples->resize(num_elements());
+	if (num_elements()==0)
+		return;
+	if (m_view || m_layout==linear_layout)
+	{
+		std::copy(values(),values()+num_elements(),o_samples->begin());
+		return;
+	}
+	scalar_field& samples = *o_samples;
+	for (const_iterator it=begin();it!=end();++it)
+		samples[it.x()+m_dimension_x*(it.y()+m_dimension_y*it.z())] = *it;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+const float* sdf::grid::linear_data(scalar_field* o_buffer) const
+{
+	if (m_view || m_layout==linear_layout)
+		return values();
+	copy_linear(o_buffer);
+	return o_buffer->empty() ? 0 : &(*o_buffer)[0];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::set_layout(layout_type i_layout)
+{
+	if (i_layout==m_layout)
+		return;
+	detach();
+
+	scalar_field reordered;
+	if (i_layout==tiled_layout)
+	{
+		const scalar_field& linear = m_data;
+		m_layout = tiled_layout;
+		reordered.assign(m_tiles[0]*m_tiles[1]*m_tiles[2]*tile_size*tile_size*tile_size,0.f);
+		unsigned int index(0);
+		for (unsigned int k=0;k<m_dimension_z;k++)
+			for (unsigned int j=0;j<m_dimension_y;j++)
+				for (unsigned int i=0;i<m_dimension_x;i++,index++)
+					reordered[raw_index(i,j,k)] = linear[index];
+	}
+	else
+	{
+		copy_linear(&reordered);
+		m_layout = linear_layout;
+	}
+	m_data.swap(reordered);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::update_tiles()
+{
+	m_tiles[0] = (m_dimension_x+tile_size-1)/tile_size;
+	m_tiles[1] = (m_dimension_y+tile_size-1)/tile_size;
+	m_tiles[2] = (m_dimension_z+tile_size-1)/tile_size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::grid::detach()
+{
+	if (!m_view)
+		return;
+	m_data.assign(m_view,m_view+num_elements());
+	m_view = 0;
+	m_owner.reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -74,6 +424,13 @@ unsigned int sdf::grid::depth() const
 //----------------------------------------------------------------------------------------------------------------------
 unsigned int sdf::grid::raw_index(unsigned int i_x, unsigned int i_y, unsigned int i_z) const
 {
+	if (m_layout==tiled_layout)
+	{
+		// Tiles X first, Z-order in a tile
+		const unsigned int last = tile_size-1;
+		const unsigned int tile = (i_x/tile_size)+m_tiles[0]*((i_y/tile_size)+m_tiles[1]*(i_z/tile_size));
+		return tile*tile_size*tile_size*tile_size+(spread(i_x&last)|(spread(i_y&last)<<1)|(spread(i_z&last)<<2));
+	}
 	//const unsigned int x_stride = 1;
 	const unsigned int y_stride = m_dimension_x;
 	const unsigned int z_stride = m_dimension_x*m_dimension_y;
@@ -93,7 +450,7 @@ float sdf::grid::difference(const grid& i_other) const
 		for (unsigned int j=0;j<m_dimension_y;j++)
 			for (unsigned int i=0;i<m_dimension_x;i++)
 			{
-				const float current = m_data[raw_index(i,j,k)];
+				const float current = values()[raw_index(i,j,k)];
 				const float other = i_other(i,j,k);
 				if (current!=other)
 					diff+=fabs(current-other);
@@ -121,9 +478,11 @@ void sdf::grid::serialize(binary_file_out& o_file) const
     o_file(m_dimension_x);
     o_file(m_dimension_y);
     o_file(m_dimension_z);
-	unsigned int size = (unsigned int)m_data.size();
+	unsigned int size = num_elements();
 	o_file(size);
-	o_file(&m_data[0],size);
+	scalar_field buffer;
+	if (size>0)
+		o_file(linear_data(&buffer),size);
     //o_file(m_data);
 }
 
@@ -136,6 +495,13 @@ void sdf::grid::unserialize(binary_file_in& o_file)
     //o_file(&m_data);
 	unsigned int size(0);
 	o_file(&size);
+	m_view = 0;
+	m_owner.reset();
+	const layout_type layout = m_layout;
+	m_layout = linear_layout;
+	update_tiles();
 	m_data.resize(size);
-	o_file(&m_data[0],size);
+	if (size>0)
+		o_file(&m_data[0],size);
+	set_layout(layout);
 }
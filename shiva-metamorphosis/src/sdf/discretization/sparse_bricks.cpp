@@ -0,0 +1,106 @@
+#include <sdf/discretization/sparse_bricks.hpp>
+#include <sdf/core/tools.hpp>
+#include <algorithm>
+#include <assert.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+const unsigned int sdf::sparse_bricks::no_brick;
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::sparse_bricks::sparse_bricks() : m_brick_size(0), m_num_stored(0)
+{
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		m_size[axis] = 0;
+		m_num_bricks[axis] = 0;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::sparse_bricks::initialize(unsigned int i_nx, unsigned int i_ny, unsigned int i_nz, unsigned int i_brick_size)
+{
+	assert(i_nx>1 && i_ny>1 && i_nz>1);
+	assert(i_brick_size>0);
+	m_size[0] = i_nx;
+	m_size[1] = i_ny;
+	m_size[2] = i_nz;
+	m_brick_size = i_brick_size;
+	for (unsigned int axis=0;axis<3;axis++)
+		m_num_bricks[axis] = (m_size[axis]-1+m_brick_size-1)/m_brick_size;
+
+	m_corners = sdf::grid(m_num_bricks[0]+1,m_num_bricks[1]+1,m_num_bricks[2]+1);
+	m_bricks.assign(m_num_bricks[0]*m_num_bricks[1]*m_num_bricks[2],no_brick);
+	m_samples.clear();
+	m_num_stored = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::sparse_bricks::brick_range(unsigned int i_axis, unsigned int i_brick, unsigned int* o_first, unsigned int* o_last) const
+{
+	assert(i_brick<m_num_bricks[i_axis]);
+	*o_first = i_brick*m_brick_size;
+	*o_last = std::min(*o_first+m_brick_size,m_size[i_axis]-1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::sparse_bricks::set_brick(unsigned int i, unsigned int j, unsigned int k, const std::vector<float>& i_samples)
+{
+	assert(i_samples.size()>=brick_samples());
+	unsigned int& id = m_bricks[brick_index(i,j,k)];
+	if (id==no_brick)
+	{
+		id = m_num_stored++;
+		m_samples.resize(m_num_stored*brick_samples());
+	}
+	std::copy(i_samples.begin(),i_samples.begin()+brick_samples(),m_samples.begin()+id*brick_samples());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::sparse_bricks::value(unsigned int i, unsigned int j, unsigned int k) const
+{
+	const unsigned int sample[3] = { i,j,k };
+	unsigned int brick[3], first[3], last[3];
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		assert(sample[axis]<m_size[axis]);
+		// The last sample is the end of the last brick
+		brick[axis] = std::min(sample[axis]/m_brick_size,m_num_bricks[axis]-1);
+		brick_range(axis,brick[axis],first+axis,last+axis);
+	}
+
+	const unsigned int id = m_bricks[brick_index(brick[0],brick[1],brick[2])];
+	if (id!=no_brick)
+	{
+		const unsigned int side = m_brick_size+1;
+		return m_samples[id*brick_samples()+(i-first[0])+((j-first[1])+(k-first[2])*side)*side];
+	}
+
+	const float a = (float)(i-first[0])/(float)(last[0]-first[0]);
+	const float b = (float)(j-first[1])/(float)(last[1]-first[1]);
+	const float c = (float)(k-first[2])/(float)(last[2]-first[2]);
+	const unsigned int x = brick[0], y = brick[1], z = brick[2];
+	return lerp(
+		lerp(lerp(m_corners(x,y,z),m_corners(x+1,y,z),a),lerp(m_corners(x,y+1,z),m_corners(x+1,y+1,z),a),b),
+		lerp(lerp(m_corners(x,y,z+1),m_corners(x+1,y,z+1),a),lerp(m_corners(x,y+1,z+1),m_corners(x+1,y+1,z+1),a),b),
+		c);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::sparse_bricks::to_grid(sdf::grid* o_grid) const
+{
+	*o_grid = sdf::grid(m_size[0],m_size[1],m_size[2]);
+	for (unsigned int k=0;k<m_size[2];k++)
+	{
+		for (unsigned int j=0;j<m_size[1];j++)
+		{
+			for (unsigned int i=0;i<m_size[0];i++)
+				(*o_grid)(i,j,k) = value(i,j,k);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::size_t sdf::sparse_bricks::memory_usage() const
+{
+	return dynamic_memory(m_corners.data())+dynamic_memory(m_bricks)+dynamic_memory(m_samples);
+}
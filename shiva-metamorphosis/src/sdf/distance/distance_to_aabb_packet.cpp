@@ -0,0 +1,66 @@
+#include <sdf/distance/distance_to_aabb_packet.hpp>
+#include <sdf/distance/distance_to_aabb.hpp>
+
+#ifdef SDF_USE_SSE
+#include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::distance_to_aabb_packet::distance_to_aabb_packet(const point3d i_positions[])
+{
+	for (unsigned int i=0;i<packet_size;i++)
+	{
+		m_position[0][i] = i_positions[i][0];
+		m_position[1][i] = i_positions[i][1];
+		m_position[2][i] = i_positions[i][2];
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::distance_to_aabb_packet::operator()(const aabb& i_box, const float i_best[], float o_sqdist[]) const
+{
+#ifdef SDF_USE_SSE
+	const __m128 zero = _mm_setzero_ps();
+	unsigned int mask(0);
+	for (unsigned int half=0;half<packet_size;half+=4)
+	{
+		__m128 sqdist = zero;
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			const __m128 position = _mm_loadu_ps(m_position[axis]+half);
+			const __m128 below = _mm_sub_ps(_mm_set1_ps(i_box.minimum()[axis]),position);
+			const __m128 above = _mm_sub_ps(position,_mm_set1_ps(i_box.maximum()[axis]));
+			const __m128 outside = _mm_max_ps(_mm_max_ps(below,above),zero);
+			sqdist = _mm_add_ps(sqdist,_mm_mul_ps(outside,outside));
+		}
+		_mm_storeu_ps(o_sqdist+half,sqdist);
+		mask|=static_cast<unsigned int>(_mm_movemask_ps(_mm_cmplt_ps(sqdist,_mm_loadu_ps(i_best+half))))<<half;
+	}
+	return mask;
+#else
+	for (unsigned int i=0;i<packet_size;i++)
+	{
+		const distance_to_aabb boxdist(point3d(m_position[0][i],m_position[1][i],m_position[2][i]));
+		o_sqdist[i] = boxdist(i_box);
+	}
+	return closer(o_sqdist,i_best);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::distance_to_aabb_packet::closer(const float i_sqdist[], const float i_best[])
+{
+#ifdef SDF_USE_SSE
+	return
+		static_cast<unsigned int>(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(i_sqdist+0),_mm_loadu_ps(i_best+0))))|
+		static_cast<unsigned int>(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(i_sqdist+4),_mm_loadu_ps(i_best+4))))<<4;
+#else
+	unsigned int mask(0);
+	for (unsigned int i=0;i<packet_size;i++)
+	{
+		if (i_sqdist[i]<i_best[i])
+			mask|=1u<<i;
+	}
+	return mask;
+#endif
+}
@@ -0,0 +1,90 @@
+#include <sdf/distance/distance_to_triangle_packet.hpp>
+#include <sdf/distance/triangle_kernel.hpp>
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::distance_to_triangle_packet::distance_to_triangle_packet(const point3d i_positions[])
+{
+	for (unsigned int i=0;i<packet_size;i++)
+	{
+		m_position[0][i] = i_positions[i][0];
+		m_position[1][i] = i_positions[i][1];
+		m_position[2][i] = i_positions[i][2];
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::distance_to_triangle_packet::operator()(
+	const triangle_store& i_triangles,
+	index_type i_index,
+	unsigned int i_active,
+	float io_best[],
+	distance_record io_closest_record[],
+	unsigned int io_face_id[]) const
+{
+	const index_type slot = i_triangles.slot(i_index);
+	const triangle_store::block& triangle = i_triangles.block_at(slot/triangle_store::width);
+	const unsigned int lane = slot%triangle_store::width;
+	const unsigned int face_id = triangle.m_face[lane];
+	unsigned int updated(0);
+#ifdef SDF_USE_SSE
+	detail::triangle_lanes triangles;
+	detail::broadcast_lane(triangle,lane,&triangles);
+
+	for (unsigned int half=0;half<packet_size;half+=4)
+	{
+		const unsigned int active = (i_active>>half)&15;
+		if (active==0)
+			continue;
+
+		const __m128 position[3] = { _mm_loadu_ps(m_position[0]+half),_mm_loadu_ps(m_position[1]+half),_mm_loadu_ps(m_position[2]+half) };
+		__m128 closest[3];
+		__m128i feature;
+		const __m128 sqdist = detail::closest_on_triangle(position,triangles,closest,&feature);
+
+		const unsigned int closer = active & static_cast<unsigned int>(_mm_movemask_ps(_mm_cmplt_ps(sqdist,_mm_loadu_ps(io_best+half))));
+		if (closer==0)
+			continue;
+
+		// Only the lanes which got closer are written back
+		float x[4], y[4], z[4], sq[4];
+		int features[4];
+		_mm_storeu_ps(x,closest[0]);
+		_mm_storeu_ps(y,closest[1]);
+		_mm_storeu_ps(z,closest[2]);
+		_mm_storeu_ps(sq,sqdist);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(features),feature);
+		for (unsigned int i=0;i<4;i++)
+		{
+			if (closer&(1u<<i))
+			{
+				distance_record& record = io_closest_record[half+i];
+				record.set_feature(static_cast<feature_type>(features[i]));
+				record.set_closest_point(point3d(x[i],y[i],z[i]));
+				record.set_distance_squared(sq[i]);
+				io_best[half+i] = sq[i];
+				io_face_id[half+i] = face_id;
+			}
+		}
+		updated|=closer<<half;
+	}
+#else
+	for (unsigned int i=0;i<packet_size;i++)
+	{
+		if (!(i_active&(1u<<i)))
+			continue;
+		point3d closest;
+		feature_type feature;
+		const float sqdist = detail::closest_on_triangle(point3d(m_position[0][i],m_position[1][i],m_position[2][i]),triangle,lane,&closest,&feature);
+		if (sqdist<io_best[i])
+		{
+			io_closest_record[i].set_feature(feature);
+			io_closest_record[i].set_closest_point(closest);
+			io_closest_record[i].set_distance_squared(sqdist);
+			io_best[i] = sqdist;
+			io_face_id[i] = face_id;
+			updated|=1u<<i;
+		}
+	}
+#endif
+	return updated;
+}
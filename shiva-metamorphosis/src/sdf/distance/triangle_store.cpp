@@ -0,0 +1,265 @@
+#include <sdf/distance/triangle_store.hpp>
+#include <sdf/distance/triangle_kernel.hpp>
+#include <sdf/core/tools.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <assert.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Write a vector in a lane of a block array
+	//----------------------------------------------------------------------------------------------------------------------
+	void set_lane(float o_array[3][sdf::triangle_store::width], unsigned int i_lane, float i_x, float i_y, float i_z)
+	{
+		o_array[0][i_lane] = i_x;
+		o_array[1][i_lane] = i_y;
+		o_array[2][i_lane] = i_z;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Write a vector in a lane of a block array
+	//----------------------------------------------------------------------------------------------------------------------
+	void set_lane(float o_array[3][sdf::triangle_store::width], unsigned int i_lane, const sdf::point3d& i_point)
+	{
+		set_lane(o_array,i_lane,i_point[0],i_point[1],i_point[2]);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Precompute a triangle in a lane of a block - the normal and the inverse lengths are computed in double
+	//----------------------------------------------------------------------------------------------------------------------
+	void set_triangle(sdf::triangle_store::block& o_block, unsigned int i_lane, const sdf::mesh& i_mesh, sdf::index_type i_face)
+	{
+		const unsigned int base = i_face*3;
+		const sdf::point3d& a = i_mesh.vertex(base+0);
+		const sdf::point3d& b = i_mesh.vertex(base+1);
+		const sdf::point3d& c = i_mesh.vertex(base+2);
+		const sdf::vector3d ab = b-a;
+		const sdf::vector3d ac = c-a;
+		const sdf::vector3d bc = c-b;
+		set_lane(o_block.m_a,i_lane,a);
+		set_lane(o_block.m_b,i_lane,b);
+		set_lane(o_block.m_c,i_lane,c);
+		set_lane(o_block.m_ab,i_lane,ab);
+		set_lane(o_block.m_ac,i_lane,ac);
+		set_lane(o_block.m_bc,i_lane,bc);
+
+		const double nx = (double)ab[1]*ac[2]-(double)ab[2]*ac[1];
+		const double ny = (double)ab[2]*ac[0]-(double)ab[0]*ac[2];
+		const double nz = (double)ab[0]*ac[1]-(double)ab[1]*ac[0];
+		const double length = sqrt(nx*nx+ny*ny+nz*nz);
+		if (length>0.0)
+		{
+			set_lane(o_block.m_normal,i_lane,(float)(nx/length),(float)(ny/length),(float)(nz/length));
+		}
+		else
+		{
+			const float nan = std::numeric_limits<float>::quiet_NaN();
+			set_lane(o_block.m_normal,i_lane,nan,nan,nan);
+		}
+
+		// A zero length edge gives an infinite inverse, the region test then gives NaNs which never get closer
+		const double abab = (double)ab[0]*ab[0]+(double)ab[1]*ab[1]+(double)ab[2]*ab[2];
+		const double acac = (double)ac[0]*ac[0]+(double)ac[1]*ac[1]+(double)ac[2]*ac[2];
+		const double bcbc = (double)bc[0]*bc[0]+(double)bc[1]*bc[1]+(double)bc[2]*bc[2];
+		set_lane(o_block.m_inv_length,i_lane,(float)(1.0/abab),(float)(1.0/acac),(float)(1.0/bcbc));
+		o_block.m_face[i_lane] = i_face;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Fill a lane past the end of the store - NaN vertices never get closer
+	//----------------------------------------------------------------------------------------------------------------------
+	void set_empty(sdf::triangle_store::block& o_block, unsigned int i_lane)
+	{
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		set_lane(o_block.m_a,i_lane,nan,nan,nan);
+		set_lane(o_block.m_b,i_lane,nan,nan,nan);
+		set_lane(o_block.m_c,i_lane,nan,nan,nan);
+		set_lane(o_block.m_ab,i_lane,nan,nan,nan);
+		set_lane(o_block.m_ac,i_lane,nan,nan,nan);
+		set_lane(o_block.m_bc,i_lane,nan,nan,nan);
+		set_lane(o_block.m_normal,i_lane,nan,nan,nan);
+		set_lane(o_block.m_inv_length,i_lane,nan,nan,nan);
+		o_block.m_face[i_lane] = 0;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of triangles per task of a refit
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int refit_chunk_size = 4096;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class refit_task
+	/// @brief Sets a chunk of triangles again in their slots
+	//----------------------------------------------------------------------------------------------------------------------
+	class refit_task
+	{
+	public :
+		refit_task(
+			const sdf::mesh& i_mesh,
+			const std::vector<sdf::index_type>& i_faces,
+			const sdf::triangle_store& i_store,
+			sdf::triangle_store::block_array* io_blocks)
+			: m_mesh(i_mesh), m_faces(i_faces), m_store(i_store), m_blocks(*io_blocks) {}
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			const std::size_t first = (std::size_t)i_chunk*refit_chunk_size;
+			const std::size_t end = std::min(first+refit_chunk_size,m_faces.size());
+			for (std::size_t i=first;i<end;i++)
+			{
+				const sdf::index_type current = m_store.slot((sdf::index_type)i);
+				set_triangle(m_blocks[current/sdf::triangle_store::width],current%sdf::triangle_store::width,m_mesh,m_faces[i]);
+			}
+		}
+	private :
+		const sdf::mesh& m_mesh;
+		const std::vector<sdf::index_type>& m_faces;
+		const sdf::triangle_store& m_store;
+		sdf::triangle_store::block_array& m_blocks;
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::triangle_store::triangle_store() : m_size(0) {}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::triangle_store::build(const mesh& i_mesh)
+{
+	std::vector<index_type> faces(i_mesh.num_faces());
+	for (unsigned int i=0;i<i_mesh.num_faces();i++)
+		faces[i] = i;
+	build(i_mesh,faces);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::triangle_store::build(const mesh& i_mesh, const std::vector<index_type>& i_faces)
+{
+	build(i_mesh,i_faces,std::vector<index_type>());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::triangle_store::build(const mesh& i_mesh, const std::vector<index_type>& i_faces, const std::vector<index_type>& i_ranges)
+{
+	m_size = static_cast<index_type>(i_faces.size());
+	m_slots.clear();
+	index_type num_slots = m_size;
+	if (!i_ranges.empty())
+	{
+		std::vector<bool> starts(i_faces.size(),false);
+		for (std::size_t i=0;i<i_ranges.size();i++)
+		{
+			if (i_ranges[i]<m_size)
+				starts[i_ranges[i]] = true;
+		}
+		m_slots.resize(i_faces.size());
+		num_slots = 0;
+		for (index_type i=0;i<m_size;i++)
+		{
+			if (starts[i])
+				num_slots = (num_slots+width-1)/width*width;
+			m_slots[i] = num_slots++;
+		}
+	}
+
+	m_blocks.clear();
+	m_blocks.resize((num_slots+width-1)/width);
+	for (std::size_t b=0;b<m_blocks.size();b++)
+	{
+		for (unsigned int lane=0;lane<width;lane++)
+			set_empty(m_blocks[b],lane);
+	}
+	for (index_type i=0;i<m_size;i++)
+	{
+		const index_type current = slot(i);
+		set_triangle(m_blocks[current/width],current%width,i_mesh,i_faces[i]);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::triangle_store::refit(const mesh& i_mesh, const std::vector<index_type>& i_faces)
+{
+	assert(i_faces.size()==m_size);
+	// Each task writes its own triangles, the lanes of a block are separate floats
+	thread::task_pool pool;
+	refit_task task(i_mesh,i_faces,*this,&m_blocks);
+	pool.run(static_cast<unsigned int>((i_faces.size()+refit_chunk_size-1)/refit_chunk_size),task);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::triangle_store::operator()(
+	const point3d& i_position,
+	index_type i_begin,
+	index_type i_end,
+	distance_record* io_closest_record,
+	unsigned int* io_face_id) const
+{
+	assert(i_begin<=i_end && i_end<=m_size);
+	if (i_begin==i_end)
+		return;
+	// A range is contiguous in the store
+	const index_type first = slot(i_begin);
+	const index_type end = first+(i_end-i_begin);
+
+#ifdef SDF_USE_SSE
+	const __m128 position[3] = { _mm_set1_ps(i_position[0]),_mm_set1_ps(i_position[1]),_mm_set1_ps(i_position[2]) };
+#endif
+	const index_type last = (end-1)/width;
+	for (index_type b=first/width;b<=last;b++)
+	{
+		const block& current = m_blocks[b];
+		// Lanes of the block inside the range
+		const index_type first_lane = b*width<first ? first-b*width : 0;
+		const index_type end_lane = (b+1)*width>end ? end-b*width : width;
+
+#ifdef SDF_USE_SSE
+		detail::triangle_lanes triangles;
+		detail::load_lanes(current,&triangles);
+		__m128 closest[3];
+		__m128i feature;
+		const __m128 sqdist = detail::closest_on_triangle(position,triangles,closest,&feature);
+		if (_mm_movemask_ps(_mm_cmplt_ps(sqdist,_mm_set1_ps(io_closest_record->distance_square())))==0)
+			continue;
+
+		float sq[width], x[width], y[width], z[width];
+		int features[width];
+		_mm_storeu_ps(sq,sqdist);
+		_mm_storeu_ps(x,closest[0]);
+		_mm_storeu_ps(y,closest[1]);
+		_mm_storeu_ps(z,closest[2]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(features),feature);
+		// In order, so the first of equally close triangles is kept like a sequential loop would
+		for (index_type i=first_lane;i<end_lane;i++)
+		{
+			if (sq[i]<io_closest_record->distance_square())
+			{
+				io_closest_record->set_feature(static_cast<feature_type>(features[i]));
+				io_closest_record->set_closest_point(point3d(x[i],y[i],z[i]));
+				io_closest_record->set_distance_squared(sq[i]);
+				*io_face_id = current.m_face[i];
+			}
+		}
+#else
+		for (index_type i=first_lane;i<end_lane;i++)
+		{
+			point3d closest;
+			feature_type feature;
+			const float sqdist = detail::closest_on_triangle(i_position,current,i,&closest,&feature);
+			if (sqdist<io_closest_record->distance_square())
+			{
+				io_closest_record->set_feature(feature);
+				io_closest_record->set_closest_point(closest);
+				io_closest_record->set_distance_squared(sqdist);
+				*io_face_id = current.m_face[i];
+			}
+		}
+#endif
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::size_t sdf::triangle_store::memory_usage() const
+{
+	return dynamic_memory(m_blocks)+dynamic_memory(m_slots);
+}
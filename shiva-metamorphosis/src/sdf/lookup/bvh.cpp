@@ -1,8 +1,309 @@
 #include <sdf/lookup/bvh.hpp>
 #include <sdf/core/binary_file.hpp>
 #include <sdf/core/tools.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <algorithm>
+#include <limits>
 #include <assert.h>
 
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of bins per axis when looking for the best split
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int sah_num_bins = 16;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Cost of visiting a node, relative to the cost of a block of triangle distance tests
+	//----------------------------------------------------------------------------------------------------------------------
+	const float sah_traversal_cost = 1.f;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Below this number of polygons a subtree is not worth splitting before going parallel
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int sah_parallel_min_polygons = 1024;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of subtrees per thread to aim for, so the task pool can balance uneven subtrees
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int sah_subtrees_per_thread = 4;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Leaves are tested by blocks of triangles (triangle_store), 1 to 4 triangles cost the same
+	//----------------------------------------------------------------------------------------------------------------------
+	float sah_leaf_cost(unsigned int i_count)
+	{
+		return (float)((i_count+sdf::triangle_store::width-1)/sdf::triangle_store::width);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Box and centre of every face, computed once for the whole build
+	//----------------------------------------------------------------------------------------------------------------------
+	struct sah_primitives
+	{
+		std::vector<sdf::aabb> m_boxes;
+		std::vector<sdf::point3d> m_centres;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A range of the polygon list still to be built, below an existing branch
+	//----------------------------------------------------------------------------------------------------------------------
+	struct sah_range
+	{
+		sdf::detail::bvh_branch::child_index m_node;
+		unsigned int m_begin;
+		unsigned int m_end;
+		unsigned int m_depth;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Grow a box by another box - empty boxes (an empty bin) are skipped, their bounds are inverted
+	//----------------------------------------------------------------------------------------------------------------------
+	void merge(sdf::aabb* io_box, const sdf::aabb& i_other)
+	{
+		if (i_other.minimum()[0]>i_other.maximum()[0])
+			return;
+		io_box->include(i_other.minimum());
+		io_box->include(i_other.maximum());
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Half the surface area of a box, 0 for an empty box
+	//----------------------------------------------------------------------------------------------------------------------
+	float half_area(const sdf::aabb& i_box)
+	{
+		if (i_box.minimum()[0]>i_box.maximum()[0])
+			return 0.f;
+		sdf::vector3d extent;
+		i_box.extent(&extent);
+		return extent[0]*extent[1]+extent[1]*extent[2]+extent[2]*extent[0];
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Tells in which bin a polygon falls, and whether it goes left of the split
+	//----------------------------------------------------------------------------------------------------------------------
+	class sah_binner
+	{
+	public :
+		sah_binner(const sah_primitives& i_primitives, unsigned int i_axis, float i_start, float i_scale, unsigned int i_split)
+			: m_primitives(i_primitives), m_axis(i_axis), m_start(i_start), m_scale(i_scale), m_split(i_split) {}
+
+		unsigned int bin(sdf::index_type i_polygon) const
+		{
+			const float position = (m_primitives.m_centres[i_polygon][m_axis]-m_start)*m_scale;
+			if (position<=0.f)
+				return 0;
+			return std::min(static_cast<unsigned int>(position),sah_num_bins-1);
+		}
+
+		bool operator()(sdf::index_type i_polygon) const { return bin(i_polygon)<m_split; }
+	private :
+		const sah_primitives& m_primitives;
+		unsigned int m_axis;
+		float m_start;
+		float m_scale;
+		unsigned int m_split;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Get the box of a range and find its best split. If it should be split, the range is partitioned in place
+	/// @return True if the range was split at o_middle, false if it should be a leaf
+	//----------------------------------------------------------------------------------------------------------------------
+	bool sah_split(
+		const sah_primitives& i_primitives,
+		const sdf::detail::settings& i_settings,
+		sdf::index_type* io_polygons,
+		unsigned int i_begin,
+		unsigned int i_end,
+		unsigned int i_depth,
+		sdf::aabb* o_box,
+		unsigned int* o_middle)
+	{
+		sdf::aabb box;
+		sdf::aabb centres;
+		for (unsigned int i=i_begin;i<i_end;i++)
+		{
+			merge(&box,i_primitives.m_boxes[io_polygons[i]]);
+			centres.include(i_primitives.m_centres[io_polygons[i]]);
+		}
+		*o_box = box;
+
+		const unsigned int count = i_end-i_begin;
+		if (i_depth>=i_settings.max_depth() || count<=i_settings.minimum_count() || count<=i_settings.optimum_count())
+			return false;
+
+		float best_cost = std::numeric_limits<float>::max();
+		unsigned int best_axis(3);
+		unsigned int best_split(0);
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			const float start = centres.minimum()[axis];
+			const float length = centres.maximum()[axis]-start;
+			if (!(length>0.f))
+				continue;
+
+			const sah_binner binner(i_primitives,axis,start,(float)sah_num_bins/length,0);
+			unsigned int bin_counts[sah_num_bins];
+			sdf::aabb bin_boxes[sah_num_bins];
+			std::fill(bin_counts,bin_counts+sah_num_bins,0u);
+			for (unsigned int i=i_begin;i<i_end;i++)
+			{
+				const unsigned int bin = binner.bin(io_polygons[i]);
+				bin_counts[bin]++;
+				merge(&bin_boxes[bin],i_primitives.m_boxes[io_polygons[i]]);
+			}
+
+			// Sweep from the right to get the cost of everything right of each split
+			float right_costs[sah_num_bins];
+			sdf::aabb right_box;
+			unsigned int right_count(0);
+			for (unsigned int bin=sah_num_bins-1;bin>0;bin--)
+			{
+				merge(&right_box,bin_boxes[bin]);
+				right_count+=bin_counts[bin];
+				right_costs[bin] = half_area(right_box)*sah_leaf_cost(right_count);
+			}
+			// And from the left to add the left side
+			sdf::aabb left_box;
+			unsigned int left_count(0);
+			for (unsigned int bin=0;bin<sah_num_bins-1;bin++)
+			{
+				merge(&left_box,bin_boxes[bin]);
+				left_count+=bin_counts[bin];
+				if (left_count==0 || left_count==count)
+					continue;
+				const float cost = half_area(left_box)*sah_leaf_cost(left_count)+right_costs[bin+1];
+				if (cost<best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = bin+1;
+				}
+			}
+		}
+
+		if (best_axis==3)
+		{
+			// All the centres are at the same place, no plane can separate them
+			if (count<=i_settings.maximum_count())
+				return false;
+			*o_middle = i_begin+count/2;
+			return true;
+		}
+
+		const float node_area = half_area(box);
+		const float split_cost = sah_traversal_cost+(node_area>0.f ? best_cost/node_area : 0.f);
+		if (split_cost>=sah_leaf_cost(count) && count<=i_settings.maximum_count())
+			return false;
+
+		const float start = centres.minimum()[best_axis];
+		const float length = centres.maximum()[best_axis]-start;
+		const sah_binner binner(i_primitives,best_axis,start,(float)sah_num_bins/length,best_split);
+		*o_middle = static_cast<unsigned int>(std::partition(io_polygons+i_begin,io_polygons+i_end,binner)-io_polygons);
+		assert(*o_middle>i_begin && *o_middle<i_end);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Build a whole subtree in a branch array (recursive)
+	//----------------------------------------------------------------------------------------------------------------------
+	void sah_build_subtree(
+		const sah_primitives& i_primitives,
+		const sdf::detail::settings& i_settings,
+		sdf::index_type* io_polygons,
+		sdf::detail::bvh::m_tree_pool* io_branches,
+		sdf::detail::bvh_branch::child_index i_node,
+		unsigned int i_begin,
+		unsigned int i_end,
+		unsigned int i_depth)
+	{
+		sdf::aabb box;
+		unsigned int middle(0);
+		if (!sah_split(i_primitives,i_settings,io_polygons,i_begin,i_end,i_depth,&box,&middle))
+		{
+			(*io_branches)[i_node].set_leaf(box,i_begin,i_end-i_begin);
+			return;
+		}
+
+		const sdf::detail::bvh_branch::child_index children = static_cast<sdf::detail::bvh_branch::child_index>(io_branches->size());
+		io_branches->resize(io_branches->size()+2);
+		(*io_branches)[i_node].set_node(box,children);
+
+		sah_build_subtree(i_primitives,i_settings,io_polygons,io_branches,children+0,i_begin,middle,i_depth+1);
+		sah_build_subtree(i_primitives,i_settings,io_polygons,io_branches,children+1,middle,i_end,i_depth+1);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The task given to the task pool - builds one subtree in its own branch array
+	//----------------------------------------------------------------------------------------------------------------------
+	class sah_subtree_builder
+	{
+	public :
+		sah_subtree_builder(
+			const sah_primitives& i_primitives,
+			const sdf::detail::settings& i_settings,
+			sdf::index_type* io_polygons,
+			const std::vector<sah_range>& i_ranges)
+			: m_primitives(i_primitives), m_settings(i_settings), m_polygons(io_polygons), m_ranges(i_ranges), m_subtrees(i_ranges.size()) {}
+
+		void operator()(unsigned int i_task, unsigned int /*i_thread*/)
+		{
+			const sah_range& range = m_ranges[i_task];
+			sdf::detail::bvh::m_tree_pool& branches = m_subtrees[i_task];
+			branches.resize(1);
+			sah_build_subtree(m_primitives,m_settings,m_polygons,&branches,0,range.m_begin,range.m_end,range.m_depth);
+		}
+
+		const sdf::detail::bvh::m_tree_pool& subtree(unsigned int i) const { return m_subtrees[i]; }
+	private :
+		const sah_primitives& m_primitives;
+		const sdf::detail::settings& m_settings;
+		sdf::index_type* m_polygons;
+		const std::vector<sah_range>& m_ranges;
+		std::vector<sdf::detail::bvh::m_tree_pool> m_subtrees;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of branches per task of a refit
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int refit_chunk_size = 1024;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The task given to the task pool - refits the leaves of a chunk of branches to their polygons
+	//----------------------------------------------------------------------------------------------------------------------
+	class leaf_refitter
+	{
+	public :
+		leaf_refitter(
+			const sdf::mesh& i_mesh,
+			const sdf::detail::bvh::polygon_array& i_polygons,
+			sdf::detail::bvh::m_tree_pool* io_branches)
+			: m_mesh(i_mesh), m_polygons(i_polygons), m_branches(*io_branches) {}
+
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			const std::size_t first = (std::size_t)i_chunk*refit_chunk_size;
+			const std::size_t end = std::min(first+refit_chunk_size,m_branches.size());
+			for (std::size_t i=first;i<end;i++)
+			{
+				sdf::detail::bvh_branch& branch = m_branches[i];
+				if (branch.has_children())
+					continue;
+				sdf::aabb box;
+				for (sdf::index_type j=branch.offset();j<branch.offset()+branch.num_polygons();j++)
+				{
+					const unsigned int base = m_polygons[j]*3;
+					box.include(m_mesh.vertex(base+0));
+					box.include(m_mesh.vertex(base+1));
+					box.include(m_mesh.vertex(base+2));
+				}
+				branch.set_leaf(box,branch.offset(),branch.num_polygons());
+			}
+		}
+	private :
+		const sdf::mesh& m_mesh;
+		const sdf::detail::bvh::polygon_array& m_polygons;
+		sdf::detail::bvh::m_tree_pool& m_branches;
+	};
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 const sdf::detail::bvh_branch& sdf::detail::bvh::root() const
 {
@@ -45,6 +346,7 @@ void sdf::detail::bvh::build(const mesh& i_mesh, const settings& i_settings)
 				bvhfilein(&m_polylist);
 				bvhfilein(&m_branches);
 				bvhfilein.close();
+				build_triangles(i_mesh);
 			}
 			else
 			{
@@ -69,14 +371,173 @@ void sdf::detail::bvh::force_build(const mesh& i_mesh, const settings& i_setting
 {
 	assert(i_settings.max_depth()<bvh_branch::maximum_depth);
 	assert(!i_mesh.empty());
-	// Create the root
-	m_branches.push_back(bvh_branch());
+	m_branches.clear();
+	m_polylist.clear();
+
+	if (i_settings.builder()==settings::binned_sah)
+	{
+		sah_build(i_mesh,i_settings);
+	}
+	else
+	{
+		// Create the root
+		m_branches.push_back(bvh_branch());
+
+		polygon_array all_polygons(i_mesh.num_faces());
+		for (unsigned int i=0;i<i_mesh.num_faces();i++)
+			all_polygons[i]=i;
+
+		root().build(*this,i_mesh,i_settings,all_polygons);
+	}
+	build_triangles(i_mesh);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::bvh::build_triangles(const mesh& i_mesh)
+{
+	// Each leaf starts on a new block
+	polygon_array leaves;
+	for (unsigned int i=0;i<static_cast<unsigned int>(m_branches.size());i++)
+	{
+		if (!m_branches[i].has_children() && m_branches[i].num_polygons()>0)
+			leaves.push_back(m_branches[i].offset());
+	}
+	m_triangles.build(i_mesh,m_polylist,leaves);
+}
 
-	polygon_array all_polygons(i_mesh.num_faces());
-	for (unsigned int i=0;i<i_mesh.num_faces();i++)
-		all_polygons[i]=i;
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::bvh::sah_build(const mesh& i_mesh, const settings& i_settings)
+{
+	const unsigned int num_faces = i_mesh.num_faces();
+	sah_primitives primitives;
+	primitives.m_boxes.resize(num_faces);
+	primitives.m_centres.resize(num_faces);
+	const float third = 1.f/3.f;
+	for (unsigned int i=0;i<num_faces;i++)
+	{
+		const point3d& a = i_mesh.vertex(i*3+0);
+		const point3d& b = i_mesh.vertex(i*3+1);
+		const point3d& c = i_mesh.vertex(i*3+2);
+		primitives.m_boxes[i].set(a,b,c);
+		primitives.m_centres[i] = (a+b+c)*third;
+	}
+
+	// The leaves point straight into this list, which gets partitioned in place
+	m_polylist.resize(num_faces);
+	for (unsigned int i=0;i<num_faces;i++)
+		m_polylist[i]=i;
+	index_type* polygons = &m_polylist[0];
+
+	// Split the top levels breadth first, until there are enough subtrees to keep all the threads busy
+	thread::task_pool pool;
+	const unsigned int num_subtrees = pool.num_threads()>1 ? pool.num_threads()*sah_subtrees_per_thread : 1;
+	std::vector<sah_range> subtrees;
+	std::vector<sah_range> frontier(1);
+	frontier[0].m_node = 0;
+	frontier[0].m_begin = 0;
+	frontier[0].m_end = num_faces;
+	frontier[0].m_depth = 0;
+	m_branches.resize(1);
+	while (!frontier.empty())
+	{
+		std::vector<sah_range> next;
+		for (unsigned int i=0;i<static_cast<unsigned int>(frontier.size());i++)
+		{
+			const sah_range& range = frontier[i];
+			const unsigned int num_open = static_cast<unsigned int>(subtrees.size()+next.size()+frontier.size()-i);
+			if (range.m_end-range.m_begin<sah_parallel_min_polygons || num_open>=num_subtrees)
+			{
+				subtrees.push_back(range);
+				continue;
+			}
 
-	root().build(*this,i_mesh,i_settings,all_polygons);
+			aabb box;
+			unsigned int middle(0);
+			if (!sah_split(primitives,i_settings,polygons,range.m_begin,range.m_end,range.m_depth,&box,&middle))
+			{
+				m_branches[range.m_node].set_leaf(box,range.m_begin,range.m_end-range.m_begin);
+				continue;
+			}
+
+			const bvh_branch::child_index children = static_cast<bvh_branch::child_index>(m_branches.size());
+			m_branches.resize(m_branches.size()+2);
+			m_branches[range.m_node].set_node(box,children);
+
+			sah_range halves[2] = { range, range };
+			halves[0].m_node = children+0;
+			halves[0].m_end = middle;
+			halves[1].m_node = children+1;
+			halves[1].m_begin = middle;
+			halves[0].m_depth = halves[1].m_depth = range.m_depth+1;
+			next.push_back(halves[0]);
+			next.push_back(halves[1]);
+		}
+		frontier.swap(next);
+	}
+
+	// Subtrees work on separate parts of the polygon list, so they can be built at the same time
+	sah_subtree_builder builder(primitives,i_settings,polygons,subtrees);
+	pool.run(static_cast<unsigned int>(subtrees.size()),builder);
+
+	// Move them into the tree. Each subtree root replaces its top level branch, the rest is appended with shifted children
+	std::size_t total = m_branches.size();
+	for (unsigned int i=0;i<static_cast<unsigned int>(subtrees.size());i++)
+		total += builder.subtree(i).size()-1;
+	m_branches.reserve(total);
+
+	for (unsigned int i=0;i<static_cast<unsigned int>(subtrees.size());i++)
+	{
+		const m_tree_pool& subtree = builder.subtree(i);
+		// Local child index c (never 0, which is the subtree root) ends up at shift+c
+		const bvh_branch::child_index shift = static_cast<bvh_branch::child_index>(m_branches.size())-1;
+		for (unsigned int j=0;j<static_cast<unsigned int>(subtree.size());j++)
+		{
+			bvh_branch branch = subtree[j];
+			if (branch.has_children())
+				branch.set_node(branch.box(),branch.child(0)+shift);
+			if (j==0)
+				m_branches[subtrees[i].m_node] = branch;
+			else
+				m_branches.push_back(branch);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::bvh::refit(const mesh& i_mesh)
+{
+	assert(!m_branches.empty());
+	thread::task_pool pool;
+	leaf_refitter refitter(i_mesh,m_polylist,&m_branches);
+	pool.run(static_cast<unsigned int>((m_branches.size()+refit_chunk_size-1)/refit_chunk_size),refitter);
+
+	// Both builders append the children after their parent, so walking backwards sees the children first
+	for (std::size_t i=m_branches.size();i-->0;)
+	{
+		bvh_branch& branch = m_branches[i];
+		if (!branch.has_children())
+			continue;
+		assert(branch.child(0)>i);
+		aabb box(m_branches[branch.child(0)].box());
+		merge(&box,m_branches[branch.child(1)].box());
+		branch.set_node(box,branch.child(0));
+	}
+	m_triangles.refit(i_mesh,m_polylist);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::detail::bvh::sah_cost() const
+{
+	assert(!m_branches.empty());
+	double cost = 0.0;
+	for (std::size_t i=0;i<m_branches.size();i++)
+	{
+		const bvh_branch& branch = m_branches[i];
+		const float area = half_area(branch.box());
+		cost += branch.has_children() ? sah_traversal_cost*area : sah_leaf_cost(branch.num_polygons())*area;
+	}
+	const float root_area = half_area(root().box());
+	return root_area>0.f ? static_cast<float>(cost/root_area) : 0.f;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -141,5 +602,5 @@ bool sdf::detail::bvh::operator()(
 //----------------------------------------------------------------------------------------------------------------------
 std::size_t sdf::detail::bvh::memory_usage() const
 {
-	return dynamic_memory(m_polylist)+dynamic_memory(m_branches);
+	return dynamic_memory(m_polylist)+dynamic_memory(m_branches)+m_triangles.memory_usage();
 }
\ No newline at end of file
@@ -1,15 +1,14 @@
 #include <sdf/lookup/bvh_accelerated.hpp>
+#include <sdf/core/config.hpp>
 #include <assert.h>
 
 //----------------------------------------------------------------------------------------------------------------------
-sdf::bvh_accelerated::bvh_accelerated() : m_mesh(0) {}
+sdf::bvh_accelerated::bvh_accelerated() : m_mesh(0), m_settings(26,2,16,3,detail::settings::binned_sah), m_build_cost(0.f) {}
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::bvh_accelerated::initialize(const mesh& i_mesh)
 {
-	m_mesh = &i_mesh;
-	detail::settings stt(26,2,16,3);
-	m_tree.build(i_mesh,stt);
+	initialize(i_mesh,detail::settings(26,2,16,3,detail::settings::binned_sah));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -17,7 +16,23 @@ void sdf::bvh_accelerated::initialize(const mesh& i_mesh, const detail::settings
 {
 	assert(i_settings.max_depth()<detail::bvh_branch::maximum_depth);
 	m_mesh = &i_mesh;
+	m_settings = i_settings;
 	m_tree.build(i_mesh,i_settings);
+	m_build_cost = m_tree.sah_cost();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::bvh_accelerated::refit(float i_rebuild_ratio)
+{
+	assert(m_mesh);
+	m_tree.refit(*m_mesh);
+	if (i_rebuild_ratio<=0.f || m_tree.sah_cost()<=i_rebuild_ratio*m_build_cost)
+		return false;
+
+	// The .bvh file next to the mesh describes the old shape, build without it
+	m_tree.force_build(*m_mesh,m_settings);
+	m_build_cost = m_tree.sah_cost();
+	return true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -31,9 +46,10 @@ void sdf::bvh_accelerated::operator()(const point3d& i_position, distance_record
 void sdf::bvh_accelerated::operator()(const point3d i_positions[], distance_record o_closest_record[], unsigned int o_face_id[]) const
 {
 	assert(m_mesh);
-#ifdef PACKETS
+#ifdef SDF_USE_SSE
 	m_tree(*m_mesh,i_positions,o_closest_record,o_face_id);
 #else
+	// Without SSE the packet has nothing to gain over 8 lookups
 	for(int i=0;i<8;i++)
 		m_tree(*m_mesh,i_positions[i],&o_closest_record[i],&o_face_id[i]);
 #endif
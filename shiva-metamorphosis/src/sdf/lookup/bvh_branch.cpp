@@ -2,13 +2,49 @@
 #include <sdf/lookup/bvh_branch.hpp>
 #include <sdf/lookup/bvh.hpp>
 #include <sdf/distance/distance_to_aabb.hpp>
+#include <sdf/distance/distance_to_aabb_packet.hpp>
+#include <sdf/distance/distance_to_triangle_packet.hpp>
 #include <sdf/core/triangle_triangle_overlap.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <assert.h>
 
 //----------------------------------------------------------------------------------------------------------------------
 const sdf::detail::bvh_branch::child_index not_set_yet = static_cast<sdf::detail::bvh_branch::child_index>(0); // Cannot have root as a child
 //----------------------------------------------------------------------------------------------------------------------
 const sdf::index_type invalid = static_cast<sdf::index_type>(-1);
+//----------------------------------------------------------------------------------------------------------------------
+const unsigned int packet_size = sdf::distance_to_aabb_packet::packet_size;
+//----------------------------------------------------------------------------------------------------------------------
+const unsigned int divergent_lanes = 2; // At most that many active lanes, the packet is traversed one lane at a time
+//----------------------------------------------------------------------------------------------------------------------
+const float coherent_spread = 2.f; // A packet whose points are further apart than that many times the distance of its first point is traversed one lane at a time
+//----------------------------------------------------------------------------------------------------------------------
+const float bound_slack = 1.001f; // The bound given to the other lanes is loosened a little, so the closest triangle is always strictly closer
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A branch left to visit by a packet, with the squared distance from each lane to its box
+	//----------------------------------------------------------------------------------------------------------------------
+	struct packet_entry
+	{
+		const sdf::detail::bvh_branch* m_branch;
+		float m_sqdist[packet_size];
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of lanes set in a mask
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned int num_lanes(unsigned int i_mask)
+	{
+		unsigned int count(0);
+		for (;i_mask;i_mask&=i_mask-1)
+			count++;
+		return count;
+	}
+}
 
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -120,6 +156,25 @@ void sdf::detail::bvh_branch::build(bvh& io_tree, const mesh& i_mesh, const sett
 	}
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::bvh_branch::set_leaf(const aabb& i_box, index_type i_offset, index_type i_size)
+{
+	m_box = i_box;
+	m_children = not_set_yet;
+	m_offset = i_offset;
+	m_size = i_size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::bvh_branch::set_node(const aabb& i_box, child_index i_children)
+{
+	assert(i_children!=not_set_yet);
+	m_box = i_box;
+	m_children = i_children;
+	m_offset = invalid;
+	m_size = 0;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::detail::bvh_branch::recursive_traversal(const bvh& i_tree, const mesh& i_mesh, const point3d& i_position, distance_record* io_closest_record, unsigned int* o_face_id) const
 {
@@ -162,106 +217,115 @@ void sdf::detail::bvh_branch::recursive_traversal(const bvh& i_tree, const mesh&
 	}
 	else
 	{
-		const polygon_array& polygons = i_tree.array();
-		distance_to_triangle tridist(i_position);
-		for (unsigned int i=m_offset;i<m_offset+m_size;i++)
-		{
-			const unsigned int polyid = polygons[i];
-			const unsigned int base = polyid*3;
-			distance_record thisrecord;
-			tridist(
-				i_mesh.vertex(base+0),
-				i_mesh.vertex(base+1),
-				i_mesh.vertex(base+2),
-				&thisrecord
-				);
-			if (thisrecord<*io_closest_record)
-			{
-				*io_closest_record = thisrecord;
-				*o_face_id = polyid;
-			}
-		}
+		i_tree.triangles()(i_position,m_offset,m_offset+m_size,io_closest_record,o_face_id);
 	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::detail::bvh_branch::operator()(const bvh& i_tree, const mesh& i_mesh,	const point3d i_position[], distance_record o_closest_record[],	unsigned int o_face_id[]) const
-{/*
-	if (has_children())
+{
+	// The first lane goes alone. The lanes only share their way down the tree when the closest features of all of them are
+	// in the same place, which is when the points are close to each other compared to their distance to the mesh
+	recursive_traversal(i_tree,i_mesh,i_position[0],&o_closest_record[0],&o_face_id[0]);
+	const float first = std::sqrt(o_closest_record[0].distance_square());
+	float offset[packet_size];
+	float spread(0.f);
+	for (unsigned int i=0;i<packet_size;i++)
+	{
+		offset[i] = std::sqrt(i_position[i].distance_squared_to(i_position[0]));
+		spread = std::max(spread,offset[i]);
+	}
+	if (spread>coherent_spread*first)
 	{
-		distance_to_aabb boxdist(i_position[0]);
+		// Incoherent packet, the shared traversal would visit the nodes of every lane with most lanes masked
+		for (unsigned int i=1;i<packet_size;i++)
+			recursive_traversal(i_tree,i_mesh,i_position[i],&o_closest_record[i],&o_face_id[i]);
+		return;
+	}
 
-		const bvh_branch& child0 = i_tree.branch(m_children+0);
-		const bvh_branch& child1 = i_tree.branch(m_children+1);
+	distance_to_aabb_packet boxdist(i_position);
+	distance_to_triangle_packet tridist(i_position);
 
-		const float sqdist0 = boxdist(child0.box());
-		const float sqdist1 = boxdist(child1.box());
-		if (sqdist0<sqdist1)
-		{
-			if (sqdist0<io_closest_record->distance_square())
-				child0(i_tree,i_mesh,i_position,io_closest_record,o_face_id);
-			if (sqdist1<io_closest_record->distance_square())
-				child1(i_tree,i_mesh,i_position,io_closest_record,o_face_id);
-		}
-		else
-		{
-			if (sqdist1<io_closest_record->distance_square())
-				child1(i_tree,i_mesh,i_position,io_closest_record,o_face_id);
-			if (sqdist0<io_closest_record->distance_square())
-				child0(i_tree,i_mesh,i_position,io_closest_record,o_face_id);
-		}
+	// The first lane is done. The distance of any other lane is at most the distance of the first one plus the offset
+	// between them, which prunes the tree from the start
+	float best[packet_size];
+	best[0] = 0.f;
+	for (unsigned int i=1;i<packet_size;i++)
+	{
+		const float bound = (first+offset[i])*bound_slack;
+		best[i] = std::min(o_closest_record[i].distance_square(),bound*bound);
 	}
-	else
+
+	// One stack for the whole packet, each entry keeps the box distance of every lane
+	typedef static_stack<packet_entry,maximum_depth> entry_stack;
+	entry_stack tovisit;
+
+	packet_entry root;
+	root.m_branch = this;
+	boxdist(m_box,best,root.m_sqdist);
+	tovisit.push(root);
+
+	while (!tovisit.empty())
 	{
-		const polygon_array& polygons = i_tree.array();
-		distance_to_triangle tridist(i_position);
-		for (unsigned int i=m_offset;i<m_offset+m_size;i++)
+		const packet_entry current = tovisit.top();
+		tovisit.pop();
+
+		// Lanes which may still find something closer in this branch
+		const unsigned int active = distance_to_aabb_packet::closer(current.m_sqdist,best);
+		if (active==0)
+			continue;
+
+		const bvh_branch& currentnode = *current.m_branch;
+		if (num_lanes(active)<=divergent_lanes)
 		{
-			const unsigned int polyid = polygons[i];
-			const unsigned int base = polyid*3;
-			distance_record thisrecord;
-			tridist(
-				i_mesh.vertex(base+0),
-				i_mesh.vertex(base+1),
-				i_mesh.vertex(base+2),
-				&thisrecord
-				);
-			if (thisrecord<*io_closest_record)
+			// The packet has diverged, the few lanes left are cheaper one at a time
+			for (unsigned int i=0;i<packet_size;i++)
 			{
-				*io_closest_record = thisrecord;
-				*o_face_id = polyid;
+				if (active&(1u<<i))
+				{
+					currentnode.recursive_traversal(i_tree,i_mesh,i_position[i],&o_closest_record[i],&o_face_id[i]);
+					best[i] = o_closest_record[i].distance_square();
+				}
+			}
+		}
+		else if (currentnode.has_children())
+		{
+			packet_entry children[2];
+			float nearest[2];
+			for (unsigned int c=0;c<2;c++)
+			{
+				children[c].m_branch = &i_tree.branch(currentnode.m_children+c);
+				boxdist(children[c].m_branch->box(),best,children[c].m_sqdist);
+				nearest[c] = std::numeric_limits<float>::max();
+				for (unsigned int i=0;i<packet_size;i++)
+				{
+					if (active&(1u<<i))
+						nearest[c] = std::min(nearest[c],children[c].m_sqdist[i]);
+				}
 			}
+			// The child nearest to any active lane goes on top
+			if (nearest[0]<nearest[1])
+				tovisit.push(children[1],children[0]);
+			else
+				tovisit.push(children[0],children[1]);
+		}
+		else
+		{
+			for (unsigned int i=currentnode.m_offset;i<currentnode.m_offset+currentnode.m_size;i++)
+				tridist(i_tree.triangles(),i,active,best,o_closest_record,o_face_id);
 		}
-	}*/
+	}
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void sdf::detail::bvh_branch::test_polygons(const bvh& i_tree, const mesh& i_mesh, const point3d& i_position, distance_record* io_closest_record, unsigned int* o_face_id) const
+void sdf::detail::bvh_branch::test_polygons(const bvh& i_tree, const mesh& /*i_mesh*/, const point3d& i_position, distance_record* io_closest_record, unsigned int* o_face_id) const
 {
-	const polygon_array& polygons = i_tree.array();
-	distance_to_triangle tridist(i_position);
-	for (unsigned int i=m_offset;i<m_offset+m_size;i++)
-	{
-		const unsigned int polyid = polygons[i];
-		const unsigned int base = polyid*3;
-		distance_record thisrecord;
-		tridist(
-			i_mesh.vertex(base+0),
-			i_mesh.vertex(base+1),
-			i_mesh.vertex(base+2),
-			&thisrecord
-			);
-		if (thisrecord<*io_closest_record)
-		{
-			*io_closest_record = thisrecord;
-			*o_face_id = polyid;
-		}
-	}
+	i_tree.triangles()(i_position,m_offset,m_offset+m_size,io_closest_record,o_face_id);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void sdf::detail::bvh_branch::stackless_traversal(const bvh& i_tree, const mesh& i_mesh, const point3d& i_position, distance_record* io_closest_record, unsigned int* o_face_id) const
+void sdf::detail::bvh_branch::stackless_traversal(const bvh& i_tree, const mesh& /*i_mesh*/, const point3d& i_position, distance_record* io_closest_record, unsigned int* o_face_id) const
 {
 	distance_to_aabb boxdist(i_position);
 
@@ -313,25 +377,7 @@ void sdf::detail::bvh_branch::stackless_traversal(const bvh& i_tree, const mesh&
 			}
 			else
 			{
-				const polygon_array& polygons = i_tree.array();
-				distance_to_triangle tridist(i_position);
-				for (unsigned int i=currentnode.m_offset;i<currentnode.m_offset+currentnode.m_size;i++)
-				{
-					const unsigned int polyid = polygons[i];
-					const unsigned int base = polyid*3;
-					distance_record thisrecord;
-					tridist(
-						i_mesh.vertex(base+0),
-						i_mesh.vertex(base+1),
-						i_mesh.vertex(base+2),
-						&thisrecord
-						);
-					if (thisrecord<*io_closest_record)
-					{
-						*io_closest_record = thisrecord;
-						*o_face_id = polyid;
-					}
-				}
+				i_tree.triangles()(i_position,currentnode.m_offset,currentnode.m_offset+currentnode.m_size,io_closest_record,o_face_id);
 			}
 		}
 	};
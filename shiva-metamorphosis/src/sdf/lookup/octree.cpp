@@ -1,45 +1,253 @@
 #include <sdf/lookup/octree.hpp>
 #include <sdf/lookup/octnode.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <sdf/core/tools.hpp>
+#include <sdf/core/triangle_aabb_overlap.hpp>
+#include <algorithm>
 #include <assert.h>
 
-
-//----------------------------------------------------------------------------------------------------------------------
-void sdf::detail::octree::build_children(
-	const mesh& i_mesh,
-	const settings& i_settings,
-	const polygon_array i_buckets[],
-	const aabb i_boxes[],
-	unsigned int i_depth,
-	child_index* o_childindex)
+namespace
 {
-	const child_index firstindex = static_cast<child_index>(m_nodes.size());
-	*o_childindex=firstindex;
-
-	// This resize might remove some memory so that the pointer o_childindex might become invalid, so it needs to set it before hand
-	m_nodes.resize(m_nodes.size()+8);
-
-	m_nodes[firstindex+0].build(this,i_mesh,i_boxes[0],i_buckets[0],i_depth,i_settings);
-	m_nodes[firstindex+1].build(this,i_mesh,i_boxes[1],i_buckets[1],i_depth,i_settings);
-	m_nodes[firstindex+2].build(this,i_mesh,i_boxes[2],i_buckets[2],i_depth,i_settings);
-	m_nodes[firstindex+3].build(this,i_mesh,i_boxes[3],i_buckets[3],i_depth,i_settings);
-	m_nodes[firstindex+4].build(this,i_mesh,i_boxes[4],i_buckets[4],i_depth,i_settings);
-	m_nodes[firstindex+5].build(this,i_mesh,i_boxes[5],i_buckets[5],i_depth,i_settings);
-	m_nodes[firstindex+6].build(this,i_mesh,i_boxes[6],i_buckets[6],i_depth,i_settings);
-	m_nodes[firstindex+7].build(this,i_mesh,i_boxes[7],i_buckets[7],i_depth,i_settings);
-}
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The children boxes are grown by this fraction for the triangle tests, so a polygon only goes down to a child
+	///			when it is inside it for sure
+	//----------------------------------------------------------------------------------------------------------------------
+	const float child_margin = 1e-3f;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Below this number of polygons a subtree is not worth splitting before going parallel
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int parallel_min_polygons = 1024;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of subtrees per thread to aim for, so the task pool can balance uneven subtrees
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int subtrees_per_thread = 4;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Bucket of the polygons overlapping more than one child, they stay in the node
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned char node_bucket = 8;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A range of the polygon list still to be built, and the node it belongs to
+	//----------------------------------------------------------------------------------------------------------------------
+	struct oct_range
+	{
+		sdf::detail::octree::child_index m_node;
+		sdf::aabb m_box;
+		unsigned int m_begin;
+		unsigned int m_end;
+		unsigned int m_depth;
+	};
 
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Buffers reused by the splits of a thread
+	//----------------------------------------------------------------------------------------------------------------------
+	struct split_buffers
+	{
+		std::vector<unsigned char> m_buckets;
+		std::vector<sdf::index_type> m_polygons;
+	};
 
-//----------------------------------------------------------------------------------------------------------------------
-void sdf::detail::octree::append_polygons(
-				const polygon_array& i_polygons,
-				index_type* o_offset, index_type* o_num_elements)
-{
-	*o_offset = static_cast<index_type>(m_polylist.size());
-	*o_num_elements = static_cast<index_type>(i_polygons.size());
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The boxes of the 8 children, bit 2 of the child index picks the upper half in x, bit 1 in y and bit 0 in z
+	//----------------------------------------------------------------------------------------------------------------------
+	void child_boxes(const sdf::aabb& i_box, sdf::aabb o_boxes[8])
+	{
+		sdf::point3d centre;
+		i_box.centre(&centre);
+		const sdf::point3d& mi = i_box.minimum();
+		const sdf::point3d& ma = i_box.maximum();
+		for (unsigned int i=0;i<8;i++)
+		{
+			const sdf::point3d corner(
+				(i&4) ? ma[0] : mi[0],
+				(i&2) ? ma[1] : mi[1],
+				(i&1) ? ma[2] : mi[2]);
+			o_boxes[i] = sdf::aabb(corner,centre);
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Sort a range of polygons into the node and its 8 children, in place: the node's polygons first, then each child's
+	/// @param[in] i_mesh The original mesh
+	/// @param[in] i_settings The tree settings
+	/// @param io_polygons The polygon list
+	/// @param[in] i_range The range to split
+	/// @param io_buffers Buffers for the partition
+	/// @param[out] o_bounds The node's polygons are [i_range.m_begin,o_bounds[0]), child i's are [o_bounds[i],o_bounds[i+1])
+	/// @return False if the range should be a leaf (the polygons are left untouched)
+	//----------------------------------------------------------------------------------------------------------------------
+	bool split(
+		const sdf::mesh& i_mesh,
+		const sdf::detail::settings& i_settings,
+		sdf::index_type* io_polygons,
+		const oct_range& i_range,
+		split_buffers* io_buffers,
+		unsigned int o_bounds[9])
+	{
+		const unsigned int count = i_range.m_end-i_range.m_begin;
+		if (i_range.m_depth>=i_settings.max_depth() || count<=i_settings.optimum_count())
+			return false;
+
+		// The children have the same size, only their centres differ
+		sdf::aabb boxes[8];
+		child_boxes(i_range.m_box,boxes);
+		float centres[2][3][4];
+		sdf::vector3d halfextent(0.f,0.f,0.f);
+		for (unsigned int i=0;i<8;i++)
+		{
+			sdf::point3d centre;
+			sdf::vector3d extent;
+			boxes[i].centre(&centre);
+			boxes[i].extent(&extent);
+			for (unsigned int axis=0;axis<3;axis++)
+			{
+				centres[i/4][axis][i%4] = centre[axis];
+				halfextent[axis] = std::max(halfextent[axis],extent[axis]*(0.5f+child_margin));
+			}
+		}
+
+		sdf::point3d middle;
+		i_range.m_box.centre(&middle);
+
+		std::vector<unsigned char>& buckets = io_buffers->m_buckets;
+		buckets.resize(count);
+		unsigned int counts[node_bucket+1];
+		std::fill(counts,counts+node_bucket+1,0u);
+		for (unsigned int i=0;i<count;i++)
+		{
+			const unsigned int base = io_polygons[i_range.m_begin+i]*3;
+			const sdf::point3d& first = i_mesh.vertex(base+0);
+			const sdf::point3d& second = i_mesh.vertex(base+1);
+			const sdf::point3d& third = i_mesh.vertex(base+2);
+			// Most polygons are on one side of the centre planes, only the others need the exact tests
+			const sdf::aabb tribox(first,second,third);
+			unsigned char bucket = 0;
+			bool straddles = false;
+			for (unsigned int axis=0;axis<3;axis++)
+			{
+				if (tribox.minimum()[axis]>middle[axis])
+					bucket |= 4>>axis;
+				else if (!(tribox.maximum()[axis]<middle[axis]))
+					straddles = true;
+			}
+			if (straddles)
+			{
+				const unsigned int overlaps =
+					sdf::triangle_box_overlap(centres[0],halfextent,first,second,third)|
+					(sdf::triangle_box_overlap(centres[1],halfextent,first,second,third)<<4);
+				// A single bit set means a single child
+				bucket = node_bucket;
+				if (overlaps!=0 && (overlaps&(overlaps-1))==0)
+				{
+					bucket = 0;
+					while (!(overlaps&(1u<<bucket)))
+						bucket++;
+				}
+			}
+			buckets[i] = bucket;
+			counts[bucket]++;
+		}
+
+		// Count then scatter: the node's polygons, then the children in order
+		unsigned int starts[node_bucket+1];
+		starts[node_bucket] = 0;
+		unsigned int position = counts[node_bucket];
+		for (unsigned int i=0;i<node_bucket;i++)
+		{
+			starts[i] = position;
+			position += counts[i];
+		}
+		std::vector<sdf::index_type>& scattered = io_buffers->m_polygons;
+		scattered.resize(count);
+		for (unsigned int i=0;i<count;i++)
+			scattered[starts[buckets[i]]++] = io_polygons[i_range.m_begin+i];
+		std::copy(scattered.begin(),scattered.end(),io_polygons+i_range.m_begin);
+
+		o_bounds[0] = i_range.m_begin+counts[node_bucket];
+		for (unsigned int i=0;i<node_bucket;i++)
+			o_bounds[i+1] = o_bounds[i]+counts[i];
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Build a subtree (recursive)
+	/// @param[in] i_mesh The original mesh
+	/// @param[in] i_settings The tree settings
+	/// @param io_polygons The polygon list
+	/// @param[in] i_range The range of the subtree, and its node in io_nodes
+	/// @param io_buffers Buffers for the partitions
+	/// @param io_nodes The node array
+	//----------------------------------------------------------------------------------------------------------------------
+	void build_subtree(
+		const sdf::mesh& i_mesh,
+		const sdf::detail::settings& i_settings,
+		sdf::index_type* io_polygons,
+		const oct_range& i_range,
+		split_buffers* io_buffers,
+		sdf::detail::octree::node_pool* io_nodes)
+	{
+		unsigned int bounds[9];
+		if (!split(i_mesh,i_settings,io_polygons,i_range,io_buffers,bounds))
+		{
+			(*io_nodes)[i_range.m_node].set_polygons(i_range.m_box,i_range.m_begin,i_range.m_end-i_range.m_begin);
+			return;
+		}
 
-	m_polylist.insert(m_polylist.end(),i_polygons.begin(),i_polygons.end());
+		// io_nodes grows, so the node is only accessed by index
+		const sdf::detail::octree::child_index children = static_cast<sdf::detail::octree::child_index>(io_nodes->size());
+		io_nodes->resize(io_nodes->size()+8);
+		(*io_nodes)[i_range.m_node].set_polygons(i_range.m_box,i_range.m_begin,bounds[0]-i_range.m_begin);
+		(*io_nodes)[i_range.m_node].set_children(children);
+
+		sdf::aabb boxes[8];
+		child_boxes(i_range.m_box,boxes);
+		for (unsigned int i=0;i<8;i++)
+		{
+			oct_range child;
+			child.m_node = children+i;
+			child.m_box = boxes[i];
+			child.m_begin = bounds[i];
+			child.m_end = bounds[i+1];
+			child.m_depth = i_range.m_depth+1;
+			build_subtree(i_mesh,i_settings,io_polygons,child,io_buffers,io_nodes);
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The task given to the task pool - builds one subtree in its own node array
+	//----------------------------------------------------------------------------------------------------------------------
+	class subtree_builder
+	{
+	public :
+		subtree_builder(
+			const sdf::mesh& i_mesh,
+			const sdf::detail::settings& i_settings,
+			sdf::index_type* io_polygons,
+			const std::vector<oct_range>& i_ranges,
+			unsigned int i_num_threads)
+			: m_mesh(i_mesh), m_settings(i_settings), m_polygons(io_polygons), m_ranges(i_ranges), m_subtrees(i_ranges.size()), m_buffers(i_num_threads) {}
+
+		void operator()(unsigned int i_task, unsigned int i_thread)
+		{
+			oct_range range = m_ranges[i_task];
+			range.m_node = 0;
+			sdf::detail::octree::node_pool& nodes = m_subtrees[i_task];
+			nodes.resize(1);
+			build_subtree(m_mesh,m_settings,m_polygons,range,&m_buffers[i_thread],&nodes);
+		}
+
+		const sdf::detail::octree::node_pool& subtree(unsigned int i) const { return m_subtrees[i]; }
+	private :
+		const sdf::mesh& m_mesh;
+		const sdf::detail::settings& m_settings;
+		sdf::index_type* m_polygons;
+		const std::vector<oct_range>& m_ranges;
+		std::vector<sdf::detail::octree::node_pool> m_subtrees;
+		std::vector<split_buffers> m_buffers;
+	};
 }
 
+
 //----------------------------------------------------------------------------------------------------------------------
 const sdf::detail::octnode& sdf::detail::octree::node(unsigned int i) const
 {
@@ -80,18 +288,96 @@ const sdf::detail::octree::polygon_array& sdf::detail::octree::array() const
 void sdf::detail::octree::build(const mesh& i_mesh, const settings& i_settings)
 {
 	assert(!i_mesh.empty());
+	const unsigned int num_faces = i_mesh.num_faces();
+	m_nodes.clear();
 	m_nodes.push_back(octnode()); // This is the root
 
-	octnode::polygon_array all_polygons(i_mesh.num_faces());
-	for (unsigned int i=0;i<i_mesh.num_faces();i++)
-		all_polygons[i]=i;
+	// The nodes point straight into this list, which gets partitioned in place
+	m_polylist.resize(num_faces);
+	for (unsigned int i=0;i<num_faces;i++)
+		m_polylist[i]=i;
+	index_type* polygons = &m_polylist[0];
+
+	// Split the top levels breadth first, until there are enough subtrees to keep all the threads busy
+	thread::task_pool pool;
+	const unsigned int num_subtrees = pool.num_threads()>1 ? pool.num_threads()*subtrees_per_thread : 1;
+	split_buffers buffers;
+	std::vector<oct_range> subtrees;
+	std::vector<oct_range> frontier(1);
+	frontier[0].m_node = 0;
+	i_mesh.bounding_box(&frontier[0].m_box);
+	frontier[0].m_begin = 0;
+	frontier[0].m_end = num_faces;
+	frontier[0].m_depth = 0;
+	while (!frontier.empty())
+	{
+		std::vector<oct_range> next;
+		for (unsigned int i=0;i<static_cast<unsigned int>(frontier.size());i++)
+		{
+			const oct_range& range = frontier[i];
+			const unsigned int num_open = static_cast<unsigned int>(subtrees.size()+next.size()+frontier.size()-i);
+			if (range.m_end-range.m_begin<parallel_min_polygons || num_open>=num_subtrees)
+			{
+				subtrees.push_back(range);
+				continue;
+			}
+
+			unsigned int bounds[9];
+			if (!split(i_mesh,i_settings,polygons,range,&buffers,bounds))
+			{
+				m_nodes[range.m_node].set_polygons(range.m_box,range.m_begin,range.m_end-range.m_begin);
+				continue;
+			}
 
-	aabb mainbox;
-	i_mesh.bounding_box(&mainbox);
+			const child_index children = static_cast<child_index>(m_nodes.size());
+			m_nodes.resize(m_nodes.size()+8);
+			m_nodes[range.m_node].set_polygons(range.m_box,range.m_begin,bounds[0]-range.m_begin);
+			m_nodes[range.m_node].set_children(children);
 
-	root().build(this,i_mesh,mainbox,all_polygons,0,i_settings);
+			aabb boxes[8];
+			child_boxes(range.m_box,boxes);
+			for (unsigned int j=0;j<8;j++)
+			{
+				oct_range child;
+				child.m_node = children+j;
+				child.m_box = boxes[j];
+				child.m_begin = bounds[j];
+				child.m_end = bounds[j+1];
+				child.m_depth = range.m_depth+1;
+				next.push_back(child);
+			}
+		}
+		frontier.swap(next);
+	}
+
+	// Subtrees work on separate parts of the polygon list, so they can be built at the same time
+	subtree_builder builder(i_mesh,i_settings,polygons,subtrees,pool.num_threads());
+	pool.run(static_cast<unsigned int>(subtrees.size()),builder);
+
+	// Move them into the tree. Each subtree root replaces its top level node, the rest is appended with shifted children
+	std::size_t total = m_nodes.size();
+	for (unsigned int i=0;i<static_cast<unsigned int>(subtrees.size());i++)
+		total += builder.subtree(i).size()-1;
+	m_nodes.reserve(total);
 
-	assert(tree_contains(all_polygons));
+	for (unsigned int i=0;i<static_cast<unsigned int>(subtrees.size());i++)
+	{
+		const node_pool& subtree = builder.subtree(i);
+		// Local child index c (never 0, which is the subtree root) ends up at shift+c
+		const child_index shift = static_cast<child_index>(m_nodes.size())-1;
+		for (unsigned int j=0;j<static_cast<unsigned int>(subtree.size());j++)
+		{
+			octnode node = subtree[j];
+			if (node.has_children())
+				node.set_children(node.child(0)+shift);
+			if (j==0)
+				m_nodes[subtrees[i].m_node] = node;
+			else
+				m_nodes.push_back(node);
+		}
+	}
+
+	assert(tree_contains(m_polylist));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -121,8 +407,14 @@ bool sdf::detail::octree::tree_contains(const octnode::polygon_array& i_polygons
 		}
 	}
 
-	for (node_pool::size_type i=0;i<m_nodes.size();i++)
+	for (size_type i=0;i<i_polygons.size();i++)
 		if (!included[i])
 			return false;
 	return true;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::size_t sdf::detail::octree::memory_usage() const
+{
+	return dynamic_memory(m_nodes)+dynamic_memory(m_polylist);
+}
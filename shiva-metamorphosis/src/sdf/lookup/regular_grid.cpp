@@ -1,11 +1,111 @@
 #include <sdf/lookup/regular_grid.hpp>
 #include <sdf/distance/distance_to_aabb.hpp>
 #include <sdf/core/tools.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <sdf/core/triangle_aabb_overlap.hpp>
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
 #include <math.h>
 
-//#define SDF_TIGHTERBOXES
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The cells are grown by this fraction for the triangle tests, so rounding never drops a triangle touching a side
+	//----------------------------------------------------------------------------------------------------------------------
+	const float cell_margin = 1e-3f;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of chunks of faces per thread when binning, so the task pool can balance uneven faces
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int chunks_per_thread = 4;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The cells of a chunk of faces, face after face (first pass of the binning)
+	//----------------------------------------------------------------------------------------------------------------------
+	struct face_chunk
+	{
+		unsigned int m_begin;
+		unsigned int m_end;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The cells of face m_begin+i are m_cells[m_first[i]] to m_cells[m_first[i+1]-1]
+		//----------------------------------------------------------------------------------------------------------------------
+		std::vector<unsigned int> m_first;
+		std::vector<unsigned int> m_cells;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The task given to the task pool - finds the cells of a chunk of faces
+	//----------------------------------------------------------------------------------------------------------------------
+	class cell_finder
+	{
+	public :
+		cell_finder(const sdf::detail::regular_grid& i_grid, const sdf::mesh& i_mesh, std::vector<face_chunk>* io_chunks)
+			: m_grid(i_grid), m_mesh(i_mesh), m_chunks(*io_chunks) {}
+
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			face_chunk& chunk = m_chunks[i_chunk];
+			chunk.m_first.reserve(chunk.m_end-chunk.m_begin+1);
+			for (unsigned int i=chunk.m_begin;i<chunk.m_end;i++)
+			{
+				chunk.m_first.push_back(static_cast<unsigned int>(chunk.m_cells.size()));
+				m_grid.face_cells(m_mesh,i,&chunk.m_cells);
+			}
+			chunk.m_first.push_back(static_cast<unsigned int>(chunk.m_cells.size()));
+		}
+	private :
+		const sdf::detail::regular_grid& m_grid;
+		const sdf::mesh& m_mesh;
+		std::vector<face_chunk>& m_chunks;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The task given to the task pool - counts (first pass) or scatters (second pass) the faces of a range of cells
+	///			Every task reads all the chunks but only writes its own cells, and the faces stay in order within a cell
+	//----------------------------------------------------------------------------------------------------------------------
+	class cell_scatter
+	{
+	public :
+		cell_scatter(
+			const std::vector<face_chunk>& i_chunks,
+			unsigned int i_num_cells,
+			unsigned int i_num_tasks,
+			std::vector<unsigned int>* io_cursors,
+			sdf::index_type* o_polygons)
+			: m_chunks(i_chunks), m_num_cells(i_num_cells), m_num_tasks(i_num_tasks), m_cursors(*io_cursors), m_polygons(o_polygons) {}
+
+		void operator()(unsigned int i_task, unsigned int /*i_thread*/)
+		{
+			const unsigned int first_cell = static_cast<unsigned int>((unsigned long long)m_num_cells*i_task/m_num_tasks);
+			const unsigned int end_cell = static_cast<unsigned int>((unsigned long long)m_num_cells*(i_task+1)/m_num_tasks);
+			for (std::size_t c=0;c<m_chunks.size();c++)
+			{
+				const face_chunk& chunk = m_chunks[c];
+				for (unsigned int i=chunk.m_begin;i<chunk.m_end;i++)
+				{
+					const unsigned int local = i-chunk.m_begin;
+					for (unsigned int j=chunk.m_first[local];j<chunk.m_first[local+1];j++)
+					{
+						const unsigned int cell = chunk.m_cells[j];
+						if (cell<first_cell || cell>=end_cell)
+							continue;
+						// Without a polygon list this is the counting pass
+						if (m_polygons)
+							m_polygons[m_cursors[cell]++] = i;
+						else
+							m_cursors[cell]++;
+					}
+				}
+			}
+		}
+	private :
+		const std::vector<face_chunk>& m_chunks;
+		const unsigned int m_num_cells;
+		const unsigned int m_num_tasks;
+		std::vector<unsigned int>& m_cursors;
+		sdf::index_type* m_polygons;
+	};
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::detail::regular_grid::build(const mesh& i_mesh, const cell_weights& i_weights)
@@ -44,60 +144,90 @@ void sdf::detail::regular_grid::build(const mesh& i_mesh, const cell_weights& i_
 	m_dim[0]=cellx;
 	m_dim[1]=celly;
 	m_dim[2]=cellz;
+	const unsigned int num_cells = cellx*celly*cellz;
+
+	// Second round: bucket those primitives! First the cells of every face, in parallel
+	thread::task_pool pool;
+	const unsigned int num_faces = i_mesh.num_faces();
+	const unsigned int num_chunks = std::min(pool.num_threads()*chunks_per_thread,num_faces);
+	std::vector<face_chunk> chunks(num_chunks);
+	for (unsigned int i=0;i<num_chunks;i++)
+	{
+		chunks[i].m_begin = static_cast<unsigned int>((unsigned long long)num_faces*i/num_chunks);
+		chunks[i].m_end = static_cast<unsigned int>((unsigned long long)num_faces*(i+1)/num_chunks);
+	}
+	cell_finder finder(*this,i_mesh,&chunks);
+	pool.run(num_chunks,finder);
 
-	cell_grid grid;
-	grid.resize(cellx*celly*cellz);
-	unsigned int polylistsize(0);
+	// Then count the faces of each cell, give each cell its place in the polygon list, and scatter the faces there
+	std::vector<unsigned int> cursors(num_cells,0);
+	cell_scatter counter(chunks,num_cells,pool.num_threads(),&cursors,0);
+	pool.run(pool.num_threads(),counter);
 
-	// Second round: bucket those primitives!
-	for (unsigned int i=0;i<i_mesh.num_faces();i++)
+	m_grid.resize(num_cells);
+	unsigned int polylistsize(0);
+	for (unsigned int i=0;i<num_cells;i++)
 	{
-		const unsigned int base = i*3;
-		aabb tribox(
-			i_mesh.vertex(base+0),
-			i_mesh.vertex(base+1),
-			i_mesh.vertex(base+2));
-
-		vector3d primextent;
-		tribox.extent(&primextent);
-		
-		index_3d minindex,maxindex;
-		const bool minisvalid = get_cell_id(tribox.minimum(),&minindex);
-		const bool maxisvalid = get_cell_id(tribox.maximum(),&maxindex);
-		assert(minisvalid);
-		assert(maxisvalid);
-		unsigned int num_buckets(0);
-		for (int ix=minindex.x();ix<=maxindex.x();ix++)
-			for (int iy=minindex.y();iy<=maxindex.y();iy++)
-				for (int iz=minindex.z();iz<=maxindex.z();iz++)
-				{
-					index_3d current(ix,iy,iz);
-#ifdef SDF_TIGHTERBOXES
-					aabb cellbox;
-					cell_aabb(current,&cellbox);
-					if (cellbox.intersects(i_mesh.vertex(base+0),i_mesh.vertex(base+1),i_mesh.vertex(base+2)))
-#endif
-					{
-						grid[get_absolute_id(current)].add(i);
-						++num_buckets;
-					}
-				}
-		assert(num_buckets!=0);
-		polylistsize+=num_buckets;
+		m_grid[i].set(polylistsize,cursors[i]);
+		const unsigned int count = cursors[i];
+		cursors[i] = polylistsize;
+		polylistsize += count;
 	}
 
-	m_polylist.reserve(polylistsize);
-	m_grid.resize(cellx*celly*cellz);
-	for (unsigned int i=0;i<(unsigned int)m_grid.size();i++)
+	m_polylist.resize(polylistsize);
+	if (polylistsize>0)
 	{
-		m_grid[i].set((unsigned int)m_polylist.size(),grid[i].size());
-		m_polylist.insert(m_polylist.end(),grid[i].array().begin(),grid[i].array().end());
+		cell_scatter scatter(chunks,num_cells,pool.num_threads(),&cursors,&m_polylist[0]);
+		pool.run(pool.num_threads(),scatter);
 	}
 }
 
-#ifdef SDF_TIGHTERBOXES
-#undef SDF_TIGHTERBOXES
-#endif // SDF_TIGHTERBOXES
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::regular_grid::face_cells(const mesh& i_mesh, unsigned int i_face, std::vector<unsigned int>* o_cells) const
+{
+	const unsigned int base = i_face*3;
+	const point3d& first = i_mesh.vertex(base+0);
+	const point3d& second = i_mesh.vertex(base+1);
+	const point3d& third = i_mesh.vertex(base+2);
+	const aabb tribox(first,second,third);
+
+	index_3d minindex,maxindex;
+	const bool minisvalid = get_cell_id(tribox.minimum(),&minindex);
+	const bool maxisvalid = get_cell_id(tribox.maximum(),&maxindex);
+	assert(minisvalid);
+	assert(maxisvalid);
+
+	// The cells along x are tested 4 at a time, the last group repeats its last cell
+	const vector3d halfextent = m_cellsize*(0.5f+cell_margin);
+	const std::size_t num_before = o_cells->size();
+	float centres[3][4];
+	for (int iz=minindex.z();iz<=maxindex.z();iz++)
+	{
+		for (int iy=minindex.y();iy<=maxindex.y();iy++)
+		{
+			for (unsigned int lane=0;lane<4;lane++)
+			{
+				centres[1][lane] = m_box.minimum()[1]+m_cellsize[1]*static_cast<float>(iy)+m_cellsize[1]*0.5f;
+				centres[2][lane] = m_box.minimum()[2]+m_cellsize[2]*static_cast<float>(iz)+m_cellsize[2]*0.5f;
+			}
+			for (int ix=minindex.x();ix<=maxindex.x();ix+=4)
+			{
+				for (int lane=0;lane<4;lane++)
+				{
+					const int x = min(ix+lane,maxindex.x());
+					centres[0][lane] = m_box.minimum()[0]+m_cellsize[0]*static_cast<float>(x)+m_cellsize[0]*0.5f;
+				}
+				const unsigned int overlaps = triangle_box_overlap(centres,halfextent,first,second,third);
+				for (int lane=0;lane<4 && ix+lane<=maxindex.x();lane++)
+				{
+					if (overlaps&(1<<lane))
+						o_cells->push_back(get_absolute_id(index_3d(ix+lane,iy,iz)));
+				}
+			}
+		}
+	}
+	assert(o_cells->size()!=num_before);
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::detail::regular_grid::operator()(const mesh& i_mesh, const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const
@@ -355,3 +485,9 @@ bool sdf::detail::regular_grid::explore_node(const mesh& i_mesh, const distance_
 
 	return found;
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+std::size_t sdf::detail::regular_grid::memory_usage() const
+{
+	return dynamic_memory(m_grid)+dynamic_memory(m_polylist);
+}
@@ -0,0 +1,409 @@
+#include <sdf/lookup/wide_bvh.hpp>
+#include <sdf/core/static_stack.hpp>
+#include <sdf/core/tools.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+
+#ifdef SDF_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Something left to visit: a node, or a leaf (offset and count in the polygon list), and its box distance
+	//----------------------------------------------------------------------------------------------------------------------
+	struct wide_entry
+	{
+		sdf::index_type m_child;
+		sdf::index_type m_count;
+		float m_sqdist;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Half the surface area of a box
+	//----------------------------------------------------------------------------------------------------------------------
+	float half_area(const sdf::aabb& i_box)
+	{
+		sdf::vector3d extent;
+		i_box.extent(&extent);
+		return extent[0]*extent[1]+extent[1]*extent[2]+extent[2]*extent[0];
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Cost of visiting a node, relative to the cost of a block of triangle distance tests (as the binary build)
+	//----------------------------------------------------------------------------------------------------------------------
+	const float sah_traversal_cost = 1.f;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of nodes per task of a refit
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int refit_chunk_size = 256;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Get the box of a child of a node, inverted for an empty slot
+	//----------------------------------------------------------------------------------------------------------------------
+	sdf::aabb child_box(const sdf::detail::wide_bvh::node& i_node, unsigned int i_child)
+	{
+		sdf::aabb box;
+		if (i_node.m_count[i_child]!=0)
+		{
+			box.set(
+				sdf::point3d(i_node.m_min[0][i_child],i_node.m_min[1][i_child],i_node.m_min[2][i_child]),
+				sdf::point3d(i_node.m_max[0][i_child],i_node.m_max[1][i_child],i_node.m_max[2][i_child]));
+		}
+		return box;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Set the box of a child of a node
+	//----------------------------------------------------------------------------------------------------------------------
+	void set_child_box(const sdf::aabb& i_box, unsigned int i_child, sdf::detail::wide_bvh::node* o_node)
+	{
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			o_node->m_min[axis][i_child] = i_box.minimum()[axis];
+			o_node->m_max[axis][i_child] = i_box.maximum()[axis];
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The task given to the task pool - refits the leaf children of a chunk of nodes to their polygons
+	//----------------------------------------------------------------------------------------------------------------------
+	class leaf_refitter
+	{
+	public :
+		leaf_refitter(
+			const sdf::mesh& i_mesh,
+			const sdf::detail::wide_bvh::polygon_array& i_polygons,
+			sdf::detail::wide_bvh::node_array* io_nodes)
+			: m_mesh(i_mesh), m_polygons(i_polygons), m_nodes(*io_nodes) {}
+
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			const std::size_t first = (std::size_t)i_chunk*refit_chunk_size;
+			const std::size_t end = std::min(first+refit_chunk_size,m_nodes.size());
+			for (std::size_t n=first;n<end;n++)
+			{
+				sdf::detail::wide_bvh::node& current = m_nodes[n];
+				for (unsigned int i=0;i<sdf::detail::wide_bvh::width;i++)
+				{
+					if (current.m_count[i]==sdf::detail::wide_bvh::inner_child || current.m_count[i]==0)
+						continue;
+					sdf::aabb box;
+					for (sdf::index_type j=current.m_child[i];j<current.m_child[i]+current.m_count[i];j++)
+					{
+						const unsigned int base = m_polygons[j]*3;
+						box.include(m_mesh.vertex(base+0));
+						box.include(m_mesh.vertex(base+1));
+						box.include(m_mesh.vertex(base+2));
+					}
+					set_child_box(box,i,&current);
+				}
+			}
+		}
+	private :
+		const sdf::mesh& m_mesh;
+		const sdf::detail::wide_bvh::polygon_array& m_polygons;
+		sdf::detail::wide_bvh::node_array& m_nodes;
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::wide_bvh::build(const mesh& i_mesh, const settings& i_settings)
+{
+	bvh tree;
+	tree.build(i_mesh,i_settings);
+	build(tree);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::wide_bvh::build(const bvh& i_tree)
+{
+	assert(!i_tree.nodes().empty());
+	m_polylist = i_tree.array();
+	m_triangles = i_tree.triangles();
+	m_nodes.clear();
+	m_nodes.reserve(i_tree.nodes().size()/2+1);
+
+	if (i_tree.root().has_children())
+	{
+		collapse(i_tree,0);
+	}
+	else
+	{
+		// A single leaf - give it a node of its own so the traversal does not need a special case
+		m_nodes.resize(1);
+		node& root = m_nodes[0];
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			for (unsigned int i=0;i<width;i++)
+			{
+				root.m_min[axis][i] = std::numeric_limits<float>::max();
+				root.m_max[axis][i] = -std::numeric_limits<float>::max();
+			}
+			root.m_min[axis][0] = i_tree.root().box().minimum()[axis];
+			root.m_max[axis][0] = i_tree.root().box().maximum()[axis];
+		}
+		for (unsigned int i=0;i<width;i++)
+		{
+			root.m_child[i] = 0;
+			root.m_count[i] = 0;
+		}
+		root.m_child[0] = i_tree.root().offset();
+		root.m_count[0] = i_tree.root().num_polygons();
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::index_type sdf::detail::wide_bvh::collapse(const bvh& i_tree, bvh_branch::child_index i_branch)
+{
+	assert(i_tree.branch(i_branch).has_children());
+
+	// Open the biggest inner child until there are 4 children
+	bvh_branch::child_index children[width];
+	unsigned int num_children(2);
+	children[0] = i_tree.branch(i_branch).child(0);
+	children[1] = i_tree.branch(i_branch).child(1);
+	while (num_children<width)
+	{
+		unsigned int biggest(width);
+		float biggest_area(-1.f);
+		for (unsigned int i=0;i<num_children;i++)
+		{
+			const bvh_branch& child = i_tree.branch(children[i]);
+			if (child.has_children() && half_area(child.box())>biggest_area)
+			{
+				biggest = i;
+				biggest_area = half_area(child.box());
+			}
+		}
+		if (biggest==width)
+			break;
+		const bvh_branch& opened = i_tree.branch(children[biggest]);
+		children[biggest] = opened.child(0);
+		children[num_children++] = opened.child(1);
+	}
+
+	const index_type index = static_cast<index_type>(m_nodes.size());
+	m_nodes.push_back(node());
+	for (unsigned int i=0;i<width;i++)
+	{
+		// Empty slots get an inverted box, so their distance is infinite
+		index_type child(0);
+		index_type count(0);
+		aabb box;
+		if (i<num_children)
+		{
+			const bvh_branch& branch = i_tree.branch(children[i]);
+			if (branch.has_children())
+			{
+				// m_nodes may grow, so the node is only accessed by index after this
+				child = collapse(i_tree,children[i]);
+				count = inner_child;
+				box = branch.box();
+			}
+			else if (branch.num_polygons()>0)
+			{
+				child = branch.offset();
+				count = branch.num_polygons();
+				box = branch.box();
+			}
+		}
+		node& current = m_nodes[index];
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			current.m_min[axis][i] = box.minimum()[axis];
+			current.m_max[axis][i] = box.maximum()[axis];
+		}
+		current.m_child[i] = child;
+		current.m_count[i] = count;
+	}
+	return index;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::wide_bvh::refit(const mesh& i_mesh)
+{
+	assert(!m_nodes.empty());
+	thread::task_pool pool;
+	leaf_refitter refitter(i_mesh,m_polylist,&m_nodes);
+	pool.run(static_cast<unsigned int>((m_nodes.size()+refit_chunk_size-1)/refit_chunk_size),refitter);
+
+	// Nodes are collapsed depth first, a child node is always after its parent
+	for (std::size_t n=m_nodes.size();n-->0;)
+	{
+		node& current = m_nodes[n];
+		for (unsigned int i=0;i<width;i++)
+		{
+			if (current.m_count[i]!=inner_child)
+				continue;
+			assert(current.m_child[i]>n);
+			const node& child = m_nodes[current.m_child[i]];
+			aabb box;
+			for (unsigned int j=0;j<width;j++)
+			{
+				if (child.m_count[j]==0)
+					continue;
+				const aabb lane = child_box(child,j);
+				box.include(lane.minimum());
+				box.include(lane.maximum());
+			}
+			set_child_box(box,i,&current);
+		}
+	}
+	m_triangles.refit(i_mesh,m_polylist);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float sdf::detail::wide_bvh::sah_cost() const
+{
+	assert(!m_nodes.empty());
+	double cost = 0.0;
+	aabb root;
+	for (std::size_t n=0;n<m_nodes.size();n++)
+	{
+		const node& current = m_nodes[n];
+		for (unsigned int i=0;i<width;i++)
+		{
+			if (current.m_count[i]==0)
+				continue;
+			const aabb box = child_box(current,i);
+			const float area = half_area(box);
+			if (current.m_count[i]==inner_child)
+				cost += sah_traversal_cost*area;
+			else
+				cost += (float)((current.m_count[i]+triangle_store::width-1)/triangle_store::width)*area;
+			if (n==0)
+			{
+				root.include(box.minimum());
+				root.include(box.maximum());
+			}
+		}
+	}
+	// The root node itself is always visited
+	const float root_area = root.minimum()[0]<=root.maximum()[0] ? half_area(root) : 0.f;
+	return root_area>0.f ? static_cast<float>(sah_traversal_cost+cost/root_area) : 0.f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::wide_bvh::child_distances(const node& i_node, const point3d& i_position, float o_distances[width], unsigned int o_order[width])
+{
+#ifdef SDF_USE_SSE
+	const __m128 zero = _mm_setzero_ps();
+	__m128 sqdist = zero;
+	for (unsigned int axis=0;axis<3;axis++)
+	{
+		const __m128 position = _mm_set1_ps(i_position[axis]);
+		const __m128 below = _mm_sub_ps(_mm_loadu_ps(i_node.m_min[axis]),position);
+		const __m128 above = _mm_sub_ps(position,_mm_loadu_ps(i_node.m_max[axis]));
+		const __m128 outside = _mm_max_ps(_mm_max_ps(below,above),zero);
+		sqdist = _mm_add_ps(sqdist,_mm_mul_ps(outside,outside));
+	}
+	_mm_storeu_ps(o_distances,sqdist);
+
+	// Distances are positive, so their bits sort like integers: hide the child slot in the 2 lowest bits
+	// and sort the 4 keys with a min/max network. Empty slots are infinite, clamp them so they do not turn into NaNs
+	sqdist = _mm_min_ps(sqdist,_mm_set1_ps(std::numeric_limits<float>::max()));
+	const __m128i slots = _mm_set_epi32(3,2,1,0);
+	const __m128i mask = _mm_set1_epi32(~3);
+	__m128 keys = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(_mm_castps_si128(sqdist),mask),slots));
+
+	// (0,1) (2,3) -> [min01 min23 max01 max23]
+	__m128 swapped = _mm_shuffle_ps(keys,keys,_MM_SHUFFLE(2,3,0,1));
+	__m128 low = _mm_min_ps(keys,swapped);
+	__m128 high = _mm_max_ps(keys,swapped);
+	keys = _mm_shuffle_ps(low,high,_MM_SHUFFLE(2,0,2,0));
+	// (0,1) (2,3) again -> [min, min(max01,max23), max(min01,min23), max]
+	swapped = _mm_shuffle_ps(keys,keys,_MM_SHUFFLE(2,3,0,1));
+	low = _mm_min_ps(keys,swapped);
+	high = _mm_max_ps(keys,swapped);
+	keys = _mm_shuffle_ps(low,high,_MM_SHUFFLE(2,0,2,0));
+	// (1,2) to finish
+	swapped = _mm_shuffle_ps(keys,keys,_MM_SHUFFLE(3,1,2,0));
+	low = _mm_min_ps(keys,swapped);
+	high = _mm_max_ps(keys,swapped);
+	keys = _mm_shuffle_ps(low,high,_MM_SHUFFLE(3,2,1,0));
+
+	unsigned int sorted[width];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sorted),_mm_castps_si128(keys));
+	for (unsigned int i=0;i<width;i++)
+		o_order[i] = sorted[i]&3;
+#else
+	for (unsigned int i=0;i<width;i++)
+	{
+		float sqdist(0.f);
+		for (unsigned int axis=0;axis<3;axis++)
+		{
+			const float outside = max(max(i_node.m_min[axis][i]-i_position[axis],i_position[axis]-i_node.m_max[axis][i]),0.f);
+			sqdist+=outside*outside;
+		}
+		o_distances[i] = sqdist;
+
+		// Insertion sort, there are only 4
+		unsigned int j=i;
+		for (;j>0 && o_distances[o_order[j-1]]>sqdist;j--)
+			o_order[j] = o_order[j-1];
+		o_order[j] = i;
+	}
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::detail::wide_bvh::operator()(
+				const mesh& /*i_mesh*/,
+				const point3d& i_position,
+				distance_record* o_closest_record,
+				unsigned int* o_face_id) const
+{
+	// Each level pushes at most 4 entries and pops one
+	typedef static_stack<wide_entry,4*bvh_branch::maximum_depth> entry_stack;
+	entry_stack tovisit;
+
+	wide_entry root;
+	root.m_child = 0;
+	root.m_count = inner_child;
+	root.m_sqdist = 0.f;
+	tovisit.push(root);
+
+	while (!tovisit.empty())
+	{
+		const wide_entry current = tovisit.top();
+		tovisit.pop();
+		if (!(current.m_sqdist<o_closest_record->distance_square()))
+			continue;
+
+		if (current.m_count==inner_child)
+		{
+			const node& currentnode = m_nodes[current.m_child];
+			float sqdists[width];
+			unsigned int order[width];
+			child_distances(currentnode,i_position,sqdists,order);
+
+			// Push the furthest first so the nearest is on top
+			for (int i=width-1;i>=0;i--)
+			{
+				const unsigned int slot = order[i];
+				if (sqdists[slot]<o_closest_record->distance_square() && currentnode.m_count[slot]!=0)
+				{
+					wide_entry child;
+					child.m_child = currentnode.m_child[slot];
+					child.m_count = currentnode.m_count[slot];
+					child.m_sqdist = sqdists[slot];
+					tovisit.push(child);
+				}
+			}
+		}
+		else
+		{
+			m_triangles(i_position,current.m_child,current.m_child+current.m_count,o_closest_record,o_face_id);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::size_t sdf::detail::wide_bvh::memory_usage() const
+{
+	return dynamic_memory(m_polylist)+dynamic_memory(m_nodes)+m_triangles.memory_usage();
+}
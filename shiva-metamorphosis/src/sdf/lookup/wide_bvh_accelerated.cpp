@@ -0,0 +1,52 @@
+#include <sdf/lookup/wide_bvh_accelerated.hpp>
+#include <assert.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::wide_bvh_accelerated::wide_bvh_accelerated() : m_mesh(0), m_settings(26,2,16,3,detail::settings::binned_sah), m_build_cost(0.f) {}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::wide_bvh_accelerated::initialize(const mesh& i_mesh)
+{
+	initialize(i_mesh,detail::settings(26,2,16,3,detail::settings::binned_sah));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::wide_bvh_accelerated::initialize(const mesh& i_mesh, const detail::settings& i_settings)
+{
+	assert(i_settings.max_depth()<detail::bvh_branch::maximum_depth);
+	m_mesh = &i_mesh;
+	m_settings = i_settings;
+	m_tree.build(i_mesh,i_settings);
+	m_build_cost = m_tree.sah_cost();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::wide_bvh_accelerated::refit(float i_rebuild_ratio)
+{
+	assert(m_mesh);
+	m_tree.refit(*m_mesh);
+	if (i_rebuild_ratio<=0.f || m_tree.sah_cost()<=i_rebuild_ratio*m_build_cost)
+		return false;
+
+	// The .bvh file next to the mesh describes the old shape, build without it
+	detail::bvh tree;
+	tree.force_build(*m_mesh,m_settings);
+	m_tree.build(tree);
+	m_build_cost = m_tree.sah_cost();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::wide_bvh_accelerated::operator()(const point3d& i_position, distance_record* o_closest_record, unsigned int* o_face_id) const
+{
+	assert(m_mesh);
+	m_tree(*m_mesh,i_position,o_closest_record,o_face_id);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::wide_bvh_accelerated::operator()(const point3d i_positions[], distance_record o_closest_record[], unsigned int o_face_id[]) const
+{
+	assert(m_mesh);
+	for(int i=0;i<8;i++)
+		m_tree(*m_mesh,i_positions[i],&o_closest_record[i],&o_face_id[i]);
+}
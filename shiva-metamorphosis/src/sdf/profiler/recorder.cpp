@@ -0,0 +1,320 @@
+#include <sdf/profiler/recorder.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Quote a string for JSON
+	//----------------------------------------------------------------------------------------------------------------------
+	std::string json_string(const std::string& i_value)
+	{
+		std::string quoted("\"");
+		for (std::string::size_type i=0;i<i_value.size();i++)
+		{
+			const char c = i_value[i];
+			if (c=='"' || c=='\\')
+				quoted += '\\';
+			if (static_cast<unsigned char>(c)<0x20)
+				quoted += ' ';
+			else
+				quoted += c;
+		}
+		return quoted+"\"";
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::profiler::recorder::thread_buffer::~thread_buffer()
+{
+	chunk* current = m_head;
+	while (current)
+	{
+		chunk* next = current->m_next.load(std::memory_order_relaxed);
+		delete current;
+		current = next;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::profiler::recorder::buffer_owner::~buffer_owner()
+{
+	if (m_buffer)
+		m_buffer->m_owned.store(false,std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::profiler::recorder::recorder() :
+	m_start(std::chrono::steady_clock::now()),
+	m_buffers(0),
+	m_num_buffers(0),
+	m_enabled(true),
+	m_echo(false)
+{
+	path_entry root;
+	root.m_name = 0;
+	root.m_depth = 0;
+	m_paths.push_back(root);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::profiler::recorder::~recorder()
+{
+	thread_buffer* current = m_buffers.load(std::memory_order_acquire);
+	while (current)
+	{
+		thread_buffer* next = current->m_next;
+		delete current;
+		current = next;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::profiler::recorder& sdf::profiler::recorder::instance()
+{
+	static recorder global;
+	return global;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+double sdf::profiler::recorder::now() const
+{
+	return std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-m_start).count();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+sdf::profiler::recorder::thread_buffer& sdf::profiler::recorder::local_buffer()
+{
+	static thread_local buffer_owner owner;
+	if (owner.m_buffer)
+		return *owner.m_buffer;
+
+	// Take the buffer of a thread that ended
+	for (thread_buffer* current=m_buffers.load(std::memory_order_acquire);current;current=current->m_next)
+	{
+		bool owned = current->m_owned.load(std::memory_order_relaxed);
+		if (!owned && current->m_owned.compare_exchange_strong(owned,true,std::memory_order_acquire))
+		{
+			current->m_open.clear();
+			owner.m_buffer = current;
+			return *current;
+		}
+	}
+
+	thread_buffer* created = new thread_buffer(m_num_buffers.fetch_add(1,std::memory_order_relaxed));
+	created->m_next = m_buffers.load(std::memory_order_relaxed);
+	while (!m_buffers.compare_exchange_weak(created->m_next,created,std::memory_order_release,std::memory_order_relaxed)) {}
+	owner.m_buffer = created;
+	return *created;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned int sdf::profiler::recorder::intern(unsigned int i_parent, const std::string& i_name)
+{
+	std::lock_guard<std::mutex> lock(m_paths_mutex);
+	const std::pair<unsigned int,std::string> key(i_parent,i_name);
+	std::map<std::pair<unsigned int,std::string>,unsigned int>::const_iterator found = m_path_ids.find(key);
+	if (found!=m_path_ids.end())
+		return found->second;
+
+	const path_entry& parent = m_paths[i_parent];
+	path_entry entry;
+	entry.m_path = i_parent==0 ? i_name : parent.m_path+'/'+i_name;
+	entry.m_name = i_parent==0 ? 0 : static_cast<unsigned int>(parent.m_path.size()+1);
+	entry.m_depth = i_parent==0 ? 0 : parent.m_depth+1;
+	m_paths.push_back(entry);
+
+	const unsigned int id = static_cast<unsigned int>(m_paths.size()-1);
+	m_path_ids.insert(std::make_pair(key,id));
+	return id;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::set_thread_name(const std::string& i_name)
+{
+	local_buffer().m_name = i_name;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::push(const std::string& i_name)
+{
+	thread_buffer& buffer = local_buffer();
+	const unsigned int parent = buffer.m_open.empty() ? 0 : buffer.m_open.back();
+	std::map<std::string,unsigned int>& children = buffer.m_children[parent];
+	std::map<std::string,unsigned int>::const_iterator found = children.find(i_name);
+	if (found!=children.end())
+		buffer.m_open.push_back(found->second);
+	else
+		buffer.m_open.push_back(children[i_name] = intern(parent,i_name));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::pop(double i_begin, double i_end)
+{
+	thread_buffer& buffer = local_buffer();
+	if (buffer.m_open.empty())
+		return;
+	const unsigned int path = buffer.m_open.back();
+	buffer.m_open.pop_back();
+
+	if (enabled())
+	{
+		chunk* tail = buffer.m_tail;
+		unsigned int count = tail->m_count.load(std::memory_order_relaxed);
+		if (count==chunk_size)
+		{
+			chunk* next = new chunk;
+			tail->m_next.store(next,std::memory_order_release);
+			buffer.m_tail = tail = next;
+			count = 0;
+		}
+
+		record& r = tail->m_events[count];
+		r.m_path = path;
+		r.m_begin = i_begin;
+		r.m_duration = i_end-i_begin;
+		// Publish it
+		tail->m_count.store(count+1,std::memory_order_release);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::events(std::vector<event>* o_events, std::vector<unsigned int>* o_threads) const
+{
+	o_events->clear();
+	o_threads->clear();
+	for (const thread_buffer* buffer=m_buffers.load(std::memory_order_acquire);buffer;buffer=buffer->m_next)
+	{
+		for (const chunk* current=buffer->m_head;current;current=current->m_next.load(std::memory_order_acquire))
+		{
+			const unsigned int count = current->m_count.load(std::memory_order_acquire);
+			// The paths of the published events are interned already
+			std::lock_guard<std::mutex> lock(m_paths_mutex);
+			for (unsigned int i=0;i<count;i++)
+			{
+				const record& r = current->m_events[i];
+				const path_entry& path = m_paths[r.m_path];
+				event e;
+				e.m_path = path.m_path;
+				e.m_name = path.m_name;
+				e.m_depth = path.m_depth;
+				e.m_begin = r.m_begin;
+				e.m_duration = r.m_duration;
+				o_events->push_back(e);
+			}
+			o_threads->insert(o_threads->end(),count,buffer->m_id);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::aggregate(std::vector<statistics>* o_statistics) const
+{
+	std::vector<event> all;
+	std::vector<unsigned int> threads;
+	events(&all,&threads);
+
+	std::map<std::string,statistics> paths;
+	for (std::size_t i=0;i<all.size();i++)
+	{
+		const event& e = all[i];
+		std::map<std::string,statistics>::iterator found = paths.find(e.m_path);
+		if (found==paths.end())
+		{
+			statistics first;
+			first.m_path = e.m_path;
+			first.m_depth = e.m_depth;
+			first.m_count = 1;
+			first.m_total = first.m_min = first.m_max = e.m_duration;
+			paths.insert(std::make_pair(e.m_path,first));
+			continue;
+		}
+		statistics& s = found->second;
+		s.m_count++;
+		s.m_total += e.m_duration;
+		s.m_min = std::min(s.m_min,e.m_duration);
+		s.m_max = std::max(s.m_max,e.m_duration);
+	}
+
+	o_statistics->clear();
+	o_statistics->reserve(paths.size());
+	for (std::map<std::string,statistics>::const_iterator it=paths.begin();it!=paths.end();++it)
+		o_statistics->push_back(it->second);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::print_summary(std::ostream& o_stream) const
+{
+	std::vector<statistics> summary;
+	aggregate(&summary);
+
+	const std::ios::fmtflags flags = o_stream.flags();
+	const std::streamsize precision = o_stream.precision();
+	o_stream<<std::left<<std::setw(48)<<"scope"<<std::right<<std::setw(10)<<"count"<<std::setw(14)<<"total ms"
+		<<std::setw(12)<<"mean ms"<<std::setw(12)<<"min ms"<<std::setw(12)<<"max ms"<<std::endl;
+	o_stream<<std::fixed<<std::setprecision(3);
+	for (std::size_t i=0;i<summary.size();i++)
+	{
+		const statistics& s = summary[i];
+		const std::string::size_type slash = s.m_path.rfind('/');
+		const std::string name = std::string(2*s.m_depth,' ')+(slash==std::string::npos ? s.m_path : s.m_path.substr(slash+1));
+		o_stream<<std::left<<std::setw(48)<<name<<std::right<<std::setw(10)<<s.m_count<<std::setw(14)<<s.m_total/1000.0
+			<<std::setw(12)<<s.m_total/s.m_count/1000.0<<std::setw(12)<<s.m_min/1000.0<<std::setw(12)<<s.m_max/1000.0<<std::endl;
+	}
+	o_stream.flags(flags);
+	o_stream.precision(precision);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool sdf::profiler::recorder::write_chrome_trace(const std::string& i_filename) const
+{
+	std::ofstream file(i_filename.c_str());
+	if (!file)
+		return false;
+
+	std::vector<event> all;
+	std::vector<unsigned int> threads;
+	events(&all,&threads);
+
+	file<<std::fixed<<std::setprecision(3);
+	file<<"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const thread_buffer* buffer=m_buffers.load(std::memory_order_acquire);buffer;buffer=buffer->m_next)
+	{
+		if (buffer->m_name.empty())
+			continue;
+		file<<(first ? "" : ",\n")<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"<<buffer->m_id
+			<<",\"args\":{\"name\":"<<json_string(buffer->m_name)<<"}}";
+		first = false;
+	}
+	for (std::size_t i=0;i<all.size();i++)
+	{
+		const event& e = all[i];
+		file<<(first ? "" : ",\n")<<"{\"name\":"<<json_string(e.m_path.substr(e.m_name))<<",\"cat\":\"sdf\",\"ph\":\"X\",\"ts\":"
+			<<e.m_begin<<",\"dur\":"<<e.m_duration<<",\"pid\":1,\"tid\":"<<threads[i]
+			<<",\"args\":{\"path\":"<<json_string(e.m_path)<<"}}";
+		first = false;
+	}
+	file<<"\n]}\n";
+	return file.good();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::recorder::clear()
+{
+	for (thread_buffer* buffer=m_buffers.load(std::memory_order_acquire);buffer;buffer=buffer->m_next)
+	{
+		chunk* current = buffer->m_head->m_next.load(std::memory_order_acquire);
+		while (current)
+		{
+			chunk* next = current->m_next.load(std::memory_order_relaxed);
+			delete current;
+			current = next;
+		}
+		buffer->m_head->m_next.store(0,std::memory_order_relaxed);
+		buffer->m_head->m_count.store(0,std::memory_order_release);
+		buffer->m_tail = buffer->m_head;
+	}
+}
@@ -3,19 +3,19 @@
 #include <cstdio>
 
 //----------------------------------------------------------------------------------------------------------------------
-sdf::profiler::scope::scope() : m_name("unnamed"), m_start()
+sdf::profiler::scope::scope() : m_name("unnamed"), m_start(0)
 {
-	std::cout<<"+profiling "<<m_name<<": start"<<std::endl;
+	start();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-sdf::profiler::scope::scope(const std::string& i_name)  : m_name(i_name), m_start()
+sdf::profiler::scope::scope(const std::string& i_name)  : m_name(i_name), m_start(0)
 {
-	std::cout<<"+profiling "<<m_name<<": start"<<std::endl;
+	start();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-sdf::profiler::scope::scope(const char* i_name, ...)  : m_name(i_name), m_start()
+sdf::profiler::scope::scope(const char* i_name, ...)  : m_name(i_name), m_start(0)
 {
 	static const unsigned int MaxTempStringSize = 256;
 	char tmp[MaxTempStringSize];
@@ -24,29 +24,42 @@ sdf::profiler::scope::scope(const char* i_name, ...)  : m_name(i_name), m_start(
 #ifdef _MSC_VER
 	vsprintf_s(tmp,MaxTempStringSize,i_name,args);
 #else
-        vsprintf(tmp,i_name,args);
+	vsnprintf(tmp,MaxTempStringSize,i_name,args);
 #endif
 	m_name = tmp;
 	va_end(args);
-	std::cout<<"+profiling "<<m_name<<": start"<<std::endl;
+	start();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 sdf::profiler::scope::~scope()
 {
-	print_time();
+	recorder& profiles = recorder::instance();
+	profiles.pop(m_start,profiles.now());
+	if (profiles.echo())
+		print_time();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::profiler::scope::start()
+{
+	recorder& profiles = recorder::instance();
+	if (profiles.echo())
+		std::cout<<"+profiling "<<m_name<<": start"<<std::endl;
+	profiles.push(m_name);
+	m_start = profiles.now();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::profiler::scope::restart()
 {
-	m_start.restart();
+	m_start = recorder::instance().now();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 float sdf::profiler::scope::query() const
 {
-	const float timeinsec = static_cast<float>(m_start.elapsed());
+	const float timeinsec = static_cast<float>((recorder::instance().now()-m_start)*1e-6);
 	return timeinsec;
 }
 
@@ -58,7 +71,7 @@ void sdf::profiler::scope::print_time() const
 	{
 		const unsigned int mins = static_cast<unsigned int>(time/60.f);
 		const float restsec = (float)fmod(time,60.f);
-		
+
 		std::cout<<"-profiling "<<m_name<<": "<<mins<<"min"<<restsec<<"s"<<std::endl;
 	}
 	else
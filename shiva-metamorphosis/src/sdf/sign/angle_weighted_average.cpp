@@ -1,10 +1,340 @@
 #include <sdf/sign/angle_weighted_average.hpp>
 #include <sdf/core/binary_file.hpp>
 #include <sdf/core/tools.hpp>
-#include <map>
+#include <sdf/core/task_pool.hpp>
+#include <algorithm>
 #include <assert.h>
 #include <math.h>
 
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of faces, vertices or half edges per task of the normal passes
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int chunk_size = 4096;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of tasks for a number of elements
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned int num_chunks(unsigned int i_num_elements)
+	{
+		return (i_num_elements+chunk_size-1)/chunk_size;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief First and end element of a task
+	//----------------------------------------------------------------------------------------------------------------------
+	void chunk_range(unsigned int i_chunk, unsigned int i_num_elements, unsigned int* o_first, unsigned int* o_end)
+	{
+		*o_first = i_chunk*chunk_size;
+		*o_end = std::min(*o_first+chunk_size,i_num_elements);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class selection
+	/// @brief The elements a pass works on - all of them, or a list (the ones a refit has to update)
+	//----------------------------------------------------------------------------------------------------------------------
+	class selection
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief All the elements from 0 to i_size
+		//----------------------------------------------------------------------------------------------------------------------
+		explicit selection(unsigned int i_size) : m_list(0), m_size(i_size) {}
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief The elements of a list
+		//----------------------------------------------------------------------------------------------------------------------
+		explicit selection(const std::vector<sdf::index_type>& i_list) : m_list(&i_list), m_size((unsigned int)i_list.size()) {}
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of elements
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int size() const { return m_size; }
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Get the i-th element
+		//----------------------------------------------------------------------------------------------------------------------
+		sdf::index_type operator[](unsigned int i) const { return m_list ? (*m_list)[i] : i; }
+	private :
+		const std::vector<sdf::index_type>* m_list;
+		unsigned int m_size;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Face normal weighted by the angle of the face at one of its corners
+	/// @param[in] i_mesh The mesh
+	/// @param[in] i_face_normals The unit face normals
+	/// @param[in] i_corner The corner (offset in the index array)
+	//----------------------------------------------------------------------------------------------------------------------
+	sdf::vector3d corner_normal(const sdf::mesh& i_mesh, const sdf::normal_array& i_face_normals, sdf::index_type i_corner)
+	{
+		const sdf::index_type face = i_corner/3;
+		const sdf::index_type corner = i_corner%3;
+		const sdf::point3d& a = i_mesh.vertex_at(i_mesh.index_at(face*3+corner));
+		const sdf::point3d& b = i_mesh.vertex_at(i_mesh.index_at(face*3+(corner+1)%3));
+		const sdf::point3d& c = i_mesh.vertex_at(i_mesh.index_at(face*3+(corner+2)%3));
+		sdf::vector3d ab = b-a;
+		ab.normalize();
+		sdf::vector3d ac = c-a;
+		ac.normalize();
+		return i_face_normals[face]*acos(ac.dot(ab));
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class edge_table
+	/// @brief Half edges waiting for their opposite, an open addressing hash table (linear probing) from the vertex pair
+	///			to the half edge (offset in the index array). Taken edges leave a tombstone until the table is rebuilt.
+	///			Faces next to each other in the file share their edges, so few edges wait at the same time: the table
+	///			grows with them and stays in cache rather than being sized for the whole mesh
+	//----------------------------------------------------------------------------------------------------------------------
+	class edge_table
+	{
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Returned when there is no such edge
+		//----------------------------------------------------------------------------------------------------------------------
+		static const sdf::index_type no_edge = 0xffffffff;
+	public :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Constructor - empty table
+		//----------------------------------------------------------------------------------------------------------------------
+		edge_table() : m_num_live(0), m_num_used(0)
+		{
+			const entry empty = { 0,0,no_edge };
+			m_entries.assign(1024,empty);
+			m_mask = 1023;
+			m_shift = 64-10;
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Find and remove an edge
+		/// @param[in] i_first The first vertex index
+		/// @param[in] i_second The second vertex index
+		/// @return The half edge, no_edge if it is not there
+		//----------------------------------------------------------------------------------------------------------------------
+		sdf::index_type take(sdf::index_type i_first, sdf::index_type i_second)
+		{
+			const unsigned int position = find(i_first,i_second);
+			const sdf::index_type edge = m_entries[position].m_edge;
+			if (edge!=no_edge)
+			{
+				m_entries[position].m_edge = erased;
+				m_num_live--;
+			}
+			return edge;
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Add an edge, replacing the one with the same vertices
+		/// @param[in] i_first The first vertex index
+		/// @param[in] i_second The second vertex index
+		/// @param[in] i_edge The half edge
+		//----------------------------------------------------------------------------------------------------------------------
+		void put(sdf::index_type i_first, sdf::index_type i_second, sdf::index_type i_edge)
+		{
+			unsigned int position = find(i_first,i_second);
+			if (m_entries[position].m_edge==no_edge)
+			{
+				// New entry, keep at least half of the table empty
+				if (2*(m_num_used+1)>m_entries.size())
+				{
+					rebuild();
+					position = find(i_first,i_second);
+				}
+				m_num_live++;
+				m_num_used++;
+			}
+			entry& current = m_entries[position];
+			current.m_first = i_first;
+			current.m_second = i_second;
+			current.m_edge = i_edge;
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of edges waiting
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int size() const { return m_num_live; }
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Position of an edge, or of the empty entry where it would go
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int find(sdf::index_type i_first, sdf::index_type i_second) const
+		{
+			// Fibonacci hashing of the pair, the high bits of the product mix both indices
+			const unsigned long long key = ((unsigned long long)i_first<<32)|i_second;
+			unsigned int position = (unsigned int)((key*0x9e3779b97f4a7c15ull)>>m_shift);
+			while (m_entries[position].m_edge!=no_edge)
+			{
+				const entry& current = m_entries[position];
+				if (current.m_edge!=erased && current.m_first==i_first && current.m_second==i_second)
+					break;
+				position = (position+1)&m_mask;
+			}
+			return position;
+		}
+
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Drop the tombstones, and grow so the waiting edges fill a quarter of the table at most
+		//----------------------------------------------------------------------------------------------------------------------
+		void rebuild()
+		{
+			std::size_t capacity = m_entries.size();
+			while (capacity<4*(std::size_t)(m_num_live+1))
+			{
+				capacity*=2;
+				m_shift--;
+			}
+			std::vector<entry> entries;
+			entries.swap(m_entries);
+			const entry empty = { 0,0,no_edge };
+			m_entries.assign(capacity,empty);
+			m_mask = (unsigned int)capacity-1;
+			for (std::size_t i=0;i<entries.size();i++)
+			{
+				if (entries[i].m_edge!=no_edge && entries[i].m_edge!=erased)
+					m_entries[find(entries[i].m_first,entries[i].m_second)] = entries[i];
+			}
+			m_num_used = m_num_live;
+		}
+	private :
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Edge of an entry which has been taken
+		//----------------------------------------------------------------------------------------------------------------------
+		static const sdf::index_type erased = 0xfffffffe;
+		struct entry
+		{
+			sdf::index_type m_first;
+			sdf::index_type m_second;
+			sdf::index_type m_edge;
+		};
+		std::vector<entry> m_entries;
+		unsigned int m_mask;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief 64 minus the log2 of the capacity
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_shift;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of edges waiting
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_num_live;
+		//----------------------------------------------------------------------------------------------------------------------
+		/// @brief Number of entries which are not empty (waiting edges and tombstones)
+		//----------------------------------------------------------------------------------------------------------------------
+		unsigned int m_num_used;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class face_normal_task
+	/// @brief Unit normal of a chunk of faces
+	//----------------------------------------------------------------------------------------------------------------------
+	class face_normal_task
+	{
+	public :
+		face_normal_task(const sdf::mesh& i_mesh, const selection& i_faces, sdf::normal_array* o_normals)
+			: m_mesh(i_mesh), m_faces(i_faces), m_normals(*o_normals) {}
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			unsigned int first, end;
+			chunk_range(i_chunk,m_faces.size(),&first,&end);
+			for (unsigned int f=first;f<end;f++)
+			{
+				const sdf::index_type i = m_faces[f];
+				const sdf::index_type offset = i*3;
+				const sdf::point3d& a = m_mesh.vertex_at(m_mesh.index_at(offset+0));
+				const sdf::point3d& b = m_mesh.vertex_at(m_mesh.index_at(offset+1));
+				const sdf::point3d& c = m_mesh.vertex_at(m_mesh.index_at(offset+2));
+				const sdf::vector3d ab = b-a;
+				const sdf::vector3d ac = c-a;
+				sdf::vector3d normal;
+				normal.cross(ab,ac);
+				m_normals[i]=normal;
+				// The length of the cross product is the area of the parallelogram, 0 for degenerated triangles
+				//assert(m_normals[i].length_squared()!=0);
+				m_normals[i].normalize();
+			}
+		}
+	private :
+		const sdf::mesh& m_mesh;
+		const selection& m_faces;
+		sdf::normal_array& m_normals;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class vertex_normal_task
+	/// @brief Sum of the corner normals of a chunk of vertices
+	//----------------------------------------------------------------------------------------------------------------------
+	class vertex_normal_task
+	{
+	public :
+		vertex_normal_task(
+			const sdf::mesh& i_mesh,
+			const sdf::normal_array& i_face_normals,
+			const std::vector<sdf::index_type>& i_first_corner,
+			const std::vector<sdf::index_type>& i_vertex_corners,
+			const selection& i_vertices,
+			sdf::normal_array* o_normals)
+			: m_mesh(i_mesh), m_face_normals(i_face_normals), m_first_corner(i_first_corner), m_vertex_corners(i_vertex_corners),
+			m_vertices(i_vertices), m_normals(*o_normals) {}
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			unsigned int first, end;
+			chunk_range(i_chunk,m_vertices.size(),&first,&end);
+			for (unsigned int i=first;i<end;i++)
+			{
+				const sdf::index_type v = m_vertices[i];
+				sdf::vector3d normal;
+				for (sdf::index_type c=m_first_corner[v];c<m_first_corner[v+1];c++)
+					normal+=corner_normal(m_mesh,m_face_normals,m_vertex_corners[c]);
+				// Normalization is probably unnecessary
+				normal.normalize();
+				m_normals[v] = normal;
+			}
+		}
+	private :
+		const sdf::mesh& m_mesh;
+		const sdf::normal_array& m_face_normals;
+		const std::vector<sdf::index_type>& m_first_corner;
+		const std::vector<sdf::index_type>& m_vertex_corners;
+		const selection& m_vertices;
+		sdf::normal_array& m_normals;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @class edge_normal_task
+	/// @brief Sum of the normals of the faces on each side of a chunk of half edges
+	//----------------------------------------------------------------------------------------------------------------------
+	class edge_normal_task
+	{
+	public :
+		edge_normal_task(
+			const sdf::normal_array& i_face_normals,
+			const std::vector<sdf::index_type>& i_opposite,
+			const selection& i_edges,
+			sdf::normal_array* o_normals)
+			: m_face_normals(i_face_normals), m_opposite(i_opposite), m_edges(i_edges), m_normals(*o_normals) {}
+		void operator()(unsigned int i_chunk, unsigned int /*i_thread*/)
+		{
+			unsigned int first, end;
+			chunk_range(i_chunk,m_edges.size(),&first,&end);
+			for (unsigned int i=first;i<end;i++)
+			{
+				const sdf::index_type e = m_edges[i];
+				// Border edges only have their own face
+				if (m_opposite[e]==sdf::angle_weighted_average::no_edge)
+					m_normals[e] = m_face_normals[e/3];
+				else
+					m_normals[e] = m_face_normals[e/3]+m_face_normals[m_opposite[e]/3];
+			}
+		}
+	private :
+		const sdf::normal_array& m_face_normals;
+		const std::vector<sdf::index_type>& m_opposite;
+		const selection& m_edges;
+		sdf::normal_array& m_normals;
+	};
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+const sdf::index_type sdf::angle_weighted_average::no_edge;
 
 //----------------------------------------------------------------------------------------------------------------------
 sdf::angle_weighted_average::angle_weighted_average() : m_mesh(0)
@@ -153,115 +483,145 @@ float sdf::angle_weighted_average::operator ()(const point3d& i_position, const
 
 
 //----------------------------------------------------------------------------------------------------------------------
-void sdf::angle_weighted_average::build_face_normals()
+void sdf::angle_weighted_average::refit(const std::vector<index_type>& i_moved)
 {
-	m_face_normals.resize(m_mesh->num_faces());
-	for (unsigned int i=0;i<m_mesh->num_faces();i++)
+	assert(is_initialized());
+	if (i_moved.empty())
+		return;
+	// Not there when the normals were read from a file
+	if (m_first_corner.size()!=m_mesh->num_vertices()+1)
+		build_corners();
+	if (m_opposite.size()!=m_mesh->num_indices())
+		build_opposite();
+
+	// The faces around the moved vertices
+	std::vector<index_type> faces;
+	std::vector<unsigned char> flags(m_mesh->num_faces(),0);
+	for (std::size_t i=0;i<i_moved.size();i++)
 	{
-		const index_type offset = i*3;
-		const index_type& index_a = m_mesh->index_at(offset+0);
-		const index_type& index_b = m_mesh->index_at(offset+1);
-		const index_type& index_c = m_mesh->index_at(offset+2);
-		const point3d& a = m_mesh->vertex_at(index_a);
-		const point3d& b = m_mesh->vertex_at(index_b);
-		const point3d& c = m_mesh->vertex_at(index_c);		
-		const vector3d ab = b-a;
-		const vector3d ac = c-a;
-		vector3d normal;
-		normal.cross(ab,ac);
-		m_face_normals[i]=normal;
-		// This assert makes sure the triangle is not degenerated
-		// The length of a cross product is 
-		// the area of the parallelogram craeted by the two vectors
-		//assert(m_face_normals[i].length_squared()!=0);
-		m_face_normals[i].normalize();
+		const index_type v = i_moved[i];
+		for (index_type c=m_first_corner[v];c<m_first_corner[v+1];c++)
+		{
+			const index_type face = m_vertex_corners[c]/3;
+			if (!flags[face])
+			{
+				flags[face] = 1;
+				faces.push_back(face);
+			}
+		}
+	}
+
+	// The angles and normals of those faces change the normals of all their vertices, and of their edges on both sides
+	std::vector<index_type> vertices, edges;
+	flags.assign(m_mesh->num_vertices(),0);
+	std::vector<unsigned char> edge_flags(m_mesh->num_indices(),0);
+	for (std::size_t i=0;i<faces.size();i++)
+	{
+		for (index_type e=faces[i]*3;e<faces[i]*3+3;e++)
+		{
+			const index_type v = m_mesh->index_at(e);
+			if (!flags[v])
+			{
+				flags[v] = 1;
+				vertices.push_back(v);
+			}
+			const index_type sides[2] = { e,m_opposite[e] };
+			for (unsigned int side=0;side<2;side++)
+			{
+				if (sides[side]!=no_edge && !edge_flags[sides[side]])
+				{
+					edge_flags[sides[side]] = 1;
+					edges.push_back(sides[side]);
+				}
+			}
+		}
 	}
+
+	thread::task_pool pool;
+	const selection face_selection(faces);
+	face_normal_task face_task(*m_mesh,face_selection,&m_face_normals);
+	pool.run(num_chunks(face_selection.size()),face_task);
+
+	const selection vertex_selection(vertices);
+	vertex_normal_task vertex_task(*m_mesh,m_face_normals,m_first_corner,m_vertex_corners,vertex_selection,&m_vertex_normals);
+	pool.run(num_chunks(vertex_selection.size()),vertex_task);
+
+	const selection edge_selection(edges);
+	edge_normal_task edge_task(m_face_normals,m_opposite,edge_selection,&m_edge_normals);
+	pool.run(num_chunks(edge_selection.size()),edge_task);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::angle_weighted_average::build_face_normals()
+{
+	m_face_normals.resize(m_mesh->num_faces());
+	thread::task_pool pool;
+	const selection faces(m_mesh->num_faces());
+	face_normal_task task(*m_mesh,faces,&m_face_normals);
+	pool.run(num_chunks(faces.size()),task);
 }
 
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::angle_weighted_average::build_vertex_normals()
 {
+	build_corners();
 	m_vertex_normals.resize(m_mesh->num_vertices());
-	for (unsigned int i=0;i<m_mesh->num_faces();i++)
-	{
-		const index_type offset = i*3;
-		const index_type& index_a = m_mesh->index_at(offset+0);
-		const index_type& index_b = m_mesh->index_at(offset+1);
-		const index_type& index_c = m_mesh->index_at(offset+2);
-		const point3d& a = m_mesh->vertex_at(index_a);
-		const point3d& b = m_mesh->vertex_at(index_b);
-		const point3d& c = m_mesh->vertex_at(index_c);
-		const vector3d& normal = m_face_normals[i];
-
-		vector3d ab = b-a; 
-		ab.normalize();
-		vector3d bc = c-b;
-		bc.normalize();
-		vector3d ca = a-c;
-		ca.normalize();
-		const vector3d ba(-ab[0],-ab[1],-ab[2]);
-		const vector3d cb(-bc[0],-bc[1],-bc[2]);
-		const vector3d ac(-ca[0],-ca[1],-ca[2]);
-
-
-		const float weight_a = acos(ac.dot(ab));
-		const float weight_b = acos(ba.dot(bc));
-		const float weight_c = acos(cb.dot(ca));
-
-		m_vertex_normals[index_a]+=normal*weight_a;
-		m_vertex_normals[index_b]+=normal*weight_b;
-		m_vertex_normals[index_c]+=normal*weight_c;
-	}
-	// Normalization is probably unnecessary
-	for (unsigned int i=0;i<m_mesh->num_vertices();i++)
-		m_vertex_normals[i].normalize();	
+	thread::task_pool pool;
+	const selection vertices(m_mesh->num_vertices());
+	vertex_normal_task task(*m_mesh,m_face_normals,m_first_corner,m_vertex_corners,vertices,&m_vertex_normals);
+	pool.run(num_chunks(vertices.size()),task);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void sdf::angle_weighted_average::build_edge_normals()
 {
-
+	build_opposite();
 	m_edge_normals.resize(m_mesh->num_indices());
+	thread::task_pool pool;
+	const selection edges(m_mesh->num_indices());
+	edge_normal_task task(m_face_normals,m_opposite,edges,&m_edge_normals);
+	pool.run(num_chunks(edges.size()),task);
+}
 
-	typedef std::pair<index_type,index_type> edge_key;
-	typedef std::pair<unsigned int, index_type> face_edge;
-	typedef std::map<edge_key,face_edge> edge_map;
-
-	// Edge key references both vertex indices
-	// Face edge reference the face index (to get the normal) and the index of the index (offset in edge normal array)
-	edge_map edges;
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::angle_weighted_average::build_corners()
+{
+	// The corners of each vertex, in face order so the sums are the same as adding the faces one after the other
+	m_first_corner.assign(m_mesh->num_vertices()+1,0);
+	for (unsigned int i=0;i<m_mesh->num_indices();i++)
+		m_first_corner[m_mesh->index_at(i)+1]++;
+	for (unsigned int v=0;v<m_mesh->num_vertices();v++)
+		m_first_corner[v+1]+=m_first_corner[v];
+	m_vertex_corners.resize(m_mesh->num_indices());
+	std::vector<index_type> next(m_first_corner.begin(),m_first_corner.end()-1);
+	for (unsigned int i=0;i<m_mesh->num_indices();i++)
+		m_vertex_corners[next[m_mesh->index_at(i)]++] = i;
+}
 
+//----------------------------------------------------------------------------------------------------------------------
+void sdf::angle_weighted_average::build_opposite()
+{
+	// Pair each half edge with the first later half edge going the other way, faces in order
+	// An edge seen again before being paired (non manifold or flipped faces) replaces the one waiting
+	m_opposite.assign(m_mesh->num_indices(),no_edge);
+	edge_table edges;
 	for (unsigned int i=0;i<m_mesh->num_faces();i++)
 	{
 		const index_type offset = i*3;
-
 		for (unsigned int j=0;j<3;j++)
 		{
 			const index_type& index_a = m_mesh->index_at(offset+j);
 			const index_type& index_b = m_mesh->index_at(offset+((j+1)%3));
-			edge_key e1 = std::make_pair(index_a,index_b);
-			edge_map::iterator e1adjacent = edges.find(e1);
-
-			if (e1adjacent!=edges.end())
+			const index_type adjacent = edges.take(index_a,index_b);
+			if (adjacent!=edge_table::no_edge)
 			{
-				vector3d edge_normal = m_face_normals[i]+m_face_normals[e1adjacent->second.first];
-				m_edge_normals[offset+j]=edge_normal;
-				m_edge_normals[e1adjacent->second.second]=edge_normal;
-				edges.erase(e1adjacent);
+				m_opposite[offset+j] = adjacent;
+				m_opposite[adjacent] = offset+j;
 			}
 			else
 			{
-				const vector3d edge_normal = m_face_normals[i];
-				m_edge_normals[offset+j]=edge_normal;
-				edge_key flippede1 = std::make_pair(index_b,index_a);
-				if (edges.find(flippede1)!=edges.end())
-				{
-					// Flipped face!
-					// Flipped faces are now allowed
-					//assert(false);
-				}
-				edges[std::make_pair(index_b,index_a)]=std::make_pair(i,offset+j);
+				edges.put(index_b,index_a,offset+j);
 			}
 		}
 	}
@@ -271,5 +631,7 @@ void sdf::angle_weighted_average::build_edge_normals()
 
 std::size_t sdf::angle_weighted_average::memory_usage() const
 {
-	return dynamic_memory(m_face_normals)+dynamic_memory(m_vertex_normals)+dynamic_memory(m_edge_normals);
+	return
+		dynamic_memory(m_face_normals)+dynamic_memory(m_vertex_normals)+dynamic_memory(m_edge_normals)+
+		dynamic_memory(m_first_corner)+dynamic_memory(m_vertex_corners)+dynamic_memory(m_opposite);
 }
\ No newline at end of file
@@ -0,0 +1,591 @@
+//----------------------------------------------------------------------------------------------------------------------
+/// @file sdf_batch.cpp
+/// @brief Convert a directory of meshes (.obj, .stl, .ply) to compressed field files (.cbf, see brick_file).
+///			The output of a mesh is named after the whole mesh file name, a.obj gives a.obj.cbf, so a.obj and a.stl do not collide.
+///			The conversion is a pipeline of three stages, each on its own thread, so the jobs overlap:
+///			- the meshes are hashed and read from the disk
+///			- the signed distance field is built (normals and lookup) and sampled on a grid. It is built from the mesh alone,
+///			  the .awn and .bvh files next to the mesh are neither read nor written: they may be older than the mesh
+///			- the grid is compressed and written
+///			Every parallel section uses a task pool of the same number of threads (--threads).
+///			An output is up to date when the hash of its mesh and of its settings matches the one recorded in the manifest
+///			of the output directory (sdf_batch.manifest): it is skipped, unless --force is given.
+///			The resolution and the padding can be set per mesh in a job list (--jobs), one mesh per line:
+///			  path/relative/to/input.obj [resolution [padding]]
+///			Lines starting with # are ignored, the missing values are the command line ones.
+//----------------------------------------------------------------------------------------------------------------------
+
+#include <sdf/core/mapped_file.hpp>
+#include <sdf/discretization/brick_file.hpp>
+#include <sdf/discretization/discretized_field.hpp>
+#include <sdf/lookup/wide_bvh_accelerated.hpp>
+#include <sdf/profiler/scope.hpp>
+#include <sdf/signed_distance_field_from_mesh.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The field built for every mesh - the wide bvh gives the same distances as the bvh, faster
+	//----------------------------------------------------------------------------------------------------------------------
+	typedef sdf::signed_distance_field_from_mesh<float,sdf::wide_bvh_accelerated> distance_function;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Changes when the way the fields are made changes, so every output is made again
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int pipeline_version = 1;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Name of the manifest, in the output directory
+	//----------------------------------------------------------------------------------------------------------------------
+	const char* const manifest_name = "sdf_batch.manifest";
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of jobs a stage can get ahead of the next one - it bounds the memory used
+	//----------------------------------------------------------------------------------------------------------------------
+	const std::size_t queue_depth = 2;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The command line options
+	//----------------------------------------------------------------------------------------------------------------------
+	struct options
+	{
+		std::string m_input;
+		std::string m_output;
+		std::string m_jobs;
+		std::string m_trace;
+		unsigned int m_resolution;
+		float m_padding;
+		unsigned int m_brick_size;
+		unsigned int m_bits;
+		float m_band;
+		unsigned int m_threads;
+		bool m_recursive;
+		bool m_force;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A mesh to convert
+	//----------------------------------------------------------------------------------------------------------------------
+	struct job
+	{
+		std::string m_input;
+		std::string m_output;
+		std::string m_name;
+		unsigned int m_resolution;
+		float m_padding;
+		unsigned long long m_hash;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief 64 bits FNV-1a hash
+	/// @param[in] i_data The bytes to hash
+	/// @param[in] i_size Number of bytes
+	/// @param[in] i_hash The hash so far, to chain several blocks
+	/// @return The hash
+	//----------------------------------------------------------------------------------------------------------------------
+	unsigned long long hash_bytes(const void* i_data, std::size_t i_size, unsigned long long i_hash = 14695981039346656037ULL)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(i_data);
+		for (std::size_t i=0;i<i_size;i++)
+		{
+			i_hash ^= bytes[i];
+			i_hash *= 1099511628211ULL;
+		}
+		return i_hash;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Hash a mesh file and all the settings its field depends on
+	/// @param[in] i_job The job, its resolution and padding are used
+	/// @param[in] i_options The compression settings are used
+	/// @param[out] o_hash The hash
+	/// @return False if the file cannot be read
+	//----------------------------------------------------------------------------------------------------------------------
+	bool hash_job(const job& i_job, const options& i_options, unsigned long long* o_hash)
+	{
+		SDF_PROFILE(hash)
+		sdf::mapped_file file(i_job.m_input);
+		if (!file.is_open())
+			return false;
+
+		std::ostringstream settings;
+		settings<<pipeline_version<<' '<<i_job.m_resolution<<' '<<i_job.m_padding<<' '
+			<<i_options.m_brick_size<<' '<<i_options.m_bits<<' '<<i_options.m_band;
+		const std::string text = settings.str();
+		*o_hash = hash_bytes(file.data(),file.size(),hash_bytes(text.data(),text.size()));
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The hashes of the outputs made so far, saved in the output directory after every job so a stopped conversion
+	///			resumes where it was. The stages call it from different threads
+	//----------------------------------------------------------------------------------------------------------------------
+	class manifest
+	{
+	public :
+		manifest(const std::string& i_filename) : m_filename(i_filename)
+		{
+			std::ifstream file(m_filename.c_str());
+			std::string line;
+			while (std::getline(file,line))
+			{
+				std::istringstream fields(line);
+				unsigned long long hash(0);
+				std::string output;
+				if (fields>>std::hex>>hash && std::getline(fields>>std::ws,output))
+					m_hashes[output] = hash;
+			}
+		}
+
+		bool up_to_date(const job& i_job) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::map<std::string,unsigned long long>::const_iterator found = m_hashes.find(i_job.m_name);
+			return found!=m_hashes.end() && found->second==i_job.m_hash && boost::filesystem::exists(i_job.m_output);
+		}
+
+		bool record(const job& i_job)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_hashes[i_job.m_name] = i_job.m_hash;
+
+			// Written aside then renamed, an interrupted save keeps the previous manifest
+			const std::string temporary = m_filename+".tmp";
+			{
+				std::ofstream file(temporary.c_str());
+				for (std::map<std::string,unsigned long long>::const_iterator it=m_hashes.begin();it!=m_hashes.end();++it)
+					file<<std::hex<<it->second<<' '<<it->first<<'\n';
+				if (!file)
+					return false;
+			}
+			boost::system::error_code error;
+			boost::filesystem::rename(temporary,m_filename,error);
+			return !error;
+		}
+	private :
+		manifest(const manifest&);
+		manifest& operator=(const manifest&);
+	private :
+		std::string m_filename;
+		std::map<std::string,unsigned long long> m_hashes;
+		mutable std::mutex m_mutex;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A queue between two stages. Pushing blocks while it is full, popping blocks while it is empty and open
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename T>
+	class stage_queue
+	{
+	public :
+		stage_queue(std::size_t i_capacity) : m_capacity(i_capacity), m_closed(false) {}
+
+		void push(const T& i_value)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_values.size()>=m_capacity)
+				m_changed.wait(lock);
+			m_values.push_back(i_value);
+			m_changed.notify_all();
+		}
+
+		bool pop(T* o_value)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_values.empty() && !m_closed)
+				m_changed.wait(lock);
+			if (m_values.empty())
+				return false;
+			*o_value = m_values.front();
+			m_values.pop_front();
+			m_changed.notify_all();
+			return true;
+		}
+
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+			m_changed.notify_all();
+		}
+	private :
+		std::size_t m_capacity;
+		bool m_closed;
+		std::deque<T> m_values;
+		std::mutex m_mutex;
+		std::condition_variable m_changed;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A mesh read, waiting for its field to be built
+	//----------------------------------------------------------------------------------------------------------------------
+	struct loaded_job
+	{
+		job m_job;
+		distance_function* m_function;
+		double m_seconds;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A field sampled, waiting to be written
+	//----------------------------------------------------------------------------------------------------------------------
+	struct sampled_job
+	{
+		job m_job;
+		sdf::discretized_field* m_field;
+		double m_seconds;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The state shared by the stages
+	//----------------------------------------------------------------------------------------------------------------------
+	struct pipeline
+	{
+		pipeline(const options& i_options, const std::string& i_manifest) :
+			m_options(i_options), m_manifest(i_manifest), m_loaded(queue_depth), m_sampled(queue_depth),
+			m_converted(0), m_skipped(0), m_failed(0) {}
+
+		const options& m_options;
+		std::vector<job> m_jobs;
+		manifest m_manifest;
+		stage_queue<loaded_job> m_loaded;
+		stage_queue<sampled_job> m_sampled;
+		std::mutex m_log_mutex;
+		// The load and the write stages both count failures
+		std::atomic<unsigned int> m_converted;
+		std::atomic<unsigned int> m_skipped;
+		std::atomic<unsigned int> m_failed;
+
+		void log(const std::string& i_message, bool i_error = false)
+		{
+			std::lock_guard<std::mutex> lock(m_log_mutex);
+			(i_error ? std::cerr : std::cout)<<i_message<<std::endl;
+		}
+	private :
+		pipeline& operator=(const pipeline&);
+	};
+
+	typedef std::chrono::steady_clock clock_type;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Time elapsed since a start point
+	/// @param[in] i_start The start point
+	/// @return The time in seconds
+	//----------------------------------------------------------------------------------------------------------------------
+	double seconds_since(const clock_type::time_point& i_start)
+	{
+		return std::chrono::duration<double>(clock_type::now()-i_start).count();
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief First stage - hash the meshes, skip the ones up to date and read the others
+	//----------------------------------------------------------------------------------------------------------------------
+	void load_stage(pipeline* io_pipeline)
+	{
+		sdf::profiler::recorder::instance().set_thread_name("load");
+		for (std::size_t i=0;i<io_pipeline->m_jobs.size();i++)
+		{
+			job& current = io_pipeline->m_jobs[i];
+			if (!hash_job(current,io_pipeline->m_options,&current.m_hash))
+			{
+				io_pipeline->log("could not read "+current.m_input,true);
+				io_pipeline->m_failed++;
+				continue;
+			}
+			if (!io_pipeline->m_options.m_force && io_pipeline->m_manifest.up_to_date(current))
+			{
+				io_pipeline->log(current.m_name+" : up to date");
+				io_pipeline->m_skipped++;
+				continue;
+			}
+
+			const clock_type::time_point start = clock_type::now();
+			distance_function* function(0);
+			{
+				SDF_PROFILE_SCOPE("load %s",current.m_name.c_str())
+				function = new distance_function(current.m_input);
+			}
+			if (function->get_mesh().empty())
+			{
+				io_pipeline->log("could not load the mesh "+current.m_input,true);
+				io_pipeline->m_failed++;
+				delete function;
+				continue;
+			}
+			loaded_job loaded = { current, function, seconds_since(start) };
+			io_pipeline->m_loaded.push(loaded);
+		}
+		io_pipeline->m_loaded.close();
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Second stage - build the distance field and sample it
+	//----------------------------------------------------------------------------------------------------------------------
+	void sample_stage(pipeline* io_pipeline)
+	{
+		sdf::profiler::recorder::instance().set_thread_name("sample");
+		const unsigned int num_threads = io_pipeline->m_options.m_threads;
+		loaded_job loaded;
+		while (io_pipeline->m_loaded.pop(&loaded))
+		{
+			const job& current = loaded.m_job;
+			const clock_type::time_point start = clock_type::now();
+			sdf::discretized_field* field(0);
+			{
+				SDF_PROFILE_SCOPE("sample %s",current.m_name.c_str())
+				distance_function& function = *loaded.m_function;
+				function.initialize_without_files();
+
+				const sdf::aabb& box = function.get_box();
+				sdf::vector3d extent;
+				box.extent(&extent);
+				field = new sdf::discretized_field(
+					box.minimum()-extent*current.m_padding,
+					box.maximum()+extent*current.m_padding,
+					current.m_resolution,current.m_resolution,current.m_resolution);
+				if (current.m_resolution%2==0)
+					field->fill_packets_mt(function,num_threads);
+				else
+					field->fill_mt(function,num_threads);
+			}
+			delete loaded.m_function;
+
+			sampled_job sampled = { current, field, loaded.m_seconds+seconds_since(start) };
+			io_pipeline->m_sampled.push(sampled);
+		}
+		io_pipeline->m_sampled.close();
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Last stage - compress the fields and write them
+	//----------------------------------------------------------------------------------------------------------------------
+	void write_stage(pipeline* io_pipeline)
+	{
+		sdf::profiler::recorder::instance().set_thread_name("write");
+		const options& settings = io_pipeline->m_options;
+		sampled_job sampled;
+		while (io_pipeline->m_sampled.pop(&sampled))
+		{
+			const job& current = sampled.m_job;
+			const clock_type::time_point start = clock_type::now();
+			bool written = false;
+			{
+				SDF_PROFILE_SCOPE("write %s",current.m_name.c_str())
+				boost::system::error_code error;
+				boost::filesystem::create_directories(boost::filesystem::path(current.m_output).parent_path(),error);
+				const sdf::discretized_field& field = *sampled.m_field;
+				written = sdf::brick_file::write(current.m_output,field.grid(),field.minimum(),field.maximum(),
+					settings.m_brick_size,settings.m_bits,settings.m_band,settings.m_threads);
+			}
+			delete sampled.m_field;
+
+			if (!written || !io_pipeline->m_manifest.record(current))
+			{
+				io_pipeline->log("could not write "+current.m_output,true);
+				io_pipeline->m_failed++;
+				continue;
+			}
+			std::ostringstream message;
+			message<<current.m_name<<" : "<<current.m_resolution<<"^3 in "<<sampled.m_seconds+seconds_since(start)<<"s";
+			io_pipeline->log(message.str());
+			io_pipeline->m_converted++;
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Check the extension of a mesh file
+	//----------------------------------------------------------------------------------------------------------------------
+	bool is_mesh(const boost::filesystem::path& i_path)
+	{
+		std::string extension = i_path.extension().string();
+		std::transform(extension.begin(),extension.end(),extension.begin(),::tolower);
+		return extension==".obj" || extension==".stl" || extension==".ply";
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Make a job, the output mirrors the path of the mesh relative to the input directory
+	//----------------------------------------------------------------------------------------------------------------------
+	job make_job(const options& i_options, const std::string& i_relative, unsigned int i_resolution, float i_padding)
+	{
+		const boost::filesystem::path name(i_relative+".cbf");
+
+		job made;
+		made.m_input = (boost::filesystem::path(i_options.m_input)/i_relative).string();
+		made.m_output = (boost::filesystem::path(i_options.m_output)/name).string();
+		made.m_name = name.generic_string();
+		made.m_resolution = i_resolution;
+		made.m_padding = i_padding;
+		made.m_hash = 0;
+		return made;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief List the meshes of the input directory
+	/// @return False if the directory cannot be read
+	//----------------------------------------------------------------------------------------------------------------------
+	bool scan_directory(const options& i_options, std::vector<job>* o_jobs)
+	{
+		const boost::filesystem::path root(i_options.m_input);
+		if (!boost::filesystem::is_directory(root))
+			return false;
+
+		std::vector<std::string> meshes;
+		if (i_options.m_recursive)
+		{
+			for (boost::filesystem::recursive_directory_iterator it(root),end;it!=end;++it)
+			{
+				if (boost::filesystem::is_regular_file(it->status()) && is_mesh(it->path()))
+					meshes.push_back(it->path().string().substr(root.string().size()+1));
+			}
+		}
+		else
+		{
+			for (boost::filesystem::directory_iterator it(root),end;it!=end;++it)
+			{
+				if (boost::filesystem::is_regular_file(it->status()) && is_mesh(it->path()))
+					meshes.push_back(it->path().filename().string());
+			}
+		}
+		// Same order on every run and every system
+		std::sort(meshes.begin(),meshes.end());
+		for (std::size_t i=0;i<meshes.size();i++)
+			o_jobs->push_back(make_job(i_options,meshes[i],i_options.m_resolution,i_options.m_padding));
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read the job list, the meshes are relative to the input directory
+	/// @return False if the list cannot be read or a line is not valid
+	//----------------------------------------------------------------------------------------------------------------------
+	bool read_job_list(const options& i_options, std::vector<job>* o_jobs)
+	{
+		std::ifstream file(i_options.m_jobs.c_str());
+		if (!file)
+		{
+			std::cerr<<"could not read the job list "<<i_options.m_jobs<<std::endl;
+			return false;
+		}
+		std::string line;
+		for (unsigned int number=1;std::getline(file,line);number++)
+		{
+			std::istringstream fields(line);
+			std::string mesh;
+			if (!(fields>>mesh) || mesh[0]=='#')
+				continue;
+			unsigned int resolution = i_options.m_resolution;
+			float padding = i_options.m_padding;
+			if (fields>>resolution)
+				fields>>padding;
+			if (resolution<2 || padding<0.f)
+			{
+				std::cerr<<i_options.m_jobs<<":"<<number<<": not a valid resolution or padding"<<std::endl;
+				return false;
+			}
+			o_jobs->push_back(make_job(i_options,mesh,resolution,padding));
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read the command line
+	/// @return False if the program should stop
+	//----------------------------------------------------------------------------------------------------------------------
+	bool parse_options(int argc, char** argv, options* o_options)
+	{
+		namespace po = boost::program_options;
+		po::options_description visible("Options");
+		visible.add_options()
+			("help,h","produce help message")
+			("output,o",po::value<std::string>(&o_options->m_output)->default_value(""),"output directory, the input directory by default")
+			("jobs,j",po::value<std::string>(&o_options->m_jobs)->default_value(""),"job list: a mesh per line, with its resolution and padding")
+			("resolution,r",po::value<unsigned int>(&o_options->m_resolution)->default_value(128),"number of samples along each axis")
+			("padding,p",po::value<float>(&o_options->m_padding)->default_value(0.1f),"space around the mesh, as a ratio of its size")
+			("brick-size",po::value<unsigned int>(&o_options->m_brick_size)->default_value(8),"samples along a brick, 8 or 16")
+			("bits",po::value<unsigned int>(&o_options->m_bits)->default_value(16),"bits of the quantised samples, 8 or 16")
+			("band",po::value<float>(&o_options->m_band)->default_value(8.f),"band kept around the surface, in samples (0 keeps all)")
+			("threads,t",po::value<unsigned int>(&o_options->m_threads)->default_value(0),"number of threads, 0 uses all the cores")
+			("recursive,R",po::bool_switch(&o_options->m_recursive),"look for meshes in the sub directories too")
+			("force,f",po::bool_switch(&o_options->m_force),"convert every mesh, even the up to date ones")
+			("trace",po::value<std::string>(&o_options->m_trace)->default_value(""),"write a Chrome trace of the conversion to this file");
+		po::options_description hidden;
+		hidden.add_options()
+			("input",po::value<std::string>(&o_options->m_input),"input directory");
+		po::options_description all;
+		all.add(visible).add(hidden);
+		po::positional_options_description positional;
+		positional.add("input",1);
+
+		po::variables_map variables;
+		try
+		{
+			po::store(po::command_line_parser(argc,argv).options(all).positional(positional).run(),variables);
+			po::notify(variables);
+		}
+		catch (const po::error& e)
+		{
+			std::cerr<<e.what()<<std::endl;
+			return false;
+		}
+
+		if (variables.count("help") || o_options->m_input.empty())
+		{
+			std::cout<<"usage: sdf_batch [options] input_directory"<<std::endl<<visible<<std::endl;
+			return false;
+		}
+		if ((o_options->m_brick_size!=8 && o_options->m_brick_size!=16) || (o_options->m_bits!=8 && o_options->m_bits!=16) ||
+			o_options->m_resolution<2 || o_options->m_padding<0.f)
+		{
+			std::cerr<<"the brick size and the bits are 8 or 16, the resolution at least 2 and the padding positive"<<std::endl;
+			return false;
+		}
+		if (o_options->m_output.empty())
+			o_options->m_output = o_options->m_input;
+		return true;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	options settings;
+	if (!parse_options(argc,argv,&settings))
+		return 1;
+
+	sdf::profiler::recorder::instance().set_enabled(!settings.m_trace.empty());
+	boost::system::error_code error;
+	boost::filesystem::create_directories(settings.m_output,error);
+	pipeline stages(settings,(boost::filesystem::path(settings.m_output)/manifest_name).string());
+	const bool listed = settings.m_jobs.empty() ? scan_directory(settings,&stages.m_jobs) : read_job_list(settings,&stages.m_jobs);
+	if (!listed)
+	{
+		std::cerr<<"could not list the meshes of "<<settings.m_input<<std::endl;
+		return 1;
+	}
+
+	const clock_type::time_point start = clock_type::now();
+	std::thread loader(load_stage,&stages);
+	std::thread writer(write_stage,&stages);
+	sample_stage(&stages);
+	loader.join();
+	writer.join();
+
+	std::cout<<stages.m_converted.load()<<" converted, "<<stages.m_skipped.load()<<" up to date, "<<stages.m_failed.load()<<" failed in "
+		<<seconds_since(start)<<"s"<<std::endl;
+	if (!settings.m_trace.empty() && !sdf::profiler::recorder::instance().write_chrome_trace(settings.m_trace))
+		std::cerr<<"could not write the trace to "<<settings.m_trace<<std::endl;
+	return stages.m_failed ? 2 : 0;
+}
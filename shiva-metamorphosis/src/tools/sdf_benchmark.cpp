@@ -0,0 +1,501 @@
+//----------------------------------------------------------------------------------------------------------------------
+/// @file sdf_benchmark.cpp
+/// @brief Headless benchmark of the distance lookups of the sdf library. For every mesh given, each lookup is built and
+///			queried on the same random points (in the box of the mesh, grown by 10%), and compared to the brute force:
+///			build time, memory, query throughput (single, packets of 8, all the threads) and max/mean distance error.
+///			The lookups are built from the mesh alone, the .bvh files next to it are neither read nor written.
+///			The results go to the standard output (or a file) as CSV or JSON, one row per mesh and lookup.
+///
+///			sdf_benchmark [--format csv|json] [--output file] [--queries n] [--threads n] [--seed n]
+///			              [--lookups brute_force,bvh,wide_bvh,grid,octree] mesh.obj [mesh.stl ...]
+//----------------------------------------------------------------------------------------------------------------------
+
+#include <sdf/core/mesh.hpp>
+#include <sdf/core/task_pool.hpp>
+#include <sdf/distance/distance_record.hpp>
+#include <sdf/lookup/brute_force.hpp>
+#include <sdf/lookup/bvh_accelerated.hpp>
+#include <sdf/lookup/grid_accelerated.hpp>
+#include <sdf/lookup/octree_accelerated.hpp>
+#include <sdf/lookup/wide_bvh_accelerated.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of queries of a multithreaded task
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int queries_per_task = 256;
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Number of points in a packet query
+	//----------------------------------------------------------------------------------------------------------------------
+	const unsigned int packet_size = 8;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The command line options
+	//----------------------------------------------------------------------------------------------------------------------
+	struct options
+	{
+		options() : m_json(false), m_queries(10000), m_threads(0), m_seed(1) {}
+
+		std::vector<std::string> m_meshes;
+		std::vector<std::string> m_lookups;
+		std::string m_output;
+		bool m_json;
+		unsigned int m_queries;
+		unsigned int m_threads;
+		unsigned int m_seed;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The measures of one lookup on one mesh. The throughputs are in queries per second, 0 when not measured
+	//----------------------------------------------------------------------------------------------------------------------
+	struct result
+	{
+		result() : m_faces(0), m_build_ms(0), m_memory(0), m_single_qps(0), m_packet_qps(0), m_threaded_qps(0), m_threads(0),
+			m_max_error(0), m_mean_error(0) {}
+
+		std::string m_mesh;
+		std::string m_lookup;
+		unsigned int m_faces;
+		double m_build_ms;
+		std::size_t m_memory;
+		double m_single_qps;
+		double m_packet_qps;
+		double m_threaded_qps;
+		unsigned int m_threads;
+		double m_max_error;
+		double m_mean_error;
+	};
+
+	typedef std::chrono::steady_clock clock_type;
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Time elapsed since a start point
+	/// @param[in] i_start The start point
+	/// @return The time in seconds
+	//----------------------------------------------------------------------------------------------------------------------
+	double seconds_since(const clock_type::time_point& i_start)
+	{
+		return std::chrono::duration<double>(clock_type::now()-i_start).count();
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Queries per second, guarding against a time too small to be measured
+	//----------------------------------------------------------------------------------------------------------------------
+	double throughput(std::size_t i_queries, double i_seconds)
+	{
+		return i_seconds>0 ? i_queries/i_seconds : 0;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Query a range of points with any lookup, each task is queries_per_task points
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename Lookup>
+	class query_task
+	{
+	public :
+		query_task(const Lookup& i_lookup, const std::vector<sdf::point3d>& i_points, std::vector<float>* o_distances) :
+			m_lookup(i_lookup), m_points(i_points), m_distances(*o_distances) {}
+
+		void operator()(unsigned int i_task, unsigned int /*i_thread*/)
+		{
+			const std::size_t first = std::size_t(i_task)*queries_per_task;
+			const std::size_t end = std::min(first+queries_per_task,m_points.size());
+			for (std::size_t i=first;i<end;i++)
+			{
+				sdf::distance_record record;
+				unsigned int face(0);
+				m_lookup(m_points[i],&record,&face);
+				m_distances[i] = sqrtf(record.distance_square());
+			}
+		}
+	private :
+		query_task& operator=(const query_task&);
+	private :
+		const Lookup& m_lookup;
+		const std::vector<sdf::point3d>& m_points;
+		std::vector<float>& m_distances;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Query all the points one by one on the calling thread
+	/// @return The time in seconds
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename Lookup>
+	double query_single(const Lookup& i_lookup, const std::vector<sdf::point3d>& i_points, std::vector<float>* o_distances)
+	{
+		query_task<Lookup> task(i_lookup,i_points,o_distances);
+		const unsigned int num_tasks = static_cast<unsigned int>((i_points.size()+queries_per_task-1)/queries_per_task);
+		const clock_type::time_point start = clock_type::now();
+		for (unsigned int i=0;i<num_tasks;i++)
+			task(i,0);
+		return seconds_since(start);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Query all the points with all the threads of the pool
+	/// @return The time in seconds
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename Lookup>
+	double query_threaded(const Lookup& i_lookup, const std::vector<sdf::point3d>& i_points, sdf::thread::task_pool& i_pool,
+		std::vector<float>* o_distances)
+	{
+		query_task<Lookup> task(i_lookup,i_points,o_distances);
+		const unsigned int num_tasks = static_cast<unsigned int>((i_points.size()+queries_per_task-1)/queries_per_task);
+		const clock_type::time_point start = clock_type::now();
+		i_pool.run(num_tasks,task);
+		return seconds_since(start);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Packet queries - only the bounding volume hierarchies have them
+	/// @param[out] o_seconds The time in seconds
+	/// @return False if the lookup cannot query packets
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename Lookup>
+	bool query_packets(const Lookup& /*i_lookup*/, const std::vector<sdf::point3d>& /*i_points*/, std::vector<float>* /*o_distances*/,
+		double* /*o_seconds*/)
+	{
+		return false;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Packet queries of a (binary or wide) bounding volume hierarchy, the tail is padded with the last point
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename Lookup>
+	void query_packets_of_8(const Lookup& i_lookup, const std::vector<sdf::point3d>& i_points, std::vector<float>* o_distances,
+		double* o_seconds)
+	{
+		std::vector<float>& distances = *o_distances;
+		const clock_type::time_point start = clock_type::now();
+		for (std::size_t first=0;first<i_points.size();first+=packet_size)
+		{
+			const std::size_t count = std::min<std::size_t>(packet_size,i_points.size()-first);
+			sdf::point3d positions[packet_size];
+			for (unsigned int i=0;i<packet_size;i++)
+				positions[i] = i_points[first+std::min<std::size_t>(i,count-1)];
+			sdf::distance_record records[packet_size];
+			unsigned int faces[packet_size];
+			i_lookup(positions,records,faces);
+			for (std::size_t i=0;i<count;i++)
+				distances[first+i] = sqrtf(records[i].distance_square());
+		}
+		*o_seconds = seconds_since(start);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	bool query_packets(const sdf::bvh_accelerated& i_lookup, const std::vector<sdf::point3d>& i_points, std::vector<float>* o_distances,
+		double* o_seconds)
+	{
+		query_packets_of_8(i_lookup,i_points,o_distances,o_seconds);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	bool query_packets(const sdf::wide_bvh_accelerated& i_lookup, const std::vector<sdf::point3d>& i_points, std::vector<float>* o_distances,
+		double* o_seconds)
+	{
+		query_packets_of_8(i_lookup,i_points,o_distances,o_seconds);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Accumulate the error of a set of distances against the reference ones
+	/// @param[in] i_distances The distances to check
+	/// @param[in] i_reference The brute force distances
+	/// @param[in,out] io_result The max error is updated, the mean is accumulated (divided by the caller)
+	/// @return The number of distances accumulated
+	//----------------------------------------------------------------------------------------------------------------------
+	std::size_t accumulate_error(const std::vector<float>& i_distances, const std::vector<float>& i_reference, result* io_result)
+	{
+		for (std::size_t i=0;i<i_distances.size();i++)
+		{
+			const double error = fabs(double(i_distances[i])-double(i_reference[i]));
+			io_result->m_max_error = std::max(io_result->m_max_error,error);
+			io_result->m_mean_error += error;
+		}
+		return i_distances.size();
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Build a lookup, query the points every way it can, and compare all the answers to the reference
+	/// @param[in] i_mesh The mesh
+	/// @param[in] i_points The query points
+	/// @param[in] i_pool The threads for the multithreaded queries
+	/// @param[in,out] io_reference The brute force distances. When empty, it is filled with the distances of this lookup
+	///			(the brute force itself)
+	/// @param[out] o_result The measures (the mesh name and the lookup name are not set)
+	//----------------------------------------------------------------------------------------------------------------------
+	template<typename Lookup>
+	void benchmark(const sdf::mesh& i_mesh, const std::vector<sdf::point3d>& i_points, sdf::thread::task_pool& i_pool,
+		std::vector<float>* io_reference, result* o_result)
+	{
+		o_result->m_faces = i_mesh.num_faces();
+		o_result->m_threads = i_pool.num_threads();
+
+		Lookup lookup;
+		const clock_type::time_point start = clock_type::now();
+		lookup.initialize(i_mesh);
+		o_result->m_build_ms = seconds_since(start)*1000.0;
+		o_result->m_memory = lookup.memory_usage();
+
+		std::vector<float> single(i_points.size()), threaded(i_points.size()), packets;
+		o_result->m_single_qps = throughput(i_points.size(),query_single(lookup,i_points,&single));
+		o_result->m_threaded_qps = throughput(i_points.size(),query_threaded(lookup,i_points,i_pool,&threaded));
+
+		if (io_reference->empty())
+			*io_reference = single;
+		const std::vector<float>& reference = *io_reference;
+		std::size_t count = accumulate_error(single,reference,o_result);
+		count += accumulate_error(threaded,reference,o_result);
+
+		double packet_seconds(0);
+		packets.resize(i_points.size());
+		if (query_packets(lookup,i_points,&packets,&packet_seconds))
+		{
+			o_result->m_packet_qps = throughput(i_points.size(),packet_seconds);
+			count += accumulate_error(packets,reference,o_result);
+		}
+
+		o_result->m_mean_error = count ? o_result->m_mean_error/count : 0;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Random query points in the box of the mesh, grown by 10% in every direction
+	//----------------------------------------------------------------------------------------------------------------------
+	void query_points(const sdf::aabb& i_box, unsigned int i_count, unsigned int i_seed, std::vector<sdf::point3d>* o_points)
+	{
+		std::mt19937 generator(i_seed);
+		std::uniform_real_distribution<float> unit(-0.1f,1.1f);
+		const sdf::point3d& minimum = i_box.minimum();
+		const sdf::point3d& maximum = i_box.maximum();
+		o_points->resize(i_count);
+		for (unsigned int i=0;i<i_count;i++)
+		{
+			sdf::point3d& p = (*o_points)[i];
+			for (unsigned int axis=0;axis<3;axis++)
+				p[axis] = minimum[axis]+unit(generator)*(maximum[axis]-minimum[axis]);
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Quote a string for JSON (the mesh paths can contain backslashes)
+	//----------------------------------------------------------------------------------------------------------------------
+	std::string json_string(const std::string& i_value)
+	{
+		std::string quoted("\"");
+		for (std::size_t i=0;i<i_value.size();i++)
+		{
+			if (i_value[i]=='"' || i_value[i]=='\\')
+				quoted += '\\';
+			quoted += i_value[i];
+		}
+		return quoted+"\"";
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Quote a string for CSV, only when it needs to be
+	//----------------------------------------------------------------------------------------------------------------------
+	std::string csv_string(const std::string& i_value)
+	{
+		if (i_value.find_first_of(",\"\n")==std::string::npos)
+			return i_value;
+		std::string quoted("\"");
+		for (std::size_t i=0;i<i_value.size();i++)
+		{
+			if (i_value[i]=='"')
+				quoted += '"';
+			quoted += i_value[i];
+		}
+		return quoted+"\"";
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Write the results as CSV, with a header line
+	//----------------------------------------------------------------------------------------------------------------------
+	void write_csv(const std::vector<result>& i_results, std::ostream& o_stream)
+	{
+		o_stream<<"mesh,faces,lookup,build_ms,memory_bytes,single_qps,packet_qps,threaded_qps,threads,max_error,mean_error\n";
+		for (std::size_t i=0;i<i_results.size();i++)
+		{
+			const result& r = i_results[i];
+			o_stream<<csv_string(r.m_mesh)<<','<<r.m_faces<<','<<r.m_lookup<<','<<r.m_build_ms<<','<<r.m_memory<<','
+				<<r.m_single_qps<<','<<r.m_packet_qps<<','<<r.m_threaded_qps<<','<<r.m_threads<<','
+				<<r.m_max_error<<','<<r.m_mean_error<<'\n';
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Write the results as a JSON array of objects, with the same fields as the CSV
+	//----------------------------------------------------------------------------------------------------------------------
+	void write_json(const std::vector<result>& i_results, std::ostream& o_stream)
+	{
+		o_stream<<"[\n";
+		for (std::size_t i=0;i<i_results.size();i++)
+		{
+			const result& r = i_results[i];
+			o_stream<<"\t{ \"mesh\": "<<json_string(r.m_mesh)<<", \"faces\": "<<r.m_faces<<", \"lookup\": "<<json_string(r.m_lookup)
+				<<", \"build_ms\": "<<r.m_build_ms<<", \"memory_bytes\": "<<r.m_memory
+				<<", \"single_qps\": "<<r.m_single_qps<<", \"packet_qps\": "<<r.m_packet_qps<<", \"threaded_qps\": "<<r.m_threaded_qps
+				<<", \"threads\": "<<r.m_threads<<", \"max_error\": "<<r.m_max_error<<", \"mean_error\": "<<r.m_mean_error<<" }"
+				<<(i+1<i_results.size() ? ",\n" : "\n");
+		}
+		o_stream<<"]\n";
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Print how to use the benchmark
+	//----------------------------------------------------------------------------------------------------------------------
+	void usage(const char* i_program)
+	{
+		std::cerr<<"usage: "<<i_program<<" [--format csv|json] [--output file] [--queries n] [--threads n] [--seed n]\n"
+			<<"       [--lookups brute_force,bvh,wide_bvh,grid,octree] mesh [mesh ...]\n"
+			<<"The meshes can be OBJ, STL or PLY files. The brute force is always run, it is the reference."<<std::endl;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Read the command line
+	/// @return False if it is not valid
+	//----------------------------------------------------------------------------------------------------------------------
+	bool parse_options(int argc, char** argv, options* o_options)
+	{
+		std::string lookups("brute_force,bvh,wide_bvh,grid,octree");
+		for (int i=1;i<argc;i++)
+		{
+			const std::string argument(argv[i]);
+			const bool has_value = i+1<argc;
+			if (argument=="--format" && has_value)
+			{
+				const std::string format(argv[++i]);
+				if (format!="csv" && format!="json")
+					return false;
+				o_options->m_json = format=="json";
+			}
+			else if (argument=="--output" && has_value)
+				o_options->m_output = argv[++i];
+			else if (argument=="--queries" && has_value)
+				o_options->m_queries = static_cast<unsigned int>(strtoul(argv[++i],0,10));
+			else if (argument=="--threads" && has_value)
+				o_options->m_threads = static_cast<unsigned int>(strtoul(argv[++i],0,10));
+			else if (argument=="--seed" && has_value)
+				o_options->m_seed = static_cast<unsigned int>(strtoul(argv[++i],0,10));
+			else if (argument=="--lookups" && has_value)
+				lookups = argv[++i];
+			else if (argument.compare(0,2,"--")==0)
+				return false;
+			else
+				o_options->m_meshes.push_back(argument);
+		}
+
+		std::istringstream names(lookups);
+		std::string name;
+		while (std::getline(names,name,','))
+		{
+			if (name!="brute_force" && name!="bvh" && name!="wide_bvh" && name!="grid" && name!="octree")
+			{
+				std::cerr<<"unknown lookup "<<name<<std::endl;
+				return false;
+			}
+			o_options->m_lookups.push_back(name);
+		}
+		return !o_options->m_meshes.empty() && o_options->m_queries>0;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Benchmark all the lookups asked for on a mesh
+	/// @return False if the mesh could not be loaded
+	//----------------------------------------------------------------------------------------------------------------------
+	bool benchmark_mesh(const std::string& i_filename, const options& i_options, sdf::thread::task_pool& i_pool,
+		std::vector<result>* o_results)
+	{
+		sdf::mesh mesh;
+		sdf::aabb box;
+		if (!mesh.load_from_file(i_filename,&box) || mesh.num_faces()==0)
+		{
+			std::cerr<<"could not load "<<i_filename<<std::endl;
+			return false;
+		}
+		std::cerr<<i_filename<<" : "<<mesh.num_faces()<<" faces"<<std::endl;
+		// The build times are measured without the .bvh files, and nothing is written next to the mesh
+		mesh.forget_source();
+
+		std::vector<sdf::point3d> points;
+		query_points(box,i_options.m_queries,i_options.m_seed,&points);
+
+		// The brute force goes first, it gives the reference distances
+		std::vector<float> reference;
+		result brute;
+		brute.m_mesh = i_filename;
+		brute.m_lookup = "brute_force";
+		benchmark<sdf::brute_force>(mesh,points,i_pool,&reference,&brute);
+		if (std::find(i_options.m_lookups.begin(),i_options.m_lookups.end(),"brute_force")!=i_options.m_lookups.end())
+			o_results->push_back(brute);
+
+		for (std::size_t i=0;i<i_options.m_lookups.size();i++)
+		{
+			const std::string& name = i_options.m_lookups[i];
+			result r;
+			r.m_mesh = i_filename;
+			r.m_lookup = name;
+			if (name=="bvh")
+				benchmark<sdf::bvh_accelerated>(mesh,points,i_pool,&reference,&r);
+			else if (name=="wide_bvh")
+				benchmark<sdf::wide_bvh_accelerated>(mesh,points,i_pool,&reference,&r);
+			else if (name=="grid")
+				benchmark<sdf::grid_accelerated>(mesh,points,i_pool,&reference,&r);
+			else if (name=="octree")
+				benchmark<sdf::octree_accelerated>(mesh,points,i_pool,&reference,&r);
+			else
+				continue;
+			std::cerr<<"  "<<name<<" : build "<<r.m_build_ms<<" ms, max error "<<r.m_max_error<<std::endl;
+			o_results->push_back(r);
+		}
+		return true;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	options settings;
+	if (!parse_options(argc,argv,&settings))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	sdf::thread::task_pool pool(settings.m_threads);
+	std::vector<result> results;
+	bool success = true;
+	for (std::size_t i=0;i<settings.m_meshes.size();i++)
+		success = benchmark_mesh(settings.m_meshes[i],settings,pool,&results) && success;
+
+	std::ofstream file;
+	if (!settings.m_output.empty())
+	{
+		file.open(settings.m_output.c_str());
+		if (!file)
+		{
+			std::cerr<<"could not write "<<settings.m_output<<std::endl;
+			return 1;
+		}
+	}
+	std::ostream& stream = settings.m_output.empty() ? std::cout : file;
+	stream.precision(9);
+	if (settings.m_json)
+		write_json(results,stream);
+	else
+		write_csv(results,stream);
+
+	return success ? 0 : 2;
+}
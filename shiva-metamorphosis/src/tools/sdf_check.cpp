@@ -0,0 +1,207 @@
+//----------------------------------------------------------------------------------------------------------------------
+/// @file sdf_check.cpp
+/// @brief Headless checks of the sdf library, for the build servers. Every check builds its own fields from analytic shapes,
+///			so no input file is needed. Each check prints one line, the failures are detailed.
+///			The exit code is 0 when every check passed, 1 otherwise.
+///
+///			sdf_check
+//----------------------------------------------------------------------------------------------------------------------
+
+#include <sdf/discretization/brick_file.hpp>
+#include <sdf/discretization/discretized_field.hpp>
+#include <sdf/discretization/grid.hpp>
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <math.h>
+
+namespace
+{
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Signed distance to a sphere of radius 0.6 centred on the origin, negative inside
+	//----------------------------------------------------------------------------------------------------------------------
+	float sphere(float i_x, float i_y, float i_z)
+	{
+		return sqrtf(i_x*i_x+i_y*i_y+i_z*i_z)-0.6f;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Signed distance to a torus around Y (radii 0.55 and 0.2) centred on the origin, negative inside
+	//----------------------------------------------------------------------------------------------------------------------
+	float torus(float i_x, float i_y, float i_z)
+	{
+		const float ring = sqrtf(i_x*i_x+i_z*i_z)-0.55f;
+		return sqrtf(ring*ring+i_y*i_y)-0.2f;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A shape to sample
+	//----------------------------------------------------------------------------------------------------------------------
+	struct shape
+	{
+		const char* m_name;
+		float (*m_function)(float,float,float);
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief The shapes every check runs on
+	//----------------------------------------------------------------------------------------------------------------------
+	const shape shapes[] = { { "sphere", sphere }, { "torus", torus } };
+	const unsigned int num_shapes = sizeof(shapes)/sizeof(shapes[0]);
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief A shape as a field function, counting its evaluations
+	//----------------------------------------------------------------------------------------------------------------------
+	struct counted_shape
+	{
+		counted_shape(const shape& i_shape) : m_shape(i_shape), m_count(0) {}
+		float operator()(const sdf::point3d& i_point, unsigned int* /*io_face_id*/, sdf::distance_record* /*o_hit*/) const
+		{
+			m_count++;
+			return m_shape.m_function(i_point[0],i_point[1],i_point[2]);
+		}
+		const shape& m_shape;
+		mutable std::atomic<unsigned int> m_count;
+	};
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Sample a shape on a grid covering [-1,1]^3, the first and last samples are on the bounds
+	/// @param[in] i_shape The shape
+	/// @param[in] i_resolution Number of samples in each direction
+	/// @param[out] o_grid The samples
+	//----------------------------------------------------------------------------------------------------------------------
+	void sample(const shape& i_shape, unsigned int i_resolution, sdf::grid* o_grid)
+	{
+		*o_grid = sdf::grid(i_resolution,i_resolution,i_resolution);
+		const float step = 2.f/static_cast<float>(i_resolution-1);
+		for (unsigned int k=0;k<i_resolution;k++)
+			for (unsigned int j=0;j<i_resolution;j++)
+				for (unsigned int i=0;i<i_resolution;i++)
+					(*o_grid)(i,j,k) = i_shape.m_function(-1.f+step*i,-1.f+step*j,-1.f+step*k);
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Check that no sample changes sign through a brick file, whatever the bits and the brick size: the zero level set
+	///			is the surface rendered from the file
+	/// @return True if the check passed
+	//----------------------------------------------------------------------------------------------------------------------
+	bool check_brick_file_signs()
+	{
+		const boost::filesystem::path filename = boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("sdf_check_%%%%%%%%.cbf");
+		const unsigned int resolutions[] = { 32, 64 };
+		const unsigned int bits[] = { 8, 16 };
+		const unsigned int brick_sizes[] = { 8, 16 };
+
+		unsigned int cases(0), failures(0);
+		for (unsigned int s=0;s<num_shapes;s++)
+		{
+			for (unsigned int r=0;r<2;r++)
+			{
+				sdf::grid samples;
+				sample(shapes[s],resolutions[r],&samples);
+				for (unsigned int b=0;b<2;b++)
+				{
+					for (unsigned int z=0;z<2;z++)
+					{
+						cases++;
+						if (!sdf::brick_file::write(filename.string(),samples,sdf::point3d(-1.f,-1.f,-1.f),sdf::point3d(1.f,1.f,1.f),brick_sizes[z],bits[b],8.f,1))
+						{
+							std::cout<<"  "<<shapes[s].m_name<<" "<<resolutions[r]<<"^3, "<<bits[b]<<" bits, bricks of "<<brick_sizes[z]<<": could not write "<<filename.string()<<std::endl;
+							failures++;
+							continue;
+						}
+
+						sdf::grid decoded;
+						bool read(false);
+						{
+							sdf::brick_file file(filename.string());
+							read = file.is_open() && file.read(&decoded,1);
+						}
+						unsigned int changed(0);
+						if (read)
+						{
+							for (unsigned int i=0;i<samples.num_elements();i++)
+							{
+								if ((samples[i]<0.f)!=(decoded[i]<0.f) || (samples[i]>0.f)!=(decoded[i]>0.f))
+									changed++;
+							}
+						}
+						if (!read || changed)
+						{
+							std::cout<<"  "<<shapes[s].m_name<<" "<<resolutions[r]<<"^3, "<<bits[b]<<" bits, bricks of "<<brick_sizes[z]<<": ";
+							if (read)
+								std::cout<<changed<<" samples changed sign"<<std::endl;
+							else
+								std::cout<<"could not read the file back"<<std::endl;
+							failures++;
+						}
+					}
+				}
+			}
+		}
+
+		boost::system::error_code error;
+		boost::filesystem::remove(filename,error);
+		std::cout<<(failures ? "FAILED" : "ok")<<" brick_file keeps the signs ("<<cases<<" cases, "<<failures<<" failed)"<<std::endl;
+		return failures==0;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Check that fill_adaptive keeps the sign of every sample and evaluates the function less than fill: at 64^3 a
+	///			sphere or a torus takes less than half the evaluations, with and without the centre check
+	/// @return True if the check passed
+	//----------------------------------------------------------------------------------------------------------------------
+	bool check_adaptive_fill()
+	{
+		const unsigned int resolution = 64;
+		const float tolerances[] = { 0.f, 0.1f };
+
+		unsigned int cases(0), failures(0);
+		for (unsigned int s=0;s<num_shapes;s++)
+		{
+			sdf::discretized_field exact(sdf::point3d(-1.f,-1.f,-1.f),sdf::point3d(1.f,1.f,1.f),resolution,resolution,resolution);
+			counted_shape all(shapes[s]);
+			exact.fill(all);
+			for (unsigned int t=0;t<2;t++)
+			{
+				cases++;
+				sdf::discretized_field adaptive(sdf::point3d(-1.f,-1.f,-1.f),sdf::point3d(1.f,1.f,1.f),resolution,resolution,resolution);
+				counted_shape some(shapes[s]);
+				adaptive.fill_adaptive(some,8,tolerances[t]);
+
+				unsigned int changed(0);
+				for (unsigned int k=0;k<resolution;k++)
+				{
+					for (unsigned int j=0;j<resolution;j++)
+					{
+						for (unsigned int i=0;i<resolution;i++)
+						{
+							const float a = exact.element_at(i,j,k), b = adaptive.element_at(i,j,k);
+							if ((a<0.f)!=(b<0.f) || (a>0.f)!=(b>0.f))
+								changed++;
+						}
+					}
+				}
+				if (changed || 2*some.m_count>=all.m_count)
+				{
+					std::cout<<"  "<<shapes[s].m_name<<" "<<resolution<<"^3, tolerance "<<tolerances[t]<<": "<<changed<<" samples changed sign, "
+						<<some.m_count<<" evaluations for "<<all.m_count<<" with fill"<<std::endl;
+					failures++;
+				}
+			}
+		}
+
+		std::cout<<(failures ? "FAILED" : "ok")<<" fill_adaptive keeps the signs with half the evaluations ("<<cases<<" cases, "<<failures<<" failed)"<<std::endl;
+		return failures==0;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int main(int /*argc*/, char** /*argv*/)
+{
+	bool passed(true);
+	passed = check_brick_file_signs() && passed;
+	passed = check_adaptive_fill() && passed;
+	return passed ? 0 : 1;
+}
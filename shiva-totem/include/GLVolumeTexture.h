@@ -12,6 +12,11 @@ public :
 	/// @brief Constructor
 	//----------------------------------------------------------------------------------------------------------------------
         GLVolumeTexture();
+	//----------------------------------------------------------------------------------------------------------------------
+	/// @brief Upload a grid to a 3D texture, straight from its raw data (the mapped file for a loaded .bdf)
+	/// @param[in] i_volume The samples
+	/// @return True
+	//----------------------------------------------------------------------------------------------------------------------
         bool update(const sdf::grid& i_volume);
 	//----------------------------------------------------------------------------------------------------------------------
 	/// @brief Bind the volume texture to openGL
@@ -0,0 +1,151 @@
+///-----------------------------------------------------------------------------------------------
+/// \file MeshExportJob.h
+/// \brief Runs the printability analysis and mesh export of a totem on a background thread
+/// Start it with an exported tree, then come back regularly to check how far it has got
+/// Its owner gives it up with Release() rather than deleting it, so a running export never has to be waited for
+/// \author Michelle Wu
+/// \version 1.0
+///-----------------------------------------------------------------------------------------------
+
+#ifndef __SHIVA_MESH_EXPORT_JOB__
+#define __SHIVA_MESH_EXPORT_JOB__
+
+#include <boost/bind/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <iostream>
+
+#include "vol_totem.h"
+
+class MeshExportJob
+{
+public:
+
+	//----------------------------------------------------------------------------------
+	/// \brief Stages the job goes through
+	//----------------------------------------------------------------------------------
+	enum Stage
+	{
+		IDLE,
+		ANALYSING,
+		MESHING,
+		FINISHED,
+		FAILED,
+		CANCELLED
+	};
+	//----------------------------------------------------------------------------------
+	/// \brief Ctor
+	//----------------------------------------------------------------------------------
+	MeshExportJob();
+	//----------------------------------------------------------------------------------
+	/// \brief Dtor. Cancels a running job and waits for the export thread to return
+	//----------------------------------------------------------------------------------
+	~MeshExportJob();
+	//----------------------------------------------------------------------------------
+	/// \brief Cancels the job and gives it up. The job is deleted now if its thread has returned,
+	/// otherwise the export thread deletes it when it returns. The job must not be used afterwards
+	//----------------------------------------------------------------------------------
+	void Release();
+	//----------------------------------------------------------------------------------
+	/// \brief Starts analysing and meshing the given tree. Returns false if a job is already running
+	/// \param [in] _exportRoot Tree built with VolumeTree::Tree::BuildPrintExportNode
+	/// \param [in] _filename File to write the mesh to
+	/// \param [in] _quality Mesh quality passed on to the vol_totem mesher
+	//----------------------------------------------------------------------------------
+	bool Start( totemio::TotemNode *_exportRoot, std::string _filename, float _quality );
+	//----------------------------------------------------------------------------------
+	/// \brief Requests the running job to stop
+	/// vol_totem cannot be interrupted, so the job stops at the next stage and no file is left behind
+	//----------------------------------------------------------------------------------
+	void Cancel();
+	//----------------------------------------------------------------------------------
+	/// \brief Returns true while the job is analysing or meshing
+	//----------------------------------------------------------------------------------
+	bool IsBusy();
+	//----------------------------------------------------------------------------------
+	/// \brief Returns the current stage
+	//----------------------------------------------------------------------------------
+	Stage GetStage();
+	//----------------------------------------------------------------------------------
+	/// \brief Returns true once when the job has ended, and hands over how it ended
+	/// The job goes back to IDLE afterwards
+	/// \param [out] _stage FINISHED, FAILED or CANCELLED
+	/// \param [out] _message Message to show to the user
+	//----------------------------------------------------------------------------------
+	bool CollectResult( Stage &_stage, std::string &_message );
+	//----------------------------------------------------------------------------------
+	/// \brief Returns the file the job writes to
+	//----------------------------------------------------------------------------------
+	std::string GetFilename() { return m_filename; }
+	//----------------------------------------------------------------------------------
+	/// \brief Required for boost::thread. Runs the export, then deletes the job if it was released meanwhile
+	//----------------------------------------------------------------------------------
+	void ThreadProcess();
+	//----------------------------------------------------------------------------------
+
+protected:
+
+	//----------------------------------------------------------------------------------
+	/// \brief Moves the job to a new stage
+	/// \param [in] _stage
+	/// \param [in] _message
+	//----------------------------------------------------------------------------------
+	void SetStage( Stage _stage, std::string _message = "" );
+	//----------------------------------------------------------------------------------
+	/// \brief This is where the analysis and meshing will take place
+	//----------------------------------------------------------------------------------
+	void Export();
+	//----------------------------------------------------------------------------------
+	/// \brief Returns whether Cancel() has been called since the job started
+	//----------------------------------------------------------------------------------
+	bool IsCancelRequested();
+	//----------------------------------------------------------------------------------
+	/// \brief Waits for a previous export thread and deletes it
+	//----------------------------------------------------------------------------------
+	void JoinThread();
+	//----------------------------------------------------------------------------------
+	/// \brief Current stage
+	//----------------------------------------------------------------------------------
+	Stage m_stage;
+	//----------------------------------------------------------------------------------
+	/// \brief Whether the user asked to stop the job
+	//----------------------------------------------------------------------------------
+	bool m_cancelRequested;
+	//----------------------------------------------------------------------------------
+	/// \brief Whether the export thread has not returned yet
+	//----------------------------------------------------------------------------------
+	bool m_threadRunning;
+	//----------------------------------------------------------------------------------
+	/// \brief Whether the owner gave the job up while its thread was running
+	//----------------------------------------------------------------------------------
+	bool m_released;
+	//----------------------------------------------------------------------------------
+	/// \brief Message describing how the job ended
+	//----------------------------------------------------------------------------------
+	std::string m_message;
+	//----------------------------------------------------------------------------------
+	/// \brief File name to save
+	//----------------------------------------------------------------------------------
+	std::string m_filename;
+	//----------------------------------------------------------------------------------
+	/// \brief Mesh quality
+	//----------------------------------------------------------------------------------
+	float m_quality;
+	//----------------------------------------------------------------------------------
+	/// \brief Tree being exported, only touched by the export thread while the job is busy
+	//----------------------------------------------------------------------------------
+	totemio::TotemNode *m_exportRoot;
+	//----------------------------------------------------------------------------------
+	/// \brief Guards the stage, message and the cancel, running and released flags
+	//----------------------------------------------------------------------------------
+	boost::mutex m_stateMtx;
+	//----------------------------------------------------------------------------------
+	/// \brief Export thread
+	//----------------------------------------------------------------------------------
+	boost::thread *m_exportThread;
+	//----------------------------------------------------------------------------------
+
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "System/Activity.h"
 #include "Totem/TotemController.h"
 #include "VolView.h"
+#include "MeshExportJob.h"
 
 
 class PrintActivity : public ShivaGUI::Activity
@@ -41,6 +42,11 @@ protected:
 	//----------------------------------------------------------------------------------
 	virtual void OnDestroy();
 	//----------------------------------------------------------------------------------
+	/// \brief This function is called when the Activity is updated. It follows the background mesh export
+	/// \param [in] _deltaTs
+	//----------------------------------------------------------------------------------
+	virtual void OnUpdate( float _deltaTs );
+	//----------------------------------------------------------------------------------
 	/// \brief This will handle events from buttons etc
 	/// \param [in] _handler
 	/// \param [in] _view
@@ -92,6 +98,23 @@ protected:
 	//----------------------------------------------------------------------------------
 	void RebuildTrees();
 	//----------------------------------------------------------------------------------
+	/// \brief Asks for a file name and starts exporting the model as a mesh in the background
+	/// \param [in] _includePole Whether the pole is exported
+	/// \param [in] _includeBase Whether the base is exported
+	/// \param [in] _description What was exported, for the confirmation message
+	//----------------------------------------------------------------------------------
+	void ExportMesh( bool _includePole, bool _includeBase, std::string _description );
+	//----------------------------------------------------------------------------------
+	/// \brief Shows the save dialog for .obj files
+	/// \return The chosen file name, or an empty string if the user cancelled
+	//----------------------------------------------------------------------------------
+	std::string ChooseMeshFilename();
+	//----------------------------------------------------------------------------------
+	/// \brief Shows text in the title of every window that has one
+	/// \param [in] _text
+	//----------------------------------------------------------------------------------
+	void SetStatusText( std::string _text );
+	//----------------------------------------------------------------------------------
 	/// \brief Initialises a main window with input and output capabilities
 	/// \param [in] _guiController
 	/// \param [in] _data
@@ -120,6 +143,22 @@ protected:
 	//----------------------------------------------------------------------------------
 	float m_saveRescaleSize;
 	//----------------------------------------------------------------------------------
+	/// \brief Quality of exported meshes, read from the "MeshQuality" option. Smaller values give a finer mesh
+	//----------------------------------------------------------------------------------
+	float m_meshQuality;
+	//----------------------------------------------------------------------------------
+	/// \brief Background analysis and export of .obj files, released when the activity is destroyed
+	//----------------------------------------------------------------------------------
+	MeshExportJob *m_exportJob;
+	//----------------------------------------------------------------------------------
+	/// \brief Last export stage shown to the user
+	//----------------------------------------------------------------------------------
+	MeshExportJob::Stage m_exportStage;
+	//----------------------------------------------------------------------------------
+	/// \brief What the running export includes, for the confirmation message
+	//----------------------------------------------------------------------------------
+	std::string m_exportDescription;
+	//----------------------------------------------------------------------------------
 	/// \brief Red component of object colour
 	//----------------------------------------------------------------------------------
 	float m_objectColourR;
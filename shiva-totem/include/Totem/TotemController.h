@@ -11,6 +11,7 @@
 
 #include <map>
 #include <list>
+#include <vector>
 
 #include "VolumeRenderer/SpringyVec3.h"
 #include "VolumeTree/Leaves/VolCacheNode.h"
@@ -160,7 +161,8 @@ namespace Totem
 		//----------------------------------------------------------------------------------
 		void SetSelectedObject( Totem::Object* _obj ) { m_selectedObject = _obj; }
 		//----------------------------------------------------------------------------------
-		/// \brief Will select the first object who's bounding box intersects with the line (if any)
+		/// \brief Will select the first object whose surface intersects with the line (if any)
+		/// Falls back on the first bounding box hit if no surface is found within the time budget
 		//----------------------------------------------------------------------------------
 		bool SelectIntersectingObject( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ );
 		//----------------------------------------------------------------------------------
@@ -268,6 +270,63 @@ namespace Totem
 		float m_blendAmount;
 		//----------------------------------------------------------------------------------
 
+		// PICKING
+
+		//----------------------------------------------------------------------------------
+		/// \brief Node of the bounding volume hierarchy built over the objects for picking
+		//----------------------------------------------------------------------------------
+		struct PickNode
+		{
+			//----------------------------------------------------------------------------------
+			/// \brief Bounds (minX, maxX, minY, maxY, minZ, maxZ)
+			//----------------------------------------------------------------------------------
+			float m_bounds[ 6 ];
+			//----------------------------------------------------------------------------------
+			/// \brief Index of the children in the node list, -1 for leaves
+			//----------------------------------------------------------------------------------
+			int m_left, m_right;
+			//----------------------------------------------------------------------------------
+			/// \brief Object in a leaf, NULL otherwise
+			//----------------------------------------------------------------------------------
+			Totem::Object *m_object;
+		};
+		//----------------------------------------------------------------------------------
+		/// \brief Time allowed for exact picking in milliseconds
+		//----------------------------------------------------------------------------------
+		unsigned int m_pickTimeBudget;
+		//----------------------------------------------------------------------------------
+		/// \brief Picks the object whose surface is hit first by the ray
+		/// \param [in] _originX
+		/// \param [in] _originY
+		/// \param [in] _originZ
+		/// \param [in] _dirX
+		/// \param [in] _dirY
+		/// \param [in] _dirZ
+		/// \return The object hit, or NULL if no surface was found within the time budget
+		//----------------------------------------------------------------------------------
+		Totem::Object* PickSurface( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ );
+		//----------------------------------------------------------------------------------
+		/// \brief Builds the hierarchy over _leaves[ _begin, _end ), splitting at the median centre of the longest axis
+		/// \param [out] _nodes Node list to add to
+		/// \param [in] _leaves One leaf per object, reordered in place
+		/// \param [in] _begin
+		/// \param [in] _end
+		/// \return Index of the subtree root in _nodes
+		//----------------------------------------------------------------------------------
+		static int BuildPickTree( std::vector< PickNode > &_nodes, std::vector< PickNode > &_leaves, unsigned int _begin, unsigned int _end );
+		//----------------------------------------------------------------------------------
+		/// \brief Traces the ray through the hierarchy, visiting nearer boxes first
+		/// \param [in] _nodes
+		/// \param [in] _nodeIndex
+		/// \param [in] _ray Origin then direction
+		/// \param [in] _deadline Value of SDL_GetTicks() after which we give up
+		/// \param [in,out] _hitObject Closest object hit so far
+		/// \param [in,out] _hitDist Distance to the closest hit so far
+		/// \param [out] _timedOut Set to true once the deadline has passed
+		//----------------------------------------------------------------------------------
+		static void TracePickTree( const std::vector< PickNode > &_nodes, int _nodeIndex, const float *_ray, unsigned int _deadline, Totem::Object **_hitObject, float &_hitDist, bool &_timedOut );
+		//----------------------------------------------------------------------------------
+
 	};
 }
 
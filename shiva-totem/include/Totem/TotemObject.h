@@ -40,20 +40,21 @@ namespace Totem
 		//----------------------------------------------------------------------------------
 		~Object();
 		//----------------------------------------------------------------------------------
-		/// \brief Set child and recalculate offsets
+		/// \brief Set child and recalculate offsets of this object and the ones above it
 		/// \param [in] _value Child node
 		//----------------------------------------------------------------------------------
-		void SetChild( Object *_value ) { m_child = _value; RecalcOffsets(); }
+		void SetChild( Object *_value ) { m_child = _value; InvalidateBaseOffset(); RecalcOffsetsUpward(); }
 		//----------------------------------------------------------------------------------
 		/// \brief Set previous child (before deletion)
 		/// \param [in] _value Child node
 		//----------------------------------------------------------------------------------
 		void SetPrevChild( Object *_value ) { m_prevChild = _value; }
 		//----------------------------------------------------------------------------------
-		/// \brief Set parent and recalculate offsets
+		/// \brief Set parent. The stacked position only depends on the objects below,
+		/// so there is nothing to recalculate here: the parent's SetChild() does that
 		/// \param [in] _value Parent node
 		//----------------------------------------------------------------------------------
-		void SetParent( Object *_value ) { m_parent = _value; RecalcOffsets(); }
+		void SetParent( Object *_value ) { m_parent = _value; }
 		//----------------------------------------------------------------------------------
 		/// \brief Retrieve child of Totem::Object
 		/// \return m_child
@@ -168,18 +169,34 @@ namespace Totem
 		//----------------------------------------------------------------------------------
 		void GetTranslation( float &_x, float &_y, float &_z ) { _x = m_tx; _y = m_ty; _z = m_tz; }
 		//----------------------------------------------------------------------------------
-		/// \brief Return the height of the object bounding box
+		/// \brief Return the height of the object bounding box (cached)
 		//----------------------------------------------------------------------------------
 		float GetBBoxZ();
 		//----------------------------------------------------------------------------------
 		/// \brief This should return the Z value that is the top of the bounding box of the object
+		/// This is the sum of the heights of this object and all the ones below it, cached until
+		/// the stack below us changes
 		//----------------------------------------------------------------------------------
 		float GetBaseOffset();
 		//----------------------------------------------------------------------------------
-		/// \brief Recalculate offsets
+		/// \brief Recalculate offsets of this object and all the ones below it
 		//----------------------------------------------------------------------------------
 		void RecalcOffsets();
 		//----------------------------------------------------------------------------------
+		/// \brief Retrieve bounds of the transformed object, cached until the transform changes
+		/// \param [out] _minX
+		/// \param [out] _maxX
+		/// \param [out] _minY
+		/// \param [out] _maxY
+		/// \param [out] _minZ
+		/// \param [out] _maxZ
+		//----------------------------------------------------------------------------------
+		void GetBounds( float *_minX, float *_maxX, float *_minY, float *_maxY, float *_minZ, float *_maxZ );
+		//----------------------------------------------------------------------------------
+		/// \brief Must be called if the shape of the main node has changed, so cached heights are thrown away
+		//----------------------------------------------------------------------------------
+		void InvalidateBounds();
+		//----------------------------------------------------------------------------------
 		/// \brief This is the basic position for the object. Its actual position is this (in Z, with 0 in X,Y) plus the XYZ offset value
 		//----------------------------------------------------------------------------------
 		float GetStackedPosition();
@@ -198,6 +215,49 @@ namespace Totem
 		//----------------------------------------------------------------------------------
 		float SelectIntersectingObject( Totem::Object **_selection, float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ );
 		//----------------------------------------------------------------------------------
+		/// \brief Intersect a ray with this object's (transformed) bounding box
+		/// \param [in] _originX
+		/// \param [in] _originY
+		/// \param [in] _originZ
+		/// \param [in] _dirX
+		/// \param [in] _dirY
+		/// \param [in] _dirZ
+		/// \param [out] _tNear Distance along the ray where it enters the box
+		/// \param [out] _tFar Distance along the ray where it leaves the box
+		/// \return True if the ray hits the box
+		//----------------------------------------------------------------------------------
+		bool IntersectBounds( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ, float &_tNear, float &_tFar );
+		//----------------------------------------------------------------------------------
+		/// \brief Intersect a ray with a box
+		/// \param [in] _bounds minX, maxX, minY, maxY, minZ, maxZ
+		/// \param [in] _originX
+		/// \param [in] _originY
+		/// \param [in] _originZ
+		/// \param [in] _dirX
+		/// \param [in] _dirY
+		/// \param [in] _dirZ
+		/// \param [out] _tNear Distance along the ray where it enters the box
+		/// \param [out] _tFar Distance along the ray where it leaves the box
+		/// \return True if the ray hits the box
+		//----------------------------------------------------------------------------------
+		static bool IntersectBox( const float *_bounds, float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ, float &_tNear, float &_tFar );
+		//----------------------------------------------------------------------------------
+		/// \brief Marches the ray through this object's own field between _tNear and _tFar,
+		/// with the same step size the renderer uses, and refines the first crossing
+		/// \param [in] _originX
+		/// \param [in] _originY
+		/// \param [in] _originZ
+		/// \param [in] _dirX
+		/// \param [in] _dirY
+		/// \param [in] _dirZ
+		/// \param [in] _tNear Where to start marching
+		/// \param [in] _tFar Where to stop marching
+		/// \param [in] _deadline Value of SDL_GetTicks() after which we give up
+		/// \param [out] _timedOut Set to true if we gave up because of the deadline
+		/// \return Distance to the surface, or -1 if there is no hit
+		//----------------------------------------------------------------------------------
+		float TraceSurface( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ, float _tNear, float _tFar, unsigned int _deadline, bool &_timedOut );
+		//----------------------------------------------------------------------------------
 		/// \brief Check if object is valid (has mainNode and mainTransform )
 		//----------------------------------------------------------------------------------
 		bool IsValid();
@@ -291,10 +351,46 @@ namespace Totem
 		//----------------------------------------------------------------------------------
 		float m_sz;
 		//----------------------------------------------------------------------------------
+		/// \brief Cached height of the main node
+		//----------------------------------------------------------------------------------
+		float m_bboxZ;
+		//----------------------------------------------------------------------------------
+		/// \brief Is m_bboxZ up to date?
+		//----------------------------------------------------------------------------------
+		bool m_bboxZValid;
+		//----------------------------------------------------------------------------------
+		/// \brief Cached sum of the heights of this object and all the objects below it
+		//----------------------------------------------------------------------------------
+		float m_baseOffset;
+		//----------------------------------------------------------------------------------
+		/// \brief Is m_baseOffset up to date?
+		//----------------------------------------------------------------------------------
+		bool m_baseOffsetValid;
+		//----------------------------------------------------------------------------------
+		/// \brief Cached bounds of the main transform (minX, maxX, minY, maxY, minZ, maxZ)
+		//----------------------------------------------------------------------------------
+		float m_bounds[ 6 ];
+		//----------------------------------------------------------------------------------
+		/// \brief Are m_bounds up to date?
+		//----------------------------------------------------------------------------------
+		bool m_boundsValid;
+		//----------------------------------------------------------------------------------
 		/// \brief Update main transformation matrix
 		//----------------------------------------------------------------------------------
 		void UpdateTransform();
 		//----------------------------------------------------------------------------------
+		/// \brief Set translation from offsets and stacked position, without touching other objects
+		//----------------------------------------------------------------------------------
+		void UpdateStackedTranslation();
+		//----------------------------------------------------------------------------------
+		/// \brief Recalculate offsets of this object and all the ones above it
+		//----------------------------------------------------------------------------------
+		void RecalcOffsetsUpward();
+		//----------------------------------------------------------------------------------
+		/// \brief Mark the base offset of this object and all the ones above it as out of date
+		//----------------------------------------------------------------------------------
+		void InvalidateBaseOffset();
+		//----------------------------------------------------------------------------------
 	};
 }
 
@@ -0,0 +1,241 @@
+#include "MeshExportJob.h"
+
+#include <boost/filesystem.hpp>
+
+//----------------------------------------------------------------------------------
+
+MeshExportJob::MeshExportJob()
+{
+	m_stage = IDLE;
+	m_cancelRequested = false;
+	m_threadRunning = false;
+	m_released = false;
+	m_quality = 0.01f;
+	m_exportRoot = NULL;
+	m_exportThread = NULL;
+}
+
+//----------------------------------------------------------------------------------
+
+MeshExportJob::~MeshExportJob()
+{
+	Cancel();
+	JoinThread();
+}
+
+//----------------------------------------------------------------------------------
+
+void MeshExportJob::Release()
+{
+	m_stateMtx.lock();
+		m_cancelRequested = true;
+		if( m_threadRunning )
+		{
+			// vol_totem cannot be interrupted, the export thread deletes the job when it returns
+			m_exportThread->detach();
+			delete m_exportThread;
+			m_exportThread = NULL;
+			m_released = true;
+			m_stateMtx.unlock();
+			return;
+		}
+	m_stateMtx.unlock();
+
+	delete this;
+}
+
+//----------------------------------------------------------------------------------
+
+bool MeshExportJob::Start( totemio::TotemNode *_exportRoot, std::string _filename, float _quality )
+{
+	if( _exportRoot == NULL || IsBusy() )
+	{
+		return false;
+	}
+
+	// The previous thread has already finished, this just releases it
+	JoinThread();
+
+	m_exportRoot = _exportRoot;
+	m_filename = _filename;
+	m_quality = _quality;
+
+	m_stateMtx.lock();
+		m_cancelRequested = false;
+		m_message.clear();
+		m_stage = ANALYSING;
+		m_threadRunning = true;
+	m_stateMtx.unlock();
+
+	m_exportThread = new boost::thread( boost::bind( &MeshExportJob::ThreadProcess, this ) );
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+void MeshExportJob::Cancel()
+{
+	m_stateMtx.lock();
+		m_cancelRequested = true;
+	m_stateMtx.unlock();
+}
+
+//----------------------------------------------------------------------------------
+
+bool MeshExportJob::IsBusy()
+{
+	Stage stage = GetStage();
+	return stage == ANALYSING || stage == MESHING;
+}
+
+//----------------------------------------------------------------------------------
+
+MeshExportJob::Stage MeshExportJob::GetStage()
+{
+	m_stateMtx.lock();
+		Stage stage = m_stage;
+	m_stateMtx.unlock();
+
+	return stage;
+}
+
+//----------------------------------------------------------------------------------
+
+bool MeshExportJob::CollectResult( Stage &_stage, std::string &_message )
+{
+	bool ended = false;
+
+	m_stateMtx.lock();
+		if( m_stage == FINISHED || m_stage == FAILED || m_stage == CANCELLED )
+		{
+			_stage = m_stage;
+			_message = m_message;
+			m_stage = IDLE;
+			ended = true;
+		}
+	m_stateMtx.unlock();
+
+	return ended;
+}
+
+//----------------------------------------------------------------------------------
+
+void MeshExportJob::ThreadProcess()
+{
+	Export();
+
+	m_stateMtx.lock();
+		m_threadRunning = false;
+		bool released = m_released;
+	m_stateMtx.unlock();
+
+	// Nobody else refers to a released job
+	if( released )
+	{
+		delete this;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void MeshExportJob::Export()
+{
+	std::cout << "INFO: MeshExportJob analysing model for: " << m_filename << std::endl;
+
+	unsigned int retCode = totemio::analyseModel( m_exportRoot );
+
+	if( IsCancelRequested() )
+	{
+		SetStage( CANCELLED, "Export cancelled." );
+		return;
+	}
+
+	if( retCode != totemio::CODE_OK )
+	{
+		if( retCode == totemio::CODE_MULTICOMPONENT )
+		{
+			SetStage( FAILED, "Model is not printable: it is made of separate parts." );
+		}
+		else if( retCode == totemio::CODE_UNBALANCED )
+		{
+			SetStage( FAILED, "Model is not printable: it is heavily unbalanced." );
+		}
+		else
+		{
+			SetStage( FAILED, "Model is not printable!" );
+		}
+		return;
+	}
+
+	SetStage( MESHING );
+
+	// Write next to the target first, so a cancelled or failed export never leaves a half written file behind
+	// The extension is kept because vol_totem picks the mesh format from it
+	boost::filesystem::path target( m_filename );
+	boost::filesystem::path partial = target.parent_path() / ( target.stem().string() + "_partial" + target.extension().string() );
+
+	std::cout << "INFO: MeshExportJob meshing model with quality " << m_quality << std::endl;
+
+	bool saved = totemio::saveMesh( partial.string().c_str(), m_exportRoot, m_quality );
+
+	boost::system::error_code ec;
+	if( IsCancelRequested() )
+	{
+		boost::filesystem::remove( partial, ec );
+		SetStage( CANCELLED, "Export cancelled." );
+		return;
+	}
+
+	if( !saved )
+	{
+		boost::filesystem::remove( partial, ec );
+		SetStage( FAILED, "Could not write mesh file: " + m_filename );
+		return;
+	}
+
+	boost::filesystem::rename( partial, target, ec );
+	if( ec )
+	{
+		std::cerr << "WARNING: MeshExportJob could not move " << partial.string() << " to " << m_filename << ": " << ec.message() << std::endl;
+		SetStage( FAILED, "Could not write mesh file: " + m_filename );
+		return;
+	}
+
+	SetStage( FINISHED, "Model successfully saved as: " + m_filename );
+}
+
+//----------------------------------------------------------------------------------
+
+void MeshExportJob::SetStage( Stage _stage, std::string _message )
+{
+	m_stateMtx.lock();
+		m_stage = _stage;
+		m_message = _message;
+	m_stateMtx.unlock();
+}
+
+//----------------------------------------------------------------------------------
+
+bool MeshExportJob::IsCancelRequested()
+{
+	m_stateMtx.lock();
+		bool cancelRequested = m_cancelRequested;
+	m_stateMtx.unlock();
+
+	return cancelRequested;
+}
+
+//----------------------------------------------------------------------------------
+
+void MeshExportJob::JoinThread()
+{
+	if( m_exportThread != NULL )
+	{
+		m_exportThread->join();
+		delete m_exportThread;
+		m_exportThread = NULL;
+	}
+}
+
+//----------------------------------------------------------------------------------
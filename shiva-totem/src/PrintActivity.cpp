@@ -24,6 +24,9 @@ void PrintActivity::OnCreate( ShivaGUI::Bundle *_data )
 
 	m_setObjectColour = false;
 	m_saveRescaleSize = 20.0f;
+	m_meshQuality = 0.01f;
+	m_exportJob = new MeshExportJob();
+	m_exportStage = MeshExportJob::IDLE;
 
 	m_saveDir = "Savefiles/";
 	m_saveName = "Model";//;
@@ -36,6 +39,7 @@ void PrintActivity::OnCreate( ShivaGUI::Bundle *_data )
 
 		m_rotationStepsize = prefs->GetFloat( "RotationStepsize", m_rotationStepsize );
 		m_saveRescaleSize = prefs->GetFloat( "SaveRescaleSize", m_saveRescaleSize );
+		m_meshQuality = prefs->GetFloat( "MeshQuality", m_meshQuality );
 
 		if( prefs->Contains( "ObjectColourR" ) && prefs->Contains( "ObjectColourG" ) && prefs->Contains( "ObjectColourB" ) )
 		{
@@ -44,6 +48,12 @@ void PrintActivity::OnCreate( ShivaGUI::Bundle *_data )
 			m_objectColourB = prefs->GetFloat( "ObjectColourB", m_objectColourB );
 			m_setObjectColour = true;
 		}
+
+		if( m_meshQuality <= 0.0f )
+		{
+			std::cerr << "WARNING: PrintActivity MeshQuality must be positive, using default" << std::endl;
+			m_meshQuality = 0.01f;
+		}
 	}
 
 	// Set totem colour
@@ -86,6 +96,10 @@ void PrintActivity::OnCreate( ShivaGUI::Bundle *_data )
 void PrintActivity::OnDestroy()
 {
 	delete m_buttonHandler;
+
+	// A running export is left to finish on its own instead of blocking the UI until it does
+	m_exportJob->Release();
+	m_exportJob = NULL;
 }
 
 //----------------------------------------------------------------------------------
@@ -99,299 +113,33 @@ void PrintActivity::UtilityEventReceived( UtilityEventHandler *_handler, ShivaGU
 #ifdef _DEBUG
 			std::cout << "INFO: PrintActivity request to 3D print model with pole and base." << std::endl;
 #endif
-			VolumeTree::Tree tmpTree;
-			tmpTree.SetRoot( m_totemController->GetNodeTree() );
-			tinyfd_messageBox("Information", "About to check that the model is printable", "ok", "info", NULL);
-			if (!tmpTree.IsPrintable( true, true))
-			{
-				//TODO: handle that in the interface
-				std::cout << "ERROR: Model is not printable!" << std::endl;
-
-				tinyfd_messageBox("ERROR!", "Model is not printable!", "ok", "error", NULL);
-			}
-			else
-			{
-				// for meshes we use timestamp instead of increasing numbers
-				// subject to discussion with teachers
-				std::string extension = ".obj";
-				//
-				using namespace boost::posix_time;
-				ptime now = second_clock::universal_time();
-				static std::locale loc(std::cout.getloc(), new time_facet("%Y%m%d_%H%M%S"));
-				std::ostringstream ss;
-				ss.imbue(loc);
-				ss << now;
-				std::string filename = m_saveDir + m_saveName + ss.str() + extension;
-				char const * lFilterPatterns[ 1 ] = { "*.obj" };
-
-				// Show save dialog
-				char const * theSaveFileName;
-				theSaveFileName = tinyfd_saveFileDialog ("SHIVA Models", filename.c_str(), 1, lFilterPatterns, NULL);
-
-				
-			if (theSaveFileName)
-			{
-				// User didn't cancel save operation
-
-				// This next bit is to trap if the .xml extension is missing - tinyfd appears to have no option for checking this.
-				
-				bool OKToSave = true;
-
-				std::string fileToSave;
-				fileToSave = theSaveFileName;
-
-				bool fileFound = false;
-
-				std::size_t found = fileToSave.find(".obj");
-				if (found == std::string::npos)
-				{
-					// If no .xml extension, add one
-					fileToSave = fileToSave + ".obj";			
-
-					// Now check to make sure the filename with .xml exists to prevent accidental overwriting
-					bool fileExists;
-					fileExists = boost::filesystem::exists( fileToSave );
-
-					if (fileExists)
-					{
-						fileFound - true;
-						if (tinyfd_messageBox("WARNING!", "Filename exists - overwrite?", "yesno", "warning", NULL) == 1)
-							// Yes  
-							OKToSave = true;
-						else
-							// No
-							OKToSave = false;
-					}
-				}			
-
-				if( OKToSave)
-				{
-					if( !boost::filesystem::exists( m_saveDir ) )
-					{
-						boost::filesystem::create_directory( m_saveDir );
-					}
-
-					// Set the current path and filename (for displaying on the main screen)
-					ShivaGUI::SharedPreferences *prefs = GetGUIManager()->GetProgSpecificOptions();
-					prefs->SetFullFilename(fileToSave);
-
-					tmpTree.SaveMesh(fileToSave, true, true);
-
-					// Palaver required to combine char and strings together so that they can be displayed as a char message in tinyfd_messageBox:
-					std::string strMessage = "Model successfully saved (with base and pole) as: " + fileToSave; 
-					const char *cstrMessage = strMessage.c_str();
-
-					tinyfd_messageBox("Information", cstrMessage, "ok", "info", NULL);
-
-//				m_showSaveConfirmation = true;
-//				m_saveTextCounter = 3.0f;
-				}
-			}
-			}
-
-//			RebuildTrees(); //do we need that?
+			ExportMesh( true, true, "with base and pole" );
 		}
 		else if( _view->GetID() == "PrintModel" )
 		{
 #ifdef _DEBUG
 			std::cout << "INFO: PrintActivity request to 3D print model without pole and base" << std::endl;
 #endif
-			VolumeTree::Tree tmpTree;
-			tmpTree.SetRoot( m_totemController->GetNodeTree() );
-			tinyfd_messageBox("Information", "About to check that the model is printable", "ok", "info", NULL);
-			if (!tmpTree.IsPrintable(false, false))
-			{
-				//TODO: handle that in the interface
-				std::cout << "ERROR: Model is not printable!" << std::endl;
-
-				tinyfd_messageBox("ERROR!", "Model is not printable!", "ok", "error", NULL);
-			}
-			else
-			{
-				// for meshes we use timestamp instead of increasing numbers
-				// subject to discussion with teachers
-				std::string extension = ".obj";
-				//
-				using namespace boost::posix_time;
-				ptime now = second_clock::universal_time();
-				static std::locale loc(std::cout.getloc(), new time_facet("%Y%m%d_%H%M%S"));
-				std::ostringstream ss;
-				ss.imbue(loc);
-				ss << now;
-				std::string filename = m_saveDir + m_saveName + ss.str() + extension;
-				
-				char const * lFilterPatterns[ 1 ] = { "*.obj" };
-
-				// Show save dialog
-				char const * theSaveFileName;
-				theSaveFileName = tinyfd_saveFileDialog ("SHIVA Models", filename.c_str(), 1, lFilterPatterns, NULL);
-
-
-			if (theSaveFileName)
-			{
-				// User didn't cancel save operation
-
-				// This next bit is to trap if the .xml extension is missing - tinyfd appears to have no option for checking this.
-				
-				bool OKToSave = true;
-
-				std::string fileToSave;
-				fileToSave = theSaveFileName;
-
-				bool fileFound = false;
-
-				std::size_t found = fileToSave.find(".obj");
-				if (found == std::string::npos)
-				{
-					// If no .xml extension, add one
-					fileToSave = fileToSave + ".obj";			
-
-					// Now check to make sure the filename with .xml exists to prevent accidental overwriting
-					bool fileExists;
-					fileExists = boost::filesystem::exists( fileToSave );
-
-					if (fileExists)
-					{
-						fileFound - true;
-						if (tinyfd_messageBox("WARNING!", "Filename exists - overwrite?", "yesno", "warning", NULL) == 1)
-							// Yes  
-							OKToSave = true;
-						else
-							// No
-							OKToSave = false;
-					}
-				}			
-
-				if( OKToSave)
-				{
-					if( !boost::filesystem::exists( m_saveDir ) )
-					{
-						boost::filesystem::create_directory( m_saveDir );
-					}
-
-					// Set the current path and filename (for displaying on the main screen)
-//					ShivaGUI::SharedPreferences *prefs = GetGUIManager()->GetProgSpecificOptions();
-//					prefs->SetFullFilename(fileToSave);
-
-					tmpTree.SaveMesh(fileToSave, false, false);
-
-					// Palaver required to combine char and strings together so that they can be displayed as a char message in tinyfd_messageBox
-					std::string strMessage = "Model successfully saved (without base or pole) as: " + fileToSave; 
-					const char *cstrMessage = strMessage.c_str();
-
-					tinyfd_messageBox("Information", cstrMessage, "ok", "info", NULL);
-//					tinyfd_messageBox("Information", "Model successfully saved as : " + filename.c_str() + " (without base or pole)", "ok", "info", NULL);
-
-		//				m_showSaveConfirmation = true;
-//				m_saveTextCounter = 3.0f;
-				}
-			}
-			}
-
-//			RebuildTrees(); //do we need that?
+			ExportMesh( false, false, "without base or pole" );
 		}
 		else if( _view->GetID() == "PrintBase" )
 		{
 #ifdef _DEBUG
 			std::cout << "INFO: PrintActivity request to 3D print model without pole and with base" << std::endl;
 #endif
-			VolumeTree::Tree tmpTree;
-			tmpTree.SetRoot( m_totemController->GetNodeTree() );
-			tinyfd_messageBox("Information", "About to check that the model is printable", "ok", "info", NULL);
-			if (!tmpTree.IsPrintable(false, true))
-			{
-				//TODO: handle that in the interface
-				std::cout << "ERROR: Model is not printable!" << std::endl;
-
-				tinyfd_messageBox("ERROR!", "Model is not printable!", "ok", "error", NULL);
-			}
-			else
-			{
-				// for meshes we use timestamp instead of increasing numbers
-				// subject to discussion with teachers
-
-				std::string extension = ".obj";
-				//
-				using namespace boost::posix_time;
-				ptime now = second_clock::universal_time();
-				static std::locale loc(std::cout.getloc(), new time_facet("%Y%m%d_%H%M%S"));
-				std::ostringstream ss;
-				ss.imbue(loc);
-				ss << now;
-				std::string filename = m_saveDir + m_saveName + ss.str() + extension;
-
-				char const * lFilterPatterns[ 1 ] = { "*.obj" };
-
-				// Show save dialog
-				char const * theSaveFileName;
-				theSaveFileName = tinyfd_saveFileDialog ("SHIVA Models", filename.c_str(), 1, lFilterPatterns, NULL);
-
-
-			if (theSaveFileName)
+			ExportMesh( false, true, "with base and without pole" );
+		}
+		else if( _view->GetID() == "BackButton" )
+		{
+			if( m_exportJob->IsBusy() )
 			{
-				// User didn't cancel save operation
-
-				// This next bit is to trap if the .xml extension is missing - tinyfd appears to have no option for checking this.
-				
-				bool OKToSave = true;
-
-				std::string fileToSave;
-				fileToSave = theSaveFileName;
-
-//				bool fileFound = false;
-
-				std::size_t found = fileToSave.find(".obj");
-				if (found == std::string::npos)
+				if( tinyfd_messageBox( "WARNING!", "A mesh is still being exported - cancel it and go back?", "yesno", "warning", NULL ) != 1 )
 				{
-					// If no .xml extension, add one
-					fileToSave = fileToSave + ".obj";			
-
-					// Now check to make sure the filename with .xml exists to prevent accidental overwriting
-					bool fileExists;
-					fileExists = boost::filesystem::exists( fileToSave );
-
-					if (fileExists)
-					{
-//						fileFound - true;
-						if (tinyfd_messageBox("WARNING!", "Filename exists - overwrite?", "yesno", "warning", NULL) == 1)
-							// Yes  
-							OKToSave = true;
-						else
-							// No
-							OKToSave = false;
-					}
-				}			
-
-				if( OKToSave )
-				{
-					if( !boost::filesystem::exists( m_saveDir ) )
-					{
-						boost::filesystem::create_directory( m_saveDir );
-					}
-
-					// Set the current path and filename (for displaying on the main screen)
-//					ShivaGUI::SharedPreferences *prefs = GetGUIManager()->GetProgSpecificOptions();
-//					prefs->SetFullFilename(fileToSave);
-
-					tmpTree.SaveMesh(fileToSave, false, true);
-
-					// Palaver required to combine char and strings together so that they can be displayed as a char message in tinyfd_messageBox
-					std::string strMessage = "Model successfully saved (with base and without pole) as: " + fileToSave; 
-					const char *cstrMessage = strMessage.c_str();
-
-					tinyfd_messageBox("Information", cstrMessage, "ok", "info", NULL);
-
-//				m_showSaveConfirmation = true;
-//				m_saveTextCounter = 3.0f;
+					return;
 				}
+				// The job is released when the activity is destroyed, without waiting for it
+				m_exportJob->Cancel();
 			}
-			}
-
-
-//			RebuildTrees(); //do we need that?
-		}
-		else if( _view->GetID() == "BackButton" )
-		{
 			m_totemController->ShowSelection( true );
 			Finish();
 		}
@@ -618,6 +366,48 @@ void PrintActivity::UtilityEventReceived( UtilityEventHandler *_handler, ShivaGU
 
 //----------------------------------------------------------------------------------
 
+void PrintActivity::OnUpdate( float _deltaTs )
+{
+	MeshExportJob::Stage stage = m_exportJob->GetStage();
+	if( stage != m_exportStage )
+	{
+		m_exportStage = stage;
+		if( stage == MeshExportJob::ANALYSING )
+		{
+			SetStatusText( "checking model (1/2)..." );
+		}
+		else if( stage == MeshExportJob::MESHING )
+		{
+			SetStatusText( "exporting mesh (2/2)..." );
+		}
+	}
+
+	MeshExportJob::Stage result;
+	std::string message;
+	if( m_exportJob->CollectResult( result, message ) )
+	{
+		m_exportStage = MeshExportJob::IDLE;
+		SetStatusText( "print or export" );
+
+		if( result == MeshExportJob::FINISHED )
+		{
+			message = "Model successfully saved (" + m_exportDescription + ") as: " + m_exportJob->GetFilename();
+			tinyfd_messageBox( "Information", message.c_str(), "ok", "info", NULL );
+		}
+		else if( result == MeshExportJob::FAILED )
+		{
+			std::cout << "ERROR: " << message << std::endl;
+			tinyfd_messageBox( "ERROR!", message.c_str(), "ok", "error", NULL );
+		}
+		else
+		{
+			tinyfd_messageBox( "Information", message.c_str(), "ok", "info", NULL );
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
 void PrintActivity::OnActivityResult( ShivaGUI::Bundle *_data )
 {
 	RebuildTrees();
@@ -625,6 +415,116 @@ void PrintActivity::OnActivityResult( ShivaGUI::Bundle *_data )
 
 //----------------------------------------------------------------------------------
 
+void PrintActivity::ExportMesh( bool _includePole, bool _includeBase, std::string _description )
+{
+	if( m_exportJob->IsBusy() )
+	{
+		if( tinyfd_messageBox( "WARNING!", "A mesh is already being exported - cancel it?", "yesno", "warning", NULL ) == 1 )
+		{
+			m_exportJob->Cancel();
+		}
+		return;
+	}
+
+	// The export tree is a copy of the model, so it can be meshed while the user carries on
+	VolumeTree::Tree tmpTree;
+	tmpTree.SetRoot( m_totemController->GetNodeTree() );
+	totemio::TotemNode *exportRoot = tmpTree.BuildPrintExportNode( _includePole, _includeBase );
+	if( exportRoot == NULL )
+	{
+		std::cout << "ERROR: Model is not printable!" << std::endl;
+		tinyfd_messageBox( "ERROR!", "Model is not printable!", "ok", "error", NULL );
+		return;
+	}
+
+	std::string fileToSave = ChooseMeshFilename();
+	if( fileToSave.empty() )
+	{
+		return;
+	}
+
+	if( !boost::filesystem::exists( m_saveDir ) )
+	{
+		boost::filesystem::create_directory( m_saveDir );
+	}
+
+	if( _includePole && _includeBase )
+	{
+		// Set the current path and filename (for displaying on the main screen)
+		ShivaGUI::SharedPreferences *prefs = GetGUIManager()->GetProgSpecificOptions();
+		prefs->SetFullFilename( fileToSave );
+	}
+
+	m_exportDescription = _description;
+	m_exportJob->Start( exportRoot, fileToSave, m_meshQuality );
+}
+
+//----------------------------------------------------------------------------------
+
+std::string PrintActivity::ChooseMeshFilename()
+{
+	// for meshes we use timestamp instead of increasing numbers
+	// subject to discussion with teachers
+	std::string extension = ".obj";
+	//
+	using namespace boost::posix_time;
+	ptime now = second_clock::universal_time();
+	static std::locale loc(std::cout.getloc(), new time_facet("%Y%m%d_%H%M%S"));
+	std::ostringstream ss;
+	ss.imbue(loc);
+	ss << now;
+	std::string filename = m_saveDir + m_saveName + ss.str() + extension;
+	char const * lFilterPatterns[ 1 ] = { "*.obj" };
+
+	// Show save dialog
+	char const * theSaveFileName;
+	theSaveFileName = tinyfd_saveFileDialog ("SHIVA Models", filename.c_str(), 1, lFilterPatterns, NULL);
+
+	if( !theSaveFileName )
+	{
+		// User cancelled save operation
+		return "";
+	}
+
+	// This next bit is to trap if the .obj extension is missing - tinyfd appears to have no option for checking this.
+	std::string fileToSave = theSaveFileName;
+
+	std::size_t found = fileToSave.find(".obj");
+	if (found == std::string::npos)
+	{
+		// If no .obj extension, add one
+		fileToSave = fileToSave + ".obj";
+
+		// Now check to make sure the filename with .obj exists to prevent accidental overwriting
+		if( boost::filesystem::exists( fileToSave ) )
+		{
+			if (tinyfd_messageBox("WARNING!", "Filename exists - overwrite?", "yesno", "warning", NULL) != 1)
+				// No
+				return "";
+		}
+	}
+
+	return fileToSave;
+}
+
+//----------------------------------------------------------------------------------
+
+void PrintActivity::SetStatusText( std::string _text )
+{
+	int numWindows = GetNumGUIControllers();
+	for( int i = 0; i < numWindows; i++ )
+	{
+		ShivaGUI::GUIController *guiController = GetGUIController( i );
+		ShivaGUI::TextView *titleTextView = dynamic_cast< ShivaGUI::TextView* >( guiController->GetResources()->GetViewFromID( "titleTextView" ) );
+		if( titleTextView != NULL )
+		{
+			titleTextView->SetText( _text, guiController->GetResources() );
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
 void PrintActivity::RebuildTrees()
 {
 	std::vector< std::pair< VolView*, ShivaGUI::GUIController* > >::iterator it;
@@ -498,14 +498,11 @@ bool SDFView::_load_volume_from_file(const std::string& i_filename, unsigned int
 	assert(i_volume_id<number_of_models);
 	assert(!i_filename.empty());
 
+	// The grid is a view of the mapped file, the texture is uploaded straight from it
 	sdf::discretized_field df;
-	sdf::binary_file_in filein(i_filename);
-	if (filein.is_open())
+	if (df.load(i_filename))
 	{
 		std::cout<<"INFO: Loading Volume to OpenGL: "<<i_filename<<std::endl;
-		df.unserialize(filein);
-		filein.close();
-
 
 		_volume_data[i_volume_id].update(df.grid());
 
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cfloat>
+
 #include "Totem/TotemController.h"
 #include "System/SharedPreferences.h"
 #include "GUIManager.h"
@@ -39,6 +42,8 @@ Totem::Controller::Controller()
 
 	m_blendAmount = 0.1f;
 
+	m_pickTimeBudget = 30;
+
 	RebuildPole();
 }
 
@@ -930,9 +935,14 @@ bool Totem::Controller::SelectIntersectingObject( float _originX, float _originY
 {
 	if( m_objectRoot != NULL )
 	{
-		Totem::Object *selection = NULL;
-		// This function will choose the intersecting object nearest the origin
-		m_objectRoot->SelectIntersectingObject( &selection, _originX, _originY, _originZ, _dirX, _dirY, _dirZ );
+		// Bounding boxes are loose for rotated or blended objects, so test the actual surfaces first
+		Totem::Object *selection = PickSurface( _originX, _originY, _originZ, _dirX, _dirY, _dirZ );
+
+		if( selection == NULL )
+		{
+			// This function will choose the object whose bounding box intersection is nearest the origin
+			m_objectRoot->SelectIntersectingObject( &selection, _originX, _originY, _originZ, _dirX, _dirY, _dirZ );
+		}
 
 		if( selection != NULL )
 		{
@@ -947,6 +957,165 @@ bool Totem::Controller::SelectIntersectingObject( float _originX, float _originY
 
 //----------------------------------------------------------------------------------
 
+namespace
+{
+	//----------------------------------------------------------------------------------
+	/// \brief Orders pick tree leaves by the centre of their bounds along one axis
+	//----------------------------------------------------------------------------------
+	template< typename NodeT >
+	struct PickCentreLess
+	{
+		PickCentreLess( unsigned int _axis ) : m_axis( _axis ) {}
+		bool operator()( const NodeT &_a, const NodeT &_b ) const
+		{
+			return ( _a.m_bounds[ 2 * m_axis ] + _a.m_bounds[ 2 * m_axis + 1 ] ) < ( _b.m_bounds[ 2 * m_axis ] + _b.m_bounds[ 2 * m_axis + 1 ] );
+		}
+		unsigned int m_axis;
+	};
+}
+
+//----------------------------------------------------------------------------------
+
+Totem::Object* Totem::Controller::PickSurface( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ )
+{
+	// One leaf per object on the pole
+	std::vector< PickNode > leaves;
+	for( Totem::Object *current = m_objectRoot; current != NULL; current = current->GetChild() )
+	{
+		if( current->IsValid() )
+		{
+			PickNode leaf;
+			current->GetBounds( &leaf.m_bounds[ 0 ], &leaf.m_bounds[ 1 ], &leaf.m_bounds[ 2 ], &leaf.m_bounds[ 3 ], &leaf.m_bounds[ 4 ], &leaf.m_bounds[ 5 ] );
+			leaf.m_left = leaf.m_right = -1;
+			leaf.m_object = current;
+			leaves.push_back( leaf );
+		}
+	}
+	if( leaves.empty() )
+	{
+		return NULL;
+	}
+
+	std::vector< PickNode > nodes;
+	nodes.reserve( 2 * leaves.size() );
+	int rootIndex = BuildPickTree( nodes, leaves, 0, ( unsigned int )leaves.size() );
+
+	float ray[ 6 ] = { _originX, _originY, _originZ, _dirX, _dirY, _dirZ };
+	unsigned int deadline = SDL_GetTicks() + m_pickTimeBudget;
+	Totem::Object *hitObject = NULL;
+	float hitDist = FLT_MAX;
+	bool timedOut = false;
+	TracePickTree( nodes, rootIndex, ray, deadline, &hitObject, hitDist, timedOut );
+
+#ifdef _DEBUG
+	if( timedOut )
+	{
+		std::cout << "INFO: Totem::Controller::PickSurface() ran out of time, hit so far: " << hitObject << std::endl;
+	}
+#endif
+
+	return hitObject;
+}
+
+//----------------------------------------------------------------------------------
+
+int Totem::Controller::BuildPickTree( std::vector< PickNode > &_nodes, std::vector< PickNode > &_leaves, unsigned int _begin, unsigned int _end )
+{
+	if( _end - _begin == 1 )
+	{
+		_nodes.push_back( _leaves[ _begin ] );
+		return ( int )_nodes.size() - 1;
+	}
+
+	PickNode node;
+	node.m_object = NULL;
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		node.m_bounds[ 2 * i ] = FLT_MAX;
+		node.m_bounds[ 2 * i + 1 ] = -FLT_MAX;
+	}
+	for( unsigned int leaf = _begin; leaf < _end; leaf++ )
+	{
+		for( unsigned int i = 0; i < 3; i++ )
+		{
+			node.m_bounds[ 2 * i ] = ( std::min )( node.m_bounds[ 2 * i ], _leaves[ leaf ].m_bounds[ 2 * i ] );
+			node.m_bounds[ 2 * i + 1 ] = ( std::max )( node.m_bounds[ 2 * i + 1 ], _leaves[ leaf ].m_bounds[ 2 * i + 1 ] );
+		}
+	}
+
+	// Split at the median along the longest axis
+	unsigned int axis = 0;
+	for( unsigned int i = 1; i < 3; i++ )
+	{
+		if( ( node.m_bounds[ 2 * i + 1 ] - node.m_bounds[ 2 * i ] ) > ( node.m_bounds[ 2 * axis + 1 ] - node.m_bounds[ 2 * axis ] ) )
+		{
+			axis = i;
+		}
+	}
+	unsigned int middle = ( _begin + _end ) / 2;
+	std::nth_element( _leaves.begin() + _begin, _leaves.begin() + middle, _leaves.begin() + _end, PickCentreLess< PickNode >( axis ) );
+
+	// Children are added after the parent so indices are stable
+	_nodes.push_back( node );
+	int nodeIndex = ( int )_nodes.size() - 1;
+	int left = BuildPickTree( _nodes, _leaves, _begin, middle );
+	int right = BuildPickTree( _nodes, _leaves, middle, _end );
+	_nodes[ nodeIndex ].m_left = left;
+	_nodes[ nodeIndex ].m_right = right;
+
+	return nodeIndex;
+}
+
+//----------------------------------------------------------------------------------
+
+void Totem::Controller::TracePickTree( const std::vector< PickNode > &_nodes, int _nodeIndex, const float *_ray, unsigned int _deadline, Totem::Object **_hitObject, float &_hitDist, bool &_timedOut )
+{
+	if( _timedOut )
+	{
+		return;
+	}
+
+	const PickNode &node = _nodes[ _nodeIndex ];
+	float tNear, tFar;
+	if( !Totem::Object::IntersectBox( node.m_bounds, _ray[ 0 ], _ray[ 1 ], _ray[ 2 ], _ray[ 3 ], _ray[ 4 ], _ray[ 5 ], tNear, tFar ) || ( tFar < 0.0f ) || ( tNear > _hitDist ) )
+	{
+		// Missed, behind us, or further away than something we've already hit
+		return;
+	}
+
+	if( node.m_object != NULL )
+	{
+		float dist = node.m_object->TraceSurface( _ray[ 0 ], _ray[ 1 ], _ray[ 2 ], _ray[ 3 ], _ray[ 4 ], _ray[ 5 ], tNear, ( std::min )( tFar, _hitDist ), _deadline, _timedOut );
+		if( ( dist >= 0.0f ) && ( dist < _hitDist ) )
+		{
+			*_hitObject = node.m_object;
+			_hitDist = dist;
+		}
+		return;
+	}
+
+	// Visit the child whose box we enter first, so the second can usually be skipped
+	float leftNear = FLT_MAX, rightNear = FLT_MAX;
+	if( !Totem::Object::IntersectBox( _nodes[ node.m_left ].m_bounds, _ray[ 0 ], _ray[ 1 ], _ray[ 2 ], _ray[ 3 ], _ray[ 4 ], _ray[ 5 ], leftNear, tFar ) )
+	{
+		leftNear = FLT_MAX;
+	}
+	if( !Totem::Object::IntersectBox( _nodes[ node.m_right ].m_bounds, _ray[ 0 ], _ray[ 1 ], _ray[ 2 ], _ray[ 3 ], _ray[ 4 ], _ray[ 5 ], rightNear, tFar ) )
+	{
+		rightNear = FLT_MAX;
+	}
+
+	int first = node.m_left, second = node.m_right;
+	if( rightNear < leftNear )
+	{
+		std::swap( first, second );
+	}
+	TracePickTree( _nodes, first, _ray, _deadline, _hitObject, _hitDist, _timedOut );
+	TracePickTree( _nodes, second, _ray, _deadline, _hitObject, _hitDist, _timedOut );
+}
+
+//----------------------------------------------------------------------------------
+
 void Totem::Controller::AddOperation( Totem::Operation *_inOp )
 {
 	// Operations are added/removed from the *front* of the list
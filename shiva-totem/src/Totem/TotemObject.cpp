@@ -1,3 +1,4 @@
+#include <SDL.h>
 #include "Totem/TotemObject.h"
 
 //----------------------------------------------------------------------------------
@@ -21,6 +22,9 @@ Totem::Object::Object( VolumeTree::Node *_mainNodeIn, unsigned int _nGUIControll
 	m_tx = m_ty = m_tz = 0.0f;
 	m_rx = m_ry = m_rz = 0.0f;
 	m_sx = m_sy = m_sz = 1.0f;
+
+	m_bboxZ = m_baseOffset = 0.0f;
+	m_bboxZValid = m_baseOffsetValid = m_boundsValid = false;
 }
 
 //----------------------------------------------------------------------------------
@@ -42,6 +46,9 @@ Totem::Object::Object( VolumeTree::Node *_mainNodeIn, VolumeTree::TransformNode
 	m_rx = m_ry = m_rz = 0.0f;
 	m_sx = m_sy = m_sz = 1.0f;
 
+	m_bboxZ = m_baseOffset = 0.0f;
+	m_bboxZValid = m_baseOffsetValid = m_boundsValid = false;
+
 	float junk;
 	// Retrieve translation, rotation and scale info from imported transform node
 	m_mainTransform->GetTransformParams( m_tx, m_ty, m_tz, 
@@ -109,6 +116,8 @@ void Totem::Object::ShiftOrder( bool _up, bool _swapOffsets )
 
 			// If old parent had a parent, that becomes our new parent
 			m_parent = grandparent;
+			// Our child has changed without going through SetChild()
+			InvalidateBaseOffset();
 			if( m_parent != NULL )
 			{
 				m_parent->SetChild( this );
@@ -161,6 +170,8 @@ void Totem::Object::ShiftOrder( bool _up, bool _swapOffsets )
 			// Child becomes parent
 			m_parent = m_child;
 			m_child = grandchild; // Put this here because setting children/parents causes rebuild of offsets which requires a valid child
+			// Our child has changed without going through SetChild()
+			InvalidateBaseOffset();
 			m_parent->SetChild( this );
 
 			// If old child had a child, that becomes our new child
@@ -219,6 +230,7 @@ Totem::Object* Totem::Object::GetRoot()
 VolumeTree::Node* Totem::Object::GetNodeTree( float _blendAmount )
 {
 	m_mainTransform->SetChild( m_mainNode );
+	m_boundsValid = false;
 
 	VolumeTree::Node *rootNode = m_mainTransform;
 
@@ -330,39 +342,84 @@ void Totem::Object::AddTranslationOffset( float _x, float _y, float _z, bool _ch
 
 float Totem::Object::GetBBoxZ()
 {
-	if( m_mainNode != NULL )
+	if( !m_bboxZValid )
 	{
-		float x, y, z;
-		m_mainNode->GetBoundSizes( &x, &y, &z );
-		return z;
+		m_bboxZ = 0.0f;
+		if( m_mainNode != NULL )
+		{
+			float x, y;
+			m_mainNode->GetBoundSizes( &x, &y, &m_bboxZ );
+		}
+		m_bboxZValid = true;
 	}
-	return 0.0f;
+	return m_bboxZ;
 }
 
 //----------------------------------------------------------------------------------
 
 float Totem::Object::GetBaseOffset()
 {
-	float total = GetBBoxZ();
-	if( m_child != NULL )
+	// Only walks down as far as the first object that's still valid
+	if( !m_baseOffsetValid )
 	{
-		total += m_child->GetBaseOffset();
+		m_baseOffset = GetBBoxZ();
+		if( m_child != NULL )
+		{
+			m_baseOffset += m_child->GetBaseOffset();
+		}
+		m_baseOffsetValid = true;
 	}
-	return total;
+	return m_baseOffset;
 }
 
 //----------------------------------------------------------------------------------
 
-void Totem::Object::RecalcOffsets()
+void Totem::Object::InvalidateBaseOffset()
+{
+	// Everything above us is stacked on top of our base offset
+	for( Totem::Object *current = this; current != NULL; current = current->m_parent )
+	{
+		current->m_baseOffsetValid = false;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void Totem::Object::InvalidateBounds()
+{
+	m_bboxZValid = false;
+	m_boundsValid = false;
+	InvalidateBaseOffset();
+	RecalcOffsetsUpward();
+}
+
+//----------------------------------------------------------------------------------
+
+void Totem::Object::UpdateStackedTranslation()
 {
 	m_tx = m_offsetX;
 	m_ty = m_offsetY;
 	m_tz = GetStackedPosition() + m_offsetZ;
 	UpdateTransform();
+}
 
-	if( m_child != NULL )
+//----------------------------------------------------------------------------------
+
+void Totem::Object::RecalcOffsets()
+{
+	for( Totem::Object *current = this; current != NULL; current = current->m_child )
 	{
-		m_child->RecalcOffsets();
+		current->UpdateStackedTranslation();
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void Totem::Object::RecalcOffsetsUpward()
+{
+	for( Totem::Object *current = this; current != NULL; current = current->m_parent )
+	{
+		current->UpdateStackedTranslation();
 	}
 }
 
@@ -376,13 +433,22 @@ float Totem::Object::GetStackedPosition()
 		z += m_child->GetBaseOffset();
 	}
 	
-	if( m_mainNode != NULL )
+	z += GetBBoxZ() * 0.5f;
+	return z;
+}
+
+//----------------------------------------------------------------------------------
+
+void Totem::Object::GetBounds( float *_minX, float *_maxX, float *_minY, float *_maxY, float *_minZ, float *_maxZ )
+{
+	if( !m_boundsValid )
 	{
-		float bx, by, bz;
-		m_mainNode->GetBoundSizes( &bx, &by, &bz );
-		z += bz * 0.5f;
+		m_mainTransform->GetBounds( &m_bounds[ 0 ], &m_bounds[ 1 ], &m_bounds[ 2 ], &m_bounds[ 3 ], &m_bounds[ 4 ], &m_bounds[ 5 ] );
+		m_boundsValid = true;
 	}
-	return z;
+	*_minX = m_bounds[ 0 ]; *_maxX = m_bounds[ 1 ];
+	*_minY = m_bounds[ 2 ]; *_maxY = m_bounds[ 3 ];
+	*_minZ = m_bounds[ 4 ]; *_maxZ = m_bounds[ 5 ];
 }
 
 //----------------------------------------------------------------------------------
@@ -396,43 +462,8 @@ float Totem::Object::SelectIntersectingObject( Totem::Object **_selection, float
 	}
 
 	// Do our collision test
-	float ourDist = 0.0f;
-	bool ourHit = false;
-
-	// Intersect ray with a box
-
-	//_mainTransform->SetChild(_mainNode);
-	float boxminX, boxminY, boxminZ, boxmaxX, boxmaxY, boxmaxZ;
-	m_mainTransform->GetBounds( &boxminX, &boxmaxX, &boxminY, &boxmaxY, &boxminZ, &boxmaxZ );
-
-	
-	#ifdef _DEBUG
-		std::cout << "INFO: Attempting selection, object bounds: minX " << boxminX << " maxX " << boxmaxX << std::endl;
-		std::cout << "INFO:                                      minY " << boxminY << " maxY " << boxmaxY << std::endl;
-		std::cout << "INFO:                                      minZ " << boxminZ << " maxZ " << boxmaxZ << std::endl;
-	#endif
-
-	// http://www.siggraph.org/education/materials/HyperGraph/raytrace/rtinter3.htm
-	// bool intersectBox(Ray r, float3 boxmin, float3 boxmax, float *tnear, float *tfar)
-	{
-		// compute intersection of ray with all six bbox planes
-		float invRX = 1.0f / _dirX; float invRY = 1.0f / _dirY; float invRZ = 1.0f / _dirZ;
-		float tbotX = invRX * ( boxminX - _originX ); float tbotY = invRY * ( boxminY - _originY ); float tbotZ = invRZ * ( boxminZ - _originZ );
-		float ttopX = invRX * ( boxmaxX - _originX ); float ttopY = invRY * ( boxmaxY - _originY ); float ttopZ = invRZ * ( boxmaxZ - _originZ );
-
-		// re-order intersections to find smallest and largest on each axis
-		float tminX = ( std::min )( ttopX, tbotX ); float tminY = ( std::min )( ttopY, tbotY ); float tminZ = ( std::min )( ttopZ, tbotZ );
-		float tmaxX = ( std::max )( ttopX, tbotX ); float tmaxY = ( std::max )( ttopY, tbotY ); float tmaxZ = ( std::max )( ttopZ, tbotZ );
-
-		// find the largest tmin and the smallest tmax
-		float largest_tmin = ( std::max )( ( std::max )( tminX, tminY ), ( std::max )( tminX, tminZ ) );
-		float smallest_tmax = ( std::min )( ( std::min )( tmaxX, tmaxY ), ( std::min )( tmaxX, tmaxZ ) );
-
-		ourDist = largest_tmin;
-		//*tfar = smallest_tmax;
-
-		ourHit = smallest_tmax > largest_tmin;
-	}
+	float ourDist = 0.0f, junk;
+	bool ourHit = IntersectBounds( _originX, _originY, _originZ, _dirX, _dirY, _dirZ, ourDist, junk );
 	
 	#ifdef _DEBUG
 		std::cout << "INFO: Attempting selection, object hit result " << ourHit << " distance " << ourDist << std::endl;
@@ -468,8 +499,113 @@ float Totem::Object::SelectIntersectingObject( Totem::Object **_selection, float
 
 //----------------------------------------------------------------------------------
 
+bool Totem::Object::IntersectBounds( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ, float &_tNear, float &_tFar )
+{
+	if( m_mainTransform == NULL )
+	{
+		return false;
+	}
+
+	float bounds[ 6 ];
+	GetBounds( &bounds[ 0 ], &bounds[ 1 ], &bounds[ 2 ], &bounds[ 3 ], &bounds[ 4 ], &bounds[ 5 ] );
+
+	#ifdef _DEBUG
+		std::cout << "INFO: Attempting selection, object bounds: minX " << bounds[ 0 ] << " maxX " << bounds[ 1 ] << std::endl;
+		std::cout << "INFO:                                      minY " << bounds[ 2 ] << " maxY " << bounds[ 3 ] << std::endl;
+		std::cout << "INFO:                                      minZ " << bounds[ 4 ] << " maxZ " << bounds[ 5 ] << std::endl;
+	#endif
+
+	return IntersectBox( bounds, _originX, _originY, _originZ, _dirX, _dirY, _dirZ, _tNear, _tFar );
+}
+
+//----------------------------------------------------------------------------------
+
+bool Totem::Object::IntersectBox( const float *_bounds, float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ, float &_tNear, float &_tFar )
+{
+	// http://www.siggraph.org/education/materials/HyperGraph/raytrace/rtinter3.htm
+	// bool intersectBox(Ray r, float3 boxmin, float3 boxmax, float *tnear, float *tfar)
+
+	// compute intersection of ray with all six bbox planes
+	float invRX = 1.0f / _dirX; float invRY = 1.0f / _dirY; float invRZ = 1.0f / _dirZ;
+	float tbotX = invRX * ( _bounds[ 0 ] - _originX ); float tbotY = invRY * ( _bounds[ 2 ] - _originY ); float tbotZ = invRZ * ( _bounds[ 4 ] - _originZ );
+	float ttopX = invRX * ( _bounds[ 1 ] - _originX ); float ttopY = invRY * ( _bounds[ 3 ] - _originY ); float ttopZ = invRZ * ( _bounds[ 5 ] - _originZ );
+
+	// re-order intersections to find smallest and largest on each axis
+	float tminX = ( std::min )( ttopX, tbotX ); float tminY = ( std::min )( ttopY, tbotY ); float tminZ = ( std::min )( ttopZ, tbotZ );
+	float tmaxX = ( std::max )( ttopX, tbotX ); float tmaxY = ( std::max )( ttopY, tbotY ); float tmaxZ = ( std::max )( ttopZ, tbotZ );
+
+	// find the largest tmin and the smallest tmax
+	_tNear = ( std::max )( ( std::max )( tminX, tminY ), ( std::max )( tminX, tminZ ) );
+	_tFar = ( std::min )( ( std::min )( tmaxX, tmaxY ), ( std::min )( tmaxX, tmaxZ ) );
+
+	return _tFar > _tNear;
+}
+
+//----------------------------------------------------------------------------------
+
+float Totem::Object::TraceSurface( float _originX, float _originY, float _originZ, float _dirX, float _dirY, float _dirZ, float _tNear, float _tFar, unsigned int _deadline, bool &_timedOut )
+{
+	_timedOut = false;
+	if( m_mainNode == NULL || m_mainTransform == NULL )
+	{
+		return -1.0f;
+	}
+
+	// The fields aren't distance fields (inside is positive, outside isn't scaled to distance),
+	// so we can't take sphere-tracing sized steps. Use the renderer's step instead (see VolView::CalcStepsize)
+	float bounds[ 6 ];
+	GetBounds( &bounds[ 0 ], &bounds[ 1 ], &bounds[ 2 ], &bounds[ 3 ], &bounds[ 4 ], &bounds[ 5 ] );
+	float maxDim = ( std::max )( ( std::max )( bounds[ 1 ] - bounds[ 0 ], bounds[ 3 ] - bounds[ 2 ] ), bounds[ 5 ] - bounds[ 4 ] );
+	float stepSize = maxDim / 170.0f;
+	if( stepSize <= 0.0f )
+	{
+		return -1.0f;
+	}
+
+	float t = ( std::max )( _tNear, 0.0f );
+	if( m_mainTransform->GetFunctionValue( _originX + t * _dirX, _originY + t * _dirY, _originZ + t * _dirZ ) >= 0.0f )
+	{
+		// Starting inside the surface
+		return t;
+	}
+
+	while( t < _tFar )
+	{
+		if( SDL_GetTicks() > _deadline )
+		{
+			_timedOut = true;
+			return -1.0f;
+		}
+
+		float tNext = ( std::min )( t + stepSize, _tFar );
+		if( m_mainTransform->GetFunctionValue( _originX + tNext * _dirX, _originY + tNext * _dirY, _originZ + tNext * _dirZ ) >= 0.0f )
+		{
+			// Crossed the surface, bisect to get a bit closer to it
+			float tOutside = t, tInside = tNext;
+			for( unsigned int i = 0; i < 8; i++ )
+			{
+				float tMid = 0.5f * ( tOutside + tInside );
+				if( m_mainTransform->GetFunctionValue( _originX + tMid * _dirX, _originY + tMid * _dirY, _originZ + tMid * _dirZ ) >= 0.0f )
+				{
+					tInside = tMid;
+				}
+				else
+				{
+					tOutside = tMid;
+				}
+			}
+			return tInside;
+		}
+		t = tNext;
+	}
+	return -1.0f;
+}
+
+//----------------------------------------------------------------------------------
+
 void  Totem::Object::UpdateTransform()
 {
+	m_boundsValid = false;
 	m_mainTransform->SetTransformParams( m_tx, m_ty, m_tz,
 										 m_rx, m_ry, m_rz,
 										 m_sx, m_sy, m_sz,
@@ -60,6 +60,8 @@
 //#endif  // _DEBUG
 
 #include <iostream>
+#include <sdf/profiler/recorder.hpp>
+
 #include <boost/program_options.hpp>
 
 #include "GUIManager.h"
@@ -106,12 +108,21 @@ struct ProgramOptions
 {
 	std::string profileDirectory;
 	std::string profileName;
+	std::string traceFile;
+	std::string meshInput;
+	std::string meshOutput;
+	unsigned int meshDepth;
 };
 //----------------------------------------------------------------------------------
 /// \brief Forward declaration of a function that will sort out our command-line options
 //----------------------------------------------------------------------------------
 
 bool GetOptions( ProgramOptions *_options, int _argc, char **_argv );
+//----------------------------------------------------------------------------------
+/// \brief Forward declaration of a function that meshes a model file without starting the GUI
+//----------------------------------------------------------------------------------
+
+bool ExportMesh( const ProgramOptions &_options );
 
 //----------------------------------------------------------------------------------
 
@@ -124,6 +135,10 @@ int main( int argc, char **argv )
 	if( !GetOptions( &options, argc, argv ) )
 		return 0;
 
+	// Meshing a model does not need the GUI
+	if( !options.meshInput.empty() )
+		return ExportMesh( options ) ? 0 : 1;
+
 
 	ShivaModelManager *modelManager = ShivaModelManager::Init( "Resources/Models/index.xml" );
 	ShivaGUI::GUIManager *mainGUIManager = new ShivaGUI::GUIManager( "SHIVA Totem Prototype 1b", "totem1b" );
@@ -216,8 +231,19 @@ currentModelNode->SetPrimKind("Torus");
 	mainGUIManager->RegisterActivityCreator( "NewProfileActivity", ShivaGUI::CreateNewProfileActivity::Factory );
 	mainGUIManager->RegisterViewCreator( "VolView", VolView::Factory );
 
+	// Only record the profiled scopes for a trace, an interactive session would keep adding them
+	sdf::profiler::recorder::instance().set_enabled( !options.traceFile.empty() );
+	sdf::profiler::recorder::instance().set_thread_name( "main" );
+
 	mainGUIManager->StartWithProfileChooser( "AssembleActivity", options.profileDirectory, options.profileName );
 
+	if( !options.traceFile.empty() )
+	{
+		sdf::profiler::recorder::instance().print_summary();
+		if( !sdf::profiler::recorder::instance().write_chrome_trace( options.traceFile ) )
+			std::cerr << "WARNING: could not write the trace to " << options.traceFile << std::endl;
+	}
+
 	Totem::Controller::UnInit();
 	Totem::CommandManager::UnInit();
 
@@ -249,9 +275,27 @@ bool GetOptions( ProgramOptions *_options, int _argc, char **_argv )
 		 boost::program_options::value< std::string >( &( _options->profileName ) )->default_value( "" ),
 		 "profile name" );
 
+	boost::program_options::options_description debugging( "Debugging options" );
+	debugging.add_options()
+		( "trace,t",
+		 boost::program_options::value< std::string >( &( _options->traceFile ) )->default_value( "" ),
+		 "write the profiled scopes to this file on exit, as a Chrome trace (chrome://tracing), and print their timings" );
+
+
+	boost::program_options::options_description mesh( "Mesh export options" );
+	mesh.add_options()
+		( "mesh,m",
+		 boost::program_options::value< std::string >( &( _options->meshInput ) )->default_value( "" ),
+		 "mesh this .xml or .vol model with the built-in extractor and exit without starting the GUI" )
+		( "mesh_output,o",
+		 boost::program_options::value< std::string >( &( _options->meshOutput ) )->default_value( "mesh.stl" ),
+		 "file the mesh is saved to, the extension picks the format (.stl or .obj)" )
+		( "mesh_depth",
+		 boost::program_options::value< unsigned int >( &( _options->meshDepth ) )->default_value( 8 ),
+		 "the finest grid has 2^depth cells along the longest side of the model" );
 
 	boost::program_options::options_description allOptions( "Allowed options" );
-	allOptions.add( generic ).add( profile );
+	allOptions.add( generic ).add( profile ).add( debugging ).add( mesh );
 
 	boost::program_options::variables_map variableMap;
 	boost::program_options::store( boost::program_options::parse_command_line( _argc, _argv, allOptions ), variableMap );
@@ -275,4 +319,27 @@ bool GetOptions( ProgramOptions *_options, int _argc, char **_argv )
 	return true;
 }
 
+//----------------------------------------------------------------------------------
+
+// brief This function loads the model given on the command line and saves its mesh, for scripts and build servers
+
+bool ExportMesh( const ProgramOptions &_options )
+{
+	VolumeTree::Tree tree;
+	if( !tree.Load( _options.meshInput.c_str() ) )
+	{
+		std::cerr << "ERROR: could not load the model " << _options.meshInput << std::endl;
+		return false;
+	}
+
+	if( !tree.ExtractMesh( _options.meshOutput, true, true, _options.meshDepth ) )
+	{
+		std::cerr << "ERROR: could not mesh " << _options.meshInput << " to " << _options.meshOutput << std::endl;
+		return false;
+	}
+
+	std::cout << "INFO: meshed " << _options.meshInput << " to " << _options.meshOutput << std::endl;
+	return true;
+}
+
 //----------------------------------------------------------------------------------
\ No newline at end of file
@@ -51,9 +51,15 @@ public:
 	//----------------------------------------------------------------------------------
 	/// \brief Function that recompiles the fragment shader for the new tree. 
 	/// Must be called if the tree has changed
+	/// Once a program exists the new one is compiled in the background: the previous
+	/// program keeps being drawn and is swapped out by Update() when the new one is ready
 	//----------------------------------------------------------------------------------
 	bool RebuildTree();
 	//----------------------------------------------------------------------------------
+	/// \brief Returns true while a rebuilt shader is still being compiled
+	//----------------------------------------------------------------------------------
+	bool IsRebuildPending() const { return m_pendingShader != NULL; }
+	//----------------------------------------------------------------------------------
 	/// \brief Draw method
 	//----------------------------------------------------------------------------------
 	void Draw();
@@ -412,6 +418,10 @@ protected:
 	//----------------------------------------------------------------------------------	
 	Shader* m_shader;
 	//----------------------------------------------------------------------------------
+	/// \brief Shader program for the rebuilt tree, still compiling. NULL if none
+	//----------------------------------------------------------------------------------
+	Shader* m_pendingShader;
+	//----------------------------------------------------------------------------------
 	/// \brief Vertex shader
 	//----------------------------------------------------------------------------------
 	std::string m_vertShaderString;
@@ -479,6 +489,20 @@ protected:
 	//----------------------------------------------------------------------------------
 	float** m_paramUniformData;
 	//----------------------------------------------------------------------------------
+	/// \brief List lengths matching m_shader while m_pendingShader is compiling, NULL otherwise
+	//----------------------------------------------------------------------------------
+	unsigned int *m_liveParamUniformListLengths;
+	//----------------------------------------------------------------------------------
+	/// \brief Uniform data matching m_shader while m_pendingShader is compiling, NULL otherwise
+	//----------------------------------------------------------------------------------
+	float** m_liveParamUniformData;
+	//----------------------------------------------------------------------------------
+	/// \brief Free uniform lists allocated by BuildParameterUniformLists()
+	/// \param [in] _listLengths
+	/// \param [in] _data
+	//----------------------------------------------------------------------------------
+	static void FreeParameterUniformLists( unsigned int *_listLengths, float **_data );
+	//----------------------------------------------------------------------------------
 	/// \brief Returns iterator from the parameters list
 	/// \param [in] _id Parameter ID
 	//----------------------------------------------------------------------------------
@@ -527,6 +551,10 @@ protected:
 	//----------------------------------------------------------------------------------
 	bool InitialiseShaders( std::string _vsFile, std::string _fsPartFile );
 	//----------------------------------------------------------------------------------
+	/// \brief Swaps in the pending shader if it has finished compiling
+	//----------------------------------------------------------------------------------
+	void PollPendingShader();
+	//----------------------------------------------------------------------------------
 	/// \brief Load matrices to shader
 	//----------------------------------------------------------------------------------
 	void LoadMatricesToShader();
@@ -86,6 +86,33 @@ public:
 	/// \brief Link shader program (need to do this to support GLSL 1.40)
 	//--------------------------------------------------------------------------------------
 	void link();
+	//--------------------------------------------------------------------------------------
+	/// \brief Submit both shaders and the program link without querying their status,
+	/// so the driver can carry on compiling while we keep rendering with another program.
+	/// Attribute locations must be bound between this and linkDeferred()
+	/// \param [in] _vsFile Vertex shader source
+	/// \param [in] _fsFile Fragment shader source
+	//--------------------------------------------------------------------------------------
+	void compileDeferred( std::string _vsFile, std::string _fsFile );
+	//--------------------------------------------------------------------------------------
+	/// \brief Submit the program link started with compileDeferred()
+	//--------------------------------------------------------------------------------------
+	void linkDeferred();
+	//--------------------------------------------------------------------------------------
+	/// \brief Returns true once the deferred compile and link can be queried without stalling.
+	/// Without GL_ARB_parallel_shader_compile this is always true
+	//--------------------------------------------------------------------------------------
+	bool isDeferredComplete() const;
+	//--------------------------------------------------------------------------------------
+	/// \brief Check the result of a deferred compile and link, marking the shader initialised
+	/// \return True if the program is ready to be bound
+	//--------------------------------------------------------------------------------------
+	bool finishDeferred();
+	//--------------------------------------------------------------------------------------
+	/// \brief Ask the driver to use as many compiler threads as it sees fit.
+	/// Needs a current context, does nothing if GL_ARB_parallel_shader_compile isn't there
+	//--------------------------------------------------------------------------------------
+	static void enableParallelCompile();
     //--------------------------------------------------------------------------------------
 	/// \brief Comparison operator overload
 	//--------------------------------------------------------------------------------------
@@ -121,11 +148,11 @@ private:
     //--------------------------------------------------------------------------------------
 	/// \brief Vertex shader filename
 	//--------------------------------------------------------------------------------------
-	const char* m_vsFileName;
+	std::string m_vsFileName;
 	//--------------------------------------------------------------------------------------
 	/// \brief Fragment shader filename
 	//--------------------------------------------------------------------------------------
-	const char* m_fsFileName;
+	std::string m_fsFileName;
 	//--------------------------------------------------------------------------------------
 	
 };
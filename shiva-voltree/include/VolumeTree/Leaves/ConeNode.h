@@ -64,6 +64,15 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		float GetFunctionValue( float _x, float _y, float _z );
 		//----------------------------------------------------------------------------------
+		/// \brief Bounds the function over a box, the R-intersections are increasing in both arguments
+		/// so the bounds of the infinite cone and of the caps give theirs
+		/// \param [in] _min Minimum corner of the box
+		/// \param [in] _max Maximum corner of the box
+		/// \param [out] _lower
+		/// \param [out] _upper
+		//----------------------------------------------------------------------------------
+		virtual void GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper );
+		//----------------------------------------------------------------------------------
 		/// \brief Returns a GLSL-compatible string for the function
 		/// \param [in] _callCache
 		/// \param [in] _samplePosStr
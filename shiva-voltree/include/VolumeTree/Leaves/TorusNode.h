@@ -64,6 +64,14 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		float GetFunctionValue( float _x, float _y, float _z );
 		//----------------------------------------------------------------------------------
+		/// \brief Range of the function over a box, written with the distance to the Y axis so each term appears once
+		/// \param [in] _min Minimum corner of the box
+		/// \param [in] _max Maximum corner of the box
+		/// \param [out] _lower
+		/// \param [out] _upper
+		//----------------------------------------------------------------------------------
+		virtual void GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper );
+		//----------------------------------------------------------------------------------
 		/// \brief Returns a GLSL-compatible string for the function
 		/// \param [in] _callCache
 		/// \param [in] _samplePosStr
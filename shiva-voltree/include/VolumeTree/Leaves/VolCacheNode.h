@@ -12,20 +12,33 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include "VolumeTree/Node.h"
+#include <sdf/discretization/grid.hpp>
 
 namespace totemio
 {
 	class CacheNode;
 }
 
+namespace sdf
+{
+	template< typename T, typename Lookup > class signed_distance_field_from_mesh;
+	class wide_bvh_accelerated;
+}
+
 namespace VolumeTree
 {
 	class VolCacheNode : public Node
 	{
 	public:
 
+		//----------------------------------------------------------------------------------
+		/// \brief Distance field of a mesh, imported without going through a file
+		//----------------------------------------------------------------------------------
+		typedef sdf::signed_distance_field_from_mesh< float, sdf::wide_bvh_accelerated > MeshFunction;
+
 		//----------------------------------------------------------------------------------
 		/// \brief Default ctor
 		//----------------------------------------------------------------------------------
@@ -41,6 +54,12 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		VolCacheNode( totemio::CacheNode* _nodeIn );
 		//----------------------------------------------------------------------------------
+		/// \brief Ctor passing the distance field of a mesh, the node takes ownership of it.
+		///        Its lookup is built once here, without the .bvh/.awn files of the mesh, the cache is voxelised from it whenever SetUseCache asks for a resolution
+		/// \param [in] _meshFunction Not initialised yet
+		//----------------------------------------------------------------------------------
+		VolCacheNode( MeshFunction* _meshFunction );
+		//----------------------------------------------------------------------------------
 		/// \brief Dtor
 		//----------------------------------------------------------------------------------
 		virtual ~VolCacheNode();
@@ -50,13 +69,23 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		virtual std::string GetNodeType() { return "VolCacheNode"; }
 		//----------------------------------------------------------------------------------
-		/// \brief Samples the function at a specific point
+		/// \brief Samples the function at a specific point, trilinear filtering of the cache like the GPU,
+		///        or the exact distance for a mesh
 		/// \param [in] _x
 		/// \param [in] _y
 		/// \param [in] _z
 		//----------------------------------------------------------------------------------
 		float GetFunctionValue( float _x, float _y, float _z );
 		//----------------------------------------------------------------------------------
+		/// \brief Bounds the function over a box. The distance to a mesh changes no faster than the position,
+		/// the filtered cache stays between the samples around the box
+		/// \param [in] _min Minimum corner of the box
+		/// \param [in] _max Maximum corner of the box
+		/// \param [out] _lower
+		/// \param [out] _upper
+		//----------------------------------------------------------------------------------
+		virtual void GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper );
+		//----------------------------------------------------------------------------------
 		/// \brief Returns a GLSL-compatible string for the function
 		/// \param [in] _callCache
 		/// \param [in] _samplePosStr
@@ -99,6 +128,10 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		totemio::CacheNode *m_volCacheNode;
 		//----------------------------------------------------------------------------------
+		/// \brief Distance field of the mesh, NULL for the other sources
+		//----------------------------------------------------------------------------------
+		MeshFunction *m_meshFunction;
+		//----------------------------------------------------------------------------------
 		/// \brief Minimum X boundary
 		//----------------------------------------------------------------------------------
 		float m_boundsMinX;
@@ -145,6 +178,27 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		float SampleCacheFunction( unsigned int _x, unsigned int _y, unsigned int _z );
 		//----------------------------------------------------------------------------------
+		/// \brief Returns true if the file is a compressed .cbf field rather than a VOL file
+		//----------------------------------------------------------------------------------
+		bool IsCompressedFile() const;
+		//----------------------------------------------------------------------------------
+		/// \brief Decodes the .cbf file and resamples it (trilinear) at the cache resolution into m_sampledCache
+		//----------------------------------------------------------------------------------
+		bool LoadCompressedCache();
+		//----------------------------------------------------------------------------------
+		/// \brief Samples the mesh distance field on all cores at the cache resolution into m_sampledCache,
+		///        unless it is already at that resolution
+		//----------------------------------------------------------------------------------
+		bool SampleMeshCache();
+		//----------------------------------------------------------------------------------
+		/// \brief Cache built from a .cbf file or a mesh, m_cachedFunction points to it
+		//----------------------------------------------------------------------------------
+		std::vector< float > m_sampledCache;
+		//----------------------------------------------------------------------------------
+		/// \brief View of m_cachedFunction, sampled with the same filtering as the cache texture
+		//----------------------------------------------------------------------------------
+		sdf::grid m_cacheGrid;
+		//----------------------------------------------------------------------------------
 
 	};
 }
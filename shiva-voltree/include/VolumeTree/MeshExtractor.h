@@ -0,0 +1,189 @@
+///-----------------------------------------------------------------------------------------------
+/// \file MeshExtractor.h
+/// \brief Extracts a triangle mesh from a node tree without going through vol_totem
+/// Uses dual contouring over a sparse octree: only octree cells that may contain the surface are refined,
+/// so the cost follows the surface area of the model rather than its bounding volume
+/// \author Michelle Wu
+/// \version 1.0
+///-----------------------------------------------------------------------------------------------
+
+#ifndef MESHEXTRACTOR_H_
+#define MESHEXTRACTOR_H_
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "VolumeTree/Node.h"
+
+namespace VolumeTree
+{
+	class MeshExtractor
+	{
+	public:
+
+		//----------------------------------------------------------------------------------
+		/// \brief Ctor
+		/// \param [in] _root Root of the tree to mesh. The tree must not change while extracting
+		//----------------------------------------------------------------------------------
+		MeshExtractor( Node *_root );
+		//----------------------------------------------------------------------------------
+		/// \brief Sets the resolution, the finest grid has 2^_depth cells along the longest side of the model
+		/// \param [in] _depth Clamped to [ 3, 10 ]
+		//----------------------------------------------------------------------------------
+		void SetDepth( unsigned int _depth );
+		//----------------------------------------------------------------------------------
+		/// \brief Sets the number of worker threads, 0 uses all cores
+		/// \param [in] _numThreads
+		//----------------------------------------------------------------------------------
+		void SetNumThreads( unsigned int _numThreads ) { m_numThreads = _numThreads; }
+		//----------------------------------------------------------------------------------
+		/// \brief Builds the mesh. Returns false if the tree has no usable bounds or no surface was found
+		//----------------------------------------------------------------------------------
+		bool Extract();
+		//----------------------------------------------------------------------------------
+		/// \brief Returns vertex positions, three floats per vertex
+		//----------------------------------------------------------------------------------
+		const std::vector< float >& GetVertices() { return m_vertices; }
+		//----------------------------------------------------------------------------------
+		/// \brief Returns triangles, three vertex indices per triangle, wound counter-clockwise seen from outside
+		//----------------------------------------------------------------------------------
+		const std::vector< unsigned int >& GetTriangles() { return m_triangles; }
+		//----------------------------------------------------------------------------------
+		/// \brief Saves the mesh, the format is chosen from the extension (.stl or .obj)
+		/// \param [in] _filename
+		//----------------------------------------------------------------------------------
+		bool Save( std::string _filename );
+		//----------------------------------------------------------------------------------
+		/// \brief Saves the mesh as a Wavefront .obj file
+		/// \param [in] _filename
+		//----------------------------------------------------------------------------------
+		bool SaveOBJ( std::string _filename );
+		//----------------------------------------------------------------------------------
+		/// \brief Saves the mesh as a binary .stl file
+		/// \param [in] _filename
+		//----------------------------------------------------------------------------------
+		bool SaveSTL( std::string _filename );
+		//----------------------------------------------------------------------------------
+		/// \brief Required for boost::thread. Each worker takes octree cells from the queue until it is empty
+		//----------------------------------------------------------------------------------
+		void ThreadProcess( unsigned int _threadID );
+		//----------------------------------------------------------------------------------
+
+	protected:
+
+		//----------------------------------------------------------------------------------
+		/// \brief Octree cell, in units of the finest grid
+		//----------------------------------------------------------------------------------
+		struct OctreeCell
+		{
+			unsigned int m_min[ 3 ];
+			unsigned int m_size;
+		};
+		//----------------------------------------------------------------------------------
+		/// \brief What one worker produced. Vertices are keyed by the grid cell they belong to,
+		/// quads by the four cells around the crossed edge, so results can be welded afterwards
+		//----------------------------------------------------------------------------------
+		struct WorkerOutput
+		{
+			std::vector< unsigned int > m_vertexKeys;
+			std::vector< float > m_vertexPositions;
+			std::vector< unsigned int > m_quads;
+		};
+		//----------------------------------------------------------------------------------
+		/// \brief Works out the grid from the bounds of the tree
+		//----------------------------------------------------------------------------------
+		bool InitGrid();
+		//----------------------------------------------------------------------------------
+		/// \brief Returns false if the range of the field over the cell proves it does not contain the surface
+		/// \param [in] _cell
+		//----------------------------------------------------------------------------------
+		bool MayContainSurface( const OctreeCell &_cell );
+		//----------------------------------------------------------------------------------
+		/// \brief Refines a cell down to brick size, pruning empty children
+		/// \param [in] _cell
+		/// \param [out] _output
+		//----------------------------------------------------------------------------------
+		void ProcessCell( const OctreeCell &_cell, WorkerOutput &_output );
+		//----------------------------------------------------------------------------------
+		/// \brief Samples a brick of the finest grid and emits a quad for each edge the surface crosses
+		/// \param [in] _cell
+		/// \param [out] _output
+		//----------------------------------------------------------------------------------
+		void ProcessBrick( const OctreeCell &_cell, WorkerOutput &_output );
+		//----------------------------------------------------------------------------------
+		/// \brief Places the vertex of a grid cell on the surface
+		/// \param [in] _values Corner values of the cell, in the usual x fastest order
+		/// \param [in] _cellMin Position of the cell's minimum corner
+		/// \param [out] _position
+		//----------------------------------------------------------------------------------
+		void PlaceCellVertex( const float *_values, const float *_cellMin, float *_position );
+		//----------------------------------------------------------------------------------
+		/// \brief Welds the workers' results into one indexed mesh
+		//----------------------------------------------------------------------------------
+		void MergeOutputs();
+		//----------------------------------------------------------------------------------
+		/// \brief Field value at a point
+		//----------------------------------------------------------------------------------
+		float GetValue( float _x, float _y, float _z ) { return m_root->GetFunctionValue( _x, _y, _z ); }
+		//----------------------------------------------------------------------------------
+		/// \brief Root of the tree
+		//----------------------------------------------------------------------------------
+		Node *m_root;
+		//----------------------------------------------------------------------------------
+		/// \brief The finest grid has 2^m_depth cells per side
+		//----------------------------------------------------------------------------------
+		unsigned int m_depth;
+		//----------------------------------------------------------------------------------
+		/// \brief Finest grid cells per side
+		//----------------------------------------------------------------------------------
+		unsigned int m_gridSize;
+		//----------------------------------------------------------------------------------
+		/// \brief Finest grid cells per side of a brick
+		//----------------------------------------------------------------------------------
+		unsigned int m_brickSize;
+		//----------------------------------------------------------------------------------
+		/// \brief Number of worker threads, 0 for all cores
+		//----------------------------------------------------------------------------------
+		unsigned int m_numThreads;
+		//----------------------------------------------------------------------------------
+		/// \brief Position of grid vertex ( 0, 0, 0 )
+		//----------------------------------------------------------------------------------
+		float m_origin[ 3 ];
+		//----------------------------------------------------------------------------------
+		/// \brief Size of a finest grid cell
+		//----------------------------------------------------------------------------------
+		float m_cellSize;
+		//----------------------------------------------------------------------------------
+		/// \brief Octree cells waiting for a worker
+		//----------------------------------------------------------------------------------
+		std::vector< OctreeCell > m_queue;
+		//----------------------------------------------------------------------------------
+		/// \brief Next queue entry to hand out
+		//----------------------------------------------------------------------------------
+		unsigned int m_queueNext;
+		//----------------------------------------------------------------------------------
+		/// \brief Queue mutex
+		//----------------------------------------------------------------------------------
+		boost::mutex m_queueMtx;
+		//----------------------------------------------------------------------------------
+		/// \brief One output per worker
+		//----------------------------------------------------------------------------------
+		std::vector< WorkerOutput > m_outputs;
+		//----------------------------------------------------------------------------------
+		/// \brief Welded vertex positions
+		//----------------------------------------------------------------------------------
+		std::vector< float > m_vertices;
+		//----------------------------------------------------------------------------------
+		/// \brief Welded triangles
+		//----------------------------------------------------------------------------------
+		std::vector< unsigned int > m_triangles;
+		//----------------------------------------------------------------------------------
+
+	};
+}
+
+#endif
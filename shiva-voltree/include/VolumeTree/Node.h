@@ -64,6 +64,16 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		virtual float GetFunctionValue( float _x, float _y, float _z ) = 0;
 		//----------------------------------------------------------------------------------
+		/// \brief Bounds the function over a box, so the regions the surface cannot go through can be skipped
+		/// The range must hold the function at every point of the box, it does not have to be tight.
+		/// The default range is infinite, a node which cannot bound its function is never skipped
+		/// \param [in] _min Minimum corner of the box
+		/// \param [in] _max Maximum corner of the box
+		/// \param [out] _lower Lower bound of the function over the box
+		/// \param [out] _upper Upper bound of the function over the box
+		//----------------------------------------------------------------------------------
+		virtual void GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper );
+		//----------------------------------------------------------------------------------
 		/// \brief Returns a GLSL-compatible string for the function
 		/// Cached nodes will give a cache instruction instead of a full subtree
 		/// Default behaviour is to call GetFunctionGLSLString() so nodes with children
@@ -361,6 +371,14 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		virtual void OnUpdateParameters( GLSLRenderer *_renderer ) {}
 		//----------------------------------------------------------------------------------
+		/// \brief Range of the square of a value in [ _lower, _upper ]
+		/// \param [in] _lower
+		/// \param [in] _upper
+		/// \param [out] _squareLower
+		/// \param [out] _squareUpper
+		//----------------------------------------------------------------------------------
+		static void SquareRange( float _lower, float _upper, float *_squareLower, float *_squareUpper );
+		//----------------------------------------------------------------------------------
 		/// \brief Shader for drawing outline of bounding boxes
 		//----------------------------------------------------------------------------------
 		Shader* m_bboxLinesShader;
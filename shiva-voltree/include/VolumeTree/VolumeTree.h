@@ -22,6 +22,8 @@ class GLSLRenderer;
 
 namespace VolumeTree
 {
+	class CSGNode;
+
 	class Tree
 	{
 	public:
@@ -71,6 +73,14 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		bool IsPrintable( bool bIncludePole = true, bool bIncludeBase = true);
 		//----------------------------------------------------------------------------------
+		/// \brief Builds the vol_totem tree that is analysed and meshed for printing
+		/// The returned tree is a copy, so it can be handed to another thread while the model is edited
+		/// \param [in] _includePole Flag to check if the pole is included
+		/// \param [in] _includeBase Flag to check if the base of the totem is included
+		/// \return NULL if the tree does not have the expected totem layout
+		//----------------------------------------------------------------------------------
+		totemio::TotemNode* BuildPrintExportNode( bool _includePole, bool _includeBase );
+		//----------------------------------------------------------------------------------
 		/// \brief Import model from .vol file
 		/// \param [in] _filename File name
 		//----------------------------------------------------------------------------------
@@ -83,8 +93,20 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		/// \brief Save .obj file function
 		/// \param [in] _filename File name
+		/// \param [in] bIncludePole Flag to check if the pole is included
+		/// \param [in] bIncludeBase Flag to check if the base of the totem is included
+		/// \param [in] _quality Mesh quality passed on to the vol_totem mesher, smaller values give a finer mesh
 		//----------------------------------------------------------------------------------
-		bool SaveMesh( std::string _filename, bool bIncludePole = true, bool bIncludeBase = true );
+		bool SaveMesh( std::string _filename, bool bIncludePole = true, bool bIncludeBase = true, float _quality = 0.01f );
+		//----------------------------------------------------------------------------------
+		/// \brief Save .stl or .obj file with the built-in extractor instead of vol_totem
+		/// \param [in] _filename File name, the extension picks the format
+		/// \param [in] bIncludePole Flag to check if the pole is included
+		/// \param [in] bIncludeBase Flag to check if the base of the totem is included
+		/// \param [in] _depth The finest grid has 2^_depth cells along the longest side of the model
+		/// \param [in] _numThreads Number of worker threads, 0 uses all cores
+		//----------------------------------------------------------------------------------
+		bool ExtractMesh( std::string _filename, bool bIncludePole = true, bool bIncludeBase = true, unsigned int _depth = 8, unsigned int _numThreads = 0 );
 		//----------------------------------------------------------------------------------
 		/// \brief Calculate bounding box
 		//----------------------------------------------------------------------------------
@@ -209,6 +231,14 @@ namespace VolumeTree
 		//----------------------------------------------------------------------------------
 		totemio::TotemNode* BuildExportNode( Node *currentNode );
 		//----------------------------------------------------------------------------------
+		/// \brief Finds the part of the totem to print
+		/// \param [in] _includePole Flag to check if the pole is included
+		/// \param [in] _includeBase Flag to check if the base of the totem is included
+		/// \param [in] _joinNode Used to join the model to the pole or base alone, so it must outlive the returned node
+		/// \return NULL if the tree does not have the expected totem layout
+		//----------------------------------------------------------------------------------
+		Node* GetPrintRootNode( bool _includePole, bool _includeBase, CSGNode &_joinNode );
+		//----------------------------------------------------------------------------------
 		/// \brief Export node tree as .xml file
 		/// \param [in] _currentNode
 		/// \param [in] _root Root element in the xml file 
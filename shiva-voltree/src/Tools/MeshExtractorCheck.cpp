@@ -0,0 +1,139 @@
+///-----------------------------------------------------------------------------------------------
+/// \file MeshExtractorCheck.cpp
+/// \brief Headless check of VolumeTree::MeshExtractor, for the build servers
+/// Meshes trees of primitives whose bounds are known and checks the mesh reaches them, which fails
+/// if the octree pruning drops a part of the surface. Each tree prints one line, the exit code is
+/// 0 when every tree passed, 1 otherwise
+///
+/// mesh_extractor_check [ output directory for the meshes ]
+///-----------------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "VolumeTree/MeshExtractor.h"
+#include "VolumeTree/Leaves/SphereNode.h"
+#include "VolumeTree/Leaves/CylinderNode.h"
+#include "VolumeTree/Nodes/CSG.h"
+#include "VolumeTree/Nodes/TransformNode.h"
+
+namespace
+{
+	//----------------------------------------------------------------------------------
+	/// \brief Resolution of the meshes, the finest grid has 2^MESH_DEPTH cells along the longest side
+	//----------------------------------------------------------------------------------
+	const unsigned int MESH_DEPTH = 7;
+
+	//----------------------------------------------------------------------------------
+	/// \brief Meshes a tree and checks the mesh is not empty and its bounds match the expected ones within two cells
+	/// \param [in] _name Printed with the result
+	/// \param [in] _root Root of the tree
+	/// \param [in] _expectedMin Expected minimum corner of the surface
+	/// \param [in] _expectedMax Expected maximum corner of the surface
+	/// \param [in] _outputDirectory If not empty the mesh is saved there as _name.obj
+	/// \return True if the check passed
+	//----------------------------------------------------------------------------------
+	bool CheckTree( const std::string &_name, VolumeTree::Node *_root, const float *_expectedMin, const float *_expectedMax, const std::string &_outputDirectory )
+	{
+		VolumeTree::MeshExtractor extractor( _root );
+		extractor.SetDepth( MESH_DEPTH );
+		bool extracted = extractor.Extract();
+
+		const std::vector< float > &vertices = extractor.GetVertices();
+		const std::vector< unsigned int > &triangles = extractor.GetTriangles();
+		unsigned int numVertices = ( unsigned int )vertices.size() / 3;
+
+		float meshMin[ 3 ] = { 0.0f, 0.0f, 0.0f };
+		float meshMax[ 3 ] = { 0.0f, 0.0f, 0.0f };
+		for( unsigned int v = 0; v < numVertices; v++ )
+		{
+			for( unsigned int i = 0; i < 3; i++ )
+			{
+				float value = vertices[ 3 * v + i ];
+				meshMin[ i ] = v ? ( std::min )( meshMin[ i ], value ) : value;
+				meshMax[ i ] = v ? ( std::max )( meshMax[ i ], value ) : value;
+			}
+		}
+
+		// The vertices are placed within their grid cell, the grid is sized from the longest side
+		float maxExtent = 0.0f;
+		for( unsigned int i = 0; i < 3; i++ )
+		{
+			maxExtent = ( std::max )( maxExtent, _expectedMax[ i ] - _expectedMin[ i ] );
+		}
+		float tolerance = 2.0f * maxExtent / ( float )( 1u << MESH_DEPTH );
+
+		bool passed = extracted && numVertices > 0 && !triangles.empty();
+		for( unsigned int i = 0; i < 3 && passed; i++ )
+		{
+			passed = fabs( meshMin[ i ] - _expectedMin[ i ] ) <= tolerance && fabs( meshMax[ i ] - _expectedMax[ i ] ) <= tolerance;
+		}
+
+		std::cout << ( passed ? "ok" : "FAILED" ) << " " << _name << ": " << numVertices << " vertices, " << triangles.size() / 3 << " triangles";
+		if( numVertices > 0 )
+		{
+			std::cout << ", bounds ( " << meshMin[ 0 ] << ", " << meshMin[ 1 ] << ", " << meshMin[ 2 ] << " ) to ( "
+				<< meshMax[ 0 ] << ", " << meshMax[ 1 ] << ", " << meshMax[ 2 ] << " )";
+		}
+		std::cout << std::endl;
+		if( !passed )
+		{
+			std::cout << "  expected ( " << _expectedMin[ 0 ] << ", " << _expectedMin[ 1 ] << ", " << _expectedMin[ 2 ] << " ) to ( "
+				<< _expectedMax[ 0 ] << ", " << _expectedMax[ 1 ] << ", " << _expectedMax[ 2 ] << " ) within " << tolerance << std::endl;
+		}
+
+		if( extracted && !_outputDirectory.empty() )
+		{
+			extractor.Save( _outputDirectory + "/" + _name + ".obj" );
+		}
+		return passed;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+	std::string outputDirectory = argc > 1 ? argv[ 1 ] : "";
+	bool passed = true;
+
+	// A lone sphere
+	{
+		VolumeTree::SphereNode sphere( 0.5f, 0.5f, 0.5f );
+		const float expectedMin[ 3 ] = { -0.5f, -0.5f, -0.5f };
+		const float expectedMax[ 3 ] = { 0.5f, 0.5f, 0.5f };
+		passed = CheckTree( "sphere", &sphere, expectedMin, expectedMax, outputDirectory ) && passed;
+	}
+
+	// A pole a few cells thick through a sphere: the pole is a small part of the model and must not be pruned
+	{
+		VolumeTree::SphereNode sphere( 0.4f, 0.4f, 0.4f );
+		VolumeTree::CylinderNode pole( 1.6f, 0.03f, 0.03f );
+		VolumeTree::CSGNode join;
+		join.SetChildA( &sphere );
+		join.SetChildB( &pole );
+		const float expectedMin[ 3 ] = { -0.4f, -0.4f, -0.8f };
+		const float expectedMax[ 3 ] = { 0.4f, 0.4f, 0.8f };
+		passed = CheckTree( "sphere_and_pole", &join, expectedMin, expectedMax, outputDirectory ) && passed;
+	}
+
+	// A pole under a cell thick, moved off the axis through a transform: a sampled estimate of the slope misses it
+	{
+		VolumeTree::SphereNode sphere( 0.4f, 0.4f, 0.4f );
+		VolumeTree::CylinderNode pole( 1.6f, 0.01f, 0.01f );
+		VolumeTree::TransformNode move( &pole );
+		move.GetTransformMatrix().identity();
+		cml::matrix_set_translation( move.GetTransformMatrix(), 0.02f, 0.02f, 0.0f );
+		VolumeTree::CSGNode join;
+		join.SetChildA( &sphere );
+		join.SetChildB( &move );
+		const float expectedMin[ 3 ] = { -0.4f, -0.4f, -0.8f };
+		const float expectedMax[ 3 ] = { 0.4f, 0.4f, 0.8f };
+		passed = CheckTree( "sphere_and_thin_pole", &join, expectedMin, expectedMax, outputDirectory ) && passed;
+	}
+
+	return passed ? 0 : 1;
+}
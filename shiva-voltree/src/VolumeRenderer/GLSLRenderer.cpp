@@ -3,6 +3,7 @@
 #endif
 
 #include "VolumeRenderer/GLSLRenderer.h"
+#include <sdf/profiler/scope.hpp>
 #include <cmath>
 
 
@@ -102,6 +103,11 @@ GLSLRenderer::GLSLRenderer( unsigned int _width, unsigned int _height )
 	m_paramIDCount = 0;
 	m_paramUniformListLengths = NULL;
 	m_paramUniformData = NULL;
+	m_liveParamUniformListLengths = NULL;
+	m_liveParamUniformData = NULL;
+
+	m_shader = NULL;
+	m_pendingShader = NULL;
 }
 
 //----------------------------------------------------------------------------------
@@ -110,10 +116,11 @@ GLSLRenderer::~GLSLRenderer()
 {
 	// This function clears the cache list
 	ReserveCaches( 0 );
-	delete [] m_paramUniformListLengths;
-	delete [] m_paramUniformData;
+	FreeParameterUniformLists( m_paramUniformListLengths, m_paramUniformData );
+	FreeParameterUniformLists( m_liveParamUniformListLengths, m_liveParamUniformData );
 	delete m_functionTree;
 	delete m_cam;
+	delete m_pendingShader;
 	delete m_shader;
 }
 
@@ -355,6 +362,8 @@ void GLSLRenderer::Draw( unsigned int _context )
 //----------------------------------------------------------------------------------
 void GLSLRenderer::Update( float _deltaTs )
 {
+	PollPendingShader();
+
 	float rotOffsetX = m_angularVelX * _deltaTs;
 	float rotOffsetY = m_angularVelY * _deltaTs;
 	float rotOffsetZ = m_angularVelZ * _deltaTs;
@@ -708,7 +717,10 @@ void GLSLRenderer::FillCache( unsigned int _cacheID, float* _data, unsigned int
 	glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
 	// Transfer data to OpenGL
-	glTexImage3D( GL_TEXTURE_3D, 0, GL_RGBA32F, _sizeX, _sizeY, _sizeZ, 0, GL_ALPHA, GL_FLOAT, _data );
+	{
+		SDF_PROFILE_SCOPE( "texture upload %ux%ux%u", _sizeX, _sizeY, _sizeZ )
+		glTexImage3D( GL_TEXTURE_3D, 0, GL_RGBA32F, _sizeX, _sizeY, _sizeZ, 0, GL_ALPHA, GL_FLOAT, _data );
+	}
 
 	glBindTexture( GL_TEXTURE_3D, 0 );
 
@@ -745,6 +757,9 @@ bool GLSLRenderer::InitialiseShaders( std::string _vsFile, std::string _fsPartFi
 	// Read in FRAGMENT SHADER (first part)
 	m_fragShaderString = m_shader->fileRead( _fsPartFile.c_str() );
 
+	// Later rebuilds are compiled in the background, let the driver use its own threads for that
+	Shader::enableParallelCompile();
+
 	return RebuildTree();
 }
 
@@ -752,6 +767,7 @@ bool GLSLRenderer::InitialiseShaders( std::string _vsFile, std::string _fsPartFi
 
 bool GLSLRenderer::RebuildTree()
 {
+	SDF_PROFILE_SCOPE( "shader rebuild" )
 	#ifdef _DEBUG
 	{
 		GLenum err = glGetError();
@@ -762,6 +778,17 @@ bool GLSLRenderer::RebuildTree()
 	}
 	#endif
 	
+	// If there is already a program on screen we keep drawing it while the new one compiles,
+	// so it must hang on to the uniform layout it was built with
+	bool deferCompile = ( m_shader != NULL ) && m_shader->isInit();
+	if( deferCompile && ( m_pendingShader == NULL ) )
+	{
+		m_liveParamUniformListLengths = m_paramUniformListLengths;
+		m_liveParamUniformData = m_paramUniformData;
+		m_paramUniformListLengths = NULL;
+		m_paramUniformData = NULL;
+	}
+
 	// Make sure the uniform lists are up to date
 	m_functionTree->UpdateParameters( this );
 	BuildParameterUniformLists();
@@ -786,16 +813,64 @@ bool GLSLRenderer::RebuildTree()
 		std::cout << "INFO: GLSLRenderer::RebuildTree(): function string for fragment shader is now: \n" << functionString << std::endl;
 	#endif
 
-	// Finally initialise our shader program
-	m_shader->init( m_vertShaderString, fullFragShaderString );
-	glBindAttribLocation( m_shader->getID(), 0, "vPosition" );
-	m_shader->link();
+	if( !deferCompile )
+	{
+		// Nothing to show until this is done, so compile it straight away
+		m_shader->init( m_vertShaderString, fullFragShaderString );
+		glBindAttribLocation( m_shader->getID(), 0, "vPosition" );
+		m_shader->link();
+
+		return true;
+	}
+
+	// Any rebuild still in flight is out of date now
+	delete m_pendingShader;
+
+	// Submit without waiting for the result, PollPendingShader() picks it up when it's ready
+	m_pendingShader = new Shader();
+	m_pendingShader->compileDeferred( m_vertShaderString, fullFragShaderString );
+	glBindAttribLocation( m_pendingShader->getID(), 0, "vPosition" );
+	m_pendingShader->linkDeferred();
 
 	return true;
 }
 
 //----------------------------------------------------------------------------------
 
+void GLSLRenderer::PollPendingShader()
+{
+	if( ( m_pendingShader == NULL ) || !m_pendingShader->isDeferredComplete() )
+	{
+		return;
+	}
+
+	SDF_PROFILE_SCOPE( "shader swap" )
+
+	if( m_pendingShader->finishDeferred() )
+	{
+		delete m_shader;
+		m_shader = m_pendingShader;
+
+		FreeParameterUniformLists( m_liveParamUniformListLengths, m_liveParamUniformData );
+	}
+	else
+	{
+		std::cerr << "ERROR: GLSLRenderer::PollPendingShader() rebuilt shader is invalid, keeping previous program" << std::endl;
+		delete m_pendingShader;
+
+		// Give the previous program its own uniform layout back
+		FreeParameterUniformLists( m_paramUniformListLengths, m_paramUniformData );
+		m_paramUniformListLengths = m_liveParamUniformListLengths;
+		m_paramUniformData = m_liveParamUniformData;
+	}
+
+	m_pendingShader = NULL;
+	m_liveParamUniformListLengths = NULL;
+	m_liveParamUniformData = NULL;
+}
+
+//----------------------------------------------------------------------------------
+
 unsigned int GLSLRenderer::GetNumUsedRawParameters()
 {
 	unsigned int paramSizeCount = 0;
@@ -1121,11 +1196,35 @@ std::string GLSLRenderer::GetParameterGLSLDeclaration()
 
 //----------------------------------------------------------------------------------
 
+void GLSLRenderer::FreeParameterUniformLists( unsigned int *_listLengths, float **_data )
+{
+	if( _data != NULL )
+	{
+		for( unsigned int i = 0; i < GetParameterTypeSize(); i++ )
+		{
+			delete [] _data[ i ];
+		}
+	}
+	delete [] _data;
+	delete [] _listLengths;
+}
+
+//----------------------------------------------------------------------------------
+
 void GLSLRenderer::BindParametersToGL()
 {
+	// While a rebuild is compiling, m_shader still expects the layout it was built with
+	unsigned int *listLengths = m_paramUniformListLengths;
+	float **uniformData = m_paramUniformData;
+	if( m_liveParamUniformListLengths != NULL )
+	{
+		listLengths = m_liveParamUniformListLengths;
+		uniformData = m_liveParamUniformData;
+	}
+
 	for( unsigned int currentUniformType = 0; currentUniformType < GetParameterTypeSize(); currentUniformType++ )
 	{
-		unsigned int numUniforms = m_paramUniformListLengths[ currentUniformType ];
+		unsigned int numUniforms = listLengths[ currentUniformType ];
 		if( numUniforms > 0 )
 		{
 			ParameterType currentType = static_cast< ParameterType >( currentUniformType );
@@ -1134,27 +1233,27 @@ void GLSLRenderer::BindParametersToGL()
 			{
 				if( currentType == FLOAT )
 				{
-					glUniform1fv( uniformLocation, numUniforms, m_paramUniformData[ currentUniformType ] );
+					glUniform1fv( uniformLocation, numUniforms, uniformData[ currentUniformType ] );
 				}
 				else if( currentType == VEC2 )
 				{
-					glUniform2fv( uniformLocation, numUniforms, m_paramUniformData[ currentUniformType ] );
+					glUniform2fv( uniformLocation, numUniforms, uniformData[ currentUniformType ] );
 				}
 				else if( currentType == VEC3 )
 				{
-					glUniform3fv( uniformLocation, numUniforms, m_paramUniformData[ currentUniformType ] );
+					glUniform3fv( uniformLocation, numUniforms, uniformData[ currentUniformType ] );
 				}
 				else if( currentType == VEC4 )
 				{
-					glUniform4fv( uniformLocation, numUniforms, m_paramUniformData[ currentUniformType ] );
+					glUniform4fv( uniformLocation, numUniforms, uniformData[ currentUniformType ] );
 				}
 				else if( currentType == MAT3 )
 				{
-					glUniformMatrix3fv( uniformLocation, numUniforms, false, m_paramUniformData[ currentUniformType ] );
+					glUniformMatrix3fv( uniformLocation, numUniforms, false, uniformData[ currentUniformType ] );
 				}
 				else if( currentType == MAT4 )
 				{
-					glUniformMatrix4fv( uniformLocation, numUniforms, false, m_paramUniformData[ currentUniformType ] );
+					glUniformMatrix4fv( uniformLocation, numUniforms, false, uniformData[ currentUniformType ] );
 				}
 			}
 		}
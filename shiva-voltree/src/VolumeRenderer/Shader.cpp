@@ -16,16 +16,16 @@ Shader::Shader( std::string _vsFile, std::string _fsFile ) : m_init( false ),
                                                              m_vs( 0 ),
                                                              m_fs( 0 )
 {
-	m_vsFileName = _vsFile.c_str();
-	m_fsFileName = _fsFile.c_str();
+	m_vsFileName = _vsFile;
+	m_fsFileName = _fsFile;
 }
 
 //------------------------------------------------------------------------------------
 
 void Shader::setFileNames( std::string _vsFile, std::string _fsFile )
 {
-	m_vsFileName = _vsFile.c_str();
-	m_fsFileName = _fsFile.c_str();
+	m_vsFileName = _vsFile;
+	m_fsFileName = _fsFile;
 }
 
 //------------------------------------------------------------------------------------
@@ -95,7 +95,7 @@ bool Shader::validateProgram( GLuint _program, GLuint _vs, GLuint _fs )
 
 void Shader::init( std::string _vsFile, std::string _fsFile )
 {
-    if( m_init ) { destroy(); }
+    destroy();
 
     // #1 Create a shader object
     // #2 Compile shader source into the object
@@ -117,14 +117,16 @@ void Shader::init( std::string _vsFile, std::string _fsFile )
 
     glCompileShader( m_vs );
     // Determine if the compilation was successful
-    if( !validateShader( m_vs, m_vsFileName ) ) {
+    if( !validateShader( m_vs, m_vsFileName.c_str() ) ) {
 		//std::cerr << "Vertex shader is not valid." << std::endl;
+        m_vs = 0;
         return;
     }
 
     glCompileShader( m_fs );
-    if( !validateShader( m_fs, m_fsFileName ) ) {
+    if( !validateShader( m_fs, m_fsFileName.c_str() ) ) {
 		//std::cerr << "Fragment shader is not valid." << std::endl;
+        m_fs = 0;
         return;
     }
 
@@ -153,20 +155,105 @@ void Shader::link()
 	glLinkProgram( m_id );
     if (!validateProgram( m_id, m_vs, m_fs ) ) {
 		//std::cerr << "Link failed." << std::endl;
+        m_id = m_vs = m_fs = 0;
         return;
     }
     m_init = true;
 }
 
+//--------------------------------------------------------------------------------------
+
+void Shader::compileDeferred( std::string _vsFile, std::string _fsFile )
+{
+    destroy();
+
+    m_vs = glCreateShader( GL_VERTEX_SHADER );
+    m_fs = glCreateShader( GL_FRAGMENT_SHADER );
+
+    const char* vsText = _vsFile.c_str();
+    const char* fsText = _fsFile.c_str();
+
+    glShaderSource( m_vs, 1, &vsText, NULL );
+    glShaderSource( m_fs, 1, &fsText, NULL );
+
+    // Don't query the compile status here, that's what would block until the driver is done
+    glCompileShader( m_vs );
+    glCompileShader( m_fs );
+
+    m_id = glCreateProgram();
+
+    glAttachShader( m_id, m_vs );
+    glAttachShader( m_id, m_fs );
+}
+
+//--------------------------------------------------------------------------------------
+
+void Shader::linkDeferred()
+{
+    glLinkProgram( m_id );
+}
+
+//--------------------------------------------------------------------------------------
+
+bool Shader::isDeferredComplete() const
+{
+    if( !GLEW_ARB_parallel_shader_compile || m_id == 0 )
+    {
+        // Nothing to poll, the status queries in finishDeferred() will wait if they have to
+        return true;
+    }
+    GLint isComplete = GL_FALSE;
+    glGetProgramiv( m_id, GL_COMPLETION_STATUS_ARB, &isComplete );
+    return isComplete == GL_TRUE;
+}
+
+//--------------------------------------------------------------------------------------
+
+bool Shader::finishDeferred()
+{
+    // The validate functions delete whatever failed, so forget about those IDs
+    if( !validateShader( m_vs, m_vsFileName.c_str() ) ) {
+        m_vs = 0;
+        destroy();
+        return false;
+    }
+    if( !validateShader( m_fs, m_fsFileName.c_str() ) ) {
+        m_fs = 0;
+        destroy();
+        return false;
+    }
+    if( !validateProgram( m_id, m_vs, m_fs ) ) {
+        m_id = m_vs = m_fs = 0;
+        return false;
+    }
+    m_init = true;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------
+
+void Shader::enableParallelCompile()
+{
+    if( GLEW_ARB_parallel_shader_compile )
+    {
+        // 0xFFFFFFFF lets the implementation pick the number of threads
+        glMaxShaderCompilerThreadsARB( 0xFFFFFFFF );
+    }
+}
+
 //------------------------------------------------------------------------------------
 
 void Shader::destroy()
 {
-    if( m_init )
+    if( m_init || m_id != 0 || m_vs != 0 || m_fs != 0 )
     {
-        glDetachShader( m_id, m_fs );
-        glDetachShader( m_id, m_vs );
+        if( m_id != 0 )
+        {
+            if( m_fs != 0 ) { glDetachShader( m_id, m_fs ); }
+            if( m_vs != 0 ) { glDetachShader( m_id, m_vs ); }
+        }
 
+        // Deleting name 0 is silently ignored
         glDeleteShader( m_fs );
         glDeleteShader( m_vs );
 
@@ -1,5 +1,14 @@
 #include "VolumeTree/Leaves/ConeNode.h"
 
+namespace
+{
+	// R-intersection: f1+f2-sqrt(f1^2+f2^2), increasing in both arguments
+	float RIntersect( float _f1, float _f2 )
+	{
+		return _f1 + _f2 - sqrt( _f1 * _f1 + _f2 * _f2 );
+	}
+}
+
 //----------------------------------------------------------------------------------
 
 VolumeTree::ConeNode::ConeNode()
@@ -43,6 +52,30 @@ float VolumeTree::ConeNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::ConeNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	float lowerZ = -m_length * 0.5f;
+	float upperZ = m_length * 0.5f;
+	float radius = m_radius * ( 1.0f / m_length );
+
+	float lower, upper;
+	SquareRange( _min[ 2 ] - upperZ, _max[ 2 ] - upperZ, &lower, &upper );
+	for( unsigned int i = 0; i < 2; i++ )
+	{
+		float a = _min[ i ] / radius;
+		float b = _max[ i ] / radius;
+		float squareLower, squareUpper;
+		SquareRange( ( std::min )( a, b ), ( std::max )( a, b ), &squareLower, &squareUpper );
+		lower -= squareUpper;
+		upper -= squareLower;
+	}
+
+	*_lower = RIntersect( RIntersect( lower, upperZ - _max[ 2 ] ), _min[ 2 ] - lowerZ );
+	*_upper = RIntersect( RIntersect( upper, upperZ - _min[ 2 ] ), _max[ 2 ] - lowerZ );
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::ConeNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr)
 {
 	std::stringstream functionString;
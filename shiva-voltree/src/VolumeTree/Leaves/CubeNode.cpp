@@ -45,6 +45,26 @@ float VolumeTree::CubeNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::CubeNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	// Same planes as GetFunctionValue, each one is lowest on the side of the box furthest inside
+	float half = m_lengthX * 0.5f;
+
+	float value = CSG_Intersect( half - _max[ 2 ], _min[ 2 ] + half );
+	value = CSG_Intersect( value, half - _max[ 1 ] );
+	value = CSG_Intersect( value, _min[ 1 ] + half );
+	value = CSG_Intersect( value, half - _max[ 0 ] );
+	*_lower = CSG_Intersect( value, _min[ 0 ] + half );
+
+	value = CSG_Intersect( half - _min[ 2 ], _max[ 2 ] + half );
+	value = CSG_Intersect( value, half - _min[ 1 ] );
+	value = CSG_Intersect( value, _max[ 1 ] + half );
+	value = CSG_Intersect( value, half - _min[ 0 ] );
+	*_upper = CSG_Intersect( value, _max[ 0 ] + half );
+}
+
+//----------------------------------------------------------------------------------
+
 float VolumeTree::CubeNode::CSG_Intersect( float _f1, float _f2 )
 {
 	return _f1 + _f2 - sqrt( pow( _f1, 2 ) + pow( _f2, 2 ) );
@@ -1,5 +1,14 @@
 #include "VolumeTree/Leaves/CylinderNode.h"
 
+namespace
+{
+	// R-intersection: f1+f2-sqrt(f1^2+f2^2), increasing in both arguments
+	float RIntersect( float _f1, float _f2 )
+	{
+		return _f1 + _f2 - sqrt( _f1 * _f1 + _f2 * _f2 );
+	}
+}
+
 //----------------------------------------------------------------------------------
 
 VolumeTree::CylinderNode::CylinderNode() : Node()
@@ -48,6 +57,28 @@ float VolumeTree::CylinderNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::CylinderNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	const float radii[ 2 ] = { m_radiusX, m_radiusY };
+	float lower = 1.0f, upper = 1.0f;
+	for( unsigned int i = 0; i < 2; i++ )
+	{
+		float a = _min[ i ] / radii[ i ];
+		float b = _max[ i ] / radii[ i ];
+		float squareLower, squareUpper;
+		SquareRange( ( std::min )( a, b ), ( std::max )( a, b ), &squareLower, &squareUpper );
+		lower -= squareUpper;
+		upper -= squareLower;
+	}
+
+	float lowerZ = -m_length * 0.5f;
+	float upperZ = m_length * 0.5f;
+	*_lower = RIntersect( RIntersect( lower, upperZ - _max[ 2 ] ), _min[ 2 ] - lowerZ );
+	*_upper = RIntersect( RIntersect( upper, upperZ - _min[ 2 ] ), _max[ 2 ] - lowerZ );
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::CylinderNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr )
 {
 	std::stringstream functionString;
@@ -38,6 +38,23 @@ float VolumeTree::SphereNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::SphereNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	const float radii[ 3 ] = { m_radiusX, m_radiusY, m_radiusZ };
+	*_lower = *_upper = 1.0f;
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		float a = _min[ i ] / radii[ i ];
+		float b = _max[ i ] / radii[ i ];
+		float squareLower, squareUpper;
+		SquareRange( ( std::min )( a, b ), ( std::max )( a, b ), &squareLower, &squareUpper );
+		*_lower -= squareUpper;
+		*_upper -= squareLower;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::SphereNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr )
 {
 	std::stringstream functionString;
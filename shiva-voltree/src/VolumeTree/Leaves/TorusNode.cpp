@@ -28,6 +28,24 @@ float VolumeTree::TorusNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::TorusNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	// With r the distance to the Y axis the function is circleRadius^2 - y^2 - ( r - sweepRadius )^2
+	float xLower, xUpper, yLower, yUpper, zLower, zUpper;
+	SquareRange( _min[ 0 ], _max[ 0 ], &xLower, &xUpper );
+	SquareRange( _min[ 1 ], _max[ 1 ], &yLower, &yUpper );
+	SquareRange( _min[ 2 ], _max[ 2 ], &zLower, &zUpper );
+
+	float ringLower, ringUpper;
+	SquareRange( sqrt( xLower + zLower ) - m_sweepRadius, sqrt( xUpper + zUpper ) - m_sweepRadius, &ringLower, &ringUpper );
+
+	float circle = m_circleRadius * m_circleRadius;
+	*_lower = circle - yUpper - ringUpper;
+	*_upper = circle - yLower - ringLower;
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::TorusNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr )
 {
 	std::stringstream functionString;
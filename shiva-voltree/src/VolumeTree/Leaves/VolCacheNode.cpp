@@ -2,6 +2,9 @@
 
 #include "vol_metamorph.h"
 #include "vol_totem.h"
+#include <sdf/discretization/brick_file.hpp>
+#include <sdf/discretization/discretized_field.hpp>
+#include <sdf/signed_distance_field_from_mesh.hpp>
 
 //----------------------------------------------------------------------------------
 
@@ -11,6 +14,7 @@ VolumeTree::VolCacheNode::VolCacheNode()
 	m_boundsMinX = m_boundsMaxX = m_boundsMinY = m_boundsMaxY = m_boundsMinZ = m_boundsMaxZ = 0.0f;
 	m_cachedFunction = NULL;
 	m_volCacheNode = NULL;
+	m_meshFunction = NULL;
 }
 
 //----------------------------------------------------------------------------------
@@ -18,6 +22,7 @@ VolumeTree::VolCacheNode::VolCacheNode()
 VolumeTree::VolCacheNode::VolCacheNode( totemio::CacheNode *_nodeIn )
 {
 	m_volCacheNode = _nodeIn;
+	m_meshFunction = NULL;
 	m_requiresCache = true;
 	m_boundsMinX = m_boundsMaxX = m_boundsMinY = m_boundsMaxY = m_boundsMinZ = m_boundsMaxZ = 0.0f;
 	m_cachedFunction = NULL;
@@ -50,15 +55,72 @@ VolumeTree::VolCacheNode::VolCacheNode( totemio::CacheNode *_nodeIn )
 
 //----------------------------------------------------------------------------------
 
+VolumeTree::VolCacheNode::VolCacheNode( MeshFunction *_meshFunction )
+{
+	m_volCacheNode = NULL;
+	m_meshFunction = _meshFunction;
+	m_requiresCache = true;
+	m_boundsMinX = m_boundsMaxX = m_boundsMinY = m_boundsMaxY = m_boundsMinZ = m_boundsMaxZ = 0.0f;
+	m_cachedFunction = NULL;
+
+	if( m_meshFunction == NULL )
+		return;
+	if( m_meshFunction->get_mesh().empty() )
+	{
+		std::cerr << "WARNING: Could not import an empty mesh" << std::endl;
+		delete m_meshFunction;
+		m_meshFunction = NULL;
+		return;
+	}
+
+	// The lookup serves every cache resolution and GetFunctionValue, it is only built once.
+	// It is built from the mesh alone: the .bvh/.awn files next to the mesh may be older than it
+	m_meshFunction->initialize_without_files();
+
+	// Enlarge bbox by 10% like the cache nodes, so the cache has a negative shell around the mesh
+	const sdf::aabb &box = m_meshFunction->get_box();
+	sdf::vector3d extent;
+	box.extent( &extent );
+	m_boundsMinX = box.minimum()[ 0 ] - extent[ 0 ] * 0.1f;
+	m_boundsMaxX = box.maximum()[ 0 ] + extent[ 0 ] * 0.1f;
+	m_boundsMinY = box.minimum()[ 1 ] - extent[ 1 ] * 0.1f;
+	m_boundsMaxY = box.maximum()[ 1 ] + extent[ 1 ] * 0.1f;
+	m_boundsMinZ = box.minimum()[ 2 ] - extent[ 2 ] * 0.1f;
+	m_boundsMaxZ = box.maximum()[ 2 ] + extent[ 2 ] * 0.1f;
+}
+
+//----------------------------------------------------------------------------------
+
 VolumeTree::VolCacheNode::VolCacheNode( std::string _filename )
 {
 	m_volCacheNode = NULL;
+	m_meshFunction = NULL;
 	m_requiresCache = true;
 	m_filename = _filename;
 	m_boundsMinX = m_boundsMaxX = m_boundsMinY = m_boundsMaxY = m_boundsMinZ = m_boundsMaxZ = 0.0f;
 	m_cachedFunction = NULL;
 	// Just get bounds for now
 
+	if( IsCompressedFile() )
+	{
+		// Only the header and the brick index are read here
+		sdf::brick_file file( _filename );
+		if( !file.is_open() )
+		{
+			std::cerr << "WARNING: Could not open CBF file: " << _filename << std::endl;
+		}
+		else
+		{
+			m_boundsMinX = file.minimum()[ 0 ];
+			m_boundsMaxX = file.maximum()[ 0 ];
+			m_boundsMinY = file.minimum()[ 1 ];
+			m_boundsMaxY = file.maximum()[ 1 ];
+			m_boundsMinZ = file.minimum()[ 2 ];
+			m_boundsMaxZ = file.maximum()[ 2 ];
+		}
+		return;
+	}
+
 	float *bounds = NULL;
 	float *data = NULL; //new float[27];
 
@@ -97,43 +159,82 @@ VolumeTree::VolCacheNode::~VolCacheNode()
 		totemio::freeTree( m_volCacheNode );
 		totemio::freePointer( &m_cachedFunction );
 	}
-	else if( m_cachedFunction != NULL )
+	else if( m_cachedFunction != NULL && m_sampledCache.empty() )
 	{
 		freePt( &m_cachedFunction );
 	}
+	delete m_meshFunction;
 }
 
 //----------------------------------------------------------------------------------
 
 float VolumeTree::VolCacheNode::GetFunctionValue( float _x, float _y, float _z )
 {
-	// TODO: use cached function
-	// Transform coords
+	// A mesh is exact, the cache only serves the GPU
+	if( m_meshFunction != NULL )
+		return -( *m_meshFunction )( _x, _y, _z );
+
+	if( m_cachedFunction == NULL || m_cacheGrid.num_elements() == 0 )
+		return -1.0f;
+
+	// Same texture coordinates as Cache() in the shader, and the same filtering as the cache texture
 	_x = ( _x + m_cacheOffsetX ) * m_cacheScaleX + 0.5f;
 	_y = ( _y + m_cacheOffsetY ) * m_cacheScaleY + 0.5f;
 	_z = ( _z + m_cacheOffsetZ ) * m_cacheScaleZ + 0.5f;
 
-	// TODO: tri-lerp
-	// For now, just use nearest filtering:
+	return -m_cacheGrid.sample( _x, _y, _z );
+}
 
-	_x = ( std::max )( _x, 0.0f );
-	_y = ( std::max )( _y, 0.0f );
-	_z = ( std::max )( _z, 0.0f );
+//----------------------------------------------------------------------------------
 
-	_x = ( std::min )( _x, 1.0f );
-	_y = ( std::min )( _y, 1.0f );
-	_z = ( std::min )( _z, 1.0f );
+void VolumeTree::VolCacheNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	if( m_meshFunction != NULL )
+	{
+		// Every point of the box is within half its diagonal of the centre
+		float radius = 0.5f * sqrt( ( _max[ 0 ] - _min[ 0 ] ) * ( _max[ 0 ] - _min[ 0 ] ) + ( _max[ 1 ] - _min[ 1 ] ) * ( _max[ 1 ] - _min[ 1 ] ) + ( _max[ 2 ] - _min[ 2 ] ) * ( _max[ 2 ] - _min[ 2 ] ) );
+		float centre = GetFunctionValue( 0.5f * ( _min[ 0 ] + _max[ 0 ] ), 0.5f * ( _min[ 1 ] + _max[ 1 ] ), 0.5f * ( _min[ 2 ] + _max[ 2 ] ) );
+		*_lower = centre - radius;
+		*_upper = centre + radius;
+		return;
+	}
 
-	_x = ( _x * ( float )m_cacheResX );
-	_y = ( _y * ( float )m_cacheResY );
-	_z = ( _z * ( float )m_cacheResZ );
+	if( m_cachedFunction == NULL || m_cacheGrid.num_elements() == 0 )
+	{
+		*_lower = *_upper = -1.0f;
+		return;
+	}
 
-	float scrap;
-	_x = modf( _x, &scrap ) < 0.5 ? floor( _x ) : ceil( _x );
-	_y = modf( _y, &scrap ) < 0.5 ? floor( _y ) : ceil( _y );
-	_z = modf( _z, &scrap ) < 0.5 ? floor( _z ) : ceil( _z );
+	// The samples the filtering can reach from the box, with the same texture coordinates as GetFunctionValue
+	const float offsets[ 3 ] = { m_cacheOffsetX, m_cacheOffsetY, m_cacheOffsetZ };
+	const float scales[ 3 ] = { m_cacheScaleX, m_cacheScaleY, m_cacheScaleZ };
+	const unsigned int sizes[ 3 ] = { m_cacheGrid.width(), m_cacheGrid.height(), m_cacheGrid.depth() };
+	unsigned int first[ 3 ], last[ 3 ];
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		float a = ( ( _min[ i ] + offsets[ i ] ) * scales[ i ] + 0.5f ) * ( float )sizes[ i ] - 0.5f;
+		float b = ( ( _max[ i ] + offsets[ i ] ) * scales[ i ] + 0.5f ) * ( float )sizes[ i ] - 0.5f;
+		float top = ( float )( sizes[ i ] - 1 );
+		first[ i ] = ( unsigned int )( std::min )( ( std::max )( floor( ( std::min )( a, b ) ), 0.0f ), top );
+		last[ i ] = ( unsigned int )( std::min )( ( std::max )( floor( ( std::max )( a, b ) ) + 1.0f, 0.0f ), top );
+	}
 
-	return SampleCacheFunction( ( unsigned int )_x, ( unsigned int )_y,( unsigned int )_z );
+	float lowest = m_cacheGrid( first[ 0 ], first[ 1 ], first[ 2 ] );
+	float highest = lowest;
+	for( unsigned int z = first[ 2 ]; z <= last[ 2 ]; z++ )
+	{
+		for( unsigned int y = first[ 1 ]; y <= last[ 1 ]; y++ )
+		{
+			for( unsigned int x = first[ 0 ]; x <= last[ 0 ]; x++ )
+			{
+				float value = m_cacheGrid( x, y, z );
+				lowest = ( std::min )( lowest, value );
+				highest = ( std::max )( highest, value );
+			}
+		}
+	}
+	*_lower = -highest;
+	*_upper = -lowest;
 }
 
 //----------------------------------------------------------------------------------
@@ -181,6 +282,20 @@ void VolumeTree::VolCacheNode::SetUseCache( bool _useCache, unsigned int _cacheI
 				std::cerr << "WARNING: Could not build cache from cache node: " << m_volCacheNode->getID() << std::endl;
 			}
 		}
+		else if( m_meshFunction != NULL )
+		{
+			if( !SampleMeshCache() )
+			{
+				std::cerr << "WARNING: Could not build cache from mesh at resolution " << m_cacheResX << "x" << m_cacheResY << "x" << m_cacheResZ << std::endl;
+			}
+		}
+		else if( IsCompressedFile() )
+		{
+			if( !LoadCompressedCache() )
+			{
+				std::cerr << "WARNING: Could not build cache from CBF file: " << m_filename << std::endl;
+			}
+		}
 		else if( !m_filename.empty() )
 		{
 
@@ -202,6 +317,10 @@ void VolumeTree::VolCacheNode::SetUseCache( bool _useCache, unsigned int _cacheI
 			}
 			freePt( &bounds );
 		}
+
+		// The samples are viewed, m_cachedFunction keeps owning them
+		if( m_cachedFunction != NULL )
+			m_cacheGrid.view( m_cacheResX, m_cacheResY, m_cacheResZ, m_cachedFunction, std::shared_ptr< const void >() );
 	}
 }
 
@@ -247,4 +366,108 @@ float VolumeTree::VolCacheNode::SampleCacheFunction( unsigned int _x, unsigned i
 	return -1.0f;
 }
 
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::VolCacheNode::IsCompressedFile() const
+{
+	return m_filename.size() > 4 && m_filename.compare( m_filename.size() - 4, 4, ".cbf" ) == 0;
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::VolCacheNode::LoadCompressedCache()
+{
+	m_cachedFunction = NULL;
+	m_sampledCache.clear();
+
+	sdf::brick_file file( m_filename );
+	sdf::grid samples;
+	if( !file.is_open() || !file.read( &samples ) )
+		return false;
+
+	// Cache sample i is at min + i * extent / res, like the caches built by Node::BuildCaches
+	const unsigned int resolution[ 3 ] = { m_cacheResX, m_cacheResY, m_cacheResZ };
+	std::vector< unsigned int > first[ 3 ];
+	std::vector< float > weight[ 3 ];
+	for( unsigned int axis = 0; axis < 3; axis++ )
+	{
+		const unsigned int size = file.size( axis );
+		first[ axis ].resize( resolution[ axis ] );
+		weight[ axis ].resize( resolution[ axis ] );
+		for( unsigned int i = 0; i < resolution[ axis ]; i++ )
+		{
+			const float position = ( float )i / ( float )resolution[ axis ] * ( float )( size - 1 );
+			first[ axis ][ i ] = ( std::min )( ( unsigned int )position, size > 1 ? size - 2 : 0 );
+			weight[ axis ][ i ] = size > 1 ? position - ( float )first[ axis ][ i ] : 0.0f;
+		}
+	}
+
+	m_sampledCache.resize( m_cacheResX * m_cacheResY * m_cacheResZ );
+	const unsigned int stepX = file.size( 0 ) > 1 ? 1 : 0;
+	const unsigned int stepY = file.size( 1 ) > 1 ? 1 : 0;
+	const unsigned int stepZ = file.size( 2 ) > 1 ? 1 : 0;
+	unsigned int index = 0;
+	for( unsigned int z = 0; z < m_cacheResZ; z++ )
+	{
+		const unsigned int k = first[ 2 ][ z ];
+		const float wz = weight[ 2 ][ z ];
+		for( unsigned int y = 0; y < m_cacheResY; y++ )
+		{
+			const unsigned int j = first[ 1 ][ y ];
+			const float wy = weight[ 1 ][ y ];
+			for( unsigned int x = 0; x < m_cacheResX; x++, index++ )
+			{
+				const unsigned int i = first[ 0 ][ x ];
+				const float wx = weight[ 0 ][ x ];
+				const float c00 = samples( i, j, k ) * ( 1.0f - wx ) + samples( i + stepX, j, k ) * wx;
+				const float c10 = samples( i, j + stepY, k ) * ( 1.0f - wx ) + samples( i + stepX, j + stepY, k ) * wx;
+				const float c01 = samples( i, j, k + stepZ ) * ( 1.0f - wx ) + samples( i + stepX, j, k + stepZ ) * wx;
+				const float c11 = samples( i, j + stepY, k + stepZ ) * ( 1.0f - wx ) + samples( i + stepX, j + stepY, k + stepZ ) * wx;
+				const float c0 = c00 * ( 1.0f - wy ) + c10 * wy;
+				const float c1 = c01 * ( 1.0f - wy ) + c11 * wy;
+				m_sampledCache[ index ] = c0 * ( 1.0f - wz ) + c1 * wz;
+			}
+		}
+	}
+
+	if( !m_sampledCache.empty() )
+		m_cachedFunction = &m_sampledCache[ 0 ];
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::VolCacheNode::SampleMeshCache()
+{
+	// Same resolution as the last call, the samples are still valid
+	if( m_cachedFunction != NULL && m_cacheGrid.width() == m_cacheResX && m_cacheGrid.height() == m_cacheResY && m_cacheGrid.depth() == m_cacheResZ )
+		return true;
+
+	m_cachedFunction = NULL;
+	m_sampledCache.clear();
+	if( m_cacheResX < 2 || m_cacheResY < 2 || m_cacheResZ < 2 )
+		return false;
+
+	SDF_PROFILE_SCOPE( "voxelise mesh %ux%ux%u", m_cacheResX, m_cacheResY, m_cacheResZ )
+	// Cache sample i is at min + i * extent / res, like the caches built by Node::BuildCaches,
+	// the field spans its samples so its maximum is one step short of the bounds
+	const sdf::point3d minimum( m_boundsMinX, m_boundsMinY, m_boundsMinZ );
+	const sdf::point3d maximum(
+		m_boundsMinX + ( m_boundsMaxX - m_boundsMinX ) * ( float )( m_cacheResX - 1 ) / ( float )m_cacheResX,
+		m_boundsMinY + ( m_boundsMaxY - m_boundsMinY ) * ( float )( m_cacheResY - 1 ) / ( float )m_cacheResY,
+		m_boundsMinZ + ( m_boundsMaxZ - m_boundsMinZ ) * ( float )( m_cacheResZ - 1 ) / ( float )m_cacheResZ );
+	sdf::discretized_field field( minimum, maximum, m_cacheResX, m_cacheResY, m_cacheResZ );
+
+	// Packets of 8 points need an even number of samples along every axis
+	if( m_cacheResX % 2 == 0 && m_cacheResY % 2 == 0 && m_cacheResZ % 2 == 0 )
+		field.fill_packets_mt( *m_meshFunction );
+	else
+		field.fill_mt( *m_meshFunction );
+
+	field.grid().copy_linear( &m_sampledCache );
+	if( !m_sampledCache.empty() )
+		m_cachedFunction = &m_sampledCache[ 0 ];
+	return m_cachedFunction != NULL;
+}
+
 //----------------------------------------------------------------------------------
\ No newline at end of file
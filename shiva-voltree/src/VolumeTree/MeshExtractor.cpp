@@ -0,0 +1,528 @@
+#include "VolumeTree/MeshExtractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace
+{
+	// The node ranges are computed in floats like the samples, a range this close to zero may still hold a sign change
+	const float RANGE_SLACK = 1e-5f;
+	// Empty finest cells kept around the model's bounds, so the surface never touches the grid's edge
+	const unsigned int GRID_MARGIN = 2;
+	// Bricks of 2^BRICK_DEPTH cells per side are sampled in one go instead of being refined further
+	const unsigned int BRICK_DEPTH = 3;
+}
+
+//----------------------------------------------------------------------------------
+
+VolumeTree::MeshExtractor::MeshExtractor( Node *_root )
+{
+	m_root = _root;
+	m_depth = 8;
+	m_gridSize = 0;
+	m_brickSize = 0;
+	m_numThreads = 0;
+	m_origin[ 0 ] = m_origin[ 1 ] = m_origin[ 2 ] = 0.0f;
+	m_cellSize = 0.0f;
+	m_queueNext = 0;
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::MeshExtractor::SetDepth( unsigned int _depth )
+{
+	m_depth = ( std::min )( ( std::max )( _depth, 3u ), 10u );
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::MeshExtractor::Extract()
+{
+	m_vertices.clear();
+	m_triangles.clear();
+
+	if( m_root == NULL || !InitGrid() )
+	{
+		std::cerr << "ERROR: VolumeTree::MeshExtractor given a tree without usable bounds" << std::endl;
+		return false;
+	}
+
+	unsigned int numThreads = m_numThreads;
+	if( numThreads == 0 )
+	{
+		numThreads = ( std::max )( boost::thread::hardware_concurrency(), 1u );
+	}
+
+	// Refine the top of the octree here until there is enough work to share between the threads
+	OctreeCell rootCell;
+	rootCell.m_min[ 0 ] = rootCell.m_min[ 1 ] = rootCell.m_min[ 2 ] = 0;
+	rootCell.m_size = m_gridSize;
+
+	m_queue.clear();
+	m_queue.push_back( rootCell );
+	while( !m_queue.empty() && m_queue.size() < 8 * numThreads && m_queue.front().m_size > m_brickSize )
+	{
+		std::vector< OctreeCell > children;
+		for( std::vector< OctreeCell >::iterator it = m_queue.begin(); it != m_queue.end(); ++it )
+		{
+			if( !MayContainSurface( *it ) )
+			{
+				continue;
+			}
+
+			unsigned int half = it->m_size / 2;
+			for( unsigned int i = 0; i < 8; i++ )
+			{
+				OctreeCell child;
+				child.m_min[ 0 ] = it->m_min[ 0 ] + ( ( i & 1 ) ? half : 0 );
+				child.m_min[ 1 ] = it->m_min[ 1 ] + ( ( i & 2 ) ? half : 0 );
+				child.m_min[ 2 ] = it->m_min[ 2 ] + ( ( i & 4 ) ? half : 0 );
+				child.m_size = half;
+				children.push_back( child );
+			}
+		}
+		m_queue.swap( children );
+	}
+
+	m_queueNext = 0;
+	m_outputs.assign( numThreads, WorkerOutput() );
+
+	boost::thread_group workers;
+	for( unsigned int i = 0; i < numThreads; i++ )
+	{
+		workers.create_thread( boost::bind( &MeshExtractor::ThreadProcess, this, i ) );
+	}
+	workers.join_all();
+
+	MergeOutputs();
+
+	m_outputs.clear();
+	m_queue.clear();
+
+#ifdef _DEBUG
+	std::cout << "INFO: VolumeTree::MeshExtractor extracted " << m_vertices.size() / 3 << " vertices, " << m_triangles.size() / 3 << " triangles at depth " << m_depth << " with " << numThreads << " threads" << std::endl;
+#endif
+
+	return !m_triangles.empty();
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::MeshExtractor::ThreadProcess( unsigned int _threadID )
+{
+	WorkerOutput &output = m_outputs[ _threadID ];
+
+	while( true )
+	{
+		m_queueMtx.lock();
+		if( m_queueNext >= m_queue.size() )
+		{
+			m_queueMtx.unlock();
+			return;
+		}
+		OctreeCell cell = m_queue[ m_queueNext++ ];
+		m_queueMtx.unlock();
+
+		ProcessCell( cell, output );
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::MeshExtractor::InitGrid()
+{
+	float bounds[ 6 ];
+	m_root->GetBounds( &bounds[ 0 ], &bounds[ 1 ], &bounds[ 2 ], &bounds[ 3 ], &bounds[ 4 ], &bounds[ 5 ] );
+
+	float maxExtent = 0.0f;
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		maxExtent = ( std::max )( maxExtent, bounds[ 2 * i + 1 ] - bounds[ 2 * i ] );
+	}
+	if( !( maxExtent > 0.0f ) )
+	{
+		return false;
+	}
+
+	m_gridSize = 1u << m_depth;
+	m_brickSize = 1u << ( std::min )( BRICK_DEPTH, m_depth );
+	m_cellSize = maxExtent / ( float )( m_gridSize - 2 * GRID_MARGIN );
+
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		float centre = 0.5f * ( bounds[ 2 * i ] + bounds[ 2 * i + 1 ] );
+		m_origin[ i ] = centre - 0.5f * ( float )m_gridSize * m_cellSize;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::MeshExtractor::MayContainSurface( const OctreeCell &_cell )
+{
+	// The cell's edges are all inside its closed box, with the same positions as the samples of ProcessBrick
+	float boxMin[ 3 ], boxMax[ 3 ];
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		boxMin[ i ] = m_origin[ i ] + ( float )_cell.m_min[ i ] * m_cellSize;
+		boxMax[ i ] = m_origin[ i ] + ( float )( _cell.m_min[ i ] + _cell.m_size ) * m_cellSize;
+	}
+
+	float lower, upper;
+	m_root->GetFunctionRange( boxMin, boxMax, &lower, &upper );
+
+	// Only skip the cell when the range proves the field keeps one sign over it, an infinite range never does
+	float slack = RANGE_SLACK * ( fabs( lower ) + fabs( upper ) );
+	return !( lower > slack || upper < -slack );
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::MeshExtractor::ProcessCell( const OctreeCell &_cell, WorkerOutput &_output )
+{
+	if( !MayContainSurface( _cell ) )
+	{
+		return;
+	}
+
+	if( _cell.m_size <= m_brickSize )
+	{
+		ProcessBrick( _cell, _output );
+		return;
+	}
+
+	unsigned int half = _cell.m_size / 2;
+	for( unsigned int i = 0; i < 8; i++ )
+	{
+		OctreeCell child;
+		child.m_min[ 0 ] = _cell.m_min[ 0 ] + ( ( i & 1 ) ? half : 0 );
+		child.m_min[ 1 ] = _cell.m_min[ 1 ] + ( ( i & 2 ) ? half : 0 );
+		child.m_min[ 2 ] = _cell.m_min[ 2 ] + ( ( i & 4 ) ? half : 0 );
+		child.m_size = half;
+		ProcessCell( child, _output );
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::MeshExtractor::ProcessBrick( const OctreeCell &_cell, WorkerOutput &_output )
+{
+	// The brick owns the edges starting at its grid vertices, but the cells around those edges
+	// reach one cell further down on each axis, so the samples start one vertex early
+	const unsigned int B = _cell.m_size;
+	const unsigned int S = B + 2;
+	const unsigned int C = B + 1;
+	const int base[ 3 ] = { ( int )_cell.m_min[ 0 ] - 1, ( int )_cell.m_min[ 1 ] - 1, ( int )_cell.m_min[ 2 ] - 1 };
+
+	std::vector< float > values( S * S * S );
+	for( unsigned int z = 0; z < S; z++ )
+	{
+		for( unsigned int y = 0; y < S; y++ )
+		{
+			for( unsigned int x = 0; x < S; x++ )
+			{
+				values[ ( z * S + y ) * S + x ] = GetValue( m_origin[ 0 ] + ( float )( base[ 0 ] + ( int )x ) * m_cellSize,
+				                                            m_origin[ 1 ] + ( float )( base[ 1 ] + ( int )y ) * m_cellSize,
+				                                            m_origin[ 2 ] + ( float )( base[ 2 ] + ( int )z ) * m_cellSize );
+			}
+		}
+	}
+
+	std::vector< bool > cellDone( C * C * C, false );
+	const unsigned int strides[ 3 ] = { 1, S, S * S };
+	const int N = ( int )m_gridSize;
+
+	for( unsigned int sz = 1; sz <= B; sz++ )
+	{
+		for( unsigned int sy = 1; sy <= B; sy++ )
+		{
+			for( unsigned int sx = 1; sx <= B; sx++ )
+			{
+				const unsigned int s[ 3 ] = { sx, sy, sz };
+				const int v[ 3 ] = { base[ 0 ] + ( int )sx, base[ 1 ] + ( int )sy, base[ 2 ] + ( int )sz };
+				unsigned int index = ( sz * S + sy ) * S + sx;
+
+				for( unsigned int a = 0; a < 3; a++ )
+				{
+					unsigned int u = ( a + 1 ) % 3;
+					unsigned int w = ( a + 2 ) % 3;
+
+					// Skip edges whose neighbouring cells would fall outside the grid, the margin keeps the surface away from them
+					if( v[ a ] + 1 > N || v[ u ] < 1 || v[ u ] > N - 1 || v[ w ] < 1 || v[ w ] > N - 1 )
+					{
+						continue;
+					}
+
+					float f0 = values[ index ];
+					float f1 = values[ index + strides[ a ] ];
+					bool inside0 = f0 >= 0.0f;
+					if( inside0 == ( f1 >= 0.0f ) )
+					{
+						continue;
+					}
+
+					// Cells around the edge, counter-clockwise seen from the +a side
+					const int offsets[ 4 ][ 2 ] = { { -1, -1 }, { 0, -1 }, { 0, 0 }, { -1, 0 } };
+					unsigned int keys[ 4 ];
+					for( unsigned int i = 0; i < 4; i++ )
+					{
+						unsigned int c[ 3 ];
+						c[ a ] = s[ a ];
+						c[ u ] = s[ u ] + offsets[ i ][ 0 ];
+						c[ w ] = s[ w ] + offsets[ i ][ 1 ];
+
+						const unsigned int g[ 3 ] = { ( unsigned int )( base[ 0 ] + ( int )c[ 0 ] ), ( unsigned int )( base[ 1 ] + ( int )c[ 1 ] ), ( unsigned int )( base[ 2 ] + ( int )c[ 2 ] ) };
+						keys[ i ] = ( g[ 2 ] * m_gridSize + g[ 1 ] ) * m_gridSize + g[ 0 ];
+
+						unsigned int cellIndex = ( c[ 2 ] * C + c[ 1 ] ) * C + c[ 0 ];
+						if( !cellDone[ cellIndex ] )
+						{
+							cellDone[ cellIndex ] = true;
+
+							float cornerValues[ 8 ];
+							for( unsigned int j = 0; j < 8; j++ )
+							{
+								cornerValues[ j ] = values[ ( ( c[ 2 ] + ( ( j >> 2 ) & 1 ) ) * S + c[ 1 ] + ( ( j >> 1 ) & 1 ) ) * S + c[ 0 ] + ( j & 1 ) ];
+							}
+							float cellMin[ 3 ];
+							for( unsigned int j = 0; j < 3; j++ )
+							{
+								cellMin[ j ] = m_origin[ j ] + ( float )( base[ j ] + ( int )c[ j ] ) * m_cellSize;
+							}
+
+							float position[ 3 ];
+							PlaceCellVertex( cornerValues, cellMin, position );
+							_output.m_vertexKeys.push_back( keys[ i ] );
+							_output.m_vertexPositions.insert( _output.m_vertexPositions.end(), position, position + 3 );
+						}
+					}
+
+					// Inside is positive, so the quad faces +a when the far end of the edge is outside
+					if( inside0 )
+					{
+						_output.m_quads.insert( _output.m_quads.end(), keys, keys + 4 );
+					}
+					else
+					{
+						_output.m_quads.push_back( keys[ 3 ] );
+						_output.m_quads.push_back( keys[ 2 ] );
+						_output.m_quads.push_back( keys[ 1 ] );
+						_output.m_quads.push_back( keys[ 0 ] );
+					}
+				}
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::MeshExtractor::PlaceCellVertex( const float *_values, const float *_cellMin, float *_position )
+{
+	// Average of the edge crossings
+	float sum[ 3 ] = { 0.0f, 0.0f, 0.0f };
+	unsigned int count = 0;
+	for( unsigned int i = 0; i < 8; i++ )
+	{
+		for( unsigned int bit = 1; bit < 8; bit <<= 1 )
+		{
+			if( i & bit )
+			{
+				continue;
+			}
+			unsigned int j = i | bit;
+			if( ( _values[ i ] >= 0.0f ) == ( _values[ j ] >= 0.0f ) )
+			{
+				continue;
+			}
+
+			float t = _values[ i ] / ( _values[ i ] - _values[ j ] );
+			for( unsigned int a = 0; a < 3; a++ )
+			{
+				float from = ( float )( ( i >> a ) & 1 );
+				float to = ( float )( ( j >> a ) & 1 );
+				sum[ a ] += from + t * ( to - from );
+			}
+			count++;
+		}
+	}
+
+	for( unsigned int a = 0; a < 3; a++ )
+	{
+		float local = count > 0 ? sum[ a ] / ( float )count : 0.5f;
+		_position[ a ] = _cellMin[ a ] + local * m_cellSize;
+	}
+
+	// One Newton step towards the surface, kept inside the cell so the mesh cannot fold over itself
+	float delta = 0.1f * m_cellSize;
+	float value = GetValue( _position[ 0 ], _position[ 1 ], _position[ 2 ] );
+	float gradient[ 3 ];
+	gradient[ 0 ] = GetValue( _position[ 0 ] + delta, _position[ 1 ], _position[ 2 ] ) - GetValue( _position[ 0 ] - delta, _position[ 1 ], _position[ 2 ] );
+	gradient[ 1 ] = GetValue( _position[ 0 ], _position[ 1 ] + delta, _position[ 2 ] ) - GetValue( _position[ 0 ], _position[ 1 ] - delta, _position[ 2 ] );
+	gradient[ 2 ] = GetValue( _position[ 0 ], _position[ 1 ], _position[ 2 ] + delta ) - GetValue( _position[ 0 ], _position[ 1 ], _position[ 2 ] - delta );
+
+	float lengthSquared = 0.0f;
+	for( unsigned int a = 0; a < 3; a++ )
+	{
+		gradient[ a ] /= 2.0f * delta;
+		lengthSquared += gradient[ a ] * gradient[ a ];
+	}
+
+	if( lengthSquared > 1e-12f )
+	{
+		for( unsigned int a = 0; a < 3; a++ )
+		{
+			_position[ a ] -= value * gradient[ a ] / lengthSquared;
+			_position[ a ] = ( std::min )( ( std::max )( _position[ a ], _cellMin[ a ] ), _cellMin[ a ] + m_cellSize );
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::MeshExtractor::MergeOutputs()
+{
+	// Bricks compute the vertices of the cells they share from the same samples, so duplicates are identical
+	boost::unordered_map< unsigned int, unsigned int > indices;
+
+	for( std::vector< WorkerOutput >::iterator it = m_outputs.begin(); it != m_outputs.end(); ++it )
+	{
+		for( unsigned int i = 0; i < it->m_vertexKeys.size(); i++ )
+		{
+			if( indices.insert( std::make_pair( it->m_vertexKeys[ i ], ( unsigned int )( m_vertices.size() / 3 ) ) ).second )
+			{
+				m_vertices.insert( m_vertices.end(), it->m_vertexPositions.begin() + 3 * i, it->m_vertexPositions.begin() + 3 * i + 3 );
+			}
+		}
+	}
+
+	for( std::vector< WorkerOutput >::iterator it = m_outputs.begin(); it != m_outputs.end(); ++it )
+	{
+		for( unsigned int i = 0; i + 3 < it->m_quads.size(); i += 4 )
+		{
+			unsigned int quad[ 4 ];
+			for( unsigned int j = 0; j < 4; j++ )
+			{
+				quad[ j ] = indices[ it->m_quads[ i + j ] ];
+			}
+
+			m_triangles.push_back( quad[ 0 ] );
+			m_triangles.push_back( quad[ 1 ] );
+			m_triangles.push_back( quad[ 2 ] );
+
+			m_triangles.push_back( quad[ 0 ] );
+			m_triangles.push_back( quad[ 2 ] );
+			m_triangles.push_back( quad[ 3 ] );
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::MeshExtractor::Save( std::string _filename )
+{
+	std::string extension;
+	std::size_t dot = _filename.find_last_of( '.' );
+	if( dot != std::string::npos )
+	{
+		extension = _filename.substr( dot );
+		std::transform( extension.begin(), extension.end(), extension.begin(), ::tolower );
+	}
+
+	if( extension == ".stl" )
+	{
+		return SaveSTL( _filename );
+	}
+	else if( extension == ".obj" )
+	{
+		return SaveOBJ( _filename );
+	}
+
+	std::cerr << "ERROR: VolumeTree::MeshExtractor cannot save mesh format: " << _filename << std::endl;
+	return false;
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::MeshExtractor::SaveOBJ( std::string _filename )
+{
+	std::ofstream file( _filename.c_str() );
+	if( !file )
+	{
+		std::cerr << "ERROR: VolumeTree::MeshExtractor could not open file for writing: " << _filename << std::endl;
+		return false;
+	}
+
+	file.precision( 7 );
+	file << "# " << m_vertices.size() / 3 << " vertices, " << m_triangles.size() / 3 << " faces\n";
+	for( unsigned int i = 0; i < m_vertices.size(); i += 3 )
+	{
+		file << "v " << m_vertices[ i ] << " " << m_vertices[ i + 1 ] << " " << m_vertices[ i + 2 ] << "\n";
+	}
+	for( unsigned int i = 0; i < m_triangles.size(); i += 3 )
+	{
+		file << "f " << m_triangles[ i ] + 1 << " " << m_triangles[ i + 1 ] + 1 << " " << m_triangles[ i + 2 ] + 1 << "\n";
+	}
+
+	return file.good();
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::MeshExtractor::SaveSTL( std::string _filename )
+{
+	std::ofstream file( _filename.c_str(), std::ios::out | std::ios::binary );
+	if( !file )
+	{
+		std::cerr << "ERROR: VolumeTree::MeshExtractor could not open file for writing: " << _filename << std::endl;
+		return false;
+	}
+
+	// Binary STL is little endian, as are all the platforms we build for
+	char header[ 80 ];
+	memset( header, 0, sizeof( header ) );
+	strncpy( header, "SHIVA binary STL", sizeof( header ) - 1 );
+	file.write( header, sizeof( header ) );
+
+	boost::uint32_t numTriangles = ( boost::uint32_t )( m_triangles.size() / 3 );
+	file.write( ( const char* )&numTriangles, sizeof( numTriangles ) );
+
+	const boost::uint16_t attributes = 0;
+	for( unsigned int i = 0; i < m_triangles.size(); i += 3 )
+	{
+		const float *a = &m_vertices[ 3 * m_triangles[ i ] ];
+		const float *b = &m_vertices[ 3 * m_triangles[ i + 1 ] ];
+		const float *c = &m_vertices[ 3 * m_triangles[ i + 2 ] ];
+
+		float facet[ 12 ];
+		float ab[ 3 ] = { b[ 0 ] - a[ 0 ], b[ 1 ] - a[ 1 ], b[ 2 ] - a[ 2 ] };
+		float ac[ 3 ] = { c[ 0 ] - a[ 0 ], c[ 1 ] - a[ 1 ], c[ 2 ] - a[ 2 ] };
+		facet[ 0 ] = ab[ 1 ] * ac[ 2 ] - ab[ 2 ] * ac[ 1 ];
+		facet[ 1 ] = ab[ 2 ] * ac[ 0 ] - ab[ 0 ] * ac[ 2 ];
+		facet[ 2 ] = ab[ 0 ] * ac[ 1 ] - ab[ 1 ] * ac[ 0 ];
+		float length = sqrt( facet[ 0 ] * facet[ 0 ] + facet[ 1 ] * facet[ 1 ] + facet[ 2 ] * facet[ 2 ] );
+		if( length > 0.0f )
+		{
+			facet[ 0 ] /= length;
+			facet[ 1 ] /= length;
+			facet[ 2 ] /= length;
+		}
+		for( unsigned int j = 0; j < 3; j++ )
+		{
+			facet[ 3 + j ] = a[ j ];
+			facet[ 6 + j ] = b[ j ];
+			facet[ 9 + j ] = c[ j ];
+		}
+
+		file.write( ( const char* )facet, sizeof( facet ) );
+		file.write( ( const char* )&attributes, sizeof( attributes ) );
+	}
+
+	return file.good();
+}
+
+//----------------------------------------------------------------------------------
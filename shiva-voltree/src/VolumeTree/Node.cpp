@@ -1,5 +1,7 @@
 #include "VolumeTree/Node.h"
 #include "VolumeRenderer/GLSLRenderer.h"
+#include <sdf/profiler/scope.hpp>
+#include <limits>
 
 //----------------------------------------------------------------------------------
 
@@ -35,6 +37,35 @@ VolumeTree::Node::~Node()
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::Node::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	*_lower = -std::numeric_limits< float >::infinity();
+	*_upper = std::numeric_limits< float >::infinity();
+}
+
+//----------------------------------------------------------------------------------
+
+void VolumeTree::Node::SquareRange( float _lower, float _upper, float *_squareLower, float *_squareUpper )
+{
+	if( _lower >= 0.0f )
+	{
+		*_squareLower = _lower * _lower;
+		*_squareUpper = _upper * _upper;
+	}
+	else if( _upper <= 0.0f )
+	{
+		*_squareLower = _upper * _upper;
+		*_squareUpper = _lower * _lower;
+	}
+	else
+	{
+		*_squareLower = 0.0f;
+		*_squareUpper = ( std::max )( _lower * _lower, _upper * _upper );
+	}
+}
+
+//----------------------------------------------------------------------------------
+
 void VolumeTree::Node::SetUseCache( bool _useCache, unsigned int _cacheID, unsigned int _cacheResX, unsigned int _cacheResY, unsigned int _cacheResZ )
 {
 	m_cacheDirty = m_cacheDirty || ( _cacheID != m_cacheNumber || m_cacheResX != _cacheResX || m_cacheResY != _cacheResY || m_cacheResZ != _cacheResZ );
@@ -67,6 +98,8 @@ void VolumeTree::Node::BuildCaches( GLSLRenderer *_renderer )
 			GetBoundSizes( &boundsX, &boundsY, &boundsZ );
 			unsigned int volX = m_cacheResX, volY = m_cacheResY, volZ = m_cacheResZ;
 
+			SDF_PROFILE_SCOPE( "cache %d (%ux%ux%u)", m_cacheNumber, volX, volY, volZ )
+
 			//_cacheScaleX = boundsX;
 			//_cacheScaleY = boundsY;
 			//_cacheScaleZ = boundsZ;
@@ -93,7 +126,10 @@ void VolumeTree::Node::BuildCaches( GLSLRenderer *_renderer )
 			float startX = minX, startY = minY, startZ = minZ;
 			float stepX = boundsX / ( float )volX, stepY = boundsY / ( float )volY, stepZ = boundsZ / ( float )volZ;
 			
-			PopulateCacheData( &cacheData, startX, startY, startZ, stepX, stepY, stepZ );
+			{
+				SDF_PROFILE_SCOPE( "populate" )
+				PopulateCacheData( &cacheData, startX, startY, startZ, stepX, stepY, stepZ );
+			}
 
 			// Pass to renderer
 			_renderer->FillCache( m_cacheNumber, cacheData, volX, volY, volZ );
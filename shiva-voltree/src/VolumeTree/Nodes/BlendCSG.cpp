@@ -45,6 +45,38 @@ float VolumeTree::BlendCSGNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::BlendCSGNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	if( m_childA == NULL || m_childB == NULL )
+	{
+		Node::GetFunctionRange( _min, _max, _lower, _upper );
+		return;
+	}
+
+	// Same R-union as GetFunctionValue
+	float lowerA, upperA, lowerB, upperB;
+	m_childA->GetFunctionRange( _min, _max, &lowerA, &upperA );
+	m_childB->GetFunctionRange( _min, _max, &lowerB, &upperB );
+	*_lower = lowerA + lowerB + sqrt( lowerA * lowerA + lowerB * lowerB );
+	*_upper = upperA + upperB + sqrt( upperA * upperA + upperB * upperB );
+
+	// The blend term is m_a0 over a denominator of at least 1
+	float a = lowerA / m_a1, b = upperA / m_a1;
+	float squareLowerA, squareUpperA;
+	SquareRange( ( std::min )( a, b ), ( std::max )( a, b ), &squareLowerA, &squareUpperA );
+	a = lowerB / m_a2;
+	b = upperB / m_a2;
+	float squareLowerB, squareUpperB;
+	SquareRange( ( std::min )( a, b ), ( std::max )( a, b ), &squareLowerB, &squareUpperB );
+
+	float blendSmall = m_a0 / ( 1.0f + squareUpperA + squareUpperB );
+	float blendLarge = m_a0 / ( 1.0f + squareLowerA + squareLowerB );
+	*_lower += ( std::min )( blendSmall, blendLarge );
+	*_upper += ( std::max )( blendSmall, blendLarge );
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::BlendCSGNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr )
 {
 	if( m_childA != NULL && m_childB != NULL )
@@ -43,6 +43,24 @@ float VolumeTree::CSGNode::GetFunctionValue( float _x, float _y, float _z )
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::CSGNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	if( m_childA == NULL || m_childB == NULL )
+	{
+		Node::GetFunctionRange( _min, _max, _lower, _upper );
+		return;
+	}
+
+	// Same R-union as GetFunctionValue
+	float lowerA, upperA, lowerB, upperB;
+	m_childA->GetFunctionRange( _min, _max, &lowerA, &upperA );
+	m_childB->GetFunctionRange( _min, _max, &lowerB, &upperB );
+	*_lower = lowerA + lowerB + sqrt( lowerA * lowerA + lowerB * lowerB );
+	*_upper = upperA + upperB + sqrt( upperA * upperA + upperB * upperB );
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::CSGNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr )
 {
 	if( m_childA != NULL && m_childB != NULL )
@@ -220,6 +220,35 @@ float VolumeTree::TransformNode::GetFunctionValue( float _x, float _y, float _z
 
 //----------------------------------------------------------------------------------
 
+void VolumeTree::TransformNode::GetFunctionRange( const float *_min, const float *_max, float *_lower, float *_upper )
+{
+	if( m_child == NULL )
+	{
+		*_lower = *_upper = -1.0f;
+		return;
+	}
+
+	// The child is sampled at inverse * position, the box maps to a parallelepiped whose bounding box is
+	// centred on the mapped centre and as wide as the absolute matrix times the half extents
+	cml::matrix44f_c inverseTransform = cml::inverse( m_transformMatrix );
+	float childMin[ 3 ], childMax[ 3 ];
+	for( unsigned int i = 0; i < 3; i++ )
+	{
+		float centre = inverseTransform( i, 3 );
+		float extent = 0.0f;
+		for( unsigned int j = 0; j < 3; j++ )
+		{
+			centre += inverseTransform( i, j ) * 0.5f * ( _min[ j ] + _max[ j ] );
+			extent += fabs( inverseTransform( i, j ) ) * 0.5f * ( _max[ j ] - _min[ j ] );
+		}
+		childMin[ i ] = centre - extent;
+		childMax[ i ] = centre + extent;
+	}
+	m_child->GetFunctionRange( childMin, childMax, _lower, _upper );
+}
+
+//----------------------------------------------------------------------------------
+
 std::string VolumeTree::TransformNode::GetFunctionGLSLString( bool _callCache, std::string _samplePosStr )
 {
 	if( m_child != NULL)
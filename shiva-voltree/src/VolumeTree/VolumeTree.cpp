@@ -1,4 +1,5 @@
 #include "VolumeTree/VolumeTree.h"
+#include "VolumeTree/MeshExtractor.h"
 #include "VolumeTree/Leaves/ConeNode.h"
 #include "VolumeTree/Leaves/CubeNode.h"
 #include "VolumeTree/Leaves/CylinderNode.h"
@@ -8,6 +9,7 @@
 #include "VolumeTree/Nodes/BlendCSG.h"
 #include "VolumeTree/Nodes/CSG.h"
 #include "VolumeTree/Nodes/TransformNode.h"
+#include <sdf/profiler/scope.hpp>
 
 //----------------------------------------------------------------------------------
 
@@ -774,61 +776,68 @@ void VolumeTree::Tree::ExportToXML( Node *_currentNode, TiXmlElement *_root )
 
 //----------------------------------------------------------------------------------
 
-bool VolumeTree::Tree::IsPrintable( bool bIncludePole, bool bIncludeBase )
+totemio::TotemNode* VolumeTree::Tree::BuildPrintExportNode( bool _includePole, bool _includeBase )
 {
+	// The export tree is a copy, so the joining node does not need to outlive the conversion
+	VolumeTree::CSGNode joinNode;
+	Node *printRoot = GetPrintRootNode( _includePole, _includeBase, joinNode );
+	if( printRoot == NULL )
+	{
+		return NULL;
+	}
+	return BuildExportNode( printRoot );
+}
+
+//----------------------------------------------------------------------------------
 
+VolumeTree::Node* VolumeTree::Tree::GetPrintRootNode( bool _includePole, bool _includeBase, CSGNode &_joinNode )
+{
 	if( m_rootNode == NULL )
 	{
-		return false;
+		return NULL;
 	}
 
-	totemio::TotemNode* pRootNode = NULL;
-
-	if (bIncludePole && bIncludeBase)
-		pRootNode = BuildExportNode(m_rootNode);
-	else if (!bIncludePole && !bIncludeBase)
-	{
-		std::string nodeTypeStr = m_rootNode->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pChild1 = m_rootNode->GetFirstChild();
-		Node* pChild2 = m_rootNode->GetNextChild(pChild1);
-		if (!pChild1 || !pChild2)
-			return false;
-		pRootNode = BuildExportNode(pChild1);
-	}
-	else if (!bIncludePole && bIncludeBase)
-	{
-		std::string nodeTypeStr = m_rootNode->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pChild1 = m_rootNode->GetFirstChild();
-		if (!pChild1)
-			return false;
-		Node* pChild2 = m_rootNode->GetNextChild(pChild1);
-		if (!pChild2)
-			return false;
-		nodeTypeStr = pChild2->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pPole = pChild2->GetFirstChild();
-		Node* pBase = pChild2->GetNextChild(pPole);
-		
-		VolumeTree::CSGNode* pCSG = new VolumeTree::CSGNode(pChild1, pPole);
-		pRootNode = BuildExportNode(pCSG);
-		if (!pRootNode) return false;
-		unsigned int nRetCode = totemio::analyseModel(pRootNode);
-		if (nRetCode != totemio::CODE_OK)
-			return false;
-		delete pCSG;
-		return true;
+	if( _includePole && _includeBase )
+	{
+		return m_rootNode;
 	}
-	else 
+
+	// The totem root is a union of the model and a union of pole and base
+	std::string nodeTypeStr = m_rootNode->GetNodeType();
+	if( nodeTypeStr != "CSGNode" )
+		return NULL;
+	Node* pChild1 = m_rootNode->GetFirstChild();
+	if( !pChild1 )
+		return NULL;
+	Node* pChild2 = m_rootNode->GetNextChild( pChild1 );
+	if( !pChild2 )
+		return NULL;
+
+	if( !_includePole && !_includeBase )
 	{
-		//unsupported mode at the moment
-		return false;
+		return pChild1;
 	}
 
+	nodeTypeStr = pChild2->GetNodeType();
+	if( nodeTypeStr != "CSGNode" )
+		return NULL;
+	Node* pPole = pChild2->GetFirstChild();
+	Node* pBase = pChild2->GetNextChild( pPole );
+	Node* pSupport = _includePole ? pPole : pBase;
+	if( !pSupport )
+		return NULL;
+
+	_joinNode.SetChildA( pChild1 );
+	_joinNode.SetChildB( pSupport );
+	return &_joinNode;
+}
+
+//----------------------------------------------------------------------------------
+
+bool VolumeTree::Tree::IsPrintable( bool bIncludePole, bool bIncludeBase )
+{
+	totemio::TotemNode* pRootNode = BuildPrintExportNode( bIncludePole, bIncludeBase );
+
 	if (!pRootNode) return false;
 
 	unsigned int nRetCode = totemio::analyseModel(pRootNode);
@@ -853,80 +862,34 @@ bool VolumeTree::Tree::IsPrintable( bool bIncludePole, bool bIncludeBase )
 }
 
 //----------------------------------------------------------------------------------
-bool VolumeTree::Tree::SaveMesh( std::string _filename, bool bIncludePole, bool bIncludeBase)
+
+bool VolumeTree::Tree::SaveMesh( std::string _filename, bool bIncludePole, bool bIncludeBase, float _quality )
 {
-	if( m_rootNode == NULL )
-	{
-		return false;
-	}
+	totemio::TotemNode* pRootNode = BuildPrintExportNode( bIncludePole, bIncludeBase );
 
-	totemio::TotemNode* pRootNode = NULL;
-
-	if (bIncludePole && bIncludeBase)
-		pRootNode = BuildExportNode(m_rootNode);
-	else if (!bIncludePole && !bIncludeBase)
-	{
-		std::string nodeTypeStr = m_rootNode->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pChild1 = m_rootNode->GetFirstChild();
-		Node* pChild2 = m_rootNode->GetNextChild(pChild1);
-		if (!pChild1 || !pChild2)
-			return false;
-		pRootNode = BuildExportNode(pChild1);
-	}
-	else if (!bIncludePole && bIncludeBase)
-	{
-		std::string nodeTypeStr = m_rootNode->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pChild1 = m_rootNode->GetFirstChild();
-		if (!pChild1)
-			return false;
-		Node* pChild2 = m_rootNode->GetNextChild(pChild1);
-		if (!pChild2)
-			return false;
-		nodeTypeStr = pChild2->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pPole = pChild2->GetFirstChild();
-		Node* pBase = pChild2->GetNextChild(pPole);
-		
-		VolumeTree::CSGNode* pCSG = new VolumeTree::CSGNode(pChild1, pBase);
-		pRootNode = BuildExportNode(pCSG);
+	if (!pRootNode) return false;
+	return totemio::saveMesh( _filename.c_str(), pRootNode, _quality );
+}
 
-		if (!totemio::saveMesh( _filename.c_str(), pRootNode, 0.01f ))
-			return false;
-		delete pCSG;
-		return true;
+//----------------------------------------------------------------------------------
 
-	}
-	else
+bool VolumeTree::Tree::ExtractMesh( std::string _filename, bool bIncludePole, bool bIncludeBase, unsigned int _depth, unsigned int _numThreads )
+{
+	VolumeTree::CSGNode joinNode;
+	Node *printRoot = GetPrintRootNode( bIncludePole, bIncludeBase, joinNode );
+	if( printRoot == NULL )
 	{
-		std::string nodeTypeStr = m_rootNode->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pChild1 = m_rootNode->GetFirstChild();
-		if (!pChild1)
-			return false;
-		Node* pChild2 = m_rootNode->GetNextChild(pChild1);
-		if (!pChild2)
-			return false;
-		nodeTypeStr = pChild2->GetNodeType();
-		if (nodeTypeStr != "CSGNode")
-			return false;
-		Node* pPole = pChild2->GetFirstChild();
-		
-		VolumeTree::CSGNode* pCSG = new VolumeTree::CSGNode(pChild1, pPole);
-		pRootNode = BuildExportNode(pCSG);
-		if (!totemio::saveMesh( _filename.c_str(), pRootNode, 0.01f ))
-			return false;
-		delete pCSG;
-		return true;
+		return false;
 	}
 
-	if (!pRootNode) return false;
-	return totemio::saveMesh( _filename.c_str(), pRootNode, 0.01f );
+	MeshExtractor extractor( printRoot );
+	extractor.SetDepth( _depth );
+	extractor.SetNumThreads( _numThreads );
+	if( !extractor.Extract() )
+	{
+		return false;
+	}
+	return extractor.Save( _filename );
 }
 
 //----------------------------------------------------------------------------------
@@ -1099,6 +1062,7 @@ std::string VolumeTree::Tree::GetFunctionGLSLString()
 
 void VolumeTree::Tree::BuildCaches( CachingPolicy *_policy, GLSLRenderer *_renderer )
 {
+	SDF_PROFILE_SCOPE( "cache build" )
 	if( m_rootNode != NULL )
 	{
 		if( _policy != NULL )